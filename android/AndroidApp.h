@@ -1,7 +1,10 @@
 #pragma once
 
+// the Linux platform layer (linux/LinuxApp.cpp) implements the utility functions below so the Ogl* classes build as is
+#ifdef __ANDROID__
 #include <jni.h>
 #include <android/asset_manager.h>
+#endif
 
 #include "../core/MigInclude.h"
 #include "../core/MigGame.h"
@@ -14,6 +17,7 @@ extern MigTech::MigGame* allocGame();
 ///////////////////////////////////////////////////////////////////////////
 // entry points for JNI code
 
+#ifdef __ANDROID__
 void AndroidApp_create(JNIEnv* env, jobject assetMgr, jstring filesDir);
 void AndroidApp_createGraphics(void);
 void AndroidApp_init(int width, int height);
@@ -26,11 +30,14 @@ void AndroidApp_pointerPressed(float x, float y);
 void AndroidApp_pointerReleased(float x, float y);
 void AndroidApp_pointerMoved(float x, float y);
 bool AndroidApp_backKey();
+#endif
 
 ///////////////////////////////////////////////////////////////////////////
 // additional utility functions
 
+#ifdef __ANDROID__
 AAssetManager* AndroidUtil_getAssetManager();
+#endif
 int AndroidUtil_getAssetBuffer(const std::string& name, void* buf, int bufLen);
 const std::string& AndroidUtil_getFilesDir();
 const std::string& AndroidUtil_getExtFilesDir();
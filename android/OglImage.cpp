@@ -1,6 +1,8 @@
 ﻿#include "pch.h"
 #include "../core/MigUtil.h"
+#include "../core/MipChain.h"
 #include "OglImage.h"
+#include "OglRender.h"
 #include "AndroidApp.h"
 
 ///////////////////////////////////////////////////////////////////////////
@@ -8,7 +10,7 @@
 
 using namespace MigTech;
 
-OglImage::OglImage()
+OglImage::OglImage() : _minFilter(-1), _magFilter(-1), _wrap(-1)
 {
 	glGenTextures(1, &_textureID);
 }
@@ -16,14 +18,46 @@ OglImage::OglImage()
 OglImage::~OglImage()
 {
 	glDeleteTextures(1, &_textureID);
+
+	OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
+	if (rendObj != nullptr)
+		rendObj->forgetTexture(_textureID);
+}
+
+void OglImage::bindTexture(int unit)
+{
+	OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
+	rendObj->bindTexture(unit, _textureID);
 }
 
-void OglImage::bindTexture()
+// the texture must already be bound to the active unit
+void OglImage::setSampling(GLint minFilter, GLint magFilter, GLint wrap)
 {
-	glBindTexture(GL_TEXTURE_2D, _textureID);
+	OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
+
+	rendObj->countStateCall(_minFilter == minFilter);
+	if (_minFilter != minFilter)
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+		_minFilter = minFilter;
+	}
+	rendObj->countStateCall(_magFilter == magFilter);
+	if (_magFilter != magFilter)
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+		_magFilter = magFilter;
+	}
+	rendObj->countStateCall(_wrap == wrap);
+	if (_wrap != wrap)
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+		_wrap = wrap;
+	}
 }
 
-void OglImage::loadTexture(IMG_FORMAT fmt, int width, int height, void* pData)
+// the levels are packed one after another in pData (see MipChain)
+void OglImage::loadTexture(IMG_FORMAT fmt, int width, int height, void* pData, int mipLevels)
 {
 	GLenum format;
 	if (fmt == IMG_FORMAT_ALPHA)
@@ -38,11 +72,46 @@ void OglImage::loadTexture(IMG_FORMAT fmt, int width, int height, void* pData)
 		throw std::invalid_argument("(OglImage::loadTexture) No format provided");
 
 	bindTexture();
-	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pData);
-	checkGLError("OglImage::loadTexture", "glTexImage2D");
+	int bpp = MipChain::getBytesPerPixel(fmt);
+	const byte* pLevel = (const byte*) pData;
+	_byteSize = 0;
+	for (int level = 0; level < mipLevels; level++)
+	{
+		int levelWidth = MipChain::getLevelDim(width, level);
+		int levelHeight = MipChain::getLevelDim(height, level);
+		glTexImage2D(GL_TEXTURE_2D, level, format, levelWidth, levelHeight, 0, format, GL_UNSIGNED_BYTE, pLevel);
+		checkGLError("OglImage::loadTexture", "glTexImage2D");
+
+		unsigned int levelSize = (unsigned int) (bpp*levelWidth*levelHeight);
+		if (pLevel != nullptr)
+			pLevel += levelSize;
+		_byteSize += levelSize;
+	}
 
 	_width = width;
 	_height = height;
+	_mipLevels = mipLevels;
+}
+
+void OglImage::loadCompressedTexture(GLenum internalFormat, const ImageData& data, int mipLevels)
+{
+	if (internalFormat == 0)
+		throw std::invalid_argument("(OglImage::loadCompressedTexture) No format provided");
+
+	bindTexture();
+	_byteSize = 0;
+	for (int level = 0; level < mipLevels; level++)
+	{
+		unsigned int levelSize = MipChain::getLevelSize(data, level);
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, MipChain::getLevelDim(data.width, level), MipChain::getLevelDim(data.height, level),
+			0, levelSize, data.pixels + MipChain::getLevelOffset(data, level));
+		checkGLError("OglImage::loadCompressedTexture", "glCompressedTexImage2D");
+		_byteSize += levelSize;
+	}
+
+	_width = data.width;
+	_height = data.height;
+	_mipLevels = mipLevels;
 }
 
 OglRenderTarget::OglRenderTarget() : OglImage()
@@ -113,6 +182,9 @@ bool OglRenderTarget::init(IMG_FORMAT fmtHint, int width, int height, int depthB
 	}
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+	// the color texture was sized by loadTexture(), the depth buffer is 16 bits
+	if (_depthBufferID > 0)
+		_byteSize += (unsigned int) (2*width*height);
 	_width = width;
 	_height = height;
 	return true;
@@ -120,7 +192,9 @@ bool OglRenderTarget::init(IMG_FORMAT fmtHint, int width, int height, int depthB
 
 void OglRenderTarget::bindRenderTarget()
 {
-	glBindTexture(GL_TEXTURE_2D, 0);
+	// the target can't be sampled while it's being rendered into
+	OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
+	rendObj->unbindTexture(_textureID);
 	glBindFramebuffer(GL_FRAMEBUFFER, _frameBufferID);
 	checkGLError("OglImage::bindRenderTarget", "glBindFramebuffer");
 }
@@ -14,12 +14,20 @@ namespace MigTech
 	protected:
 		GLuint _textureID;
 
+		// sampling parameters last set on this texture (they're texture object state)
+		GLint _minFilter;
+		GLint _magFilter;
+		GLint _wrap;
+
 	public:
 		OglImage();
 		virtual ~OglImage();
 
-		void bindTexture();
-		void loadTexture(IMG_FORMAT fmt, int width, int height, void* pData);
+		GLuint getTextureID() const { return _textureID; }
+		void bindTexture(int unit = 0);
+		void setSampling(GLint minFilter, GLint magFilter, GLint wrap);
+		void loadTexture(IMG_FORMAT fmt, int width, int height, void* pData, int mipLevels = 1);
+		void loadCompressedTexture(GLenum internalFormat, const ImageData& data, int mipLevels);
 	};
 
 	// OpenGL version of a render target
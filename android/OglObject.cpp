@@ -10,12 +10,16 @@
 using namespace MigTech;
 
 OglObject::OglObject() :
-	_verts(nullptr),
-	_colors(nullptr),
-	_norms(nullptr),
-	_tex1(nullptr),
-	_tex2(nullptr),
-	_indices(nullptr),
+	_vbo(0),
+	_ibo(0),
+	_vboSize(0),
+	_iboSize(0),
+	_instBuffer(0),
+	_stride(0),
+	_offColor(-1),
+	_offNorm(-1),
+	_offTex1(-1),
+	_offTex2(-1),
 	_type(GL_TRIANGLES),
 	_numPts(0),
 	_numInd(0),
@@ -28,18 +32,13 @@ OglObject::OglObject() :
 
 OglObject::~OglObject()
 {
-	if (_verts)
-		delete _verts;
-	if (_colors)
-		delete _colors;
-	if (_norms)
-		delete _norms;
-	if (_tex1)
-		delete _tex1;
-	if (_tex2)
-		delete _tex2;
-	if (_indices)
-		delete _indices;
+	resetVertexArrays();
+	if (_vbo)
+		glDeleteBuffers(1, &_vbo);
+	if (_ibo)
+		glDeleteBuffers(1, &_ibo);
+	if (_instBuffer)
+		glDeleteBuffers(1, &_instBuffer);
 }
 
 int OglObject::addShaderSet(const std::string& vs, const std::string& ps)
@@ -47,7 +46,10 @@ int OglObject::addShaderSet(const std::string& vs, const std::string& ps)
 	OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
 	OglProgram* program = rendObj->loadProgram(vs, ps);
 	if (program != nullptr)
+	{
 		_programs.push_back(program);
+		_vaos.push_back(0);
+	}
 	return (program != nullptr ? _programs.size() - 1 : -1);
 }
 
@@ -70,159 +72,108 @@ void OglObject::setImage(int index, const std::string& name, TXT_FILTER minFilte
 	_mappings[index].wrap = wrap;
 }
 
+static GLenum toGLUsage(BUFFER_USAGE usage)
+{
+	return (usage == BUFFER_USAGE_DYNAMIC ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+}
+
+// buffer offsets are passed to GL disguised as pointers
+static const GLvoid* toBufferOffset(GLint offset)
+{
+	return (const GLvoid*) (intptr_t) offset;
+}
+
+void OglObject::uploadBuffer(GLenum target, GLuint& buffer, GLsizeiptr& bufferSize, const void* pdata, GLsizeiptr size)
+{
+	// don't let the upload disturb whatever vertex array is currently bound
+	OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
+	rendObj->bindVertexArray(0);
+
+	if (buffer == 0)
+		glGenBuffers(1, &buffer);
+	glBindBuffer(target, buffer);
+
+	// dynamic buffers keep their size if the new data fits, but the old storage is orphaned first so
+	// the driver doesn't have to wait for earlier draws from this buffer to finish
+	if (_usage == BUFFER_USAGE_DYNAMIC && size <= bufferSize)
+	{
+		glBufferData(target, bufferSize, nullptr, GL_DYNAMIC_DRAW);
+		glBufferSubData(target, 0, size, pdata);
+	}
+	else
+	{
+		glBufferData(target, size, pdata, toGLUsage(_usage));
+		bufferSize = size;
+	}
+	checkGLError("OglObject::uploadBuffer", "glBufferData");
+}
+
+void OglObject::resetVertexArrays()
+{
+	OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
+	for (unsigned int i = 0; i < _vaos.size(); i++)
+	{
+		rendObj->deleteVertexArray(_vaos[i]);
+		_vaos[i] = 0;
+	}
+}
+
 void OglObject::loadVertexBuffer(const void* pdata, unsigned int count, VDTYPE vdType)
 {
 	if (pdata == nullptr || count == 0)
 		throw std::invalid_argument("(OglObject::loadVertexBuffer) Invalid vertex data");
-	if (vdType == VDTYPE_UNKNOWN)
-		throw std::invalid_argument("(OglObject::loadVertexBuffer) Invalid vertex data type");
-
-	// free existing buffers
-	if (_verts)
-		delete _verts;
-	_verts = nullptr;
-	if (_colors)
-		delete _colors;
-	_colors = nullptr;
-	if (_norms)
-		delete _norms;
-	_norms = nullptr;
-	if (_tex1)
-		delete _tex1;
-	_tex1 = nullptr;
-	if (_tex2)
-		delete _tex2;
-	_tex2 = nullptr;
 
+	// the vertex structures are already interleaved floats, so they can be uploaded as is
+	GLsizei stride = 0;
+	GLint offColor = -1, offNorm = -1, offTex1 = -1, offTex2 = -1;
 	switch (vdType)
 	{
 	case VDTYPE_POSITION:
-		{
-			_verts = new GLfloat[3*count];
-
-			const VertexPosition* pd = (VertexPosition*) pdata;
-			for (int i = 0; i < count; i++)
-			{
-				_verts[3*i+0] = pd[i].pos.x;
-				_verts[3*i+1] = pd[i].pos.y;
-				_verts[3*i+2] = pd[i].pos.z;
-			}
-		}
+		stride = sizeof(VertexPosition);
 		break;
 	case VDTYPE_POSITION_COLOR:
-		{
-			_verts = new GLfloat[3*count];
-			_colors = new GLfloat[4*count];
-
-			const VertexPositionColor* pd = (VertexPositionColor*) pdata;
-			for (int i = 0; i < count; i++)
-			{
-				_verts[3*i+0] = pd[i].pos.x;
-				_verts[3*i+1] = pd[i].pos.y;
-				_verts[3*i+2] = pd[i].pos.z;
-				_colors[4*i+0] = pd[i].color.r;
-				_colors[4*i+1] = pd[i].color.g;
-				_colors[4*i+2] = pd[i].color.b;
-				_colors[4*i+3] = pd[i].color.a;
-			}
-		}
+		stride = sizeof(VertexPositionColor);
+		offColor = offsetof(VertexPositionColor, color);
 		break;
 	case VDTYPE_POSITION_COLOR_TEXTURE:
-		{
-			_verts = new GLfloat[3*count];
-			_colors = new GLfloat[4*count];
-			_tex1 = new GLfloat[2*count];
-
-			const VertexPositionColorTexture* pd = (VertexPositionColorTexture*) pdata;
-			for (int i = 0; i < count; i++)
-			{
-				_verts[3*i+0] = pd[i].pos.x;
-				_verts[3*i+1] = pd[i].pos.y;
-				_verts[3*i+2] = pd[i].pos.z;
-				_colors[4*i+0] = pd[i].color.r;
-				_colors[4*i+1] = pd[i].color.g;
-				_colors[4*i+2] = pd[i].color.b;
-				_colors[4*i+3] = pd[i].color.a;
-				_tex1[2*i+0] = pd[i].uv.x;
-				_tex1[2*i+1] = pd[i].uv.y;
-			}
-		}
+		stride = sizeof(VertexPositionColorTexture);
+		offColor = offsetof(VertexPositionColorTexture, color);
+		offTex1 = offsetof(VertexPositionColorTexture, uv);
 		break;
 	case VDTYPE_POSITION_NORMAL:
-		{
-			_verts = new GLfloat[3*count];
-			_norms = new GLfloat[3*count];
-
-			const VertexPositionNormal* pd = (VertexPositionNormal*) pdata;
-			for (int i = 0; i < count; i++)
-			{
-				_verts[3*i+0] = pd[i].pos.x;
-				_verts[3*i+1] = pd[i].pos.y;
-				_verts[3*i+2] = pd[i].pos.z;
-				_norms[3*i+0] = pd[i].norm.x;
-				_norms[3*i+1] = pd[i].norm.y;
-				_norms[3*i+2] = pd[i].norm.z;
-			}
-		}
+		stride = sizeof(VertexPositionNormal);
+		offNorm = offsetof(VertexPositionNormal, norm);
 		break;
 	case VDTYPE_POSITION_NORMAL_TEXTURE:
-		{
-			_verts = new GLfloat[3*count];
-			_norms = new GLfloat[3*count];
-			_tex1 = new GLfloat[2*count];
-
-			const VertexPositionNormalTexture* pd = (VertexPositionNormalTexture*) pdata;
-			for (int i = 0; i < count; i++)
-			{
-				_verts[3*i+0] = pd[i].pos.x;
-				_verts[3*i+1] = pd[i].pos.y;
-				_verts[3*i+2] = pd[i].pos.z;
-				_norms[3*i+0] = pd[i].norm.x;
-				_norms[3*i+1] = pd[i].norm.y;
-				_norms[3*i+2] = pd[i].norm.z;
-				_tex1[2*i+0] = pd[i].uv.x;
-				_tex1[2*i+1] = pd[i].uv.y;
-			}
-		}
+		stride = sizeof(VertexPositionNormalTexture);
+		offNorm = offsetof(VertexPositionNormalTexture, norm);
+		offTex1 = offsetof(VertexPositionNormalTexture, uv);
 		break;
 	case VDTYPE_POSITION_TEXTURE:
-		{
-			_verts = new GLfloat[3*count];
-			_tex1 = new GLfloat[2*count];
-
-			const VertexPositionTexture* pd = (VertexPositionTexture*) pdata;
-			for (int i = 0; i < count; i++)
-			{
-				_verts[3*i+0] = pd[i].pos.x;
-				_verts[3*i+1] = pd[i].pos.y;
-				_verts[3*i+2] = pd[i].pos.z;
-				_tex1[2*i+0] = pd[i].uv.x;
-				_tex1[2*i+1] = pd[i].uv.y;
-			}
-		}
+		stride = sizeof(VertexPositionTexture);
+		offTex1 = offsetof(VertexPositionTexture, uv);
 		break;
 	case VDTYPE_POSITION_TEXTURE_TEXTURE:
-		{
-			_verts = new GLfloat[3*count];
-			_tex1 = new GLfloat[2*count];
-			_tex2 = new GLfloat[2*count];
-
-			const VertexPositionTextureTexture* pd = (VertexPositionTextureTexture*) pdata;
-			for (int i = 0; i < count; i++)
-			{
-				_verts[3*i+0] = pd[i].pos.x;
-				_verts[3*i+1] = pd[i].pos.y;
-				_verts[3*i+2] = pd[i].pos.z;
-				_tex1[2*i+0] = pd[i].uv1.x;
-				_tex1[2*i+1] = pd[i].uv1.y;
-				_tex2[2*i+0] = pd[i].uv2.x;
-				_tex2[2*i+1] = pd[i].uv2.y;
-			}
-		}
+		stride = sizeof(VertexPositionTextureTexture);
+		offTex1 = offsetof(VertexPositionTextureTexture, uv1);
+		offTex2 = offsetof(VertexPositionTextureTexture, uv2);
 		break;
 	default:
 		break;
 	}
+	if (stride == 0)
+		throw std::invalid_argument("(OglObject::loadVertexBuffer) Invalid vertex data type");
+
+	// the vertex arrays captured the old layout, so they'll need to be rebuilt if it changes
+	if (stride != _stride || offColor != _offColor || offNorm != _offNorm || offTex1 != _offTex1 || offTex2 != _offTex2)
+		resetVertexArrays();
+	_stride = stride;
+	_offColor = offColor;
+	_offNorm = offNorm;
+	_offTex1 = offTex1;
+	_offTex2 = offTex2;
+
+	uploadBuffer(GL_ARRAY_BUFFER, _vbo, _vboSize, pdata, count * stride);
 	_numPts = count;
 }
 
@@ -233,9 +184,11 @@ void OglObject::loadIndexBuffer(const unsigned short* indices, unsigned int coun
 	if (type == PRIMITIVE_TYPE_UNKNOWN)
 		throw std::invalid_argument("(OglObject::loadIndexBuffer) Invalid primitive type");
 
-	_indices = new GLshort[count];
-	for (unsigned int i = 0; i < count; i++)
-		_indices[i] = indices[i];
+	// the vertex arrays don't know about a brand new index buffer yet
+	if (_ibo == 0)
+		resetVertexArrays();
+	uploadBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo, _iboSize, indices, count * sizeof(GLushort));
+
 	_type = GL_TRIANGLES;
 	if (type == PRIMITIVE_TYPE_TRIANGLE_STRIP)
 		_type = GL_TRIANGLE_STRIP;
@@ -244,8 +197,17 @@ void OglObject::loadIndexBuffer(const unsigned short* indices, unsigned int coun
 	_numInd = _offIndCount = count;
 }
 
-static GLint toGLFilter(TXT_FILTER filt)
+// a mipmap filter on a texture without levels would leave it incomplete (and black)
+static GLint toGLFilter(TXT_FILTER filt, bool mipmapped)
 {
+	if (!mipmapped)
+	{
+		if (filt == TXT_FILTER_LINEAR_MIPMAP_NEAREST || filt == TXT_FILTER_LINEAR_MIPMAP_LINEAR)
+			filt = TXT_FILTER_LINEAR;
+		else if (filt == TXT_FILTER_NEAREST_MIPMAP_NEAREST || filt == TXT_FILTER_NEAREST_MIPMAP_LINEAR)
+			filt = TXT_FILTER_NEAREST;
+	}
+
 	switch (filt)
 	{
 	case TXT_FILTER_LINEAR: return GL_LINEAR;
@@ -285,6 +247,22 @@ int OglObject::getIndexCount() const
 	return _offIndCount;
 }
 
+void OglObject::bindBuffers(OglProgram* program)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+
+	program->loadVerts(_stride, toBufferOffset(0));
+	if (_offColor != -1)
+		program->loadColors(_stride, toBufferOffset(_offColor));
+	if (_offNorm != -1)
+		program->loadNorms(_stride, toBufferOffset(_offNorm));
+	if (_offTex1 != -1)
+		program->loadTex1Coords(_stride, toBufferOffset(_offTex1));
+	if (_offTex2 != -1)
+		program->loadTex2Coords(_stride, toBufferOffset(_offTex2));
+}
+
 void OglObject::prepareRender(int shaderSet)
 {
 	OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
@@ -297,41 +275,35 @@ void OglObject::prepareRender(int shaderSet)
 	// activate the program
 	program->useProgram();
 
-	// load vertex data
-	program->loadVerts(_verts);
-
-	// load color data
-	if (_colors)
-		program->loadColors(_colors);
-
-	// load normal data
-	if (_norms)
-		program->loadNorms(_norms);
+	// bind the geometry, the vertex array only needs to be configured the first time
+	if (rendObj->hasVertexArrays() && _vbo != 0)
+	{
+		if (_vaos[shaderSet] == 0)
+		{
+			_vaos[shaderSet] = rendObj->createVertexArray();
+			rendObj->bindVertexArray(_vaos[shaderSet]);
+			bindBuffers(program);
+		}
+		else
+			rendObj->bindVertexArray(_vaos[shaderSet]);
+	}
+	else
+		bindBuffers(program);
 
-	// load texture1 data
-	if (_tex1)
-		program->loadTex1Coords(_tex1);
+	// load texture1 data (the renderer and image filter out redundant binds and parameters)
 	if (_mappings[0].pimg != nullptr && program->setTex1Location())
 	{
-		glActiveTexture(GL_TEXTURE0);
-		_mappings[0].pimg->bindTexture();
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, toGLFilter(_mappings[0].minFilter));
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, toGLFilter(_mappings[0].magFilter));
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, toGLWrap(_mappings[0].wrap));
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, toGLWrap(_mappings[0].wrap));
+		_mappings[0].pimg->bindTexture(0);
+		_mappings[0].pimg->setSampling(toGLFilter(_mappings[0].minFilter, _mappings[0].pimg->getMipLevels() > 1),
+			toGLFilter(_mappings[0].magFilter, false), toGLWrap(_mappings[0].wrap));
 	}
 
 	// load texture2 data
-	if (_tex2)
-		program->loadTex2Coords(_tex2);
 	if (_mappings[1].pimg != nullptr && program->setTex2Location())
 	{
-		glActiveTexture(GL_TEXTURE1);
-		_mappings[1].pimg->bindTexture();
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, toGLFilter(_mappings[1].minFilter));
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, toGLFilter(_mappings[1].magFilter));
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, toGLWrap(_mappings[1].wrap));
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, toGLWrap(_mappings[1].wrap));
+		_mappings[1].pimg->bindTexture(1);
+		_mappings[1].pimg->setSampling(toGLFilter(_mappings[1].minFilter, _mappings[1].pimg->getMipLevels() > 1),
+			toGLFilter(_mappings[1].magFilter, false), toGLWrap(_mappings[1].wrap));
 	}
 
 	rendObj->setFaceCulling(_cull);
@@ -339,6 +311,10 @@ void OglObject::prepareRender(int shaderSet)
 
 void OglObject::render(int shaderSet)
 {
+	// the render queue will call back in here when it's submitted
+	if (MigUtil::theRend->queueDraw(this, shaderSet))
+		return;
+
 	// if we're not in a render sequence then prepare the render
 	if (!_inRenderSet)
 		prepareRender(shaderSet);
@@ -354,15 +330,70 @@ void OglObject::render(int shaderSet)
 	// load lights
 	program->loadLights();
 
-	if (_indices)
-		glDrawElements(_type, _offIndCount, GL_UNSIGNED_SHORT, &_indices[_offInd]);
+	if (_ibo)
+		glDrawElements(_type, _offIndCount, GL_UNSIGNED_SHORT, toBufferOffset(_offInd * sizeof(GLushort)));
 	else
 	    glDrawArrays(GL_TRIANGLES, 0, _numPts);
     //checkGLError("OglObject::render", "glDrawArrays");
 }
 
+void OglObject::renderInstanced(int shaderSet, const InstanceData* instances, unsigned int count)
+{
+	if (instances == nullptr)
+		throw std::invalid_argument("(OglObject::renderInstanced) Invalid instance data");
+	if (count == 0)
+		return;
+	if (MigUtil::theRend->queueDrawInstanced(this, shaderSet, instances, count))
+		return;
+
+	// if we're not in a render sequence then prepare the render
+	if (!_inRenderSet)
+		prepareRender(shaderSet);
+
+	OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
+	OglProgram* program = _programs[shaderSet];
+	if (!program->hasInstanceData())
+		throw std::invalid_argument("(OglObject::renderInstanced) Shader set doesn't take instance data");
+
+	// the uniforms are shared by all of the instances
+	program->loadBasicConfig();
+	program->loadMatrices();
+	program->loadLights();
+
+	const GLvoid* indices = toBufferOffset(_offInd * sizeof(GLushort));
+	if (rendObj->hasInstancing() && _ibo)
+	{
+		// the instance data is streamed, orphaning the old storage so the draw doesn't wait on it
+		if (_instBuffer == 0)
+			glGenBuffers(1, &_instBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, _instBuffer);
+		glBufferData(GL_ARRAY_BUFFER, count * sizeof(InstanceData), instances, GL_STREAM_DRAW);
+
+		program->loadInstanceArrays(sizeof(InstanceData), toBufferOffset(offsetof(InstanceData, model)), toBufferOffset(offsetof(InstanceData, color)));
+		rendObj->drawElementsInstanced(_type, _offIndCount, indices, count);
+		program->unloadInstanceArrays();
+	}
+	else
+	{
+		// one draw per instance, but only the instance attributes change between them
+		program->unloadInstanceArrays();
+		for (unsigned int i = 0; i < count; i++)
+		{
+			program->loadInstance(instances[i]);
+			if (_ibo)
+				glDrawElements(_type, _offIndCount, GL_UNSIGNED_SHORT, indices);
+			else
+				glDrawArrays(GL_TRIANGLES, 0, _numPts);
+		}
+	}
+}
+
 void OglObject::startRenderSet(int shaderSet)
 {
+	// queued draws are prepared individually when they're submitted
+	if (MigUtil::theRend->isQueueing())
+		return;
+
 	prepareRender(shaderSet);
 
 	_inRenderSet = true;
@@ -372,3 +403,15 @@ void OglObject::stopRenderSet()
 {
 	_inRenderSet = false;
 }
+
+unsigned int OglObject::getStateKey(int shaderSet) const
+{
+	if (shaderSet < 0 || shaderSet >= (int)_programs.size())
+		return 0;
+
+	// program in the high bits, since that's the most expensive switch
+	unsigned int key = ((_programs[shaderSet]->getProgramID() & 0xFFFF) << 16);
+	if (_mappings[0].pimg != nullptr)
+		key |= (_mappings[0].pimg->getTextureID() & 0xFFFF);
+	return key;
+}
@@ -26,13 +26,24 @@ namespace MigTech
 	protected:
 		std::vector<OglProgram*> _programs;
 
-		// model data arrays
-		GLfloat* _verts;
-		GLfloat* _colors;
-		GLfloat* _norms;
-		GLfloat* _tex1;
-		GLfloat* _tex2;
-		GLshort* _indices;
+		// buffer objects, the vertex data is uploaded interleaved just as it was given
+		GLuint _vbo;
+		GLuint _ibo;
+		GLsizeiptr _vboSize;
+		GLsizeiptr _iboSize;
+		GLuint _instBuffer;
+
+		// one vertex array per shader set (if supported), since attribute handles vary by program
+		std::vector<GLuint> _vaos;
+
+		// vertex layout, the offsets are -1 if the attribute isn't present
+		GLsizei _stride;
+		GLint _offColor;
+		GLint _offNorm;
+		GLint _offTex1;
+		GLint _offTex2;
+
+		// draw configuration
 		GLenum _type;
 		GLsizei _numPts;
 		GLsizei _numInd;
@@ -45,6 +56,9 @@ namespace MigTech
 		bool _inRenderSet;
 
 	protected:
+		void uploadBuffer(GLenum target, GLuint& buffer, GLsizeiptr& bufferSize, const void* pdata, GLsizeiptr size);
+		void bindBuffers(OglProgram* program);
+		void resetVertexArrays();
 		void prepareRender(int shaderSet);
 
 	public:
@@ -61,8 +75,11 @@ namespace MigTech
 		virtual int getIndexCount() const;
 
 		virtual void render(int shaderSet = 0);
+		virtual void renderInstanced(int shaderSet, const InstanceData* instances, unsigned int count);
 
 		virtual void startRenderSet(int shaderSet = 0);
 		virtual void stopRenderSet();
+
+		virtual unsigned int getStateKey(int shaderSet) const;
 	};
 }
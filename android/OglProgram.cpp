@@ -16,6 +16,8 @@ OglProgram::OglProgram() :
 	_gvNormHandle(-1),
 	_gvTex1Handle(-1),
 	_gvTex2Handle(-1),
+	_giModelHandle(-1),
+	_giColorHandle(-1),
 	_modelLocation(-1),
 	_viewLocation(-1),
 	_projLocation(-1),
@@ -25,19 +27,29 @@ OglProgram::OglProgram() :
 	_texture2Location(-1),
 	_miscValLocation(-1),
 	_cfgValLocation(-1),
-	_ambientColorLocation(-1)
+	_ambientColorLocation(-1),
+	_modelGen(0), _viewGen(0), _projGen(0), _lightGen(0),
+	_basicValid(false), _tex1Set(false), _tex2Set(false)
 {
 	for (int i = 0; i < 4; i++)
 	{
 		_litColorLocation[i] = -1;
 		_litDirPosLocation[i] = -1;
+		_miscVal[i] = 0;
+		_cfgVal[i] = 0;
 	}
 }
 
 OglProgram::~OglProgram()
 {
 	if (_program)
+	{
 		glDeleteProgram(_program);
+
+		OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
+		if (rendObj != nullptr)
+			rendObj->forgetProgram(_program);
+	}
 }
 
 void OglProgram::buildProgram(const std::string& vs, const std::string& ps)
@@ -92,6 +104,8 @@ void OglProgram::buildProgram(const std::string& vs, const std::string& ps)
 	_gvNormHandle = glGetAttribLocation(_program, "vNorm");
 	_gvTex1Handle = glGetAttribLocation(_program, "vTex1");
 	_gvTex2Handle = glGetAttribLocation(_program, "vTex2");
+	_giModelHandle = glGetAttribLocation(_program, "iModel");
+	_giColorHandle = glGetAttribLocation(_program, "iColor");
 	_modelLocation = glGetUniformLocation(_program, "matModel");
 	_viewLocation = glGetUniformLocation(_program, "matView");
 	_projLocation = glGetUniformLocation(_program, "matProj");
@@ -114,15 +128,16 @@ void OglProgram::buildProgram(const std::string& vs, const std::string& ps)
 
 void OglProgram::useProgram()
 {
-	glUseProgram(_program);
+	OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
+	rendObj->useProgram(_program);
 	//checkGLError("OglProgram::useProgram", "glUseProgram");
 }
 
-bool OglProgram::loadVerts(GLfloat* verts)
+bool OglProgram::loadVerts(GLsizei stride, const GLvoid* verts)
 {
-	if (_gvPositionHandle != -1 && verts != nullptr)
+	if (_gvPositionHandle != -1)
 	{
-		glVertexAttribPointer(_gvPositionHandle, 3, GL_FLOAT, GL_FALSE, 0, verts);
+		glVertexAttribPointer(_gvPositionHandle, 3, GL_FLOAT, GL_FALSE, stride, verts);
 		//checkGLError("OglProgram::render", "glVertexAttribPointer");
 		glEnableVertexAttribArray(_gvPositionHandle);
 		//checkGLError("OglProgram::render", "glEnableVertexAttribArray");
@@ -131,11 +146,11 @@ bool OglProgram::loadVerts(GLfloat* verts)
 	return false;
 }
 
-bool OglProgram::loadColors(GLfloat* colors)
+bool OglProgram::loadColors(GLsizei stride, const GLvoid* colors)
 {
-	if (_gvColorHandle != -1 && colors)
+	if (_gvColorHandle != -1)
 	{
-		glVertexAttribPointer(_gvColorHandle, 4, GL_FLOAT, GL_FALSE, 0, colors);
+		glVertexAttribPointer(_gvColorHandle, 4, GL_FLOAT, GL_FALSE, stride, colors);
 		//checkGLError("OglProgram::render", "glVertexAttribPointer");
 		glEnableVertexAttribArray(_gvColorHandle);
 		//checkGLError("OglProgram::render", "glEnableVertexAttribArray");
@@ -144,11 +159,11 @@ bool OglProgram::loadColors(GLfloat* colors)
 	return false;
 }
 
-bool OglProgram::loadNorms(GLfloat* norms)
+bool OglProgram::loadNorms(GLsizei stride, const GLvoid* norms)
 {
-	if (_gvNormHandle != -1 && norms)
+	if (_gvNormHandle != -1)
 	{
-		glVertexAttribPointer(_gvNormHandle, 3, GL_FLOAT, GL_FALSE, 0, norms);
+		glVertexAttribPointer(_gvNormHandle, 3, GL_FLOAT, GL_FALSE, stride, norms);
 		//checkGLError("OglProgram::render", "glVertexAttribPointer");
 		glEnableVertexAttribArray(_gvNormHandle);
 		//checkGLError("OglProgram::render", "glEnableVertexAttribArray");
@@ -157,11 +172,11 @@ bool OglProgram::loadNorms(GLfloat* norms)
 	return false;
 }
 
-bool OglProgram::loadTex1Coords(GLfloat* tex1)
+bool OglProgram::loadTex1Coords(GLsizei stride, const GLvoid* tex1)
 {
-	if (_gvTex1Handle != -1 && tex1)
+	if (_gvTex1Handle != -1)
 	{
-		glVertexAttribPointer(_gvTex1Handle, 2, GL_FLOAT, GL_FALSE, 0, tex1);
+		glVertexAttribPointer(_gvTex1Handle, 2, GL_FLOAT, GL_FALSE, stride, tex1);
 		//checkGLError("OglProgram::render", "glVertexAttribPointer");
 		glEnableVertexAttribArray(_gvTex1Handle);
 		//checkGLError("OglProgram::render", "glEnableVertexAttribArray");
@@ -170,11 +185,11 @@ bool OglProgram::loadTex1Coords(GLfloat* tex1)
 	return false;
 }
 
-bool OglProgram::loadTex2Coords(GLfloat* tex2)
+bool OglProgram::loadTex2Coords(GLsizei stride, const GLvoid* tex2)
 {
-	if (_gvTex2Handle != -1 && tex2)
+	if (_gvTex2Handle != -1)
 	{
-		glVertexAttribPointer(_gvTex2Handle, 2, GL_FLOAT, GL_FALSE, 0, tex2);
+		glVertexAttribPointer(_gvTex2Handle, 2, GL_FLOAT, GL_FALSE, stride, tex2);
 		//checkGLError("OglProgram::render", "glVertexAttribPointer");
 		glEnableVertexAttribArray(_gvTex2Handle);
 		//checkGLError("OglProgram::render", "glEnableVertexAttribArray");
@@ -183,58 +198,169 @@ bool OglProgram::loadTex2Coords(GLfloat* tex2)
 	return false;
 }
 
+// sampler units never change so they only need to be set once
 bool OglProgram::setTex1Location()
 {
-	if (_texture1Location != -1)
+	if (_texture1Location != -1 && !_tex1Set)
+	{
 		glUniform1i(_texture1Location, 0);
+		_tex1Set = true;
+	}
 	return (_texture1Location != -1);
 }
 
 bool OglProgram::setTex2Location()
 {
-	if (_texture2Location != -1)
+	if (_texture2Location != -1 && !_tex2Set)
+	{
 		glUniform1i(_texture2Location, 1);
+		_tex2Set = true;
+	}
 	return (_texture2Location != -1);
 }
 
+void OglProgram::loadInstanceArrays(GLsizei stride, const GLvoid* model, const GLvoid* color)
+{
+	OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
+	if (_giModelHandle != -1)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			glVertexAttribPointer(_giModelHandle + i, 4, GL_FLOAT, GL_FALSE, stride, (const GLbyte*) model + 4 * i * sizeof(GLfloat));
+			glEnableVertexAttribArray(_giModelHandle + i);
+			rendObj->vertexAttribDivisor(_giModelHandle + i, 1);
+		}
+	}
+	if (_giColorHandle != -1)
+	{
+		glVertexAttribPointer(_giColorHandle, 4, GL_FLOAT, GL_FALSE, stride, color);
+		glEnableVertexAttribArray(_giColorHandle);
+		rendObj->vertexAttribDivisor(_giColorHandle, 1);
+	}
+}
+
+// the divisors would otherwise leak into whatever uses these handles next
+void OglProgram::unloadInstanceArrays()
+{
+	OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
+	if (_giModelHandle != -1)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			rendObj->vertexAttribDivisor(_giModelHandle + i, 0);
+			glDisableVertexAttribArray(_giModelHandle + i);
+		}
+	}
+	if (_giColorHandle != -1)
+	{
+		rendObj->vertexAttribDivisor(_giColorHandle, 0);
+		glDisableVertexAttribArray(_giColorHandle);
+	}
+}
+
+// without instancing support the instance data is sent as constant attribute values
+void OglProgram::loadInstance(const InstanceData& inst)
+{
+	if (_giModelHandle != -1)
+	{
+		const float* model = inst.model.getData();
+		for (int i = 0; i < 4; i++)
+			glVertexAttrib4fv(_giModelHandle + i, &model[4 * i]);
+	}
+	if (_giColorHandle != -1)
+		glVertexAttrib4f(_giColorHandle, inst.color.r, inst.color.g, inst.color.b, inst.color.a);
+}
+
+// these values are small so they're compared directly rather than tracked by generation
 void OglProgram::loadBasicConfig()
 {
 	OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
 	if (_objColorLocation > -1)
 	{
 		const Color& objCol = rendObj->getObjectColor();
-		glUniform4f(_objColorLocation, objCol.r, objCol.g, objCol.b, objCol.a);
+		bool elided = (_basicValid && !memcmp(&_objColor, &objCol, sizeof(Color)));
+		rendObj->countStateCall(elided);
+		if (!elided)
+		{
+			glUniform4f(_objColorLocation, objCol.r, objCol.g, objCol.b, objCol.a);
+			_objColor = objCol;
+		}
 	}
 	if (_miscValLocation > -1)
 	{
 		const float* miscVals = rendObj->getMiscVal();
-		//glUniform4fv(_miscValLocation, 4, miscVals);
-		glUniform4f(_miscValLocation, miscVals[0], miscVals[1], miscVals[2], miscVals[3]);
+		bool elided = (_basicValid && !memcmp(_miscVal, miscVals, sizeof(_miscVal)));
+		rendObj->countStateCall(elided);
+		if (!elided)
+		{
+			//glUniform4fv(_miscValLocation, 4, miscVals);
+			glUniform4f(_miscValLocation, miscVals[0], miscVals[1], miscVals[2], miscVals[3]);
+			memcpy(_miscVal, miscVals, sizeof(_miscVal));
+		}
 	}
 	if (_cfgValLocation > -1)
 	{
 		const int* cfgVals = rendObj->getConfigVal();
-		//glUniform4iv(_cfgValLocation, 4, cfgVals);
-		glUniform4i(_cfgValLocation, cfgVals[0], cfgVals[1], cfgVals[2], cfgVals[3]);
+		bool elided = (_basicValid && !memcmp(_cfgVal, cfgVals, sizeof(_cfgVal)));
+		rendObj->countStateCall(elided);
+		if (!elided)
+		{
+			//glUniform4iv(_cfgValLocation, 4, cfgVals);
+			glUniform4i(_cfgValLocation, cfgVals[0], cfgVals[1], cfgVals[2], cfgVals[3]);
+			memcpy(_cfgVal, cfgVals, sizeof(_cfgVal));
+		}
 	}
+	_basicValid = true;
 }
 
 void OglProgram::loadMatrices()
 {
 	OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
+	bool modelDirty = (_modelGen != rendObj->getModelGen());
+	bool viewDirty = (_viewGen != rendObj->getViewGen());
+	bool projDirty = (_projGen != rendObj->getProjGen());
+
 	if (_modelLocation > -1)
-		rendObj->loadModelMatrix(_modelLocation);
+	{
+		rendObj->countStateCall(!modelDirty);
+		if (modelDirty)
+			rendObj->loadModelMatrix(_modelLocation);
+	}
 	if (_viewLocation > -1)
-		rendObj->loadViewMatrix(_viewLocation);
+	{
+		rendObj->countStateCall(!viewDirty);
+		if (viewDirty)
+			rendObj->loadViewMatrix(_viewLocation);
+	}
 	if (_projLocation > -1)
-		rendObj->loadProjMatrix(_projLocation);
+	{
+		rendObj->countStateCall(!projDirty);
+		if (projDirty)
+			rendObj->loadProjMatrix(_projLocation);
+	}
 	if (_mvpLocation > -1)
-		rendObj->loadMVPMatrix(_mvpLocation);
+	{
+		bool mvpDirty = (modelDirty || viewDirty || projDirty);
+		rendObj->countStateCall(!mvpDirty);
+		if (mvpDirty)
+			rendObj->loadMVPMatrix(_mvpLocation);
+	}
+
+	_modelGen = rendObj->getModelGen();
+	_viewGen = rendObj->getViewGen();
+	_projGen = rendObj->getProjGen();
 }
 
+// the lights usually only change once per screen
 void OglProgram::loadLights()
 {
 	OglRender* rendObj = (OglRender*)MigTech::MigUtil::theRend;
+	bool elided = (_lightGen == rendObj->getLightGen());
+	rendObj->countStateCall(elided);
+	if (elided)
+		return;
+	_lightGen = rendObj->getLightGen();
+
 	if (_ambientColorLocation > -1)
 	{
 		const Color& litCol = rendObj->getAmbientColor();
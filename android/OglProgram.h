@@ -4,6 +4,7 @@
 // platform specific
 
 #include "../core/MigDefines.h"
+#include "../core/Object.h"
 #include "OglShader.h"
 
 namespace MigTech
@@ -19,6 +20,8 @@ namespace MigTech
 		GLuint _gvNormHandle;
 		GLuint _gvTex1Handle;
 		GLuint _gvTex2Handle;
+		GLuint _giModelHandle;
+		GLuint _giColorHandle;
 		GLint _modelLocation;
 		GLint _viewLocation;
 		GLint _projLocation;
@@ -32,22 +35,41 @@ namespace MigTech
 		GLint _litColorLocation[4];
 		GLint _litDirPosLocation[4];
 
+		// last uploaded uniform values, uniforms are per program state so they survive program switches
+		unsigned int _modelGen;
+		unsigned int _viewGen;
+		unsigned int _projGen;
+		unsigned int _lightGen;
+		Color _objColor;
+		float _miscVal[4];
+		int _cfgVal[4];
+		bool _basicValid;
+		bool _tex1Set;
+		bool _tex2Set;
+
 	public:
 		OglProgram();
 		~OglProgram();
 
 		void buildProgram(const std::string& vs, const std::string& ps);
 		void useProgram();
+		GLuint getProgramID() const { return _program; }
 
-		// geometry
-		bool loadVerts(GLfloat* verts);
-		bool loadColors(GLfloat* colors);
-		bool loadNorms(GLfloat* norms);
-		bool loadTex1Coords(GLfloat* tex1);
+		// geometry (pointers are offsets into the currently bound vertex buffer)
+		bool loadVerts(GLsizei stride, const GLvoid* verts);
+		bool loadColors(GLsizei stride, const GLvoid* colors);
+		bool loadNorms(GLsizei stride, const GLvoid* norms);
+		bool loadTex1Coords(GLsizei stride, const GLvoid* tex1);
 		bool setTex1Location();
-		bool loadTex2Coords(GLfloat* tex2);
+		bool loadTex2Coords(GLsizei stride, const GLvoid* tex2);
 		bool setTex2Location();
 
+		// instancing (the model matrix attribute takes 4 consecutive handles)
+		bool hasInstanceData() const { return (_giModelHandle != -1); }
+		void loadInstanceArrays(GLsizei stride, const GLvoid* model, const GLvoid* color);
+		void unloadInstanceArrays();
+		void loadInstance(const InstanceData& inst);
+
 		// non-geometry
 		void loadBasicConfig();
 		void loadMatrices();
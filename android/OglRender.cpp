@@ -1,18 +1,15 @@
 ﻿#include "pch.h"
 #include "../core/MigUtil.h"
+#include "../core/AssetLoader.h"
+#include "../core/ImageDecoder.h"
+#include "../core/KtxFile.h"
+#include "../core/MipChain.h"
 #include "OglRender.h"
-#include "OglMatrix.h"
 #include "OglShader.h"
 #include "OglObject.h"
 #include "AndroidApp.h"
 
-extern "C" {
-#include "../core/libjpeg/jpeglib.h"
-}
-
-extern "C" {
-#include "../core/libpng/png.h"
-}
+#include <EGL/egl.h>
 
 ///////////////////////////////////////////////////////////////////////////
 // platform specific
@@ -20,8 +17,13 @@ extern "C" {
 using namespace MigTech;
 
 OglRender::OglRender() :
-	_outputSize(), _clearColor(0, 0, 0)
+	_outputSize(), _clearColor(0, 0, 0),
+	_glGenVertexArrays(nullptr), _glBindVertexArray(nullptr), _glDeleteVertexArrays(nullptr),
+	_glDrawElementsInstanced(nullptr), _glVertexAttribDivisor(nullptr), _npotMipmaps(false),
+	_modelGen(1), _viewGen(1), _projGen(1), _lightGen(1),
+	_callsIssued(0), _callsElided(0), _lastCallsIssued(0), _lastCallsElided(0)
 {
+	invalidateStateCache();
 }
 
 OglRender::~OglRender()
@@ -34,6 +36,8 @@ void OglRender::createDeviceIndependentResources()
 
 void OglRender::createDeviceResources()
 {
+	// a new context starts with the GL defaults, not whatever the cache remembers
+	invalidateStateCache();
 }
 
 void OglRender::createWindowSizeDependentResources()
@@ -53,6 +57,62 @@ bool OglRender::initRenderer()
     printGLString("Renderer", GL_RENDERER);
     //printGLString("Extensions", GL_EXTENSIONS);	// warning - very long string
 
+	// vertex array objects let each object record its buffer bindings once
+	const char* exts = (const char*) glGetString(GL_EXTENSIONS);
+	if (exts != nullptr && strstr(exts, "GL_OES_vertex_array_object") != nullptr)
+	{
+		_glGenVertexArrays = (PFNGLGENVERTEXARRAYSOESPROC) eglGetProcAddress("glGenVertexArraysOES");
+		_glBindVertexArray = (PFNGLBINDVERTEXARRAYOESPROC) eglGetProcAddress("glBindVertexArrayOES");
+		_glDeleteVertexArrays = (PFNGLDELETEVERTEXARRAYSOESPROC) eglGetProcAddress("glDeleteVertexArraysOES");
+		if (_glGenVertexArrays == nullptr || _glBindVertexArray == nullptr || _glDeleteVertexArrays == nullptr)
+		{
+			_glGenVertexArrays = nullptr;
+			_glBindVertexArray = nullptr;
+			_glDeleteVertexArrays = nullptr;
+		}
+	}
+	LOGINFO("(OglRender::initRenderer) Vertex array objects are %s", (hasVertexArrays() ? "supported" : "not supported"));
+
+	// instancing has the same entry points under several vendor names
+	static const char* instExts[][3] =
+	{
+		{ "GL_EXT_instanced_arrays", "glDrawElementsInstancedEXT", "glVertexAttribDivisorEXT" },
+		{ "GL_ANGLE_instanced_arrays", "glDrawElementsInstancedANGLE", "glVertexAttribDivisorANGLE" },
+		{ "GL_NV_instanced_arrays", "glDrawElementsInstancedNV", "glVertexAttribDivisorNV" },
+	};
+	for (int i = 0; i < ARRAYSIZE(instExts) && exts != nullptr && _glDrawElementsInstanced == nullptr; i++)
+	{
+		if (strstr(exts, instExts[i][0]) != nullptr)
+		{
+			_glDrawElementsInstanced = (PFNGLDRAWELEMENTSINSTANCEDEXTPROC) eglGetProcAddress(instExts[i][1]);
+			_glVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISOREXTPROC) eglGetProcAddress(instExts[i][2]);
+			if (_glDrawElementsInstanced == nullptr || _glVertexAttribDivisor == nullptr)
+			{
+				_glDrawElementsInstanced = nullptr;
+				_glVertexAttribDivisor = nullptr;
+			}
+		}
+	}
+	LOGINFO("(OglRender::initRenderer) Instanced drawing is %s", (hasInstancing() ? "supported" : "not supported"));
+
+	// compressed textures, ETC2 is core in GLES 3
+	const char* version = (const char*) glGetString(GL_VERSION);
+	_compressionCaps = 0;
+	if (version != nullptr && strstr(version, "OpenGL ES 3") != nullptr)
+		_compressionCaps |= (1 << TEX_COMPRESSION_ETC2_RGB) | (1 << TEX_COMPRESSION_ETC2_RGBA);
+	if (exts != nullptr && strstr(exts, "GL_OES_compressed_ETC1_RGB8_texture") != nullptr)
+		_compressionCaps |= (1 << TEX_COMPRESSION_ETC1);
+	if (exts != nullptr && strstr(exts, "GL_EXT_texture_compression_s3tc") != nullptr)
+		_compressionCaps |= (1 << TEX_COMPRESSION_BC1) | (1 << TEX_COMPRESSION_BC3);
+	if (exts != nullptr && strstr(exts, "GL_KHR_texture_compression_astc_ldr") != nullptr)
+		_compressionCaps |= (1 << TEX_COMPRESSION_ASTC);
+	LOGINFO("(OglRender::initRenderer) Compressed texture caps are 0x%x", _compressionCaps);
+
+	// decoded rows are tightly packed, which matters for RGB pixels and small mip levels
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	_npotMipmaps = ((version != nullptr && strstr(version, "OpenGL ES 3") != nullptr) ||
+		(exts != nullptr && strstr(exts, "GL_OES_texture_npot") != nullptr));
+
 	createDeviceIndependentResources();
 	createDeviceResources();
 
@@ -89,57 +149,43 @@ void OglRender::termRenderer()
 	_images.clear();
 }
 
-IMatrix* OglRender::createMatrix()
-{
-	return (IMatrix*) new OglMatrix();
-}
-
-void OglRender::deleteMatrix(IMatrix* pmat)
-{
-	delete (OglMatrix*)pmat;
-}
-
-void OglRender::setProjectionMatrix(const IMatrix* pmat)
+void OglRender::applyProjectionMatrix(const Matrix* pmat)
 {
 	if (pmat != nullptr)
-	{
-		OglMatrix* pomat = (OglMatrix*)pmat;
-		_perspective.copy(pomat);
-	}
+		_perspective = *pmat;
 	else
 		_perspective.identity();
+	_projGen++;
 }
 
-void OglRender::setProjectionMatrix(float angleY, float aspect, float nearZ, float farZ, bool useOrientation)
+void OglRender::applyProjectionMatrix(float angleY, float aspect, float nearZ, float farZ, bool useOrientation)
 {
 	_perspective.loadPerspectiveFovRH(angleY, aspect, nearZ, farZ);
+	_projGen++;
 }
 
-void OglRender::setViewMatrix(const IMatrix* pmat)
+void OglRender::applyViewMatrix(const Matrix* pmat)
 {
 	if (pmat != nullptr)
-	{
-		OglMatrix* pomat = (OglMatrix*)pmat;
-		_view.copy(pomat);
-	}
+		_view = *pmat;
 	else
 		_view.identity();
+	_viewGen++;
 }
 
-void OglRender::setViewMatrix(Vector3 eyePos, Vector3 focusPos, Vector3 upVector)
+void OglRender::applyViewMatrix(Vector3 eyePos, Vector3 focusPos, Vector3 upVector)
 {
 	_view.loadLookAtRH(eyePos, focusPos, upVector);
+	_viewGen++;
 }
 
-void OglRender::setModelMatrix(const IMatrix* pmat)
+void OglRender::applyModelMatrix(const Matrix* pmat)
 {
 	if (pmat != nullptr)
-	{
-		OglMatrix* pomat = (OglMatrix*)pmat;
-		_model.copy(pomat);
-	}
+		_model = *pmat;
 	else
 		_model.identity();
+	_modelGen++;
 }
 
 void OglRender::setOutputSize(Size newSize)
@@ -155,7 +201,7 @@ Size OglRender::getOutputSize()
 	return _outputSize;
 }
 
-void OglRender::setViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer)
+void OglRender::applyViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer)
 {
 	// reset the viewport
 	if (newPort != nullptr)
@@ -281,361 +327,90 @@ Shader* OglRender::getShader(const std::string& name)
 	return nullptr;
 }
 
-static OglImage* loadJPEGImage(const std::string& name, unsigned int loadFlags)
+// CPU only, this is called from the asset loader threads
+bool OglRender::decodeImage(const std::string& path, unsigned int loadFlags, const Size& fitSize, ImageData& data)
 {
-	// get the asset file size
-	int len = AndroidUtil_getAssetBuffer(name, nullptr, 0);
-	if (len == -1)
-	{
-		LOGWARN("(OglRender::loadJPEGImage) image '%s' doesn't exist", name.c_str());
-		return nullptr;
-	}
-	//MigUtil::debug("(OglRender::loadJPEGImage) image '%s' file size is %d", name.c_str(), len);
-
-	// load the image into a memory buffer
-	byte* pFile = new byte[len];
-	if (AndroidUtil_getAssetBuffer(name, pFile, len) == -1)
-	{
-		LOGWARN("(OglRender::loadJPEGImage) image '%s' failed to load", name.c_str());
-		delete [] pFile;
-		return nullptr;
-	}
-	byte* pData = nullptr;
-
-	// initialize decompression
-	struct jpeg_decompress_struct cinfo;
-	struct jpeg_error_mgr jerr;
-	cinfo.err = jpeg_std_error(&jerr);
-	jpeg_create_decompress(&cinfo);
-	jpeg_mem_src(&cinfo, pFile, len);
-	jpeg_read_header(&cinfo, TRUE);
-	jpeg_start_decompress(&cinfo);
-	LOGINFO("(OglRender::loadJPEGImage) Image=%s, w=%d, h=%d", name.c_str(), cinfo.output_width, cinfo.output_height);
-
-	// for now, only 24-bit JPEGs
-	if (cinfo.output_components == 3)
+	bool decoded = false;
+	int findDot = path.rfind(".");
+	if (findDot != string::npos)
 	{
-		if (loadFlags == LOAD_IMAGE_NONE)
+		std::string ext = path.substr(findDot + 1);
+		if (0 == ext.compare("jpg") ||
+			0 == ext.compare("jpeg"))
 		{
-			// read into the image buffer quickly
-			int row_stride = cinfo.output_width*cinfo.output_components;
-			pData = new byte[row_stride*cinfo.output_height];
-			if (pData != nullptr)
-			{
-				JSAMPROW row_pointer[1];
-				while (cinfo.output_scanline < cinfo.output_height)
-				{
-					row_pointer[0] = pData + cinfo.output_scanline*row_stride;
-					jpeg_read_scanlines(&cinfo, row_pointer, 1);
-				}
-			}
+			decoded = ImageDecoder::loadJPEG(path, loadFlags, true, fitSize, data);
 		}
-		else
+		else if (0 == ext.compare("png"))
 		{
-			// read into the image buffer
-			int row_stride = 4 * cinfo.output_width;
-			int numPixels = row_stride * cinfo.output_height;
-			pData = new byte[numPixels];
-			if (pData != nullptr)
-			{
-				byte* psrc = new byte[3 * cinfo.output_width];
-				JSAMPROW row_pointer[1];
-				row_pointer[0] = psrc;
-
-				while (cinfo.output_scanline < cinfo.output_height)
-				{
-					jpeg_read_scanlines(&cinfo, row_pointer, 1);
-
-					byte* pdst = pData + (cinfo.output_scanline - 1)*row_stride;
-					for (unsigned int i = 0; i < cinfo.output_width; i++)
-					{
-						pdst[4 * i + 0] = psrc[3 * i + 0];
-						pdst[4 * i + 1] = psrc[3 * i + 1];
-						pdst[4 * i + 2] = psrc[3 * i + 2];
-
-						// apply image processing
-						byte alpha = 255;
-						if (loadFlags != LOAD_IMAGE_NONE)
-						{
-							if (loadFlags & LOAD_IMAGE_ADD_ALPHA)
-								alpha = (pdst[4 * i + 0] + pdst[4 * i + 1] + pdst[4 * i + 2]) / 3;
-							else if (loadFlags & LOAD_IMAGE_CLEAR_ALPHA)
-								alpha = 0;
-							if (loadFlags & LOAD_IMAGE_INVERT_ALPHA)
-								alpha = (255 - alpha);
-						}
-						pdst[4 * i + 3] = alpha;
-					}
-				}
-				delete [] psrc;
-
-				// drop color components if so flagged
-				if (loadFlags & LOAD_IMAGE_DROP_COLOR)
-				{
-					int numPixels = cinfo.output_width * cinfo.output_height;
-					byte* pNewData = new byte[numPixels];
-					for (int i = 0; i < numPixels; i++)
-					{
-						pNewData[i] = pData[4 * i + 3];
-					}
-
-					delete pData;
-					pData = pNewData;
-				}
-			}
+			decoded = ImageDecoder::loadPNG(path, loadFlags, data);
 		}
-	}
-	else
-	{
-		LOGWARN("(OglRender::loadJPEGImage) %d color components not supported", cinfo.output_components);
-	}
-
-	// clean up decompression
-	jpeg_finish_decompress(&cinfo);
-	jpeg_destroy_decompress(&cinfo);
-	delete [] pFile;
-
-	// load the data into an Image and return
-	OglImage* newImage = nullptr;
-	if (pData != nullptr)
-	{
-		IMG_FORMAT fmt = IMG_FORMAT_RGB;
-		if (loadFlags != LOAD_IMAGE_NONE)
+		else if (0 == ext.compare("ktx") ||
+			0 == ext.compare("ktx2"))
 		{
-			if (loadFlags & LOAD_IMAGE_DROP_COLOR)
-				fmt = IMG_FORMAT_ALPHA;
-			else
-				fmt = IMG_FORMAT_RGBA;
+			decoded = KtxFile::loadImage(path, loadFlags, _compressionCaps, data);
 		}
-
-		// create the image object and load
-		newImage = new OglImage();
-		newImage->loadTexture(fmt, cinfo.output_width, cinfo.output_height, pData);
-		delete pData;
 	}
-	return newImage;
-}
 
-struct USER_READ_DATA
-{
-	byte* pFile;
-	int sizeFile;
-	int currOffset;
-};
+	if (decoded && (loadFlags & LOAD_IMAGE_MIPMAPS))
+		MipChain::generate(data);
+	return decoded;
+}
 
-static void userReadData(png_structp read_ptr, png_bytep data, png_size_t length)
+static bool isPowerOf2(int n)
 {
-	if (read_ptr != nullptr)
-	{
-		USER_READ_DATA* pData = (USER_READ_DATA*) png_get_io_ptr(read_ptr);
-		if (pData != nullptr)
-		{
-			if (pData->currOffset + length <= pData->sizeFile)
-			{
-				//MigUtil::debug("(OglRender::userReadData) Reading %d bytes from offset %d", length, pData->currOffset);
-				memcpy(data, &(pData->pFile[pData->currOffset]), length);
-				pData->currOffset += length;
-			}
-			else
-				LOGERR("(OglRender::userReadData) PNG read error, EOF");
-		}
-		else
-			LOGERR("(OglRender::userReadData) PNG read error, pData was nullptr");
-	}
-	else
-		LOGERR("(OglRender::userReadData) PNG read error, read_ptr was nullptr");
+	return ((n & (n - 1)) == 0);
 }
 
-static OglImage* loadPNGImage(const std::string& name, unsigned int loadFlags)
+void OglRender::uploadImage(Image* img, const ImageData& data)
 {
-	// get the asset file size
-	int len = AndroidUtil_getAssetBuffer(name, nullptr, 0);
-	if (len == -1)
+	// a partial chain or an NPOT chain the driver can't sample would leave the texture incomplete
+	int mipLevels = data.mipLevels;
+	if (mipLevels > 1 && mipLevels != MipChain::getFullLevelCount(data.width, data.height))
 	{
-		LOGWARN("(OglRender::loadPNGImage) image '%s' doesn't exist", name.c_str());
-		return nullptr;
-	}
-	//MigUtil::debug("(OglRender::loadPNGImage) image '%s' file size is %d", name.c_str(), len);
-
-	// load the image into a memory buffer
-	byte* pFile = new byte[len];
-	if (AndroidUtil_getAssetBuffer(name, pFile, len) == -1)
-	{
-		LOGWARN("(OglRender::loadPNGImage) image '%s' failed to load", name.c_str());
-		delete [] pFile;
-		return nullptr;
+		LOGWARN("(OglRender::uploadImage) Partial mip chains aren't supported, only the base level is used");
+		mipLevels = 1;
 	}
-
-	// check the header to ensure it's a PNG
-	if (png_sig_cmp(pFile, 0, 8))
+	else if (mipLevels > 1 && !_npotMipmaps && (!isPowerOf2(data.width) || !isPowerOf2(data.height)))
 	{
-		LOGWARN("(OglRender::loadPNGImage) image '%s' does not appear to be a PNG", name.c_str());
-		delete [] pFile;
-		return nullptr;
+		LOGWARN("(OglRender::uploadImage) NPOT textures can't be mipmapped, only the base level is used");
+		mipLevels = 1;
 	}
 
-	// allocate needed structs
-	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
-	if (!png_ptr)
-	{
-		LOGWARN("(OglRender::loadPNGImage) png_create_read_struct() failed");
-		delete [] pFile;
-		return nullptr;
-	}
-	png_infop info_ptr = png_create_info_struct(png_ptr);
-	if (!info_ptr)
-	{
-		LOGWARN("(OglRender::loadPNGImage) png_create_info_struct() failed");
-		png_destroy_read_struct(&png_ptr, (png_infopp)nullptr, (png_infopp)nullptr);
-		delete [] pFile;
-		return nullptr;
-	}
-
-	// init the PNG file IO
-	USER_READ_DATA userReadDataStruct;
-	userReadDataStruct.pFile = pFile;
-	userReadDataStruct.sizeFile = len;
-	userReadDataStruct.currOffset = 0;
-	png_set_read_fn(png_ptr, &userReadDataStruct, userReadData);
-
-	// read the info header
-	png_read_info(png_ptr, info_ptr);
-
-	// transform images to RGBA type (unless greyscale)
-	int colorType = png_get_color_type(png_ptr, info_ptr);
-	if (colorType == PNG_COLOR_TYPE_PALETTE)
-	{
-		png_set_palette_to_rgb(png_ptr);
-		png_set_add_alpha(png_ptr, 0, PNG_FILLER_AFTER);
-	}
-	else if (colorType == PNG_COLOR_TYPE_RGB)
-		png_set_add_alpha(png_ptr, 0, PNG_FILLER_AFTER);
-
-	// add alpha if the transparency is in a tRNS chunk
-	if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
-		png_set_tRNS_to_alpha(png_ptr);
-
-	// expand image data that is less than 8 bits to 8 bits
-	int bitDepth = png_get_bit_depth(png_ptr, info_ptr);
-	if (colorType == PNG_COLOR_TYPE_GRAY && bitDepth < 8)
-		png_set_expand_gray_1_2_4_to_8(png_ptr);
-	else if (bitDepth < 8)
-		png_set_packing(png_ptr);
-
-	// apply the transformations
-	png_read_update_info(png_ptr, info_ptr);
-
-	// re-read header info
-	byte* pData = nullptr;
-	colorType = png_get_color_type(png_ptr, info_ptr);
-	bitDepth = png_get_bit_depth(png_ptr, info_ptr);
-	int channels = png_get_channels(png_ptr, info_ptr);
-	int imageWidth = png_get_image_width(png_ptr, info_ptr);
-	int imageHeight = png_get_image_height(png_ptr, info_ptr);
-	LOGINFO("(OglRender::loadPNGImage) Image=%s, w=%d, h=%d, bits=%d, channels=%d", name.c_str(), imageWidth, imageHeight, bitDepth, channels);
-	if (bitDepth == 8 && channels != 2 && channels != 3)
-	{
-		// allocate image buffer data
-		int row_stride = (channels == 1 ? 1 : 4) * imageWidth;
-		pData = new byte[row_stride*imageHeight];
-		if (pData != nullptr)
-		{
-			// read the PNG
-			png_bytepp row_pointers = new png_bytep[imageHeight];
-			for (int y = 0; y < imageHeight; y++)
-				row_pointers[y] = pData + y*row_stride;
-			png_read_image(png_ptr, row_pointers);
-			delete[] row_pointers;
-
-			// read the end of the PNG (skip the actual data)
-			png_read_end(png_ptr, (png_infop)nullptr);
-
-			// apply image processing
-			if (loadFlags != LOAD_IMAGE_NONE && channels != 1)
-			{
-				int numPixels = imageWidth * imageHeight;
-				for (int i = 0; i < numPixels; i++)
-				{
-					byte alpha;
-					if (loadFlags & LOAD_IMAGE_ADD_ALPHA)
-						alpha = (pData[4 * i + 0] + pData[4 * i + 1] + pData[4 * i + 2]) / 3;
-					else if (loadFlags & LOAD_IMAGE_SET_ALPHA)
-						alpha = 255;
-					else if (loadFlags & LOAD_IMAGE_CLEAR_ALPHA)
-						alpha = 0;
-					else
-						alpha = pData[4 * i + 3];
-					if (loadFlags & LOAD_IMAGE_INVERT_ALPHA)
-						alpha = (255 - alpha);
-					pData[4 * i + 3] = alpha;
-				}
-			}
-
-			// drop color components if so flagged
-			if (loadFlags & LOAD_IMAGE_DROP_COLOR)
-			{
-				int numPixels = imageWidth * imageHeight;
-				byte* pNewData = new byte[numPixels];
-				for (int i = 0; i < numPixels; i++)
-				{
-					pNewData[i] = pData[4 * i + 3];
-				}
-
-				delete [] pData;
-				pData = pNewData;
-			}
-		}
-	}
+	if (data.isCompressed())
+		((OglImage*)img)->loadCompressedTexture(KtxFile::getGLInternalFormat(data), data, mipLevels);
 	else
-	{
-		LOGWARN("(OglRender::loadPNGImage) Unsupported bit depth or channels (%d, %d)", bitDepth, channels);
-	}
-	
-	// clean up
-	png_destroy_read_struct(&png_ptr, (png_infopp)&info_ptr, (png_infopp)nullptr);
-	delete [] pFile;
-
-	// load the data into an Image and return
-	OglImage* newImage = nullptr;
-	if (pData != nullptr)
-	{
-		// create the image object and load
-		newImage = new OglImage();
-		newImage->loadTexture(loadFlags & LOAD_IMAGE_DROP_COLOR ? IMG_FORMAT_ALPHA : IMG_FORMAT_RGBA, imageWidth, imageHeight, pData);
-		delete pData;
-	}
+		((OglImage*)img)->loadTexture(data.format, data.width, data.height, data.pixels, mipLevels);
+}
+
+Image* OglRender::createPendingImage(const std::string& name)
+{
+	OglImage* newImage = new OglImage();
+	_images[name] = newImage;
 	return newImage;
 }
 
-Image* OglRender::loadImage(const std::string& name, const std::string& path, unsigned int loadFlags)
+Image* OglRender::loadNewImage(const std::string& name, const std::string& path, unsigned int loadFlags)
 {
 	// see if the image already exists
-	Image* pi = getImage(name);
+	Image* pi = findImage(name);
 	if (pi != nullptr)
 		return pi;
 
-	OglImage* newImage = nullptr;
-	int findDot = path.rfind(".");
-	if (findDot != string::npos)
-	{
-		std::string ext = path.substr(findDot + 1);
-		if (0 == ext.compare("jpg") ||
-			0 == ext.compare("jpeg"))
-		{
-			newImage = loadJPEGImage(path, loadFlags);
-		}
-		else if (0 == ext.compare("png"))
-		{
-			newImage = loadPNGImage(path, loadFlags);
-		}
-	}
-	if (newImage != nullptr)
-		_images[name] = newImage;
+	ImageData data;
+	if (!decodeImage(path, loadFlags, getOutputSize(), data))
+		return nullptr;
+	AssetLoader::recordImage(path, loadFlags, data);
+
+	// create the image object and load
+	OglImage* newImage = new OglImage();
+	uploadImage(newImage, data);
+	data.release();
+	_images[name] = newImage;
 
 	return newImage;
 }
 
-Image* OglRender::getImage(const std::string& name)
+Image* OglRender::findImage(const std::string& name)
 {
 	std::map<std::string, OglImage*>::const_iterator iter = _images.find(name);
 	if (iter != _images.end() && iter->second != nullptr)
@@ -643,10 +418,10 @@ Image* OglRender::getImage(const std::string& name)
 	return nullptr;
 }
 
-Image* OglRender::createRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint)
+Image* OglRender::createNewRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint)
 {
 	// if the render target already exists, that is considered an error
-	if (getImage(name) != nullptr)
+	if (findImage(name) != nullptr)
 		return nullptr;
 
 	OglRenderTarget* newTarget = new OglRenderTarget();
@@ -660,7 +435,7 @@ Image* OglRender::createRenderTarget(const std::string& name, IMG_FORMAT fmtHint
 	return newTarget;
 }
 
-void OglRender::unloadImage(const std::string& name)
+void OglRender::destroyImage(const std::string& name)
 {
 	std::map<std::string, OglImage*>::iterator iter = _images.find(name);
 	if (iter != _images.end() && iter->second != nullptr)
@@ -685,13 +460,19 @@ void OglRender::setClearColor(const Color& clearCol)
 	_clearColor = clearCol;
 }
 
-void OglRender::setObjectColor(const Color& objCol)
+void OglRender::applyObjectColor(const Color& objCol)
 {
 	_objColor = objCol;
 }
 
-void OglRender::setBlending(BLEND_STATE blend)
+void OglRender::applyBlending(BLEND_STATE blend)
 {
+	bool elided = (_blendState == blend);
+	countStateCall(elided);
+	if (elided)
+		return;
+	_blendState = blend;
+
 	if (blend != BLEND_STATE_NONE)
 	{
 		glEnable(GL_BLEND);
@@ -708,8 +489,17 @@ void OglRender::setBlending(BLEND_STATE blend)
 		glDisable(GL_BLEND);
 }
 
-void OglRender::setDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite)
+void OglRender::applyDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite)
 {
+	// the depth mask is left alone when depth testing is off
+	bool elided = (_depthState == depth && (depth == DEPTH_TEST_STATE_NONE || _depthWrite == (int)enableWrite));
+	countStateCall(elided);
+	if (elided)
+		return;
+	_depthState = depth;
+	if (depth != DEPTH_TEST_STATE_NONE)
+		_depthWrite = enableWrite;
+
 	if (depth != DEPTH_TEST_STATE_NONE)
 	{
 		glEnable(GL_DEPTH_TEST);
@@ -732,6 +522,12 @@ void OglRender::setDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite)
 
 void OglRender::setFaceCulling(FACE_CULLING cull)
 {
+	bool elided = (_cullState == cull);
+	countStateCall(elided);
+	if (elided)
+		return;
+	_cullState = cull;
+
 	if (cull != FACE_CULLING_NONE)
 	{
 		glEnable(GL_CULL_FACE);
@@ -741,31 +537,34 @@ void OglRender::setFaceCulling(FACE_CULLING cull)
 		glDisable(GL_CULL_FACE);
 }
 
-void OglRender::setMiscValue(int index, float value)
+void OglRender::applyMiscValue(int index, float value)
 {
 	if (index < 0 || index > 3)
 		throw std::out_of_range("(OglRender::setMiscValue) Misc index out of bounds");
 	_misc[index] = value;
 }
 
-void OglRender::setAmbientColor(const Color& ambientCol)
+void OglRender::applyAmbientColor(const Color& ambientCol)
 {
 	_ambColor = ambientCol;
+	_lightGen++;
 }
 
-void OglRender::setLightColor(int index, const Color& litCol)
+void OglRender::applyLightColor(int index, const Color& litCol)
 {
 	if (index < 0 || index > 3)
 		throw std::out_of_range("(OglRender::setLightColor) Light index out of bounds");
 	_litColor[index] = litCol;
+	_lightGen++;
 }
 
-void OglRender::setLightDirPos(int index, const Vector3& litDirPos, bool isDir)
+void OglRender::applyLightDirPos(int index, const Vector3& litDirPos, bool isDir)
 {
 	if (index < 0 || index > 3)
 		throw std::out_of_range("(OglRender::setLightDirPos) Light index out of bounds");
 	_litDirPos[index] = litDirPos;
 	_litIsDir[index] = isDir;
+	_lightGen++;
 }
 
 void OglRender::onSuspending()
@@ -854,6 +653,10 @@ void OglRender::postRender(int pass, RenderPass* passObj)
 
 void OglRender::present()
 {
+	// the counters cover one whole frame, all passes included
+	_lastCallsIssued = _callsIssued;
+	_lastCallsElided = _callsElided;
+	_callsIssued = _callsElided = 0;
 }
 
 OglProgram* OglRender::loadProgram(const std::string& vs, const std::string& ps)
@@ -875,9 +678,9 @@ OglProgram* OglRender::loadProgram(const std::string& vs, const std::string& ps)
 
 void OglRender::loadMVPMatrix(GLint location) const
 {
-	OglMatrix mvp = _model;
-	mvp.multiply(&_view);
-	mvp.multiply(&_perspective);
+	Matrix mvp;
+	Matrix::multiply(_model, _view, mvp);
+	mvp.multiply(_perspective);
 	glUniformMatrix4fv(location, 1, GL_FALSE, mvp.getData());
 }
 
@@ -936,3 +739,145 @@ bool OglRender::getLightIsDir(int index) const
 		throw std::out_of_range("(OglRender::getLightIsDir) Light index out of bounds");
 	return _litIsDir[index];
 }
+
+bool OglRender::hasVertexArrays() const
+{
+	return (_glBindVertexArray != nullptr);
+}
+
+GLuint OglRender::createVertexArray()
+{
+	GLuint vao = 0;
+	if (_glGenVertexArrays != nullptr)
+		_glGenVertexArrays(1, &vao);
+	return vao;
+}
+
+void OglRender::bindVertexArray(GLuint vao)
+{
+	if (_glBindVertexArray != nullptr)
+	{
+		bool elided = (_vertexArrayValid && _currVertexArray == vao);
+		countStateCall(elided);
+		if (!elided)
+		{
+			_glBindVertexArray(vao);
+			_currVertexArray = vao;
+			_vertexArrayValid = true;
+		}
+	}
+}
+
+void OglRender::deleteVertexArray(GLuint vao)
+{
+	if (_glDeleteVertexArrays != nullptr && vao != 0)
+	{
+		// deleting the bound vertex array reverts the binding to 0
+		_glDeleteVertexArrays(1, &vao);
+		if (_currVertexArray == vao)
+			_currVertexArray = 0;
+	}
+}
+
+bool OglRender::hasInstancing() const
+{
+	return (_glDrawElementsInstanced != nullptr);
+}
+
+void OglRender::drawElementsInstanced(GLenum mode, GLsizei count, const GLvoid* indices, GLsizei instanceCount)
+{
+	if (_glDrawElementsInstanced == nullptr)
+		throw std::runtime_error("(OglRender::drawElementsInstanced) Instancing not supported");
+	_glDrawElementsInstanced(mode, count, GL_UNSIGNED_SHORT, indices, instanceCount);
+}
+
+void OglRender::vertexAttribDivisor(GLuint index, GLuint divisor)
+{
+	if (_glVertexAttribDivisor != nullptr)
+		_glVertexAttribDivisor(index, divisor);
+}
+
+void OglRender::invalidateStateCache()
+{
+	_currProgram = 0;
+	_currVertexArray = 0;
+	_activeTexUnit = STATE_UNKNOWN;
+	_blendState = STATE_UNKNOWN;
+	_depthState = STATE_UNKNOWN;
+	_depthWrite = STATE_UNKNOWN;
+	_cullState = STATE_UNKNOWN;
+	_programValid = false;
+	_vertexArrayValid = false;
+	for (int i = 0; i < MAX_TEXTURE_MAPS; i++)
+	{
+		_boundTex[i] = 0;
+		_texValid[i] = false;
+	}
+
+	// programs hold on to the generations they last uploaded, so moving them on forces a full upload
+	_modelGen++;
+	_viewGen++;
+	_projGen++;
+	_lightGen++;
+}
+
+void OglRender::useProgram(GLuint program)
+{
+	bool elided = (_programValid && _currProgram == program);
+	countStateCall(elided);
+	if (!elided)
+	{
+		glUseProgram(program);
+		_currProgram = program;
+		_programValid = true;
+	}
+}
+
+void OglRender::bindTexture(int unit, GLuint texture)
+{
+	if (unit < 0 || unit >= MAX_TEXTURE_MAPS)
+		throw std::out_of_range("(OglRender::bindTexture) Texture unit out of bounds");
+
+	bool elided = (_activeTexUnit == unit);
+	countStateCall(elided);
+	if (!elided)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		_activeTexUnit = unit;
+	}
+
+	elided = (_texValid[unit] && _boundTex[unit] == texture);
+	countStateCall(elided);
+	if (!elided)
+	{
+		glBindTexture(GL_TEXTURE_2D, texture);
+		_boundTex[unit] = texture;
+		_texValid[unit] = true;
+	}
+}
+
+// unbinds the texture from any unit it's bound to (used before rendering into it)
+void OglRender::unbindTexture(GLuint texture)
+{
+	for (int i = 0; i < MAX_TEXTURE_MAPS; i++)
+	{
+		if (!_texValid[i] || _boundTex[i] == texture)
+			bindTexture(i, 0);
+	}
+}
+
+// deleted GL names revert to 0 wherever they are bound, and the names can be handed out again
+void OglRender::forgetTexture(GLuint texture)
+{
+	for (int i = 0; i < MAX_TEXTURE_MAPS; i++)
+	{
+		if (_boundTex[i] == texture)
+			_boundTex[i] = 0;
+	}
+}
+
+void OglRender::forgetProgram(GLuint program)
+{
+	if (_currProgram == program)
+		_currProgram = 0;
+}
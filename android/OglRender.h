@@ -10,7 +10,6 @@
 #include "OglShader.h"
 #include "OglProgram.h"
 #include "OglImage.h"
-#include "OglMatrix.h"
 
 namespace MigTech
 {
@@ -21,6 +20,25 @@ namespace MigTech
 		virtual void createDeviceIndependentResources();
 		virtual void createDeviceResources();
 		virtual void createWindowSizeDependentResources();
+		virtual Image* loadNewImage(const std::string& name, const std::string& path, unsigned int loadFlags);
+		virtual Image* createNewRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint);
+		virtual void destroyImage(const std::string& name);
+		virtual Image* findImage(const std::string& name);
+		virtual Image* createPendingImage(const std::string& name);
+
+		virtual void applyProjectionMatrix(const Matrix* pmat);
+		virtual void applyProjectionMatrix(float angleY, float aspect, float nearZ, float farZ, bool useOrientation);
+		virtual void applyViewMatrix(const Matrix* pmat);
+		virtual void applyViewMatrix(Vector3 eyePos, Vector3 focusPos, Vector3 upVector);
+		virtual void applyModelMatrix(const Matrix* pmat);
+		virtual void applyViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer);
+		virtual void applyObjectColor(const Color& objCol);
+		virtual void applyBlending(BLEND_STATE blend);
+		virtual void applyDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite);
+		virtual void applyMiscValue(int index, float value);
+		virtual void applyAmbientColor(const Color& ambientCol);
+		virtual void applyLightColor(int index, const Color& litCol);
+		virtual void applyLightDirPos(int index, const Vector3& litDirPos, bool isDir);
 
 	public:
 		OglRender();
@@ -29,41 +47,22 @@ namespace MigTech
 		virtual bool initRenderer();
 		virtual void termRenderer();
 
-		virtual IMatrix* createMatrix();
-		virtual void deleteMatrix(IMatrix* pmat);
-		virtual void setProjectionMatrix(const IMatrix* pmat);
-		virtual void setProjectionMatrix(float angleY, float aspect, float nearZ, float farZ, bool useOrientation);
-		virtual void setViewMatrix(const IMatrix* pmat);
-		virtual void setViewMatrix(Vector3 eyePos, Vector3 focusPos, Vector3 upVector);
-		virtual void setModelMatrix(const IMatrix* pmat);
-
 		virtual Shader* loadVertexShader(const std::string& name, VDTYPE vdType, unsigned int shaderHints);
 		virtual Shader* loadPixelShader(const std::string& name, unsigned int shaderHints);
 		virtual Shader* getShader(const std::string& name);
 
-		virtual Image* loadImage(const std::string& name, const std::string& path, unsigned int loadFlags);
-		virtual Image* getImage(const std::string& name);
-		virtual Image* createRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint);
-		virtual void unloadImage(const std::string& name);
+		virtual bool decodeImage(const std::string& path, unsigned int loadFlags, const Size& fitSize, ImageData& data);
+		virtual void uploadImage(Image* img, const ImageData& data);
 
 		virtual Object* createObject();
 		virtual void deleteObject(Object* pobj);
 
 		virtual void setOutputSize(Size newSize);
 		virtual Size getOutputSize();
-		virtual void setViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer);
 
 		virtual void setClearColor(const Color& clearCol);
-		virtual void setObjectColor(const Color& objCol);
-		virtual void setBlending(BLEND_STATE blend);
-		virtual void setDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite);
 		virtual void setFaceCulling(FACE_CULLING cull);
 
-		virtual void setMiscValue(int index, float value);
-		virtual void setAmbientColor(const Color& ambientCol);
-		virtual void setLightColor(int index, const Color& litCol);
-		virtual void setLightDirPos(int index, const Vector3& litDirPos, bool isDir);
-
 		virtual void onSuspending();
 		virtual void onResuming();
 
@@ -86,6 +85,61 @@ namespace MigTech
 		const Vector3& getLightDirPos(int index) const;
 		bool getLightIsDir(int index) const;
 
+		// vertex array objects come from GL_OES_vertex_array_object, which not every device has
+		bool hasVertexArrays() const;
+		GLuint createVertexArray();
+		void bindVertexArray(GLuint vao);
+		void deleteVertexArray(GLuint vao);
+
+		// instanced drawing comes from one of the instanced arrays extensions
+		bool hasInstancing() const;
+		void drawElementsInstanced(GLenum mode, GLsizei count, const GLvoid* indices, GLsizei instanceCount);
+		void vertexAttribDivisor(GLuint index, GLuint divisor);
+
+		// shadow state cache, redundant GL state calls are filtered out here
+		void invalidateStateCache();
+		void useProgram(GLuint program);
+		void bindTexture(int unit, GLuint texture);
+		void unbindTexture(GLuint texture);
+		void forgetTexture(GLuint texture);
+		void forgetProgram(GLuint program);
+
+		// uniform generations, bumped whenever the source value changes (programs compare against them)
+		unsigned int getModelGen() const { return _modelGen; }
+		unsigned int getViewGen() const { return _viewGen; }
+		unsigned int getProjGen() const { return _projGen; }
+		unsigned int getLightGen() const { return _lightGen; }
+
+		// state call counters, the getters return the totals for the last presented frame
+		void countStateCall(bool elided) { if (elided) _callsElided++; else _callsIssued++; }
+		unsigned int getCallsIssued() const { return _lastCallsIssued; }
+		unsigned int getCallsElided() const { return _lastCallsElided; }
+
+	protected:
+		// current GL state as far as the cache knows (STATE_UNKNOWN forces the next call through)
+		static const int STATE_UNKNOWN = -1;
+		GLuint _currProgram;
+		GLuint _currVertexArray;
+		int _activeTexUnit;
+		GLuint _boundTex[MAX_TEXTURE_MAPS];
+		int _blendState;
+		int _depthState;
+		int _depthWrite;
+		int _cullState;
+		bool _programValid;
+		bool _vertexArrayValid;
+		bool _texValid[MAX_TEXTURE_MAPS];
+
+		unsigned int _modelGen;
+		unsigned int _viewGen;
+		unsigned int _projGen;
+		unsigned int _lightGen;
+
+		unsigned int _callsIssued;
+		unsigned int _callsElided;
+		unsigned int _lastCallsIssued;
+		unsigned int _lastCallsElided;
+
 	protected:
 		// Cached device properties.
 		Size	_outputSize;
@@ -99,9 +153,9 @@ namespace MigTech
 		bool    _litIsDir[4];
 
 		// Supported matrices
-		OglMatrix _perspective;
-		OglMatrix _view;
-		OglMatrix _model;
+		Matrix _perspective;
+		Matrix _view;
+		Matrix _model;
 
 		// Shader list
 		std::map<std::string, OglShader*> _shaders;
@@ -111,5 +165,17 @@ namespace MigTech
 
 		// Image map list
 		std::map<std::string, OglImage*> _images;
+
+		// Vertex array extension entry points (null if not supported)
+		PFNGLGENVERTEXARRAYSOESPROC _glGenVertexArrays;
+		PFNGLBINDVERTEXARRAYOESPROC _glBindVertexArray;
+		PFNGLDELETEVERTEXARRAYSOESPROC _glDeleteVertexArrays;
+
+		// Instanced arrays extension entry points (null if not supported)
+		PFNGLDRAWELEMENTSINSTANCEDEXTPROC _glDrawElementsInstanced;
+		PFNGLVERTEXATTRIBDIVISOREXTPROC _glVertexAttribDivisor;
+
+		// GLES 2 only mipmaps power of 2 textures unless GL_OES_texture_npot is there
+		bool _npotMipmaps;
 	};
 }
\ No newline at end of file
@@ -2,6 +2,11 @@
 
 #include <stdint.h>
 #include <time.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
 
 #include <string>
 #include <stdexcept>
@@ -0,0 +1,5 @@
+precision mediump float;
+varying vec4 varColor;
+void main() {
+  gl_FragColor = varColor;
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+attribute vec4 vPosition;
+attribute mat4 iModel;
+attribute vec4 iColor;
+uniform mat4 matView;
+uniform mat4 matProj;
+varying vec4 varColor;
+void main() {
+  gl_Position = matProj * matView * iModel * vPosition;
+  varColor = iColor;
+}
\ No newline at end of file
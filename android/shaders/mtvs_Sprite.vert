@@ -0,0 +1,11 @@
+attribute vec4 vPosition;
+attribute vec4 vColor;
+attribute vec2 vTex1;
+uniform mat4 matMVP;
+varying vec2 varTexCoord;
+varying vec4 varColor;
+void main() {
+  gl_Position = matMVP * vPosition;
+  varTexCoord = vTex1;
+  varColor = vColor;
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "AnimList.h"
 #include "Timer.h"
 #include "MigUtil.h"
+#include <algorithm>
 
 using namespace MigTech;
 
@@ -42,46 +43,7 @@ AnimItem::AnimItem(IAnimTarget* target)
 	startTimeTicks = 0;
 	diffVal = 0;
 	useSystemTime = false;
-	paramArray = nullptr;
-	paramArraySize = 0;
-}
-
-AnimItem::AnimItem(const AnimItem& other)
-{
-	*this = other;
-}
-
-AnimItem::~AnimItem()
-{
-	delete[] paramArray;
-}
-
-void AnimItem::operator=(const AnimItem& rhs)
-{
-	startVal = rhs.startVal;
-	endVal = rhs.endVal;
-	duration = rhs.duration;
-	cycle = rhs.cycle;
-	type = rhs.type;
-	optData = rhs.optData;
-	animTarget = rhs.animTarget;
-	animID = rhs.animID;
-	startTimeTicks = rhs.startTimeTicks;
-	diffVal = rhs.diffVal;
-	useSystemTime = rhs.useSystemTime;
-
-	if (rhs.paramArray != nullptr && rhs.paramArraySize > 0)
-	{
-		paramArray = new float[rhs.paramArraySize];
-		for (int i = 0; i < rhs.paramArraySize; i++)
-			paramArray[i] = rhs.paramArray[i];
-		paramArraySize = rhs.paramArraySize;
-	}
-	else
-	{
-		paramArray = nullptr;
-		paramArraySize = 0;
-	}
+	curveID = -1;
 }
 
 void AnimItem::configSimpleAnim(float start, float end, long dur, int ltype)
@@ -116,15 +78,9 @@ void AnimItem::configParametricAnim(float start, float end, long dur, const floa
 	duration = dur;
 	type = ANIM_TYPE_PARAMETRIC;
 
-	if (fParams != nullptr && sizeParams > 0)
-	{
-		paramArray = new float[sizeParams];
-		for (int i = 0; i < sizeParams; i++)
-			paramArray[i] = fParams[i];
-		paramArraySize = sizeParams;
-	}
-	else
+	if (fParams == nullptr || sizeParams <= 0)
 		throw std::invalid_argument("(AnimItem::configParametricAnim) missing parameters");
+	curveID = CurvePool::intern(fParams, sizeParams);
 }
 
 void AnimItem::configParametricAnim(float start, float end, long dur, const float* fParams, int sizeParams, void* opt)
@@ -133,186 +89,333 @@ void AnimItem::configParametricAnim(float start, float end, long dur, const floa
 	optData = opt;
 }
 
+void AnimItem::configParametricAnim(float start, float end, long dur, int curve)
+{
+	startVal = start;
+	endVal = end;
+	duration = dur;
+	type = ANIM_TYPE_PARAMETRIC;
+
+	if (!CurvePool::isValid(curve))
+		throw std::invalid_argument("(AnimItem::configParametricAnim) invalid curve");
+	curveID = curve;
+}
+
+void AnimItem::configParametricAnim(float start, float end, long dur, int curve, void* opt)
+{
+	configParametricAnim(start, end, dur, curve);
+	optData = opt;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// AnimList storage
+
+// handles are made up of the slot and generation
+static const int SLOT_BITS = 16;
+static const int SLOT_MASK = (1 << SLOT_BITS) - 1;
+static const int MAX_GENERATION = 0x7FFF;
+
+static const uint64 ticksPerMilliSecond = Timer::ticksPerSecond / 1000;
+
+// evaluation results
+static const unsigned char EVAL_SKIP = 0;
+static const unsigned char EVAL_FRAME = 1;
+static const unsigned char EVAL_DONE = 2;
+
+void AnimList::AnimGroup::push(const AnimItem& item, int id, uint64 startTime, bool sysTime, uint64 order)
+{
+	startTicks.push_back(startTime);
+	duration.push_back(item.duration);
+	cycle.push_back(item.cycle);
+	startVal.push_back(item.startVal);
+	diffVal.push_back(item.endVal - item.startVal);
+	type.push_back(item.type);
+	useSystemTime.push_back(sysTime);
+	target.push_back(item.animTarget);
+	optData.push_back(item.optData);
+	animID.push_back(id);
+	curveID.push_back(item.curveID);
+	addOrder.push_back(order);
+}
+
+// moves the last item into the given index, the caller fixes up the slot
+void AnimList::AnimGroup::swapRemove(int index)
+{
+	int last = size() - 1;
+	if (index != last)
+	{
+		startTicks[index] = startTicks[last];
+		duration[index] = duration[last];
+		cycle[index] = cycle[last];
+		startVal[index] = startVal[last];
+		diffVal[index] = diffVal[last];
+		type[index] = type[last];
+		useSystemTime[index] = useSystemTime[last];
+		target[index] = target[last];
+		optData[index] = optData[last];
+		animID[index] = animID[last];
+		curveID[index] = curveID[last];
+		addOrder[index] = addOrder[last];
+	}
+
+	startTicks.pop_back();
+	duration.pop_back();
+	cycle.pop_back();
+	startVal.pop_back();
+	diffVal.pop_back();
+	type.pop_back();
+	useSystemTime.pop_back();
+	target.pop_back();
+	optData.pop_back();
+	animID.pop_back();
+	curveID.pop_back();
+	addOrder.pop_back();
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // AnimList
 
 AnimList::AnimList()
 {
-	_newAnimID = 1;
+	_itemCount = 0;
+	_nextAddOrder = 0;
 	_isListProcessing = false;
+	_needsCompact = false;
+}
+
+int AnimList::groupFromType(int type)
+{
+	if (type == AnimItem::ANIM_TYPE_PARAMETRIC)
+		return ANIM_GROUP_PARAMETRIC;
+	if (type == AnimItem::ANIM_TYPE_TIMER || type == AnimItem::ANIM_TYPE_TIMER_INFINITE)
+		return ANIM_GROUP_TIMER;
+	return ANIM_GROUP_LINEAR;
+}
+
+// returns the slot for this ID, or null if the ID is stale
+AnimList::AnimSlot* AnimList::findSlot(int id)
+{
+	int slot = (id & SLOT_MASK) - 1;
+	if (id <= 0 || slot < 0 || slot >= (int)_slots.size())
+		return nullptr;
+	if (_slots[slot].generation != (id >> SLOT_BITS))
+		return nullptr;
+	return &_slots[slot];
 }
 
 // call to add a new animation item
 int AnimList::addItem(AnimItem& newItem, bool useSystemTime)
 {
-	newItem.animID = _newAnimID++;
+	// reuse a free slot if there is one
+	int slot;
+	if (!_freeSlots.empty())
+	{
+		slot = _freeSlots.back();
+		_freeSlots.pop_back();
+	}
+	else
+	{
+		if (_slots.size() >= SLOT_MASK)
+			throw std::runtime_error("(AnimList::addItem) Too many active animations");
+
+		AnimSlot newSlot = { 1, 0, 0 };
+		_slots.push_back(newSlot);
+		slot = _slots.size() - 1;
+	}
+
+	AnimSlot& entry = _slots[slot];
+	newItem.animID = (entry.generation << SLOT_BITS) | (slot + 1);
 	newItem.startTimeTicks = (useSystemTime ? Timer::systemTime() : Timer::gameTime());
 	newItem.diffVal = newItem.endVal - newItem.startVal;
 	newItem.useSystemTime = useSystemTime;
 
-	// if we're in the middle of processing the animation list it's not safe to add it here
-	if (!_isListProcessing)
-		_itemList.push_back(newItem);
-	else
-		_addList.push_back(newItem);
+	// items added while the list is being processed sit past the end and won't run until the next frame
+	AnimGroup& group = _groups[groupFromType(newItem.type)];
+	entry.group = groupFromType(newItem.type);
+	entry.index = group.size();
+	group.push(newItem, newItem.animID, newItem.startTimeTicks, useSystemTime, _nextAddOrder++);
+	_itemCount++;
 
-	//LOGINFO("New animation item added, there are now %d items in the list", itemList.size());
+	//LOGINFO("New animation item added, there are now %d items in the list", _itemCount);
 	return newItem.animID;
 }
 
 // call to remove an existing animation item
 bool AnimList::removeItem(int id)
 {
-	vector<AnimItem>::iterator iter;
-	for (iter = _itemList.begin(); iter != _itemList.end(); iter++)
+	AnimSlot* slot = findSlot(id);
+	if (slot == nullptr)
+		return false;
+
+	AnimGroup& group = _groups[slot->group];
+	int index = slot->index;
+
+	// the ID is dead from here on
+	slot->generation = (slot->generation % MAX_GENERATION) + 1;
+	_freeSlots.push_back(slot - &_slots[0]);
+	_itemCount--;
+
+	// if we're in the middle of processing the animation list it's not safe to move items around
+	if (_isListProcessing)
+	{
+		group.target[index] = nullptr;
+		_needsCompact = true;
+	}
+	else
+	{
+		if (index != group.size() - 1)
+			_slots[(group.animID.back() & SLOT_MASK) - 1].index = index;
+		group.swapRemove(index);
+	}
+	return true;
+}
+
+// removes the items that were released while the list was being processed
+void AnimList::compactGroup(AnimGroup& group)
+{
+	for (int i = group.size() - 1; i >= 0; i--)
 	{
-		if (iter->animID == id)
+		if (group.target[i] == nullptr)
 		{
-			// if we're in the middle of processing the animation list it's not safe to remove it here
-			if (!_isListProcessing)
-				_itemList.erase(iter);
-			else
-				_delList.push_back(id);
-			return true;
+			// everything after this one is still alive
+			if (i != group.size() - 1)
+				_slots[(group.animID.back() & SLOT_MASK) - 1].index = i;
+			group.swapRemove(i);
 		}
 	}
-	return false;
 }
 
-// performs the parametric computation (p must be >= 0 and < 1)
-float AnimList::doParametricFunction(float* vals, int sizeVals, float p)
+// computes the new value for every item in the group without calling out
+void AnimList::evaluateGroup(AnimGroup& group, int count, uint64 gameNow, uint64 sysNow)
 {
-	float step = 1.0f / (sizeVals - 1);
-	//int start = 0;
-	//int end = vals.Length - 1;
-	int start = (int)(p / step);
-	int end = start + 1;
-	float fRet = 0;
-	for (int i = start; i <= end; i++)
+	group.vals.resize(count);
+	group.state.resize(count);
+
+	for (int i = 0; i < count; i++)
 	{
-		float fTemp = (float) (1.0f - fabs(p - step * i) / step);
-		if (fTemp > 0)
-			fRet += fTemp * vals[i];
+		int type = group.type[i];
+		if (group.target[i] == nullptr)
+		{
+			group.state[i] = EVAL_SKIP;
+			continue;
+		}
+
+		// some animation types never end unless explicitly told to do so
+		bool isInfinite = (
+			type == AnimItem::ANIM_TYPE_LINEAR_INFINITE ||
+			type == AnimItem::ANIM_TYPE_LINEAR_INFINITE_BOUNCE ||
+			type == AnimItem::ANIM_TYPE_TIMER_INFINITE);
+
+		// elapsed time for this animation
+		uint64 diffTicks = (group.useSystemTime[i] ? sysNow : gameNow) - group.startTicks[i];
+		long diff = (long)(diffTicks / ticksPerMilliSecond);
+
+		// is this animation done?
+		bool done = (diff >= group.duration[i] && !isInfinite);
+
+		// compute the 0->1 parameter which then computes the actual animated value
+		float param = (done ? 1 : group.cycle[i] * (diff / (float)group.duration[i]));
+		if (param > 1 && !isInfinite)
+			param = param - (int)param;	// in case cycle > 1
+		if (type == AnimItem::ANIM_TYPE_LINEAR_BOUNCE)
+		{
+			// some animation types bounce
+			param = 2 * (param <= 0.5 ? param : 1 - param);
+		}
+		else if (type == AnimItem::ANIM_TYPE_LINEAR_INFINITE_BOUNCE)
+		{
+			// some animation types bounce
+			param = param - (int)param;
+			param = 2 * (param <= 0.5 ? param : 1 - param);
+		}
+		else if (type == AnimItem::ANIM_TYPE_PARAMETRIC)
+		{
+			// pass this through the curve's sample table
+			if (!done)
+				param = CurvePool::evaluate(group.curveID[i], param);
+			else
+				param = CurvePool::lastValue(group.curveID[i]);
+		}
+		group.vals[i] = group.startVal[i] + param * group.diffVal[i];
+
+		// the timer only calls doFrame() when complete
+		bool isTimer = (type == AnimItem::ANIM_TYPE_TIMER || type == AnimItem::ANIM_TYPE_TIMER_INFINITE);
+		if (done)
+			group.state[i] = EVAL_DONE;
+		else if (!isTimer || param >= 1)
+			group.state[i] = EVAL_FRAME;
+		else
+			group.state[i] = EVAL_SKIP;
 	}
+}
 
-	//LOGINFO("doParametricFunction() returning %f (fParam is %f, step is %f)", fRet, p, step);
-	return fRet;
+// hands the computed value to the target
+void AnimList::dispatchItem(AnimGroup& group, int i, uint64 gameNow, uint64 sysNow)
+{
+	// an earlier callback may have removed this item
+	IAnimTarget* target = group.target[i];
+	if (target == nullptr)
+		return;
+
+	int id = group.animID[i];
+	void* optData = group.optData[i];
+	bool remove = !target->doFrame(id, group.vals[i], optData);
+	if (remove || group.state[i] == EVAL_DONE)
+	{
+		// signal that this animation is done
+		target->animComplete(id, optData);
+
+		// remove this animation from the list because it's done
+		removeItem(id);
+	}
+	else if (group.type[i] == AnimItem::ANIM_TYPE_TIMER_INFINITE && group.target[i] != nullptr)
+	{
+		// reset the timer animation type
+		group.startTicks[i] = (group.useSystemTime[i] ? sysNow : gameNow);
+	}
 }
 
-// called by GameScreen to process all active animations
+// called by MigGame to process all active animations
 bool AnimList::doAnimations()
 {
 	// starting list processing
 	_isListProcessing = true;
 
-	// cycle through the list and do each animation, note it's backwards to make removal easy
-	vector<AnimItem>::iterator iter = _itemList.begin();
-	for ( ; iter != _itemList.end(); )
-	{
-		// do not process any animation items that have been added to the delete list
-		bool isOk = true;
-		if (!_delList.empty())
-		{
-			std::vector<int>::const_iterator delIter = _delList.begin();
-			while (delIter != _delList.end() && isOk)
-			{
-				if (*delIter == iter->animID)
-					isOk = false;
-				delIter++;
-			}
-		}
+	// one time sample for the whole frame
+	uint64 gameNow = Timer::gameTime();
+	uint64 sysNow = Timer::systemTime();
 
-		bool needToIter = true;
-		if (isOk)
+	// compute every value first, then make the callbacks, anything added in a callback waits for the next frame
+	_dispatch.clear();
+	for (int g = 0; g < ANIM_GROUP_COUNT; g++)
+	{
+		AnimGroup& group = _groups[g];
+		int count = group.size();
+		evaluateGroup(group, count, gameNow, sysNow);
+		for (int i = 0; i < count; i++)
 		{
-			// some animation types never end unless explicitly told to do so
-			bool isInfinite = (
-				iter->type == AnimItem::ANIM_TYPE_LINEAR_INFINITE ||
-				iter->type == AnimItem::ANIM_TYPE_LINEAR_INFINITE_BOUNCE ||
-				iter->type == AnimItem::ANIM_TYPE_TIMER_INFINITE);
-
-			// and some animation types are just timers
-			bool isTimer = (
-				iter->type == AnimItem::ANIM_TYPE_TIMER ||
-				iter->type == AnimItem::ANIM_TYPE_TIMER_INFINITE);
-
-			// elapsed time for this animation
-			uint64 diffTicks = (iter->useSystemTime ? Timer::systemTime() : Timer::gameTime()) - iter->startTimeTicks;
-			long diff = Timer::ticksToMilliSeconds(diffTicks);
-
-			// is this animation done?
-			bool done = (diff >= iter->duration && !isInfinite);
-
-			// compute the 0->1 parameter which then computes the actual animated value
-			float param = (done ? 1 : iter->cycle * (diff / (float)iter->duration));
-			if (param > 1 && !isInfinite)
-				param = param - (int)param;	// in case cycle > 1
-			if (iter->type == AnimItem::ANIM_TYPE_LINEAR_BOUNCE)
-			{
-				// some animation types bounce
-				param = 2 * (param <= 0.5 ? param : 1 - param);
-			}
-			else if (iter->type == AnimItem::ANIM_TYPE_LINEAR_INFINITE_BOUNCE)
+			if (group.state[i] != EVAL_SKIP)
 			{
-				// some animation types bounce
-				param = param - (int)param;
-				param = 2 * (param <= 0.5 ? param : 1 - param);
-			}
-			else if (iter->type == AnimItem::ANIM_TYPE_PARAMETRIC)
-			{
-				// pass this through a parametric function
-				if (!done)
-					param = doParametricFunction(iter->paramArray, iter->paramArraySize, param);
-				else
-					param = iter->paramArray[iter->paramArraySize - 1];
-			}
-			float val = iter->startVal + param * iter->diffVal;
-
-			// the timer only calls doFrame() when complete
-			if (!isTimer || done || param >= 1)
-			{
-				bool remove = !iter->animTarget->doFrame(iter->animID, val, iter->optData);
-				if (remove || done)
-				{
-					// signal that this animation is done
-					iter->animTarget->animComplete(iter->animID, iter->optData);
-
-					// remove this animation from the list because it's done
-					iter = _itemList.erase(iter);
-					needToIter = false;
-					//LOGINFO("Removed animation item, there are now %d items remaining", mItemList.size());
-				}
-				else if (iter->type == AnimItem::ANIM_TYPE_TIMER_INFINITE)
-				{
-					// reset the timer animation type
-					iter->startTimeTicks = (iter->useSystemTime ? Timer::systemTime() : Timer::gameTime());
-				}
+				AnimDispatch item = { group.addOrder[i], g, i };
+				_dispatch.push_back(item);
 			}
 		}
-
-		if (needToIter)
-			++iter;
 	}
 
+	// the callbacks go out in the order the animations were added, completion handlers can depend on it
+	std::sort(_dispatch.begin(), _dispatch.end());
+	for (size_t d = 0; d < _dispatch.size(); d++)
+		dispatchItem(_groups[_dispatch[d].group], _dispatch[d].index, gameNow, sysNow);
+
 	// list processing is complete
 	_isListProcessing = false;
 
-	// remove any queued items
-	int nItems = _delList.size();
-	if (nItems > 0)
-	{
-		for (int n = 0; n < nItems; n++)
-			removeItem(_delList[n]);
-		_delList.clear();
-	}
-
-	// add any queued items
-	nItems = _addList.size();
-	if (nItems > 0)
+	// remove any items that were released during processing
+	if (_needsCompact)
 	{
-		for (int n = 0; n < nItems; n++)
-			_itemList.push_back(_addList[n]);
-		_addList.clear();
+		for (int g = 0; g < ANIM_GROUP_COUNT; g++)
+			compactGroup(_groups[g]);
+		_needsCompact = false;
 	}
 
 	return true;
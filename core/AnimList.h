@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include <vector>
+#include "CurvePool.h"
 using namespace std;
 
 namespace MigTech
@@ -68,16 +69,11 @@ namespace MigTech
 		float diffVal;
 		bool useSystemTime;
 
-		// parametric only
-		float* paramArray;
-		int paramArraySize;
+		// parametric only, see CurvePool
+		int curveID;
 
 	public:
 		AnimItem(IAnimTarget* target);
-		AnimItem(const AnimItem& other);
-		~AnimItem();
-
-		void operator=(const AnimItem& rhs);
 
 		void configSimpleAnim(float start, float end, long dur, int ltype);
 		void configSimpleAnim(float start, float end, long dur, int ltype, void* opt);
@@ -85,24 +81,84 @@ namespace MigTech
 		void configTimer(long dur, bool isInfinite, void* opt);
 		void configParametricAnim(float start, float end, long dur, const float* fParams, int sizeParams);
 		void configParametricAnim(float start, float end, long dur, const float* fParams, int sizeParams, void* opt);
+		void configParametricAnim(float start, float end, long dur, int curve);
+		void configParametricAnim(float start, float end, long dur, int curve, void* opt);
 	};
 
+	// animation IDs are handles, the low 16 bits are the slot (plus one) and the rest is
+	//  the slot generation, so a stale ID never matches a newer animation in the same slot
 	class AnimList
 	{
 	private:
-		// the master list of active animations
-		vector<AnimItem> _itemList;
-
-		// used to cache items to add/remove
-		vector<AnimItem> _addList;
-		vector<int> _delList;
+		// animations are grouped by how they're evaluated
+		enum AnimGroupType
+		{
+			ANIM_GROUP_LINEAR,
+			ANIM_GROUP_PARAMETRIC,
+			ANIM_GROUP_TIMER,
+			ANIM_GROUP_COUNT
+		};
+
+		// packed struct-of-arrays storage for one group of animations
+		struct AnimGroup
+		{
+			vector<uint64> startTicks;
+			vector<long> duration;
+			vector<long> cycle;
+			vector<float> startVal;
+			vector<float> diffVal;
+			vector<int> type;
+			vector<bool> useSystemTime;
+			vector<IAnimTarget*> target;
+			vector<void*> optData;
+			vector<int> animID;
+			vector<int> curveID;
+			vector<uint64> addOrder;
+
+			// evaluation results, filled in before any callbacks are made
+			vector<float> vals;
+			vector<unsigned char> state;
+
+			int size() const { return (int)animID.size(); }
+			void push(const AnimItem& item, int id, uint64 startTime, bool sysTime, uint64 order);
+			void swapRemove(int index);
+		};
+
+		// maps an animation ID to where it lives
+		struct AnimSlot
+		{
+			int generation;
+			int group;
+			int index;
+		};
+
+		// an item that has a callback due this frame
+		struct AnimDispatch
+		{
+			uint64 addOrder;
+			int group;
+			int index;
+
+			bool operator<(const AnimDispatch& rhs) const { return addOrder < rhs.addOrder; }
+		};
+
+		AnimGroup _groups[ANIM_GROUP_COUNT];
+		vector<AnimDispatch> _dispatch;
+		uint64 _nextAddOrder;
+		vector<AnimSlot> _slots;
+		vector<int> _freeSlots;
+		int _itemCount;
+
+		// removals while the list is being processed are compacted afterwards
 		bool _isListProcessing;
-
-		// tracks the next animation ID to return
-		int _newAnimID;
+		bool _needsCompact;
 
 	private:
-		float doParametricFunction(float* vals, int sizeVals, float p);
+		static int groupFromType(int type);
+		AnimSlot* findSlot(int id);
+		void evaluateGroup(AnimGroup& group, int count, uint64 gameNow, uint64 sysNow);
+		void dispatchItem(AnimGroup& group, int index, uint64 gameNow, uint64 sysNow);
+		void compactGroup(AnimGroup& group);
 
 	public:
 		AnimList();
@@ -113,7 +169,11 @@ namespace MigTech
 		// call to remove an existing animation item
 		bool removeItem(int id);
 
-		// called by MigGame to process all active animations
+		// called by MigGame to process all active animations, callbacks are made in the order the
+		//  animations were added regardless of which group they're stored in
 		bool doAnimations();
+
+		// number of active animations
+		int getItemCount() const { return _itemCount; }
 	};
 }
\ No newline at end of file
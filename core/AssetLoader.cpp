@@ -0,0 +1,338 @@
+﻿#include "pch.h"
+#include "AssetLoader.h"
+#include "MigUtil.h"
+#include "Timer.h"
+#include "Profiler.h"
+#include "PersistBase.h"
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+using namespace MigTech;
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+extern uint64 plat_getRawTicks();
+
+///////////////////////////////////////////////////////////////////////////
+// load jobs
+
+enum LoadJobType
+{
+	LOAD_JOB_IMAGE,
+	LOAD_JOB_DOCUMENT
+};
+
+struct LoadJob
+{
+	// filled in by the requester
+	LoadJobType type;
+	Image* image;
+	unsigned int ticket;
+	std::string name;
+	std::string path;
+	unsigned int loadFlags;
+	Size fitSize;
+
+	// filled in by the worker
+	ImageData data;
+	tinyxml2::XMLDocument* doc;
+	bool success;
+
+	// completion list link
+	LoadJob* next;
+};
+
+// decode requests, shared by the workers
+static std::deque<LoadJob*> jobQueue;
+static std::mutex jobLock;
+static std::condition_variable jobSignal;
+static bool stopWorkers = false;
+
+// decoded jobs, pushed by the workers w/o locking and drained by the render thread
+static std::atomic<LoadJob*> completedJobs(nullptr);
+
+// drained jobs waiting for upload (render thread only)
+static std::deque<LoadJob*> uploadQueue;
+
+static std::vector<std::thread> workers;
+static std::atomic<int> pendingCount(0);
+static unsigned int nextTicket = 1;
+
+// image totals (render thread only)
+static AssetLoaderStats loaderStats;
+
+uint64 AssetLoader::uploadBudget = 0;
+
+static void pushCompleted(LoadJob* job)
+{
+	job->next = completedJobs.load(std::memory_order_relaxed);
+	while (!completedJobs.compare_exchange_weak(job->next, job, std::memory_order_release, std::memory_order_relaxed))
+		;
+}
+
+static void queueJob(LoadJob* job)
+{
+	pendingCount++;
+	{
+		std::lock_guard<std::mutex> lock(jobLock);
+		jobQueue.push_back(job);
+	}
+	jobSignal.notify_one();
+}
+
+static void deleteJob(LoadJob* job)
+{
+	job->data.release();
+	if (job->doc != nullptr)
+		delete job->doc;
+	delete job;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// static interface
+
+void AssetLoader::init(int numThreads, long budgetMicros)
+{
+	if (!workers.empty())
+		return;
+
+	uploadBudget = (uint64)budgetMicros * (Timer::ticksPerSecond / 1000000);
+	stopWorkers = false;
+	for (int i = 0; i < numThreads; i++)
+		workers.push_back(std::thread(workerThread));
+
+	LOGINFO("(AssetLoader::init) %d loader threads, upload budget is %ld us", numThreads, budgetMicros);
+}
+
+void AssetLoader::term()
+{
+	if (workers.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(jobLock);
+		stopWorkers = true;
+	}
+	jobSignal.notify_all();
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+	workers.clear();
+
+	// anything that didn't make it is abandoned, the images stay pending
+	while (!jobQueue.empty())
+	{
+		deleteJob(jobQueue.front());
+		jobQueue.pop_front();
+	}
+	LoadJob* job = completedJobs.exchange(nullptr);
+	while (job != nullptr)
+	{
+		LoadJob* next = job->next;
+		deleteJob(job);
+		job = next;
+	}
+	while (!uploadQueue.empty())
+	{
+		deleteJob(uploadQueue.front());
+		uploadQueue.pop_front();
+	}
+	pendingCount = 0;
+
+	// documents that will now never arrive
+	XMLDocFactory::clearPrefetched();
+}
+
+bool AssetLoader::isRunning()
+{
+	return !workers.empty();
+}
+
+void AssetLoader::queueImage(Image* img, const std::string& name, const std::string& path, unsigned int loadFlags)
+{
+	img->_loadState = IMAGE_LOAD_PENDING;
+	img->_loadTicket = nextTicket++;
+
+	// the output size is taken now, the workers can't ask the renderer for it
+	Size fitSize = MigUtil::theRend->getOutputSize();
+
+	// w/o any workers the image is loaded right away
+	if (workers.empty())
+	{
+		ImageData data;
+		bool success = MigUtil::theRend->decodeImage(path, loadFlags, fitSize, data);
+		finishImage(img, name, path, loadFlags, data, success);
+		return;
+	}
+
+	LoadJob* job = new LoadJob();
+	job->type = LOAD_JOB_IMAGE;
+	job->image = img;
+	job->ticket = img->_loadTicket;
+	job->name = name;
+	job->path = path;
+	job->loadFlags = loadFlags;
+	job->fitSize = fitSize;
+	job->doc = nullptr;
+	job->success = false;
+	job->next = nullptr;
+	queueJob(job);
+}
+
+void AssetLoader::queueDocument(const std::string& path)
+{
+	if (workers.empty())
+	{
+		XMLDocFactory::addPrefetched(path, XMLDocFactory::parseDocument(path));
+		return;
+	}
+
+	LoadJob* job = new LoadJob();
+	job->type = LOAD_JOB_DOCUMENT;
+	job->image = nullptr;
+	job->ticket = 0;
+	job->path = path;
+	job->loadFlags = 0;
+	job->doc = nullptr;
+	job->success = false;
+	job->next = nullptr;
+	queueJob(job);
+}
+
+void AssetLoader::update()
+{
+	// take everything the workers have finished, the list comes back newest first
+	LoadJob* job = completedJobs.exchange(nullptr, std::memory_order_acquire);
+	LoadJob* ordered = nullptr;
+	while (job != nullptr)
+	{
+		LoadJob* next = job->next;
+		job->next = ordered;
+		ordered = job;
+		job = next;
+	}
+	while (ordered != nullptr)
+	{
+		uploadQueue.push_back(ordered);
+		ordered = ordered->next;
+	}
+
+	// always upload at least one so a big image can't stall the queue
+	uint64 startTime = plat_getRawTicks();
+	while (!uploadQueue.empty())
+	{
+		job = uploadQueue.front();
+		uploadQueue.pop_front();
+		pendingCount--;
+
+		if (job->type == LOAD_JOB_DOCUMENT)
+		{
+			// the factory takes the document over
+			XMLDocFactory::addPrefetched(job->path, job->doc);
+			job->doc = nullptr;
+		}
+		else
+		{
+			// the image may have been unloaded (or unloaded and reloaded) while it was decoding
+			Image* img = MigUtil::theRend->getImage(job->name);
+			if (img == job->image && img->_loadTicket == job->ticket && img->_loadState == IMAGE_LOAD_PENDING)
+				finishImage(img, job->name, job->path, job->loadFlags, job->data, job->success);
+		}
+		deleteJob(job);
+
+		if (plat_getRawTicks() - startTime >= uploadBudget)
+			break;
+	}
+}
+
+int AssetLoader::getPendingCount()
+{
+	return pendingCount;
+}
+
+void AssetLoader::recordImage(const std::string& path, unsigned int loadFlags, const ImageData& data)
+{
+	loaderStats.imagesLoaded++;
+	if ((loadFlags & LOAD_IMAGE_FIT_OUTPUT) && !data.isCompressed() && data.decodeScale <= 8)
+	{
+		int bucket = 0;
+		while ((1 << bucket) < data.decodeScale)
+			bucket++;
+		loaderStats.fitScales[bucket]++;
+		loaderStats.pixelsSkipped += (uint64)data.width * data.height * (data.decodeScale * data.decodeScale - 1);
+		if (data.decodeScale > 1)
+			LOGINFO("(AssetLoader::recordImage) '%s' was decoded at 1/%d size (%dx%d)", path.c_str(), data.decodeScale, data.width, data.height);
+	}
+}
+
+void AssetLoader::getStats(AssetLoaderStats& stats)
+{
+	stats = loaderStats;
+}
+
+void AssetLoader::resetStats()
+{
+	memset(&loaderStats, 0, sizeof(loaderStats));
+}
+
+void AssetLoader::finishImage(Image* img, const std::string& name, const std::string& path, unsigned int loadFlags, ImageData& data, bool success)
+{
+	PROFILE_ZONE("image upload");
+
+	// failed images stay registered so their owners can unload them like any other
+	if (success)
+	{
+		recordImage(path, loadFlags, data);
+		MigUtil::theRend->uploadImage(img, data);
+		img->_loadState = IMAGE_LOAD_READY;
+	}
+	else
+	{
+		LOGWARN("(AssetLoader::finishImage) Could not load image '%s'", name.c_str());
+		img->_loadState = IMAGE_LOAD_FAILED;
+	}
+	data.release();
+
+	// a callback is allowed to unload the image
+	std::vector<IImageLoadCallback*> callbacks;
+	callbacks.swap(img->_callbacks);
+	for (size_t i = 0; i < callbacks.size(); i++)
+	{
+		if (callbacks[i] != nullptr)
+			callbacks[i]->imageLoaded(name, img, success);
+	}
+}
+
+void AssetLoader::workerThread()
+{
+	while (true)
+	{
+		LoadJob* job = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(jobLock);
+			jobSignal.wait(lock, [] { return (stopWorkers || !jobQueue.empty()); });
+			if (stopWorkers)
+				break;
+
+			job = jobQueue.front();
+			jobQueue.pop_front();
+		}
+
+		if (job->type == LOAD_JOB_DOCUMENT)
+		{
+			PROFILE_ZONE("document parse");
+			job->doc = XMLDocFactory::parseDocument(job->path);
+			job->success = (job->doc != nullptr);
+		}
+		else
+		{
+			PROFILE_ZONE("image decode");
+			job->success = MigUtil::theRend->decodeImage(job->path, job->loadFlags, job->fitSize, job->data);
+		}
+		pushCompleted(job);
+	}
+}
@@ -0,0 +1,50 @@
+﻿#pragma once
+
+#include "MigDefines.h"
+#include "Image.h"
+
+namespace MigTech
+{
+	// image totals since the last reset, synchronous loads are counted too
+	struct AssetLoaderStats
+	{
+		int imagesLoaded;
+		int fitScales[4];		// LOAD_IMAGE_FIT_OUTPUT JPEGs decoded at 1/1, 1/2, 1/4 and 1/8 size
+		uint64 pixelsSkipped;	// source pixels the scaling never decoded (roughly)
+	};
+
+	// background asset loader, images are decoded on worker threads and uploaded on the render thread
+	class AssetLoader
+	{
+	private:
+		// upload time allowed per frame
+		static uint64 uploadBudget;
+
+	public:
+		// static interface, used by Game class
+		static void init(int numThreads, long budgetMicros);
+		static void term();
+		static bool isRunning();
+
+		// uploads decoded images until the frame's budget runs out
+		static void update();
+
+		// used by RenderBase, the image must already be registered as pending
+		static void queueImage(Image* img, const std::string& name, const std::string& path, unsigned int loadFlags);
+
+		// used by XMLDocFactory, the parsed document is handed back through addPrefetched()
+		static void queueDocument(const std::string& path);
+
+		// number of images decoding or waiting for upload
+		static int getPendingCount();
+
+		// the renderers record the images they load directly
+		static void recordImage(const std::string& path, unsigned int loadFlags, const ImageData& data);
+		static void getStats(AssetLoaderStats& stats);
+		static void resetStats();
+
+	private:
+		static void finishImage(Image* img, const std::string& name, const std::string& path, unsigned int loadFlags, ImageData& data, bool success);
+		static void workerThread();
+	};
+}
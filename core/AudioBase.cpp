@@ -1,6 +1,7 @@
 ﻿#include "pch.h"
 #include "AudioBase.h"
 #include "MigUtil.h"
+#include "ResourceCache.h"
 
 using namespace MigTech;
 
@@ -8,17 +9,23 @@ SoundCache::SoundCache()
 {
 }
 
+// the effects are shared with other caches through ResourceCache
+static std::string soundFileName(const std::string& name)
+{
+	std::string lname = name;
+	if (lname.find(".wav") == std::string::npos)
+		lname += ".wav";
+	return lname;
+}
+
 SoundCache::~SoundCache()
 {
-	if (MigUtil::theAudio != nullptr)
+	std::map<std::string, SoundEffect*>::iterator iter = _sounds.begin();
+	while (iter != _sounds.end())
 	{
-		std::map<std::string, SoundEffect*>::iterator iter = _sounds.begin();
-		while (iter != _sounds.end())
-		{
-			if (iter->second != nullptr)
-				MigUtil::theAudio->deleteMedia(iter->second);
-			iter++;
-		}
+		if (iter->second != nullptr)
+			ResourceCache::unloadSound(soundFileName(iter->first));
+		iter++;
 	}
 }
 
@@ -29,10 +36,8 @@ bool SoundCache::loadSound(const std::string& name)
 
 	if (MigUtil::theAudio != nullptr)
 	{
-		std::string lname = name;
-		if (lname.find(".wav") == std::string::npos)
-			lname += ".wav";
-		SoundEffect* peff = MigUtil::theAudio->loadMedia(lname, AudioBase::AUDIO_CHANNEL_SOUND);
+		std::string lname = soundFileName(name);
+		SoundEffect* peff = ResourceCache::loadSound(lname);
 		if (peff != nullptr)
 		{
 			_sounds[name] = peff;
@@ -52,12 +52,12 @@ BgBase* BgBase::loadHandlerFromXML(tinyxml2::XMLElement* xml)
 // base class for background handler
 
 BgBase::BgBase()
-	: _screenPoly(nullptr), _isVisible(true), _isOpaque(true)
+	: _bgImage(nullptr), _screenPoly(nullptr), _isVisible(true), _isOpaque(true)
 {
 }
 
 BgBase::BgBase(const std::string& bgResID)
-	: _screenPoly(nullptr), _isVisible(true), _isOpaque(true)
+	: _bgImage(nullptr), _screenPoly(nullptr), _isVisible(true), _isOpaque(true)
 {
 	init(bgResID);
 }
@@ -76,8 +76,9 @@ void BgBase::createGraphics()
 {
 	if (_screenPoly == nullptr && _bgResID.length() > 0)
 	{
-		// load the texture map
-		if (MigUtil::theRend->loadImage(_bgResID, _bgResID, LOAD_IMAGE_NONE) != nullptr)
+		// load the texture map in the background, the background isn't drawn until it's ready (no bigger than the screen needs)
+		_bgImage = MigUtil::theRend->loadImageAsync(_bgResID, _bgResID, LOAD_IMAGE_FIT_OUTPUT);
+		if (_bgImage != nullptr)
 		{
 			// create the texture object and assign the shaders
 			Object* txtObj = MigUtil::theRend->createObject();
@@ -117,6 +118,7 @@ void BgBase::destroyGraphics()
 		MigUtil::theRend->deleteObject(_screenPoly);
 	_screenPoly = nullptr;
 	MigUtil::theRend->unloadImage(_bgResID);
+	_bgImage = nullptr;
 }
 
 void BgBase::update()
@@ -125,7 +127,7 @@ void BgBase::update()
 
 void BgBase::render() const
 {
-	if (_screenPoly && _isVisible)
+	if (_screenPoly && _isVisible && (_bgImage == nullptr || _bgImage->isReady()))
 	{
 		//MigUtil::theRend->setModelMatrix(nullptr);
 		//MigUtil::theRend->setViewMatrix(nullptr);
@@ -142,12 +144,12 @@ void BgBase::render() const
 ///////////////////////////////////////////////////////////////////////////
 // background handler that cycles through 2 images
 
-CycleBg::CycleBg() : _screenPoly2(nullptr)
+CycleBg::CycleBg() : _bgImage2(nullptr), _screenPoly2(nullptr)
 {
 	_colOther = colWhite;
 }
 
-CycleBg::CycleBg(const std::string& image1, const std::string& image2, long duration) : _screenPoly2(nullptr)
+CycleBg::CycleBg(const std::string& image1, const std::string& image2, long duration) : _bgImage2(nullptr), _screenPoly2(nullptr)
 {
 	_colOther = colWhite;
 	init(image1, image2, duration);
@@ -182,7 +184,8 @@ void CycleBg::createGraphics()
 	if (!_bgRes2ID.empty() && _screenPoly2 == nullptr)
 	{
 		// load the texture map (set alpha to full in case it's empty since we'll need blending)
-		if (MigUtil::theRend->loadImage(_bgRes2ID, _bgRes2ID, LOAD_IMAGE_SET_ALPHA) != nullptr)
+		_bgImage2 = MigUtil::theRend->loadImageAsync(_bgRes2ID, _bgRes2ID, LOAD_IMAGE_SET_ALPHA | LOAD_IMAGE_FIT_OUTPUT);
+		if (_bgImage2 != nullptr)
 		{
 			// create the texture object and assign the shaders
 			Object* txtObj = MigUtil::theRend->createObject();
@@ -224,6 +227,7 @@ void CycleBg::destroyGraphics()
 		MigUtil::theRend->deleteObject(_screenPoly2);
 	_screenPoly2 = nullptr;
 	MigUtil::theRend->unloadImage(_bgRes2ID);
+	_bgImage2 = nullptr;
 }
 
 void CycleBg::destroy()
@@ -237,7 +241,7 @@ void CycleBg::render() const
 {
 	BgBase::render();
 
-	if (_screenPoly2 && _isVisible)
+	if (_screenPoly2 && _isVisible && (_bgImage2 == nullptr || _bgImage2->isReady()))
 	{
 		MigUtil::theRend->setObjectColor(_colOther);
 		MigUtil::theRend->setBlending(BLEND_STATE_SRC_ALPHA);
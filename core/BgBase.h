@@ -1,9 +1,10 @@
 ﻿#pragma once
 
-#include "tinyxml\tinyxml2.h"
+#include "tinyxml/tinyxml2.h"
 
 #include "MigBase.h"
 #include "Object.h"
+#include "Image.h"
 #include "AnimList.h"
 
 namespace MigTech
@@ -32,6 +33,7 @@ namespace MigTech
 
 	protected:
 		std::string _bgResID;
+		Image* _bgImage;
 		Object* _screenPoly;
 		bool _isVisible;
 		bool _isOpaque;
@@ -58,6 +60,7 @@ namespace MigTech
 
 	protected:
 		std::string _bgRes2ID;
+		Image* _bgImage2;
 		Object* _screenPoly2;
 		Color _colOther;
 		AnimID _idAnim;
@@ -297,9 +297,8 @@ void TextButton::draw(float alpha, const Matrix& worldMatrix) const
 {
 	if (isVisible() && _text != nullptr)
 	{
-		static Matrix newMat;
-		newMat.copy(_mat);
-		newMat.multiply(worldMatrix);
+		Matrix newMat;
+		Matrix::multiply(_mat, worldMatrix, newMat);
 
 		Color drawColor = getDrawColor();
 		_text->draw(drawColor.r, drawColor.g, drawColor.b, drawColor.a * alpha, newMat);
@@ -370,9 +369,8 @@ void PicButton::draw(float alpha, const Matrix& worldMatrix) const
 {
 	if (isVisible())
 	{
-		static Matrix newMat;
-		newMat.copy(_mat);
-		newMat.multiply(worldMatrix);
+		Matrix newMat;
+		Matrix::multiply(_mat, worldMatrix, newMat);
 
 		_mc.draw(newMat, false, alpha);
 	}
@@ -430,9 +428,8 @@ void PicTextButton::draw(float alpha, const Matrix& worldMatrix) const
 	PicButton::draw(alpha, worldMatrix);
 	if (isVisible() && _text != nullptr)
 	{
-		static Matrix newMat;
-		newMat.copy(_mat);
-		newMat.multiply(worldMatrix);
+		Matrix newMat;
+		Matrix::multiply(_mat, worldMatrix, newMat);
 
 		Color drawColor = getDrawColor();
 		_text->draw(drawColor.r, drawColor.g, drawColor.b, drawColor.a * alpha, newMat);
@@ -0,0 +1,105 @@
+﻿#include "pch.h"
+#include "CurvePool.h"
+#include "MigUtil.h"
+
+using namespace MigTech;
+
+// samples used for the built-in curves
+static const int BUILTIN_SAMPLES = 33;
+
+std::vector<CurvePool::Curve> CurvePool::curveList;
+std::vector<float> CurvePool::sampleList;
+std::multimap<unsigned int, int> CurvePool::curveLookup;
+
+// FNV-1a over the sample bits
+static unsigned int hashSamples(const float* samples, int count)
+{
+	unsigned int hash = 2166136261u;
+	const byte* data = (const byte*)samples;
+	for (size_t i = 0; i < count * sizeof(float); i++)
+	{
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static float builtinFunction(int curveID, float t)
+{
+	switch (curveID)
+	{
+	case CURVE_EASE_IN:
+		return t * t;
+	case CURVE_EASE_OUT:
+		return 1 - (1 - t) * (1 - t);
+	case CURVE_EASE_IN_OUT:
+		return t * t * (3 - 2 * t);
+	case CURVE_EASE_OUT_BACK:
+	{
+		const float c1 = 1.70158f;
+		const float c3 = c1 + 1;
+		return 1 + c3 * (t - 1) * (t - 1) * (t - 1) + c1 * (t - 1) * (t - 1);
+	}
+	case CURVE_ARC:
+		return sinf(MigUtil::convertToRadians(180) * t);
+	}
+	return t;
+}
+
+void CurvePool::addBuiltins()
+{
+	float samples[BUILTIN_SAMPLES];
+	for (int curveID = 0; curveID < CURVE_BUILTIN_COUNT; curveID++)
+	{
+		for (int i = 0; i < BUILTIN_SAMPLES; i++)
+			samples[i] = builtinFunction(curveID, i / (float)(BUILTIN_SAMPLES - 1));
+		addCurve(samples, BUILTIN_SAMPLES, hashSamples(samples, BUILTIN_SAMPLES));
+	}
+}
+
+int CurvePool::addCurve(const float* samples, int count, unsigned int hash)
+{
+	Curve newCurve;
+	newCurve.offset = sampleList.size();
+	newCurve.count = count;
+	newCurve.hash = hash;
+	sampleList.insert(sampleList.end(), samples, samples + count);
+	curveList.push_back(newCurve);
+
+	int curveID = curveList.size() - 1;
+	curveLookup.insert(std::make_pair(hash, curveID));
+	return curveID;
+}
+
+int CurvePool::intern(const float* samples, int count)
+{
+	if (samples == nullptr || count <= 0)
+		throw std::invalid_argument("(CurvePool::intern) missing samples");
+	if (curveList.empty())
+		addBuiltins();
+
+	// look for an identical curve first
+	unsigned int hash = hashSamples(samples, count);
+	std::multimap<unsigned int, int>::const_iterator iter = curveLookup.find(hash);
+	while (iter != curveLookup.end() && iter->first == hash)
+	{
+		const Curve& curve = curveList[iter->second];
+		if (curve.count == count && !memcmp(&sampleList[curve.offset], samples, count * sizeof(float)))
+			return iter->second;
+		iter++;
+	}
+
+	return addCurve(samples, count, hash);
+}
+
+bool CurvePool::isValid(int curveID)
+{
+	if (curveList.empty())
+		addBuiltins();
+	return (curveID >= 0 && curveID < (int)curveList.size());
+}
+
+int CurvePool::getCurveCount()
+{
+	return curveList.size();
+}
@@ -0,0 +1,69 @@
+﻿#pragma once
+
+#include "MigDefines.h"
+
+namespace MigTech
+{
+	// built-in curves, these IDs are always valid
+	enum CURVE_BUILTIN
+	{
+		CURVE_LINEAR = 0,
+		CURVE_EASE_IN = 1,
+		CURVE_EASE_OUT = 2,
+		CURVE_EASE_IN_OUT = 3,
+		CURVE_EASE_OUT_BACK = 4,
+		CURVE_ARC = 5,			// 0 -> 1 -> 0
+		CURVE_BUILTIN_COUNT
+	};
+
+	// shared pool of immutable parametric curves, identical curves are interned to the same ID
+	//  each curve is a table of evenly spaced samples over 0 -> 1 (main thread only)
+	class CurvePool
+	{
+	private:
+		struct Curve
+		{
+			int offset;
+			int count;
+			unsigned int hash;
+		};
+
+		static std::vector<Curve> curveList;
+		static std::vector<float> sampleList;
+		static std::multimap<unsigned int, int> curveLookup;
+
+	private:
+		static void addBuiltins();
+		static int addCurve(const float* samples, int count, unsigned int hash);
+
+	public:
+		// returns the ID of a curve with these samples, the samples are only copied the first time
+		static int intern(const float* samples, int count);
+
+		// validates an ID handed in from outside the pool
+		static bool isValid(int curveID);
+
+		// number of curves in the pool
+		static int getCurveCount();
+
+		// p must be >= 0 and < 1
+		static float evaluate(int curveID, float p)
+		{
+			const Curve& curve = curveList[curveID];
+			float f = p * (curve.count - 1);
+			int i = (int)f;
+			if (i >= curve.count - 1)
+				return sampleList[curve.offset + curve.count - 1];
+
+			const float* s = &sampleList[curve.offset + i];
+			return s[0] + (f - i) * (s[1] - s[0]);
+		}
+
+		// the value when the animation completes
+		static float lastValue(int curveID)
+		{
+			const Curve& curve = curveList[curveID];
+			return sampleList[curve.offset + curve.count - 1];
+		}
+	};
+}
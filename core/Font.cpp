@@ -1,18 +1,27 @@
 ﻿#include "pch.h"
 #include "Font.h"
 #include "MigUtil.h"
+#include "ResourceCache.h"
 
 using namespace MigTech;
 using namespace tinyxml2;
 
+// initial size of the glyph index buffer, it grows as longer strings are drawn
+static const unsigned int MIN_GLYPH_CAPACITY = 64;
+
+// 4 vertices per glyph, and the indices are 16-bit
+static const unsigned int MAX_GLYPH_CAPACITY = 16384;
+
 Font::Font(const std::string& resID, const std::string& xmlID) :
 	_resID(resID), _xmlID(xmlID),
 	_texWidth(0), _texHeight(0),
 	_globalWidth(0), _globalHeight(0),
 	_spacing(0),
 	_addAlpha(false), _useAlpha(false), _dropColor(false),
-	_stretch(1), _fontMapObj(nullptr)
+	_stretch(1), _charCount(0), _fontMapObj(nullptr),
+	_glyphCapacity(0), _graphicsGen(0)
 {
+	clearCharTable();
 }
 
 Font::Font(const std::string& fontCfgName) :
@@ -20,8 +29,11 @@ Font::Font(const std::string& fontCfgName) :
 	_globalWidth(0), _globalHeight(0),
 	_spacing(0),
 	_addAlpha(false), _useAlpha(false), _dropColor(false),
-	_stretch(1), _fontMapObj(nullptr)
+	_stretch(1), _charCount(0), _fontMapObj(nullptr),
+	_glyphCapacity(0), _graphicsGen(0)
 {
+	clearCharTable();
+
 	const XMLElement* elem = MigUtil::theGame->getConfigRoot();
 	elem = elem->FirstChildElement("fonts");
 	if (elem != nullptr)
@@ -43,6 +55,14 @@ Font::~Font()
 {
 }
 
+void Font::clearCharTable()
+{
+	memset(_charTable, 0, sizeof(_charTable));
+	for (int i = 0; i < ARRAYSIZE(_charTable); i++)
+		_charTable[i].itemIndex = -1;
+	_charCount = 0;
+}
+
 bool Font::fillRestOfInfo(CharInfo& charInfo) const
 {
 	// the width may be 0, meaning it just inherits the global width
@@ -62,7 +82,7 @@ bool Font::loadConfig()
 {
 	LOGINFO("(Font::loadConfig) Loading font XML script '%s'", _xmlID.c_str());
 
-	tinyxml2::XMLDocument* pdoc = XMLDocFactory::loadDocument(_xmlID);
+	tinyxml2::XMLDocument* pdoc = ResourceCache::loadDocument(_xmlID);
 	if (pdoc != nullptr)
 	{
 		XMLElement* elem = pdoc->FirstChildElement("Font");
@@ -97,16 +117,22 @@ bool Font::loadConfig()
 				newCharInfo.width = (attr != nullptr ? atoi(attr) : 0);
 				//LOGDBG("Char is %s, width is %d", newCharInfo.thisChar.c_str(), newCharInfo.width);
 
-				_charInfoMap[newCharInfo.thisChar] = newCharInfo;
+				CharInfo& entry = _charTable[(unsigned char)newCharInfo.thisChar];
+				if (entry.itemIndex < 0)
+					_charCount++;
+				entry = newCharInfo;
 				item = item->NextSiblingElement("Item");
 			}
 
 			LOGDBG("Done reading font XML script");
 		}
 		else
+		{
+			ResourceCache::unloadDocument(_xmlID);
 			throw std::runtime_error("(Font::create) Root font element not found");
+		}
 
-		delete pdoc;
+		ResourceCache::unloadDocument(_xmlID);
 	}
 	else
 		throw std::invalid_argument("(Font::create) Unable to open font XML script");
@@ -116,7 +142,7 @@ bool Font::loadConfig()
 
 void Font::create()
 {
-	if (_charInfoMap.size() == 0)
+	if (_charCount == 0)
 		loadConfig();
 }
 
@@ -135,49 +161,28 @@ void Font::createGraphics()
 		_texWidth = ptxt->getWidth();
 		_texHeight = ptxt->getHeight();
 
-		// create the texture object and assign the shaders
-		_fontMapObj = MigUtil::theRend->createObject();
-		_fontMapObj->addShaderSet(MIGTECH_VSHADER_POS_TEX_TRANSFORM, (_dropColor ? MIGTECH_PSHADER_TEX_ALPHA : MIGTECH_PSHADER_TEX));
-
-		// create the vertex / index arrays
-		int numChars = _charInfoMap.size();
-		VertexPositionTexture* verts = new VertexPositionTexture[4*numChars];
-		unsigned short* txtIndices = new unsigned short[6*numChars];
-
-		// fill in the arrays
-		std::map<char, CharInfo>::iterator iter = _charInfoMap.begin();
-		while (iter != _charInfoMap.end())
+		// now we can complete the configuration (need texture width/height first)
+		for (int i = 0; i < ARRAYSIZE(_charTable); i++)
 		{
-			CharInfo& info = iter->second;
-			int currChar = info.itemIndex;
-
-			// now we can complete the configuration (need texture width/height first)
-			fillRestOfInfo(info);
-
-			// load mesh vertices (position / color)
-			verts[4 * currChar + 0] = VertexPositionTexture(Vector3(0, 0, 0), Vector2(info.uMin, info.vMax));
-			verts[4 * currChar + 1] = VertexPositionTexture(Vector3(0, 1, 0), Vector2(info.uMin, info.vMin));
-			verts[4 * currChar + 2] = VertexPositionTexture(Vector3(1, 0, 0), Vector2(info.uMax, info.vMax));
-			verts[4 * currChar + 3] = VertexPositionTexture(Vector3(1, 1, 0), Vector2(info.uMax, info.vMin));
-
-			// load mesh indices
-			txtIndices[6 * currChar + 0] = 4 * currChar + 0;
-			txtIndices[6 * currChar + 1] = 4 * currChar + 2;
-			txtIndices[6 * currChar + 2] = 4 * currChar + 1;
-			txtIndices[6 * currChar + 3] = 4 * currChar + 1;
-			txtIndices[6 * currChar + 4] = 4 * currChar + 2;
-			txtIndices[6 * currChar + 5] = 4 * currChar + 3;
-
-			iter++;
+			if (_charTable[i].itemIndex >= 0)
+				fillRestOfInfo(_charTable[i]);
 		}
 
-		// assign the buffers
-		_fontMapObj->loadVertexBuffer(verts, 4 * numChars, MigTech::VDTYPE_POSITION_TEXTURE);
-		_fontMapObj->loadIndexBuffer(txtIndices, 6 * numChars, MigTech::PRIMITIVE_TYPE_TRIANGLE_LIST);
+		// create the texture object and assign the shaders, the vertices are uploaded per string
+		_fontMapObj = MigUtil::theRend->createObject();
+		_fontMapObj->setBufferUsage(BUFFER_USAGE_DYNAMIC);
+		_fontMapObj->addShaderSet(MIGTECH_VSHADER_POS_TEX_TRANSFORM, (_dropColor ? MIGTECH_PSHADER_TEX_ALPHA : MIGTECH_PSHADER_TEX));
+
+		// the index buffer only depends on the glyph count so it can be shared by every string
+		_glyphCapacity = 0;
+		reserveGlyphs(MIN_GLYPH_CAPACITY);
 
 		// texturing / culling
 		_fontMapObj->setImage(0, _resID, TXT_FILTER_LINEAR, TXT_FILTER_LINEAR, TXT_WRAP_CLAMP);
 		_fontMapObj->setCulling(FACE_CULLING_BACK);
+
+		// any glyph runs baked before now are stale
+		_graphicsGen++;
 	}
 	else
 		throw std::runtime_error("(Font::createGraphics) Unable to load font texture");
@@ -188,10 +193,38 @@ void Font::destroyGraphics()
 	if (_fontMapObj != nullptr)
 		MigUtil::theRend->deleteObject(_fontMapObj);
 	_fontMapObj = nullptr;
+	_glyphCapacity = 0;
 
 	MigUtil::theRend->unloadImage(_resID);
 }
 
+void Font::reserveGlyphs(unsigned int count) const
+{
+	if (count <= _glyphCapacity)
+		return;
+	if (count > MAX_GLYPH_CAPACITY)
+		throw std::invalid_argument("(Font::reserveGlyphs) Too many glyphs in a single string");
+
+	unsigned int newCapacity = (_glyphCapacity > MIN_GLYPH_CAPACITY ? _glyphCapacity : MIN_GLYPH_CAPACITY);
+	while (newCapacity < count)
+		newCapacity *= 2;
+	if (newCapacity > MAX_GLYPH_CAPACITY)
+		newCapacity = MAX_GLYPH_CAPACITY;
+
+	std::vector<unsigned short> txtIndices(6 * newCapacity);
+	for (unsigned int i = 0; i < newCapacity; i++)
+	{
+		txtIndices[6 * i + 0] = 4 * i + 0;
+		txtIndices[6 * i + 1] = 4 * i + 2;
+		txtIndices[6 * i + 2] = 4 * i + 1;
+		txtIndices[6 * i + 3] = 4 * i + 1;
+		txtIndices[6 * i + 4] = 4 * i + 2;
+		txtIndices[6 * i + 5] = 4 * i + 3;
+	}
+	_fontMapObj->loadIndexBuffer(&txtIndices[0], txtIndices.size(), MigTech::PRIMITIVE_TYPE_TRIANGLE_LIST);
+	_glyphCapacity = newCapacity;
+}
+
 void Font::destroy()
 {
 }
@@ -217,13 +250,9 @@ float Font::getWidth(const std::string& text) const
 	int lenText = text.length();
 	for (int i = 0; i < lenText; i++)
 	{
-		char entry = text[i];
-		std::map<char, CharInfo>::const_iterator iter = _charInfoMap.find(entry);
-		if (iter != _charInfoMap.end())
-		{
-			const CharInfo& info = iter->second;
-			width += (info.width + _spacing);
-		}
+		const CharInfo* info = getCharInfo(text[i]);
+		if (info != nullptr)
+			width += (info->width + _spacing);
 	}
 
 	return _stretch * width / (float)_globalWidth;
@@ -235,31 +264,48 @@ float Font::getHeight(const std::string& text) const
 	return 1;
 }
 
-float Font::drawChar(char key, float x, float y, float z, const Matrix& mat) const
+void Font::bakeRun(const std::string& text, GlyphRun& run) const
 {
-	float width = 0;
+	run.clear();
 
-	std::map<char, CharInfo>::const_iterator iter = _charInfoMap.find(key);
-	if (iter != _charInfoMap.end())
+	// keep track of the x-offset as we output characters
+	float x = 0;
+	int lenText = text.length();
+	for (int i = 0; i < lenText; i++)
 	{
-		// note that this isn't thread safe
-		static Matrix localMat;
+		const CharInfo* info = getCharInfo(text[i]);
+		if (info != nullptr)
+		{
+			float xScale = _stretch * info->width / (float)_globalWidth;
+			run.push_back(VertexPositionTexture(Vector3(x, 0, 0), Vector2(info->uMin, info->vMax)));
+			run.push_back(VertexPositionTexture(Vector3(x, 1, 0), Vector2(info->uMin, info->vMin)));
+			run.push_back(VertexPositionTexture(Vector3(x + xScale, 0, 0), Vector2(info->uMax, info->vMax)));
+			run.push_back(VertexPositionTexture(Vector3(x + xScale, 1, 0), Vector2(info->uMax, info->vMin)));
 
-		const CharInfo& info = iter->second;
-		float xScale = _stretch * info.width / (float)_globalWidth;
-		localMat.identity();
-		localMat.scale(xScale, 1, 1);
-		localMat.translate(x, y, z);
-		localMat.multiply(mat);
-		MigUtil::theRend->setModelMatrix(localMat);
+			x += _stretch * ((info->width + _spacing) / (float)_globalWidth);
+		}
+	}
+}
 
-		_fontMapObj->setIndexOffset(6*info.itemIndex, 6);
-		_fontMapObj->render();
+void Font::drawRun(const GlyphRun& run, float r, float g, float b, float a, const Matrix& mat) const
+{
+	if (_fontMapObj == nullptr)
+		throw std::runtime_error("(Font::drawRun) Font rendering object cannot be null");
+	if (run.empty())
+		return;
 
-		width = _stretch * ((info.width + _spacing) / (float)_globalWidth);
-	}
+	unsigned int numGlyphs = run.size() / 4;
+	reserveGlyphs(numGlyphs);
 
-	return width;
+	MigUtil::theRend->setObjectColor(Color(r, g, b, a));
+	MigUtil::theRend->setBlending(_useAlpha ? BLEND_STATE_SRC_ALPHA : BLEND_STATE_NONE);
+	MigUtil::theRend->setDepthTesting(DEPTH_TEST_STATE_NONE, false);
+	MigUtil::theRend->setModelMatrix(&mat);
+
+	// the whole string goes out in one draw call
+	_fontMapObj->loadVertexBuffer(&run[0], run.size(), MigTech::VDTYPE_POSITION_TEXTURE);
+	_fontMapObj->setIndexOffset(0, 6 * numGlyphs);
+	_fontMapObj->render();
 }
 
 void Font::draw(const std::string& text, const Color& col, const Matrix& mat) const
@@ -272,27 +318,13 @@ void Font::draw(const std::string& text, float r, float g, float b, float a, con
 	if (_fontMapObj == nullptr)
 		throw std::runtime_error("(Font::draw) Font rendering object cannot be null");
 
-	MigUtil::theRend->setObjectColor(Color(r, g, b, a));
-	MigUtil::theRend->setBlending(_useAlpha ? BLEND_STATE_SRC_ALPHA : BLEND_STATE_NONE);
-	MigUtil::theRend->setDepthTesting(DEPTH_TEST_STATE_NONE, false);
-
-	// start a render set (more efficient)
-	_fontMapObj->startRenderSet();
-
-	// keep track of the x-offset as we output characters
-	float x = 0;
-	int lenText = text.length();
-	for (int i = 0; i < lenText; i++)
-	{
-		x += drawChar(text[i], x, 0, 0, mat);
-	}
-
-	// finish the render set
-	_fontMapObj->stopRenderSet();
+	// one-off strings are baked into a scratch run every time, use Text to keep the run around
+	bakeRun(text, _scratchRun);
+	drawRun(_scratchRun, r, g, b, a, mat);
 }
 
 Text::Text() :
-	_font(MigUtil::theFont), _scale(1), _stretch(1), _offset(0),
+	_font(MigUtil::theFont), _runGen(0), _scale(1), _stretch(1), _offset(0),
 	_rotX(0), _rotY(0), _rotZ(0),
 	_u(0), _v(0), _h(1), _justify(JUSTIFY_IGNORE)
 {
@@ -301,7 +333,7 @@ Text::Text() :
 }
 
 Text::Text(const Font* font) :
-	_font(font), _scale(1), _stretch(1), _offset(0),
+	_font(font), _runGen(0), _scale(1), _stretch(1), _offset(0),
 	_rotX(0), _rotY(0), _rotZ(0),
 	_u(0), _v(0), _h(1), _justify(JUSTIFY_IGNORE)
 {
@@ -341,7 +373,11 @@ void Text::init(const std::string& text, JUSTIFY justification)
 
 void Text::update(const std::string& text, JUSTIFY justification)
 {
-	_text = text;
+	if (text != _text)
+	{
+		_text = text;
+		_runGen = 0;
+	}
 	_justify = justification;
 
 	if (_justify != JUSTIFY_IGNORE)
@@ -359,6 +395,20 @@ void Text::update(const std::string& text, JUSTIFY justification)
 	_mat.rotateX(_rotX);
 	_mat.rotateY(_rotY);
 	_mat.rotateZ(_rotZ);
+
+	// bake the glyph quads now if the font is ready, otherwise it happens on the first draw
+	getRun();
+}
+
+const GlyphRun& Text::getRun() const
+{
+	unsigned int gen = _font->getGraphicsGen();
+	if (gen != 0 && gen != _runGen)
+	{
+		_font->bakeRun(_text, _run);
+		_runGen = gen;
+	}
+	return _run;
 }
 
 void Text::transform(float scale, float stretch, float x, float y, float z, float rx, float ry, float rz)
@@ -417,7 +467,7 @@ void Text::draw(float r, float g, float b, float a) const
 {
 	if (_text.length() > 0)
 	{
-		_font->draw(_text, r, g, b, a, _mat);
+		_font->drawRun(getRun(), r, g, b, a, _mat);
 	}
 }
 
@@ -425,10 +475,9 @@ void Text::draw(float r, float g, float b, float a, const Matrix& worldMatrix) c
 {
 	if (_text.length() > 0)
 	{
-		static Matrix localMat;
-		localMat.copy(_mat);
-		localMat.multiply(worldMatrix);
+		Matrix localMat;
+		Matrix::multiply(_mat, worldMatrix, localMat);
 
-		_font->draw(_text, r, g, b, a, localMat);
+		_font->drawRun(getRun(), r, g, b, a, localMat);
 	}
 }
@@ -19,7 +19,7 @@ namespace MigTech
 	struct CharInfo
 	{
 		char thisChar;
-		int itemIndex;
+		int itemIndex;		// -1 if the font doesn't have this character
 		int left;
 		int top;
 		int width;
@@ -32,6 +32,9 @@ namespace MigTech
 	// defined below Font
 	class Text;
 
+	// a string baked into glyph quads (4 vertices per glyph, in font units)
+	typedef std::vector<VertexPositionTexture> GlyphRun;
+
 	// TODO: proper UTF8 support (this currently only works w/ ANSI chars)
 	class Font : public MigBase
 	{
@@ -57,10 +60,22 @@ namespace MigTech
 		void draw(const std::string& text, const Color& col, const Matrix& mat) const;
 		void draw(const std::string& text, float r, float g, float b, float a, const Matrix& mat) const;
 
+		// glyph runs are only valid for the graphics generation they were baked in
+		void bakeRun(const std::string& text, GlyphRun& run) const;
+		void drawRun(const GlyphRun& run, float r, float g, float b, float a, const Matrix& mat) const;
+		unsigned int getGraphicsGen() const { return _graphicsGen; }
+
 	protected:
 		bool fillRestOfInfo(CharInfo& charInfo) const;
 		bool loadConfig();
-		float drawChar(char key, float x, float y, float z, const Matrix& mat) const;
+		void clearCharTable();
+		void reserveGlyphs(unsigned int count) const;
+
+		const CharInfo* getCharInfo(char key) const
+		{
+			const CharInfo& info = _charTable[(unsigned char)key];
+			return (info.itemIndex >= 0 ? &info : nullptr);
+		}
 
 	protected:
 		std::string _resID;
@@ -79,10 +94,14 @@ namespace MigTech
 		bool _useAlpha;
 		bool _dropColor;
 		float _stretch;
-		std::map<char, CharInfo> _charInfoMap;
+		CharInfo _charTable[256];
+		int _charCount;
 
-		// render object
+		// render object (dynamic, every string is uploaded and drawn in one call)
 		Object* _fontMapObj;
+		mutable unsigned int _glyphCapacity;
+		mutable GlyphRun _scratchRun;
+		unsigned int _graphicsGen;
 	};
 
 	// holds a single piece of text ready for rendering
@@ -111,9 +130,14 @@ namespace MigTech
 		void draw(float r, float g, float b, float a) const;
 		void draw(float r, float g, float b, float a, const Matrix& worldMatrix) const;
 
+	protected:
+		const GlyphRun& getRun() const;
+
 	protected:
 		const Font* _font;
 		std::string _text;
+		mutable GlyphRun _run;
+		mutable unsigned int _runGen;
 		Vector3 _pt;
 		float _scale;
 		float _stretch;
@@ -10,20 +10,92 @@ namespace MigTech
 	static const int IMAGE_CAPS_TOP_DOWN      = 2;
 	static const int IMAGE_CAPS_BOTTOM_UP     = 4;
 
+	// load state, only images loaded asynchronously are ever pending
+	enum IMAGE_LOAD_STATE
+	{
+		IMAGE_LOAD_READY,
+		IMAGE_LOAD_PENDING,
+		IMAGE_LOAD_FAILED
+	};
+
+	// decoded pixels on their way to becoming a texture
+	//  compressed data keeps its blocks in pixels, format is what the blocks decode to
+	//  mip levels follow the base level in pixels, dataSize covers all of them (see MipChain)
+	//  a decoded single level may have a larger dataSize, that's room reserved for its chain
+	struct ImageData
+	{
+		IMG_FORMAT format;
+		int width;
+		int height;
+		byte* pixels;
+
+		TEX_COMPRESSION compression;
+		int blockWidth;
+		int blockHeight;
+		unsigned int dataSize;
+		int mipLevels;
+
+		// the source was decoded at 1/decodeScale of its size (see LOAD_IMAGE_FIT_OUTPUT)
+		int decodeScale;
+
+		ImageData() : format(IMG_FORMAT_NONE), width(0), height(0), pixels(nullptr),
+			compression(TEX_COMPRESSION_NONE), blockWidth(1), blockHeight(1), dataSize(0), mipLevels(1), decodeScale(1) { }
+		void release() { delete[] pixels; pixels = nullptr; }
+		bool isCompressed() const { return (compression != TEX_COMPRESSION_NONE); }
+	};
+
+	class Image;
+
+	// implement this interface to be told when an asynchronous image load completes
+	class IImageLoadCallback
+	{
+	public:
+		virtual void imageLoaded(const std::string& name, Image* img, bool success) = 0;
+	};
+
 	class Image
 	{
+		friend class RenderBase;
+		friend class AssetLoader;
+
 	protected:
-		Image() { _width = _height = 0; _caps = IMAGE_CAPS_NONE; };
+		Image() { _width = _height = 0; _byteSize = 0; _mipLevels = 1; _caps = IMAGE_CAPS_NONE; _loadState = IMAGE_LOAD_READY; _loadTicket = 0; };
 		virtual ~Image() { };
 
 	public:
 		int getWidth() const { return _width; }
 		int getHeight() const { return _height; }
 		unsigned int getCaps() const { return _caps; }
+		int getMipLevels() const { return _mipLevels; }
+
+		// memory used by the texture as uploaded (including any depth buffer), zero while pending
+		unsigned int getByteSize() const { return _byteSize; }
+
+		// an image that's still pending can be bound but won't have any pixels yet
+		IMAGE_LOAD_STATE getLoadState() const { return _loadState; }
+		bool isReady() const { return (_loadState == IMAGE_LOAD_READY); }
+		bool isPending() const { return (_loadState == IMAGE_LOAD_PENDING); }
+
+		// call if the callback goes away before the load completes
+		void removeLoadCallback(IImageLoadCallback* callback)
+		{
+			for (size_t i = 0; i < _callbacks.size(); i++)
+			{
+				if (_callbacks[i] == callback)
+					_callbacks[i] = nullptr;
+			}
+		}
 
 	protected:
 		int _width;
 		int _height;
+		unsigned int _byteSize;
+		int _mipLevels;
 		unsigned int _caps;
+
+		// asynchronous load tracking
+		IMAGE_LOAD_STATE _loadState;
+		unsigned int _loadTicket;
+		std::vector<IImageLoadCallback*> _callbacks;
 	};
 }
\ No newline at end of file
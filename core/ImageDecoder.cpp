@@ -0,0 +1,495 @@
+﻿#include "pch.h"
+#include "ImageDecoder.h"
+#include "MipChain.h"
+#include "MigUtil.h"
+
+extern "C" {
+#include "libjpeg/jpeglib.h"
+}
+
+extern "C" {
+#include "libpng/png.h"
+}
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define IMAGEDECODER_USE_SSE2
+#elif defined(_M_ARM) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define IMAGEDECODER_USE_NEON
+#endif
+
+using namespace MigTech;
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+extern byte* plat_loadFileBuffer(const char* filePath, int& length);
+
+///////////////////////////////////////////////////////////////////////////
+// row processing
+
+// what the pixel load flags do to each RGBA row
+struct RowOps
+{
+	enum ALPHA_OP { ALPHA_KEEP, ALPHA_AVERAGE, ALPHA_CONST };
+
+	ALPHA_OP alphaOp;
+	byte alphaConst;
+	bool invert;		// applied after keep or average, it's folded into the constant
+	bool dropColor;
+
+	RowOps(unsigned int loadFlags)
+	{
+		alphaOp = ALPHA_KEEP;
+		alphaConst = 255;
+		if (loadFlags & LOAD_IMAGE_ADD_ALPHA)
+			alphaOp = ALPHA_AVERAGE;
+		else if (loadFlags & LOAD_IMAGE_SET_ALPHA)
+			alphaOp = ALPHA_CONST;
+		else if (loadFlags & LOAD_IMAGE_CLEAR_ALPHA)
+		{
+			alphaOp = ALPHA_CONST;
+			alphaConst = 0;
+		}
+
+		invert = ((loadFlags & LOAD_IMAGE_INVERT_ALPHA) != 0);
+		if (invert && alphaOp == ALPHA_CONST)
+		{
+			alphaConst = 255 - alphaConst;
+			invert = false;
+		}
+		dropColor = ((loadFlags & LOAD_IMAGE_DROP_COLOR) != 0);
+	}
+
+	// for sources that have no alpha of their own
+	void setOpaqueSource()
+	{
+		if (alphaOp == ALPHA_KEEP)
+		{
+			alphaOp = ALPHA_CONST;
+			alphaConst = (invert ? 0 : 255);
+			invert = false;
+		}
+	}
+
+	bool isNone() const { return (alphaOp == ALPHA_KEEP && !invert && !dropColor); }
+};
+
+// RGB to RGBA with a fixed alpha
+static void expandRow(const byte* rgb, byte* rgba, int count, byte alpha)
+{
+	int x = 0;
+#if defined(IMAGEDECODER_USE_NEON)
+	for (; x + 16 <= count; x += 16)
+	{
+		uint8x16x3_t src = vld3q_u8(rgb + 3*x);
+		uint8x16x4_t dst;
+		dst.val[0] = src.val[0];
+		dst.val[1] = src.val[1];
+		dst.val[2] = src.val[2];
+		dst.val[3] = vdupq_n_u8(alpha);
+		vst4q_u8(rgba + 4*x, dst);
+	}
+#endif
+	for (; x < count; x++)
+	{
+		rgba[4*x + 0] = rgb[3*x + 0];
+		rgba[4*x + 1] = rgb[3*x + 1];
+		rgba[4*x + 2] = rgb[3*x + 2];
+		rgba[4*x + 3] = alpha;
+	}
+}
+
+// applies the alpha op in place
+static void alphaRow(byte* rgba, int count, const RowOps& ops)
+{
+	int x = 0;
+	byte flip = (ops.invert ? 0xFF : 0);
+#if defined(IMAGEDECODER_USE_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i lowByte = _mm_set1_epi32(0xFF);
+	const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+	if (ops.alphaOp == RowOps::ALPHA_AVERAGE)
+	{
+		// (r+g+b)/3 is (sum*21846)>>16 for every sum up to 765
+		const __m128i third = _mm_set1_epi16(21846);
+		const __m128i flipv = _mm_set1_epi16(flip);
+		for (; x + 8 <= count; x += 8)
+		{
+			__m128i p0 = _mm_loadu_si128((const __m128i*) (rgba + 4*x));
+			__m128i p1 = _mm_loadu_si128((const __m128i*) (rgba + 4*x + 16));
+			__m128i s0 = _mm_add_epi32(_mm_add_epi32(_mm_and_si128(p0, lowByte), _mm_and_si128(_mm_srli_epi32(p0, 8), lowByte)), _mm_and_si128(_mm_srli_epi32(p0, 16), lowByte));
+			__m128i s1 = _mm_add_epi32(_mm_add_epi32(_mm_and_si128(p1, lowByte), _mm_and_si128(_mm_srli_epi32(p1, 8), lowByte)), _mm_and_si128(_mm_srli_epi32(p1, 16), lowByte));
+			__m128i avg = _mm_xor_si128(_mm_mulhi_epu16(_mm_packs_epi32(s0, s1), third), flipv);
+			p0 = _mm_or_si128(_mm_and_si128(p0, rgbMask), _mm_slli_epi32(_mm_unpacklo_epi16(avg, zero), 24));
+			p1 = _mm_or_si128(_mm_and_si128(p1, rgbMask), _mm_slli_epi32(_mm_unpackhi_epi16(avg, zero), 24));
+			_mm_storeu_si128((__m128i*) (rgba + 4*x), p0);
+			_mm_storeu_si128((__m128i*) (rgba + 4*x + 16), p1);
+		}
+	}
+	else if (ops.alphaOp == RowOps::ALPHA_CONST)
+	{
+		const __m128i alpha = _mm_set1_epi32((int) ((unsigned int) ops.alphaConst << 24));
+		for (; x + 4 <= count; x += 4)
+		{
+			__m128i p = _mm_loadu_si128((const __m128i*) (rgba + 4*x));
+			_mm_storeu_si128((__m128i*) (rgba + 4*x), _mm_or_si128(_mm_and_si128(p, rgbMask), alpha));
+		}
+	}
+	else if (ops.invert)
+	{
+		const __m128i alphaMask = _mm_set1_epi32((int) 0xFF000000);
+		for (; x + 4 <= count; x += 4)
+		{
+			__m128i p = _mm_loadu_si128((const __m128i*) (rgba + 4*x));
+			_mm_storeu_si128((__m128i*) (rgba + 4*x), _mm_xor_si128(p, alphaMask));
+		}
+	}
+#elif defined(IMAGEDECODER_USE_NEON)
+	const uint8x16_t flipv = vdupq_n_u8(flip);
+	const uint16x4_t third = vdup_n_u16(21846);
+	for (; x + 16 <= count; x += 16)
+	{
+		uint8x16x4_t p = vld4q_u8(rgba + 4*x);
+		if (ops.alphaOp == RowOps::ALPHA_AVERAGE)
+		{
+			uint16x8_t sLo = vaddw_u8(vaddl_u8(vget_low_u8(p.val[0]), vget_low_u8(p.val[1])), vget_low_u8(p.val[2]));
+			uint16x8_t sHi = vaddw_u8(vaddl_u8(vget_high_u8(p.val[0]), vget_high_u8(p.val[1])), vget_high_u8(p.val[2]));
+			uint16x8_t aLo = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(sLo), third), 16), vshrn_n_u32(vmull_u16(vget_high_u16(sLo), third), 16));
+			uint16x8_t aHi = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(sHi), third), 16), vshrn_n_u32(vmull_u16(vget_high_u16(sHi), third), 16));
+			p.val[3] = vcombine_u8(vmovn_u16(aLo), vmovn_u16(aHi));
+		}
+		else if (ops.alphaOp == RowOps::ALPHA_CONST)
+			p.val[3] = vdupq_n_u8(ops.alphaConst);
+		p.val[3] = veorq_u8(p.val[3], flipv);
+		vst4q_u8(rgba + 4*x, p);
+	}
+#endif
+	for (; x < count; x++)
+	{
+		byte* px = rgba + 4*x;
+		if (ops.alphaOp == RowOps::ALPHA_AVERAGE)
+			px[3] = (byte) ((px[0] + px[1] + px[2]) / 3);
+		else if (ops.alphaOp == RowOps::ALPHA_CONST)
+			px[3] = ops.alphaConst;
+		px[3] ^= flip;
+	}
+}
+
+// pulls the alpha channel out into its own row
+static void extractAlphaRow(const byte* rgba, byte* alpha, int count)
+{
+	int x = 0;
+#if defined(IMAGEDECODER_USE_SSE2)
+	for (; x + 16 <= count; x += 16)
+	{
+		__m128i a0 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*) (rgba + 4*x)), 24);
+		__m128i a1 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*) (rgba + 4*x + 16)), 24);
+		__m128i a2 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*) (rgba + 4*x + 32)), 24);
+		__m128i a3 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*) (rgba + 4*x + 48)), 24);
+		_mm_storeu_si128((__m128i*) (alpha + x), _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3)));
+	}
+#elif defined(IMAGEDECODER_USE_NEON)
+	for (; x + 16 <= count; x += 16)
+		vst1q_u8(alpha + x, vld4q_u8(rgba + 4*x).val[3]);
+#endif
+	for (; x < count; x++)
+		alpha[x] = rgba[4*x + 3];
+}
+
+// runs the ops on a decoded RGBA row, dst is only written if the color is being dropped
+static void processRow(byte* rgba, byte* dst, int count, const RowOps& ops)
+{
+	if (ops.dropColor && ops.alphaOp == RowOps::ALPHA_CONST)
+	{
+		memset(dst, ops.alphaConst, count);
+		return;
+	}
+
+	if (ops.alphaOp != RowOps::ALPHA_KEEP || ops.invert)
+		alphaRow(rgba, count, ops);
+	if (ops.dropColor)
+		extractAlphaRow(rgba, dst, count);
+}
+
+// allocates the final buffer, with room for the mip chain if one is going to be built (see MipChain::generate)
+static byte* allocPixels(ImageData& data, IMG_FORMAT fmt, int width, int height, unsigned int loadFlags)
+{
+	data.format = fmt;
+	data.width = width;
+	data.height = height;
+	data.mipLevels = ((loadFlags & LOAD_IMAGE_MIPMAPS) ? MipChain::getFullLevelCount(width, height) : 1);
+	data.dataSize = MipChain::getChainSize(data);
+	data.mipLevels = 1;
+	data.pixels = new byte[data.dataSize];
+	return data.pixels;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// JPEG
+
+bool ImageDecoder::loadJPEG(const std::string& path, unsigned int loadFlags, bool allowRGB, const Size& fitSize, ImageData& data)
+{
+	int len = 0;
+	byte* pFile = plat_loadFileBuffer(path.c_str(), len);
+	if (pFile == nullptr)
+	{
+		LOGWARN("(ImageDecoder::loadJPEG) image '%s' doesn't exist", path.c_str());
+		return false;
+	}
+
+	// initialize decompression
+	struct jpeg_decompress_struct cinfo;
+	struct jpeg_error_mgr jerr;
+	cinfo.err = jpeg_std_error(&jerr);
+	jpeg_create_decompress(&cinfo);
+	jpeg_mem_src(&cinfo, pFile, len);
+	jpeg_read_header(&cinfo, TRUE);
+
+	// the IDCT does the scaling, so the skipped pixels are never decoded at all
+	int scale = 1;
+	if (loadFlags & LOAD_IMAGE_FIT_OUTPUT)
+		scale = getFitScale(cinfo.image_width, cinfo.image_height, fitSize);
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = scale;
+	jpeg_start_decompress(&cinfo);
+	LOGINFO("(ImageDecoder::loadJPEG) Image=%s, w=%d, h=%d, scale=1/%d", path.c_str(), cinfo.output_width, cinfo.output_height, scale);
+
+	// for now, only 24-bit JPEGs
+	ImageData decoded;
+	if (cinfo.output_components == 3)
+	{
+		RowOps ops(loadFlags);
+		ops.setOpaqueSource();
+
+		int width = cinfo.output_width;
+		int height = cinfo.output_height;
+		if (allowRGB && (loadFlags & LOAD_IMAGE_PIXEL_FLAGS) == 0)
+		{
+			// the decoder's rows are already in the upload format
+			byte* pData = allocPixels(decoded, IMG_FORMAT_RGB, width, height, loadFlags);
+			while (cinfo.output_scanline < cinfo.output_height)
+			{
+				JSAMPROW row = pData + cinfo.output_scanline*3*width;
+				jpeg_read_scanlines(&cinfo, &row, 1);
+			}
+		}
+		else
+		{
+			int bpp = (ops.dropColor ? 1 : 4);
+			byte* pData = allocPixels(decoded, (ops.dropColor ? IMG_FORMAT_ALPHA : IMG_FORMAT_RGBA), width, height, loadFlags);
+
+			// one decoded row, plus an RGBA row if the color is being dropped
+			byte* pRow = new byte[(ops.dropColor ? 7 : 3) * width];
+			byte* pRGBA = pRow + 3*width;
+			while (cinfo.output_scanline < cinfo.output_height)
+			{
+				byte* pDst = pData + cinfo.output_scanline*bpp*width;
+				JSAMPROW row = pRow;
+				jpeg_read_scanlines(&cinfo, &row, 1);
+
+				if (ops.alphaOp == RowOps::ALPHA_CONST && ops.dropColor)
+					memset(pDst, ops.alphaConst, width);
+				else if (ops.alphaOp == RowOps::ALPHA_CONST)
+					expandRow(pRow, pDst, width, ops.alphaConst);
+				else
+				{
+					byte* rgba = (ops.dropColor ? pRGBA : pDst);
+					expandRow(pRow, rgba, width, 255);
+					processRow(rgba, pDst, width, ops);
+				}
+			}
+			delete [] pRow;
+		}
+	}
+	else
+	{
+		LOGWARN("(ImageDecoder::loadJPEG) %d color components not supported", cinfo.output_components);
+	}
+
+	// clean up decompression
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+	delete [] pFile;
+
+	// hand back the decoded data, it'll be uploaded to a texture by the caller
+	if (decoded.pixels == nullptr)
+		return false;
+	decoded.decodeScale = scale;
+	data = decoded;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// PNG
+
+struct USER_READ_DATA
+{
+	byte* pFile;
+	int sizeFile;
+	int currOffset;
+};
+
+static void userReadData(png_structp read_ptr, png_bytep data, png_size_t length)
+{
+	if (read_ptr != nullptr)
+	{
+		USER_READ_DATA* pData = (USER_READ_DATA*) png_get_io_ptr(read_ptr);
+		if (pData != nullptr)
+		{
+			if (pData->currOffset + length <= pData->sizeFile)
+			{
+				memcpy(data, &(pData->pFile[pData->currOffset]), length);
+				pData->currOffset += length;
+			}
+			else
+				LOGERR("(ImageDecoder::userReadData) PNG read error, EOF");
+		}
+		else
+			LOGERR("(ImageDecoder::userReadData) PNG read error, pData was nullptr");
+	}
+	else
+		LOGERR("(ImageDecoder::userReadData) PNG read error, read_ptr was nullptr");
+}
+
+bool ImageDecoder::loadPNG(const std::string& path, unsigned int loadFlags, ImageData& data)
+{
+	int len = 0;
+	byte* pFile = plat_loadFileBuffer(path.c_str(), len);
+	if (pFile == nullptr)
+	{
+		LOGWARN("(ImageDecoder::loadPNG) image '%s' doesn't exist", path.c_str());
+		return false;
+	}
+
+	// check the header to ensure it's a PNG
+	if (len < 8 || png_sig_cmp(pFile, 0, 8))
+	{
+		LOGWARN("(ImageDecoder::loadPNG) image '%s' does not appear to be a PNG", path.c_str());
+		delete [] pFile;
+		return false;
+	}
+
+	// allocate needed structs
+	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	if (!png_ptr)
+	{
+		LOGWARN("(ImageDecoder::loadPNG) png_create_read_struct() failed");
+		delete [] pFile;
+		return false;
+	}
+	png_infop info_ptr = png_create_info_struct(png_ptr);
+	if (!info_ptr)
+	{
+		LOGWARN("(ImageDecoder::loadPNG) png_create_info_struct() failed");
+		png_destroy_read_struct(&png_ptr, (png_infopp)nullptr, (png_infopp)nullptr);
+		delete [] pFile;
+		return false;
+	}
+
+	// init the PNG file IO
+	USER_READ_DATA userReadDataStruct;
+	userReadDataStruct.pFile = pFile;
+	userReadDataStruct.sizeFile = len;
+	userReadDataStruct.currOffset = 0;
+	png_set_read_fn(png_ptr, &userReadDataStruct, userReadData);
+
+	// read the info header
+	png_read_info(png_ptr, info_ptr);
+
+	// transform images to RGBA type (unless greyscale)
+	int colorType = png_get_color_type(png_ptr, info_ptr);
+	if (colorType == PNG_COLOR_TYPE_PALETTE)
+	{
+		png_set_palette_to_rgb(png_ptr);
+		png_set_add_alpha(png_ptr, 0, PNG_FILLER_AFTER);
+	}
+	else if (colorType == PNG_COLOR_TYPE_RGB)
+		png_set_add_alpha(png_ptr, 0, PNG_FILLER_AFTER);
+
+	// add alpha if the transparency is in a tRNS chunk
+	if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
+		png_set_tRNS_to_alpha(png_ptr);
+
+	// expand image data that is less than 8 bits to 8 bits
+	int bitDepth = png_get_bit_depth(png_ptr, info_ptr);
+	if (colorType == PNG_COLOR_TYPE_GRAY && bitDepth < 8)
+		png_set_expand_gray_1_2_4_to_8(png_ptr);
+	else if (bitDepth < 8)
+		png_set_packing(png_ptr);
+
+	// interlaced images need every pass before a row is final
+	int passes = png_set_interlace_handling(png_ptr);
+
+	// apply the transformations
+	png_read_update_info(png_ptr, info_ptr);
+
+	// re-read header info
+	ImageData decoded;
+	bitDepth = png_get_bit_depth(png_ptr, info_ptr);
+	int channels = png_get_channels(png_ptr, info_ptr);
+	int imageWidth = png_get_image_width(png_ptr, info_ptr);
+	int imageHeight = png_get_image_height(png_ptr, info_ptr);
+	LOGINFO("(ImageDecoder::loadPNG) Image=%s, w=%d, h=%d, bits=%d, channels=%d", path.c_str(), imageWidth, imageHeight, bitDepth, channels);
+	if (bitDepth == 8 && (channels == 1 || channels == 4))
+	{
+		// greyscale rows go straight in, the flags only apply to RGBA
+		RowOps ops(channels == 4 ? loadFlags : LOAD_IMAGE_NONE);
+		bool dropColor = ((loadFlags & LOAD_IMAGE_DROP_COLOR) != 0);
+		IMG_FORMAT fmt = (dropColor ? IMG_FORMAT_ALPHA : (channels == 1 ? IMG_FORMAT_GREYSCALE : IMG_FORMAT_RGBA));
+		int bpp = (fmt == IMG_FORMAT_RGBA ? 4 : 1);
+		byte* pData = allocPixels(decoded, fmt, imageWidth, imageHeight, loadFlags);
+
+		if (passes == 1)
+		{
+			// process each row as it's decoded
+			byte* pRGBA = (ops.dropColor ? new byte[4 * imageWidth] : nullptr);
+			for (int y = 0; y < imageHeight; y++)
+			{
+				byte* pDst = pData + y*bpp*imageWidth;
+				byte* pRow = (ops.dropColor ? pRGBA : pDst);
+				png_read_row(png_ptr, pRow, nullptr);
+				if (!ops.isNone())
+					processRow(pRow, pDst, imageWidth, ops);
+			}
+			delete [] pRGBA;
+		}
+		else
+		{
+			// the whole image has to be there first, dropped color needs somewhere to go in the meantime
+			int rowStride = channels * imageWidth;
+			byte* pImage = (ops.dropColor ? new byte[rowStride*imageHeight] : pData);
+			png_bytepp row_pointers = new png_bytep[imageHeight];
+			for (int y = 0; y < imageHeight; y++)
+				row_pointers[y] = pImage + y*rowStride;
+			png_read_image(png_ptr, row_pointers);
+			delete [] row_pointers;
+
+			if (!ops.isNone())
+			{
+				for (int y = 0; y < imageHeight; y++)
+					processRow(pImage + y*rowStride, pData + y*bpp*imageWidth, imageWidth, ops);
+			}
+			if (pImage != pData)
+				delete [] pImage;
+		}
+
+		// read the end of the PNG (skip the actual data)
+		png_read_end(png_ptr, (png_infop)nullptr);
+	}
+	else
+	{
+		LOGWARN("(ImageDecoder::loadPNG) Unsupported bit depth or channels (%d, %d)", bitDepth, channels);
+	}
+
+	// clean up
+	png_destroy_read_struct(&png_ptr, (png_infopp)&info_ptr, (png_infopp)nullptr);
+	delete [] pFile;
+
+	// hand back the decoded data, it'll be uploaded to a texture by the caller
+	if (decoded.pixels == nullptr)
+		return false;
+	data = decoded;
+	return true;
+}
@@ -0,0 +1,34 @@
+﻿#pragma once
+
+#include "MigDefines.h"
+#include "Image.h"
+
+namespace MigTech
+{
+	// JPEG and PNG decoding shared by the renderers, the pixel load flags (see MigDefines.h) are applied to each
+	//  row as it comes out of the decoder and written straight into the final buffer, so there's one pass and one allocation
+	class ImageDecoder
+	{
+	public:
+		// 24-bit JPEGs only, RGB is only produced for LOAD_IMAGE_NONE and only if the renderer can upload it
+		//  with LOAD_IMAGE_FIT_OUTPUT libjpeg scales the image down while decoding (see getFitScale())
+		static bool loadJPEG(const std::string& path, unsigned int loadFlags, bool allowRGB, const Size& fitSize, ImageData& data);
+
+		// 8-bit greyscale, RGB, RGBA and palette PNGs, everything but greyscale comes out as RGBA
+		static bool loadPNG(const std::string& path, unsigned int loadFlags, ImageData& data);
+
+		// the largest of libjpeg's 1/2, 1/4 and 1/8 scales that still covers the fit size (1 if none do)
+		static int getFitScale(int srcWidth, int srcHeight, const Size& fitSize)
+		{
+			if (fitSize.width <= 0 || fitSize.height <= 0)
+				return 1;
+			int scale = 8;
+			while (scale > 1 && (getScaledDim(srcWidth, scale) < fitSize.width || getScaledDim(srcHeight, scale) < fitSize.height))
+				scale >>= 1;
+			return scale;
+		}
+
+		// libjpeg rounds scaled dimensions up
+		static int getScaledDim(int dim, int scale) { return (dim + scale - 1) / scale; }
+	};
+}
@@ -0,0 +1,377 @@
+﻿#include "pch.h"
+#include "KtxFile.h"
+#include "TextureCodec.h"
+#include "MipChain.h"
+#include "MigUtil.h"
+
+using namespace MigTech;
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+extern byte* plat_loadFileBuffer(const char* filePath, int& length);
+
+// file identifiers
+static const byte ktx1Ident[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const byte ktx2Ident[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+#define KTX1_HEADER_SIZE 64
+#define KTX2_HEADER_SIZE 80
+#define KTX2_LEVEL_INDEX_SIZE 24
+#define KTX_ENDIAN_REF 0x04030201
+#define KTX_ENDIAN_REF_REV 0x01020304
+
+// largest width or height accepted, keeps the level size math well inside 32 bits
+#define KTX_MAX_DIM 16384
+
+// GL enums found in KTX (v1) headers
+#define GL_ENUM_UNSIGNED_BYTE 0x1401
+#define GL_ENUM_ALPHA 0x1906
+#define GL_ENUM_RGB 0x1907
+#define GL_ENUM_RGBA 0x1908
+#define GL_ENUM_LUMINANCE 0x1909
+#define GL_ENUM_ETC1_RGB8 0x8D64
+#define GL_ENUM_ETC2_RGB8 0x9274
+#define GL_ENUM_ETC2_SRGB8 0x9275
+#define GL_ENUM_ETC2_RGBA8_EAC 0x9278
+#define GL_ENUM_ETC2_SRGB8_ALPHA8_EAC 0x9279
+#define GL_ENUM_DXT1_RGB 0x83F0
+#define GL_ENUM_DXT1_RGBA 0x83F1
+#define GL_ENUM_DXT5_RGBA 0x83F3
+#define GL_ENUM_ASTC_FIRST 0x93B0
+#define GL_ENUM_ASTC_SRGB_FIRST 0x93D0
+
+// Vulkan formats found in KTX2 headers (sRGB variants are the UNORM value + 1 unless noted)
+#define VK_FORMAT_R8_UNORM 9
+#define VK_FORMAT_R8_SRGB 15
+#define VK_FORMAT_R8G8B8_UNORM 23
+#define VK_FORMAT_R8G8B8_SRGB 29
+#define VK_FORMAT_R8G8B8A8_UNORM 37
+#define VK_FORMAT_R8G8B8A8_SRGB 43
+#define VK_FORMAT_BC1_RGB_UNORM 131
+#define VK_FORMAT_BC1_RGBA_SRGB 134
+#define VK_FORMAT_BC3_UNORM 137
+#define VK_FORMAT_BC3_SRGB 138
+#define VK_FORMAT_ETC2_RGB8_UNORM 147
+#define VK_FORMAT_ETC2_RGB8_SRGB 148
+#define VK_FORMAT_ETC2_RGBA8_UNORM 151
+#define VK_FORMAT_ETC2_RGBA8_SRGB 152
+#define VK_FORMAT_ASTC_FIRST 157
+
+// ASTC block footprints, in the order of both the GL and Vulkan enums
+static const int astcBlockSizes[][2] =
+{
+	{ 4, 4 }, { 5, 4 }, { 5, 5 }, { 6, 5 }, { 6, 6 }, { 8, 5 }, { 8, 6 },
+	{ 8, 8 }, { 10, 5 }, { 10, 6 }, { 10, 8 }, { 10, 10 }, { 12, 10 }, { 12, 12 }
+};
+#define ASTC_BLOCK_SIZE_COUNT (sizeof(astcBlockSizes) / sizeof(astcBlockSizes[0]))
+
+static unsigned int readU32(const byte* p, bool swap)
+{
+	if (swap)
+		return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+}
+
+static uint64 readU64(const byte* p)
+{
+	return (uint64) readU32(p, false) | ((uint64) readU32(p + 4, false) << 32);
+}
+
+static void setCompression(ImageData& data, TEX_COMPRESSION comp, int blockWidth, int blockHeight)
+{
+	data.compression = comp;
+	data.blockWidth = blockWidth;
+	data.blockHeight = blockHeight;
+	data.format = ((comp == TEX_COMPRESSION_ETC1 || comp == TEX_COMPRESSION_ETC2_RGB) ? IMG_FORMAT_RGB : IMG_FORMAT_RGBA);
+}
+
+static bool setFromGLFormat(unsigned int glType, unsigned int glFormat, unsigned int glInternalFormat, ImageData& data)
+{
+	if (glType == GL_ENUM_UNSIGNED_BYTE)
+	{
+		switch (glFormat)
+		{
+		case GL_ENUM_ALPHA: data.format = IMG_FORMAT_ALPHA; return true;
+		case GL_ENUM_LUMINANCE: data.format = IMG_FORMAT_GREYSCALE; return true;
+		case GL_ENUM_RGB: data.format = IMG_FORMAT_RGB; return true;
+		case GL_ENUM_RGBA: data.format = IMG_FORMAT_RGBA; return true;
+		}
+		return false;
+	}
+	else if (glType != 0)
+		return false;
+
+	switch (glInternalFormat)
+	{
+	case GL_ENUM_ETC1_RGB8: setCompression(data, TEX_COMPRESSION_ETC1, 4, 4); return true;
+	case GL_ENUM_ETC2_RGB8: case GL_ENUM_ETC2_SRGB8: setCompression(data, TEX_COMPRESSION_ETC2_RGB, 4, 4); return true;
+	case GL_ENUM_ETC2_RGBA8_EAC: case GL_ENUM_ETC2_SRGB8_ALPHA8_EAC: setCompression(data, TEX_COMPRESSION_ETC2_RGBA, 4, 4); return true;
+	case GL_ENUM_DXT1_RGB: case GL_ENUM_DXT1_RGBA: setCompression(data, TEX_COMPRESSION_BC1, 4, 4); return true;
+	case GL_ENUM_DXT5_RGBA: setCompression(data, TEX_COMPRESSION_BC3, 4, 4); return true;
+	}
+
+	for (unsigned int i = 0; i < ASTC_BLOCK_SIZE_COUNT; i++)
+	{
+		if (glInternalFormat == GL_ENUM_ASTC_FIRST + i || glInternalFormat == GL_ENUM_ASTC_SRGB_FIRST + i)
+		{
+			setCompression(data, TEX_COMPRESSION_ASTC, astcBlockSizes[i][0], astcBlockSizes[i][1]);
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool setFromVkFormat(unsigned int vkFormat, ImageData& data)
+{
+	switch (vkFormat)
+	{
+	case VK_FORMAT_R8_UNORM: case VK_FORMAT_R8_SRGB: data.format = IMG_FORMAT_GREYSCALE; return true;
+	case VK_FORMAT_R8G8B8_UNORM: case VK_FORMAT_R8G8B8_SRGB: data.format = IMG_FORMAT_RGB; return true;
+	case VK_FORMAT_R8G8B8A8_UNORM: case VK_FORMAT_R8G8B8A8_SRGB: data.format = IMG_FORMAT_RGBA; return true;
+	case VK_FORMAT_ETC2_RGB8_UNORM: case VK_FORMAT_ETC2_RGB8_SRGB: setCompression(data, TEX_COMPRESSION_ETC2_RGB, 4, 4); return true;
+	case VK_FORMAT_ETC2_RGBA8_UNORM: case VK_FORMAT_ETC2_RGBA8_SRGB: setCompression(data, TEX_COMPRESSION_ETC2_RGBA, 4, 4); return true;
+	case VK_FORMAT_BC3_UNORM: case VK_FORMAT_BC3_SRGB: setCompression(data, TEX_COMPRESSION_BC3, 4, 4); return true;
+	}
+
+	// the BC1 RGB and RGBA variants decode the same way
+	if (vkFormat >= VK_FORMAT_BC1_RGB_UNORM && vkFormat <= VK_FORMAT_BC1_RGBA_SRGB)
+	{
+		setCompression(data, TEX_COMPRESSION_BC1, 4, 4);
+		return true;
+	}
+	if (vkFormat >= VK_FORMAT_ASTC_FIRST && vkFormat < VK_FORMAT_ASTC_FIRST + 2*ASTC_BLOCK_SIZE_COUNT)
+	{
+		int i = (vkFormat - VK_FORMAT_ASTC_FIRST) / 2;
+		setCompression(data, TEX_COMPRESSION_ASTC, astcBlockSizes[i][0], astcBlockSizes[i][1]);
+		return true;
+	}
+	return false;
+}
+
+// sizes the level count and allocates room for every level
+static bool allocLevels(unsigned int levels, ImageData& data)
+{
+	// a count of 0 asks for levels to be generated at load time, the base level is all that's stored
+	if (levels > (unsigned int) MipChain::getFullLevelCount(data.width, data.height))
+		return false;
+	data.mipLevels = (levels > 0 ? (int) levels : 1);
+
+	data.dataSize = MipChain::getChainSize(data);
+	data.pixels = new byte[data.dataSize];
+	return true;
+}
+
+// copies a level into its place in data.pixels, rows of uncompressed pixels may be padded in the file
+static bool copyLevel(const byte* pLevel, unsigned int levelSize, unsigned int rowAlign, int level, ImageData& data)
+{
+	byte* pDest = data.pixels + MipChain::getLevelOffset(data, level);
+	unsigned int destSize = MipChain::getLevelSize(data, level);
+	if (data.isCompressed())
+	{
+		if (levelSize < destSize)
+			return false;
+
+		memcpy(pDest, pLevel, destSize);
+		return true;
+	}
+
+	int height = MipChain::getLevelDim(data.height, level);
+	unsigned int rowSize = destSize / height;
+	unsigned int fileStride = (rowSize + rowAlign - 1) / rowAlign * rowAlign;
+	if (levelSize < fileStride * (height - 1) + rowSize)
+		return false;
+
+	for (int y = 0; y < height; y++)
+		memcpy(pDest + y*rowSize, pLevel + y*fileStride, rowSize);
+	return true;
+}
+
+static bool parseKtx1(const byte* pFile, int len, ImageData& data)
+{
+	if (len < KTX1_HEADER_SIZE)
+		return false;
+
+	unsigned int endian = readU32(pFile + 12, false);
+	if (endian != KTX_ENDIAN_REF && endian != KTX_ENDIAN_REF_REV)
+		return false;
+	bool swap = (endian == KTX_ENDIAN_REF_REV);
+
+	unsigned int glType = readU32(pFile + 16, swap);
+	unsigned int glFormat = readU32(pFile + 24, swap);
+	unsigned int glInternalFormat = readU32(pFile + 28, swap);
+	data.width = (int) readU32(pFile + 36, swap);
+	data.height = (int) readU32(pFile + 40, swap);
+	unsigned int depth = readU32(pFile + 44, swap);
+	unsigned int arrayElements = readU32(pFile + 48, swap);
+	unsigned int faces = readU32(pFile + 52, swap);
+	unsigned int levels = readU32(pFile + 56, swap);
+	unsigned int kvBytes = readU32(pFile + 60, swap);
+	if (data.width <= 0 || data.height <= 0 || depth > 1 || arrayElements > 1 || faces != 1)
+	{
+		LOGWARN("(KtxFile::parse) Only 2D textures are supported");
+		return false;
+	}
+	if (data.width > KTX_MAX_DIM || data.height > KTX_MAX_DIM)
+	{
+		LOGWARN("(KtxFile::parse) Texture is too large (%dx%d)", data.width, data.height);
+		return false;
+	}
+	if (!setFromGLFormat(glType, glFormat, glInternalFormat, data))
+	{
+		LOGWARN("(KtxFile::parse) Unsupported format 0x%x/0x%x", glFormat, glInternalFormat);
+		return false;
+	}
+
+	if (kvBytes > (unsigned int) len - KTX1_HEADER_SIZE || !allocLevels(levels, data))
+		return false;
+
+	// the levels follow the key/value data, each prefixed by its size and padded to 4 bytes
+	// (bounds are tested against what's left of the file so nothing can wrap)
+	unsigned int offset = KTX1_HEADER_SIZE + kvBytes;
+	for (int level = 0; level < data.mipLevels; level++)
+	{
+		if (offset > (unsigned int) len || 4 > len - offset)
+			return false;
+		unsigned int levelSize = readU32(pFile + offset, swap);
+		offset += 4;
+		if (levelSize > len - offset || !copyLevel(pFile + offset, levelSize, 4, level, data))
+			return false;
+		offset += (levelSize + 3) / 4 * 4;
+	}
+	return true;
+}
+
+static bool parseKtx2(const byte* pFile, int len, ImageData& data)
+{
+	if (len < KTX2_HEADER_SIZE + KTX2_LEVEL_INDEX_SIZE)
+		return false;
+
+	unsigned int vkFormat = readU32(pFile + 12, false);
+	data.width = (int) readU32(pFile + 20, false);
+	data.height = (int) readU32(pFile + 24, false);
+	unsigned int depth = readU32(pFile + 28, false);
+	unsigned int layers = readU32(pFile + 32, false);
+	unsigned int faces = readU32(pFile + 36, false);
+	unsigned int levels = readU32(pFile + 40, false);
+	unsigned int superScheme = readU32(pFile + 44, false);
+	if (data.width <= 0 || data.height <= 0 || depth > 1 || layers > 1 || faces != 1)
+	{
+		LOGWARN("(KtxFile::parse) Only 2D textures are supported");
+		return false;
+	}
+	if (data.width > KTX_MAX_DIM || data.height > KTX_MAX_DIM)
+	{
+		LOGWARN("(KtxFile::parse) Texture is too large (%dx%d)", data.width, data.height);
+		return false;
+	}
+	if (superScheme != 0)
+	{
+		LOGWARN("(KtxFile::parse) Supercompressed files aren't supported");
+		return false;
+	}
+	if (!setFromVkFormat(vkFormat, data))
+	{
+		LOGWARN("(KtxFile::parse) Unsupported format %d", vkFormat);
+		return false;
+	}
+
+	if (!allocLevels(levels, data) || len < KTX2_HEADER_SIZE + data.mipLevels*KTX2_LEVEL_INDEX_SIZE)
+		return false;
+
+	// the level index starts with the base level (the level data itself is stored smallest first)
+	for (int level = 0; level < data.mipLevels; level++)
+	{
+		const byte* pIndex = pFile + KTX2_HEADER_SIZE + level*KTX2_LEVEL_INDEX_SIZE;
+		uint64 offset = readU64(pIndex);
+		uint64 levelSize = readU64(pIndex + 8);
+		if (offset > (uint64) len || levelSize > len - offset || !copyLevel(pFile + offset, (unsigned int) levelSize, 1, level, data))
+			return false;
+	}
+	return true;
+}
+
+bool KtxFile::isKtx(const byte* pFile, int len)
+{
+	return (len >= 12 && (memcmp(pFile, ktx1Ident, 12) == 0 || memcmp(pFile, ktx2Ident, 12) == 0));
+}
+
+bool KtxFile::parse(const byte* pFile, int len, ImageData& data)
+{
+	if (!isKtx(pFile, len))
+		return false;
+
+	bool ok = (pFile[5] == '1' ? parseKtx1(pFile, len, data) : parseKtx2(pFile, len, data));
+	if (!ok)
+		data.release();
+	return ok;
+}
+
+// CPU only, this is called from the asset loader threads
+bool KtxFile::loadImage(const std::string& path, unsigned int loadFlags, unsigned int compressionCaps, ImageData& data)
+{
+	int len = 0;
+	byte* pFile = plat_loadFileBuffer(path.c_str(), len);
+	if (pFile == nullptr)
+	{
+		LOGWARN("(KtxFile::loadImage) image '%s' doesn't exist", path.c_str());
+		return false;
+	}
+
+	bool ok = parse(pFile, len, data);
+	delete [] pFile;
+	if (!ok)
+	{
+		LOGWARN("(KtxFile::loadImage) image '%s' could not be parsed", path.c_str());
+		return false;
+	}
+	if (loadFlags & LOAD_IMAGE_PIXEL_FLAGS)
+		LOGWARN("(KtxFile::loadImage) Load flags are ignored for '%s'", path.c_str());
+
+	// ETC1 blocks are valid ETC2 blocks
+	if (data.compression == TEX_COMPRESSION_ETC1 && (compressionCaps & (1 << TEX_COMPRESSION_ETC1)) == 0)
+		data.compression = TEX_COMPRESSION_ETC2_RGB;
+
+	// partial blocks at the edges are only decoded for renderers that can't upload them (see TEX_CAPS_WHOLE_BLOCKS)
+	bool wholeBlocks = (data.width % data.blockWidth == 0 && data.height % data.blockHeight == 0);
+	bool supported = ((compressionCaps & (1 << data.compression)) != 0);
+	if (data.isCompressed() && (!supported || (!wholeBlocks && (compressionCaps & TEX_CAPS_WHOLE_BLOCKS) != 0)))
+	{
+		ImageData decoded;
+		if (!TextureCodec::decompress(data, decoded))
+		{
+			LOGWARN("(KtxFile::loadImage) image '%s' has no CPU decoder for its format", path.c_str());
+			data.release();
+			return false;
+		}
+		LOGINFO("(KtxFile::loadImage) image '%s' was decoded on the CPU", path.c_str());
+		data.release();
+		data = decoded;
+	}
+
+	// levels can be built for decoded data (see MipChain) but block compressed data has to be cooked with them
+	if ((loadFlags & LOAD_IMAGE_MIPMAPS) && data.isCompressed() && data.mipLevels == 1)
+		LOGWARN("(KtxFile::loadImage) image '%s' has no mip levels", path.c_str());
+	return true;
+}
+
+unsigned int KtxFile::getGLInternalFormat(const ImageData& data)
+{
+	switch (data.compression)
+	{
+	case TEX_COMPRESSION_ETC1: return GL_ENUM_ETC1_RGB8;
+	case TEX_COMPRESSION_ETC2_RGB: return GL_ENUM_ETC2_RGB8;
+	case TEX_COMPRESSION_ETC2_RGBA: return GL_ENUM_ETC2_RGBA8_EAC;
+	case TEX_COMPRESSION_BC1: return GL_ENUM_DXT1_RGBA;
+	case TEX_COMPRESSION_BC3: return GL_ENUM_DXT5_RGBA;
+	case TEX_COMPRESSION_ASTC:
+		for (unsigned int i = 0; i < ASTC_BLOCK_SIZE_COUNT; i++)
+		{
+			if (astcBlockSizes[i][0] == data.blockWidth && astcBlockSizes[i][1] == data.blockHeight)
+				return GL_ENUM_ASTC_FIRST + i;
+		}
+		return 0;
+	default:
+		return 0;
+	}
+}
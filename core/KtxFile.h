@@ -0,0 +1,25 @@
+﻿#pragma once
+
+#include "MigDefines.h"
+#include "Image.h"
+
+namespace MigTech
+{
+	// KTX (v1) and KTX2 texture containers, 2D textures only (with their mip levels, see MipChain)
+	//  supercompressed KTX2 files (Basis, zstd) aren't supported
+	class KtxFile
+	{
+	public:
+		// true if the buffer starts with either file identifier
+		static bool isKtx(const byte* pFile, int len);
+
+		// copies the levels out of the container, block compressed data stays compressed
+		static bool parse(const byte* pFile, int len, ImageData& data);
+
+		// loads and parses a file, compressed formats missing from the caps (see RenderBase) are decoded on the CPU
+		static bool loadImage(const std::string& path, unsigned int loadFlags, unsigned int compressionCaps, ImageData& data);
+
+		// the GL internal format for compressed data, 0 if there isn't one
+		static unsigned int getGLInternalFormat(const ImageData& data);
+	};
+}
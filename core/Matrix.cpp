@@ -4,119 +4,185 @@
 
 using namespace MigTech;
 
-Matrix::Matrix()
-{
-	if (MigUtil::theRend != nullptr)
-		_mat = MigUtil::theRend->createMatrix();
-	else
-		_mat = nullptr;
-}
-
-Matrix::Matrix(const Matrix& other)
-{
-	if (MigUtil::theRend != nullptr)
-	{
-		_mat = MigUtil::theRend->createMatrix();
-		_mat->copy(other._mat);
-	}
-	else
-		throw std::runtime_error("(Matrix::Matrix) Cannot copy another matrix w/o a renderer");
-}
-
-Matrix::Matrix(IMatrix* passign)
-{
-	_mat = passign;
-}
-
-Matrix::~Matrix()
-{
-	if (_mat != nullptr && MigUtil::theRend != nullptr)
-		MigUtil::theRend->deleteMatrix(_mat);
-}
-
-void Matrix::identity()
-{
-	// special case - delayed creation
-	if (_mat == nullptr && MigUtil::theRend != nullptr)
-		_mat = MigUtil::theRend->createMatrix();
-
-	_mat->identity();
-}
-
-void Matrix::copy(const Matrix& mat)
-{
-	_mat->copy(mat._mat);
-}
+bool Matrix::_depthZeroToOne = false;
 
+// elements are given in memory order
 void Matrix::load(float m00, float m01, float m02, float m03, float m10, float m11, float m12, float m13, float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33)
 {
-	_mat->load(m00, m01, m02, m03, m10, m11, m12, m13, m20, m21, m22, m23, m30, m31, m32, m33);
+	_m[0]  = m00; _m[1]  = m01; _m[2]  = m02; _m[3]  = m03;
+	_m[4]  = m10; _m[5]  = m11; _m[6]  = m12; _m[7]  = m13;
+	_m[8]  = m20; _m[9]  = m21; _m[10] = m22; _m[11] = m23;
+	_m[12] = m30; _m[13] = m31; _m[14] = m32; _m[15] = m33;
+	_isIdentity = false;
 }
 
 void Matrix::load(const float* pelem)
 {
-	_mat->load(pelem);
-}
+	if (pelem == nullptr)
+		throw std::invalid_argument("(Matrix::load) pelem is nullptr");
 
-void Matrix::loadPerspectiveFovRH(float angleY, float aspect, float nearZ, float farZ)
-{
-	_mat->loadPerspectiveFovRH(angleY, aspect, nearZ, farZ);
+	memcpy(_m, pelem, sizeof(_m));
+	_isIdentity = false;
 }
 
-void Matrix::loadLookAtRH(Vector3 eyePos, Vector3 focusPos, Vector3 upVector)
+// copied from OpenGL GLM code (and XMMatrixPerspectiveFovRH for the 0 to 1 depth range)
+void Matrix::loadPerspectiveFovRH(float angleY, float aspect, float nearZ, float farZ)
 {
-	_mat->loadLookAtRH(eyePos, focusPos, upVector);
-}
+	float tanHalfFovy = tan(angleY / 2.0f);
 
-void Matrix::multiply(const Matrix& mat)
-{
-	_mat->multiply(mat._mat);
+	memset(_m, 0, sizeof(_m));
+	_m[0] = 1.0f / (aspect * tanHalfFovy);
+	_m[5] = 1.0f / tanHalfFovy;
+	_m[11] = -1.0f;
+	if (_depthZeroToOne)
+	{
+		_m[10] = farZ / (nearZ - farZ);
+		_m[14] = (farZ * nearZ) / (nearZ - farZ);
+	}
+	else
+	{
+		_m[10] = -(farZ + nearZ) / (farZ - nearZ);
+		_m[14] = -(2.0f * farZ * nearZ) / (farZ - nearZ);
+	}
+	_isIdentity = false;
 }
 
-void Matrix::translate(const Vector3& offset)
-{
-	_mat->translate(offset);
+#define normalize(x, y, z)                  \
+{                                           \
+    float norm = 1.0f / sqrt(x*x+y*y+z*z);  \
+    x *= norm; y *= norm; z *= norm;        \
 }
 
-void Matrix::translate(float x, float y, float z)
+// copied from OpenGL GLM code
+void Matrix::loadLookAtRH(Vector3 eyePos, Vector3 focusPos, Vector3 upVector)
 {
-	_mat->translate(x, y, z);
-}
-
+	float fx = focusPos.x - eyePos.x;
+	float fy = focusPos.y - eyePos.y;
+	float fz = focusPos.z - eyePos.z;
+	normalize(fx, fy, fz);
+	float sx = fy * upVector.z - fz * upVector.y;
+	float sy = fz * upVector.x - fx * upVector.z;
+	float sz = fx * upVector.y - fy * upVector.x;
+	normalize(sx, sy, sz);
+	float ux = sy * fz - sz * fy;
+	float uy = sz * fx - sx * fz;
+	float uz = sx * fy - sy * fx;
+
+	_m[ 0] = sx;
+	_m[ 1] = ux;
+	_m[ 2] = -fx;
+	_m[ 3] = 0.0f;
+	_m[ 4] = sy;
+	_m[ 5] = uy;
+	_m[ 6] = -fy;
+	_m[ 7] = 0.0f;
+	_m[ 8] = sz;
+	_m[ 9] = uz;
+	_m[10] = -fz;
+	_m[11] = 0.0f;
+	_m[12] = -(sx*eyePos.x + sy*eyePos.y + sz*eyePos.z);
+	_m[13] = -(ux*eyePos.x + uy*eyePos.y + uz*eyePos.z);
+	_m[14] =  (fx*eyePos.x + fy*eyePos.y + fz*eyePos.z);
+	_m[15] = 1.0f;
+	_isIdentity = false;
+}
+
+// the rotations only touch two components of each basis vector, so they're done in place
 void Matrix::rotateX(float angle)
 {
-	_mat->rotateX(angle);
+	float c = cos(angle);
+	float s = sin(angle);
+	for (int j = 0; j < 4; j++)
+	{
+		float a1 = _m[4 * j + 1];
+		float a2 = _m[4 * j + 2];
+		_m[4 * j + 1] = c * a1 - s * a2;
+		_m[4 * j + 2] = s * a1 + c * a2;
+	}
+	_isIdentity = false;
 }
 
 void Matrix::rotateY(float angle)
 {
-	_mat->rotateY(angle);
+	float c = cos(angle);
+	float s = sin(angle);
+	for (int j = 0; j < 4; j++)
+	{
+		float a0 = _m[4 * j + 0];
+		float a2 = _m[4 * j + 2];
+		_m[4 * j + 0] = c * a0 + s * a2;
+		_m[4 * j + 2] = c * a2 - s * a0;
+	}
+	_isIdentity = false;
 }
 
 void Matrix::rotateZ(float angle)
 {
-	_mat->rotateZ(angle);
+	float c = cos(angle);
+	float s = sin(angle);
+	for (int j = 0; j < 4; j++)
+	{
+		float a0 = _m[4 * j + 0];
+		float a1 = _m[4 * j + 1];
+		_m[4 * j + 0] = c * a0 - s * a1;
+		_m[4 * j + 1] = s * a0 + c * a1;
+	}
+	_isIdentity = false;
 }
 
-void Matrix::scale(float sx, float sy, float sz)
+void Matrix::transform(const Vector3* pin, Vector3* pout, int count) const
 {
-	_mat->scale(sx, sy, sz);
-}
+	if (pin == nullptr || pout == nullptr)
+		throw std::invalid_argument("(Matrix::transform) Invalid point arrays");
 
-void Matrix::transform(Vector3& pt) const
-{
-	_mat->transform(pt);
+#if defined(MATRIX_USE_SSE)
+	__m128 c0 = _mm_loadu_ps(_m + 0);
+	__m128 c1 = _mm_loadu_ps(_m + 4);
+	__m128 c2 = _mm_loadu_ps(_m + 8);
+	__m128 c3 = _mm_loadu_ps(_m + 12);
+	for (int i = 0; i < count; i++)
+	{
+		__m128 v = _mm_add_ps(c3, _mm_mul_ps(c0, _mm_set1_ps(pin[i].x)));
+		v = _mm_add_ps(v, _mm_mul_ps(c1, _mm_set1_ps(pin[i].y)));
+		v = _mm_add_ps(v, _mm_mul_ps(c2, _mm_set1_ps(pin[i].z)));
+
+		float out[4];
+		_mm_storeu_ps(out, v);
+		pout[i].x = out[0];
+		pout[i].y = out[1];
+		pout[i].z = out[2];
+	}
+#elif defined(MATRIX_USE_NEON)
+	float32x4_t c0 = vld1q_f32(_m + 0);
+	float32x4_t c1 = vld1q_f32(_m + 4);
+	float32x4_t c2 = vld1q_f32(_m + 8);
+	float32x4_t c3 = vld1q_f32(_m + 12);
+	for (int i = 0; i < count; i++)
+	{
+		float32x4_t v = vmlaq_n_f32(c3, c0, pin[i].x);
+		v = vmlaq_n_f32(v, c1, pin[i].y);
+		v = vmlaq_n_f32(v, c2, pin[i].z);
+
+		float out[4];
+		vst1q_f32(out, v);
+		pout[i].x = out[0];
+		pout[i].y = out[1];
+		pout[i].z = out[2];
+	}
+#else
+	for (int i = 0; i < count; i++)
+	{
+		pout[i] = pin[i];
+		transform(pout[i]);
+	}
+#endif
 }
 
 void Matrix::dump(const char* prefix) const
 {
-	_mat->dump(prefix);
-}
-
-IMatrix* Matrix::operator*(const Matrix& rhs)
-{
-	IMatrix* pmat = MigUtil::theRend->createMatrix();
-	pmat->copy(_mat);
-	pmat->multiply(rhs._mat);
-	return pmat;
+	LOGINFO(prefix);
+	LOGINFO("%f %f %f %f", _m[0], _m[1], _m[2], _m[3]);
+	LOGINFO("%f %f %f %f", _m[4], _m[5], _m[6], _m[7]);
+	LOGINFO("%f %f %f %f", _m[8], _m[9], _m[10], _m[11]);
+	LOGINFO("%f %f %f %f", _m[12], _m[13], _m[14], _m[15]);
 }
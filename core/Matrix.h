@@ -1,51 +1,37 @@
-#pragma once
+﻿#pragma once
 
 #include "MigDefines.h"
 
+// pick the SIMD kernels for the matrix math
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#include <xmmintrin.h>
+#define MATRIX_USE_SSE
+#elif defined(_M_ARM) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MATRIX_USE_NEON
+#endif
+
 namespace MigTech
 {
-	// this is a matrix interface class that platforms can provide
-	class IMatrix
-	{
-	public:
-		IMatrix() { }
-		virtual ~IMatrix() { }
-
-		virtual void identity() = 0;
-		virtual void copy(const IMatrix* pmat) = 0;
-		virtual void load(float m00, float m01, float m02, float m03, float m10, float m11, float m12, float m13, float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33) = 0;
-		virtual void load(const float* pelem) = 0;
-
-		virtual void loadPerspectiveFovRH(float angleY, float aspect, float nearZ, float farZ) = 0;
-		virtual void loadLookAtRH(Vector3 eyePos, Vector3 focusPos, Vector3 upVector) = 0;
-
-		virtual void multiply(const IMatrix* pmat) = 0;
-		virtual void translate(const Vector3& offset) = 0;
-		virtual void translate(float x, float y, float z) = 0;
-		virtual void rotateX(float angle) = 0;
-		virtual void rotateY(float angle) = 0;
-		virtual void rotateZ(float angle) = 0;
-		virtual void scale(float sx, float sy, float sz) = 0;
-
-		virtual void transform(Vector3& pt) const = 0;
-
-		virtual void dump(const char* prefix) const = 0;
-	};
-
-	// this is simply a container class for IMatrix
+	// value type 4x4 matrix, stored so that each group of 4 floats is a basis vector (column major for
+	// OpenGL, row major for DirectX, which is the same memory layout), translation is in elements 12-14
+	//  - a.multiply(b) applies a and then b, translate/rotate/scale are applied after the existing transform
+	//  - the kernels use unaligned loads, the storage isn't over-aligned so matrices can sit anywhere
+	//    in heap allocated objects and vectors (new is only 8 byte aligned on 32-bit)
 	class Matrix
 	{
 	protected:
-		IMatrix* _mat;
+		float _m[16];
+		bool _isIdentity;
+
+		// clip space depth range used by loadPerspectiveFovRH(), set by the renderer
+		static bool _depthZeroToOne;
 
 	public:
-		Matrix();
-		Matrix(const Matrix& other);
-		Matrix(IMatrix* passign);
-		~Matrix();
+		Matrix() { identity(); }
 
 		void identity();
-		void copy(const Matrix& mat);
+		void copy(const Matrix& mat) { *this = mat; }
 		void load(float m00, float m01, float m02, float m03, float m10, float m11, float m12, float m13, float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33);
 		void load(const float* pelem);
 
@@ -53,7 +39,7 @@ namespace MigTech
 		void loadLookAtRH(Vector3 eyePos, Vector3 focusPos, Vector3 upVector);
 
 		void multiply(const Matrix& mat);
-		void translate(const Vector3& offset);
+		void translate(const Vector3& offset) { translate(offset.x, offset.y, offset.z); }
 		void translate(float x, float y, float z);
 		void rotateX(float angle);
 		void rotateY(float angle);
@@ -61,11 +47,136 @@ namespace MigTech
 		void scale(float sx, float sy, float sz);
 
 		void transform(Vector3& pt) const;
+		void transform(const Vector3* pin, Vector3* pout, int count) const;
 
 		void dump(const char* prefix) const;
 
-		IMatrix* operator*(const Matrix& rhs);
-		//operator IMatrix*() { return _mat; }
-		operator const IMatrix*() const { return _mat; }
+		const float* getData() const { return _m; }
+		bool isIdentity() const { return _isIdentity; }
+
+		// out = first followed by second, out may be either of the inputs
+		static void multiply(const Matrix& first, const Matrix& second, Matrix& out);
+
+		// OpenGL uses -1 to 1 (the default), DirectX uses 0 to 1
+		static void setDepthZeroToOne(bool zeroToOne) { _depthZeroToOne = zeroToOne; }
+		static bool getDepthZeroToOne() { return _depthZeroToOne; }
 	};
+
+	inline void Matrix::identity()
+	{
+		_m[0]  = 1; _m[1]  = 0; _m[2]  = 0; _m[3]  = 0;
+		_m[4]  = 0; _m[5]  = 1; _m[6]  = 0; _m[7]  = 0;
+		_m[8]  = 0; _m[9]  = 0; _m[10] = 1; _m[11] = 0;
+		_m[12] = 0; _m[13] = 0; _m[14] = 0; _m[15] = 1;
+		_isIdentity = true;
+	}
+
+	inline void Matrix::multiply(const Matrix& first, const Matrix& second, Matrix& out)
+	{
+		if (first._isIdentity)
+		{
+			out = second;
+			return;
+		}
+		if (second._isIdentity)
+		{
+			out = first;
+			return;
+		}
+
+		const float* a = first._m;
+		const float* b = second._m;
+#if defined(MATRIX_USE_SSE)
+		__m128 b0 = _mm_loadu_ps(b + 0);
+		__m128 b1 = _mm_loadu_ps(b + 4);
+		__m128 b2 = _mm_loadu_ps(b + 8);
+		__m128 b3 = _mm_loadu_ps(b + 12);
+		__m128 r[4];
+		for (int j = 0; j < 4; j++)
+		{
+			__m128 v = _mm_mul_ps(b0, _mm_set1_ps(a[4 * j + 0]));
+			v = _mm_add_ps(v, _mm_mul_ps(b1, _mm_set1_ps(a[4 * j + 1])));
+			v = _mm_add_ps(v, _mm_mul_ps(b2, _mm_set1_ps(a[4 * j + 2])));
+			r[j] = _mm_add_ps(v, _mm_mul_ps(b3, _mm_set1_ps(a[4 * j + 3])));
+		}
+		for (int j = 0; j < 4; j++)
+			_mm_storeu_ps(out._m + 4 * j, r[j]);
+#elif defined(MATRIX_USE_NEON)
+		float32x4_t b0 = vld1q_f32(b + 0);
+		float32x4_t b1 = vld1q_f32(b + 4);
+		float32x4_t b2 = vld1q_f32(b + 8);
+		float32x4_t b3 = vld1q_f32(b + 12);
+		float32x4_t r[4];
+		for (int j = 0; j < 4; j++)
+		{
+			float32x4_t v = vmulq_n_f32(b0, a[4 * j + 0]);
+			v = vmlaq_n_f32(v, b1, a[4 * j + 1]);
+			v = vmlaq_n_f32(v, b2, a[4 * j + 2]);
+			r[j] = vmlaq_n_f32(v, b3, a[4 * j + 3]);
+		}
+		for (int j = 0; j < 4; j++)
+			vst1q_f32(out._m + 4 * j, r[j]);
+#else
+		float r[16];
+		for (int j = 0; j < 4; j++)
+		{
+			for (int i = 0; i < 4; i++)
+				r[4 * j + i] = b[i] * a[4 * j + 0] + b[4 + i] * a[4 * j + 1] + b[8 + i] * a[4 * j + 2] + b[12 + i] * a[4 * j + 3];
+		}
+		memcpy(out._m, r, sizeof(r));
+#endif
+		out._isIdentity = false;
+	}
+
+	inline void Matrix::multiply(const Matrix& mat)
+	{
+		multiply(*this, mat, *this);
+	}
+
+	inline void Matrix::translate(float x, float y, float z)
+	{
+		// each basis vector picks up the offset scaled by its w component
+#if defined(MATRIX_USE_SSE)
+		__m128 offset = _mm_set_ps(0, z, y, x);
+		for (int j = 0; j < 4; j++)
+		{
+			__m128 v = _mm_loadu_ps(_m + 4 * j);
+			_mm_storeu_ps(_m + 4 * j, _mm_add_ps(v, _mm_mul_ps(offset, _mm_set1_ps(_m[4 * j + 3]))));
+		}
+#else
+		for (int j = 0; j < 4; j++)
+		{
+			float w = _m[4 * j + 3];
+			_m[4 * j + 0] += x * w;
+			_m[4 * j + 1] += y * w;
+			_m[4 * j + 2] += z * w;
+		}
+#endif
+		_isIdentity = false;
+	}
+
+	inline void Matrix::scale(float sx, float sy, float sz)
+	{
+#if defined(MATRIX_USE_SSE)
+		__m128 s = _mm_set_ps(1, sz, sy, sx);
+		for (int j = 0; j < 4; j++)
+			_mm_storeu_ps(_m + 4 * j, _mm_mul_ps(_mm_loadu_ps(_m + 4 * j), s));
+#else
+		for (int j = 0; j < 4; j++)
+		{
+			_m[4 * j + 0] *= sx;
+			_m[4 * j + 1] *= sy;
+			_m[4 * j + 2] *= sz;
+		}
+#endif
+		_isIdentity = false;
+	}
+
+	inline void Matrix::transform(Vector3& pt) const
+	{
+		float x = pt.x, y = pt.y, z = pt.z;
+		pt.x = x * _m[0] + y * _m[4] + z * _m[8] + _m[12];
+		pt.y = x * _m[1] + y * _m[5] + z * _m[9] + _m[13];
+		pt.z = x * _m[2] + y * _m[6] + z * _m[10] + _m[14];
+	}
 }
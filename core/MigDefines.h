@@ -12,6 +12,7 @@ namespace MigTech
 #define SHADER_HINT_PROJ		0x4
 #define SHADER_HINT_MVP			0x8
 #define SHADER_HINT_LIGHTS		0x10
+#define SHADER_HINT_INSTANCED	0x20	// takes per-instance data (see InstanceData)
 
 // maximum number of supported texture maps per object
 #define MAX_TEXTURE_MAPS		2
@@ -23,12 +24,23 @@ namespace MigTech
 #define LOAD_IMAGE_SET_ALPHA	0x4
 #define LOAD_IMAGE_CLEAR_ALPHA	0x8
 #define LOAD_IMAGE_DROP_COLOR	0x10
+#define LOAD_IMAGE_MIPMAPS		0x20	// builds a full mip chain (see MipChain)
+#define LOAD_IMAGE_FIT_OUTPUT	0x40	// JPEGs are decoded at 1/2, 1/4 or 1/8 size if that still covers the output size
+
+// the load flags above that change the decoded pixels
+#define LOAD_IMAGE_PIXEL_FLAGS	0x1F
+
+// renderer compression caps are a bit per TEX_COMPRESSION, plus this one when the GPU can't take
+//  partial blocks at the edges of a texture (D3D11 BC), GLES takes them for ETC2 and ASTC
+#define TEX_CAPS_WHOLE_BLOCKS	0x80000000
 
 // platform bits
 #define PLAT_WINDOWS			0x1
 #define PLAT_ANDROID			0x2
 #define PLAT_DESKTOP			0x4
 #define PLAT_IOS				0x8
+#define PLAT_HEADLESS			0x10
+#define PLAT_LINUX				0x20
 
 	///////////////////////////////////////////////////////////////////////////
 	// enums
@@ -68,6 +80,12 @@ namespace MigTech
 		PRIMITIVE_TYPE_TRIANGLE_FAN
 	};
 
+	enum BUFFER_USAGE
+	{
+		BUFFER_USAGE_STATIC,	// loaded once, drawn many times
+		BUFFER_USAGE_DYNAMIC	// reloaded often, storage is reused when it fits
+	};
+
 	enum FACE_CULLING
 	{
 		FACE_CULLING_NONE,
@@ -105,6 +123,19 @@ namespace MigTech
 		IMG_FORMAT_RGBA
 	};
 
+	// GPU block compressed formats, see KtxFile
+	enum TEX_COMPRESSION
+	{
+		TEX_COMPRESSION_NONE,
+		TEX_COMPRESSION_ETC1,
+		TEX_COMPRESSION_ETC2_RGB,
+		TEX_COMPRESSION_ETC2_RGBA,
+		TEX_COMPRESSION_BC1,
+		TEX_COMPRESSION_BC3,
+		TEX_COMPRESSION_ASTC,
+		TEX_COMPRESSION_COUNT
+	};
+
 	enum TXT_FILTER
 	{
 		TXT_FILTER_NONE,
@@ -273,6 +304,13 @@ namespace MigTech
 		}
 	};
 
+	// texture coordinates of a rectangle within an image
+	struct UVSet
+	{
+		float u1, v1;
+		float u2, v2;
+	};
+
 	///////////////////////////////////////////////////////////////////////////
 	// common vertex structures used to define geometry (one for each VDTYPE)
 
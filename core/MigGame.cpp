@@ -2,6 +2,9 @@
 #include "MigInclude.h"
 #include "Timer.h"
 #include "PerfMon.h"
+#include "Profiler.h"
+#include "AssetLoader.h"
+#include "ResourceCache.h"
 
 using namespace MigTech;
 using namespace tinyxml2;
@@ -48,6 +51,7 @@ bool MigGame::initRenderer(RenderBase* rtObj)
 	if (!rtObj->initRenderer())
 		return false;
 	MigUtil::theRend = rtObj;
+	MigUtil::theSprites = new SpriteBatch();
 
 	LOGINFO("(MigGame::initRenderer) MigTech renderer initialized");
 	return true;
@@ -57,12 +61,20 @@ bool MigGame::termRenderer()
 {
 	LOGINFO("(MigGame::termRenderer) MigTech renderer stopping");
 
+	// the loader threads decode through the renderer
+	AssetLoader::term();
+
+	if (MigUtil::theSprites != nullptr)
+		delete MigUtil::theSprites;
+	MigUtil::theSprites = nullptr;
+
 	if (MigUtil::theRend != nullptr)
 	{
 		MigUtil::theRend->termRenderer();
 		delete MigUtil::theRend;
 	}
 	MigUtil::theRend = nullptr;
+	ResourceCache::clear(RESOURCE_IMAGE);
 
 	LOGINFO("(MigGame::termRenderer) MigTech renderer stopped");
 	return true;
@@ -85,6 +97,7 @@ bool MigGame::termGameEngine()
 		delete MigUtil::theAudio;
 	}
 	MigUtil::theAudio = nullptr;
+	ResourceCache::clear(RESOURCE_SOUND);
 
 	LOGINFO("(MigGame::termGameEngine) MigTech game engine stopped");
 	return true;
@@ -99,7 +112,7 @@ unsigned int MigGame::queryPlatformBits()
 // Game class implementation
 
 MigGame::MigGame(const std::string& appName) :
-	_appName(appName), _cfgDoc(nullptr), _currScreen(nullptr), _newScreenOnNextUpdate(false)
+	_appName(appName), _cfgDoc(nullptr), _currScreen(nullptr), _newScreenOnNextUpdate(false), _prefetchStarted(false)
 {
 	if (MigUtil::theGame != nullptr)
 		throw std::runtime_error("(MigGame::MigGame) MigTech game singleton already set");
@@ -137,8 +150,39 @@ void MigGame::onCreate()
 			{
 				bool active = MigUtil::parseBool(elem->Attribute("active"), false);
 				PerfMon::showFPS(active);
+
+				// CPU profiler zones, the overlay and chrome trace captures are optional
+				Profiler::enable(MigUtil::parseBool(elem->Attribute("zones"), false));
+				Profiler::showOverlay(MigUtil::parseBool(elem->Attribute("overlay"), false));
+				int capture = MigUtil::parseInt(elem->Attribute("capture"), 0);
+				if (capture > 0)
+					Profiler::startCapture(capture);
+			}
+
+			// asynchronous image loading (optional), w/o any threads images load right away
+			elem = _cfgRoot->FirstChildElement("loader");
+			if (elem != nullptr)
+			{
+				int threads = MigUtil::parseInt(elem->Attribute("threads"), 0);
+				float budget = MigUtil::parseFloat(elem->Attribute("budget"), 4);
+				if (threads > 0)
+					AssetLoader::init(threads, (long)(1000 * budget));
 			}
 
+			// texture memory budget in MB (optional), w/o one idle images are freed right away
+			elem = _cfgRoot->FirstChildElement("textures");
+			if (elem != nullptr)
+			{
+				float budget = MigUtil::parseFloat(elem->Attribute("budget"), 0);
+				if (budget > 0)
+					ResourceCache::setImageBudget((uint64)(budget * 1024 * 1024));
+			}
+
+			// texture atlas index (optional), written by tools/atlascooker
+			elem = _cfgRoot->FirstChildElement("atlas");
+			if (elem != nullptr && elem->Attribute("index") != nullptr && MigUtil::theRend != nullptr)
+				MigUtil::theRend->loadAtlasIndex(elem->Attribute("index"));
+
 			// global font (optional)
 			elem = _cfgRoot->FirstChildElement("fonts");
 			if (elem != nullptr)
@@ -155,8 +199,9 @@ void MigGame::onCreate()
 		LOGINFO("(MigGame::onCreate) Creating default font");
 		MigUtil::theFont->create();
 
-		// pass the font to the performance monitor
+		// pass the font to the performance monitor and profiler
 		PerfMon::init(MigUtil::theFont);
+		Profiler::init(MigUtil::theFont);
 	}
 
 	_currScreen = createStartupScreen();
@@ -164,6 +209,7 @@ void MigGame::onCreate()
 	{
 		LOGINFO("(MigGame::onCreate) Startup screen created (%s)", _currScreen->getScreenName().c_str());
 		_currScreen->create();
+		ResourceCache::setKeepWarm(_currScreen->getKeepWarmList());
 	}
 	else
 		throw std::runtime_error("(MigGame::onCreate) No startup screen provided");
@@ -182,8 +228,14 @@ void MigGame::onCreateGraphics()
 	MigUtil::theRend->loadPixelShader(MIGTECH_PSHADER_COLOR, SHADER_HINT_NONE);
 	MigUtil::theRend->loadPixelShader(MIGTECH_PSHADER_TEX, SHADER_HINT_NONE);
 	MigUtil::theRend->loadPixelShader(MIGTECH_PSHADER_TEX_ALPHA, SHADER_HINT_NONE);
+	MigUtil::theRend->loadVertexShader(MIGTECH_VSHADER_POS_TRANSFORM_INST, VDTYPE_POSITION, SHADER_HINT_VIEW | SHADER_HINT_PROJ | SHADER_HINT_INSTANCED);
+	MigUtil::theRend->loadPixelShader(MIGTECH_PSHADER_COLOR_INST, SHADER_HINT_NONE);
+	MigUtil::theRend->loadPixelShader(MIGTECH_PSHADER_TEX_INST, SHADER_HINT_NONE);
 	LOGDBG("(MigGame::onCreateGraphics) Shaders loaded");
 
+	if (MigUtil::theSprites != nullptr)
+		MigUtil::theSprites->createGraphics();
+
 	if (MigUtil::theFont != nullptr)
 		MigUtil::theFont->createGraphics();
 
@@ -215,6 +267,9 @@ void MigGame::onSuspending()
 {
 	LOGINFO("(MigGame::onSuspending) MigTech game suspending");
 
+	// the time spent suspended shouldn't show up as a stall
+	PerfMon::doReport();
+
 	if (_currScreen != nullptr)
 		_currScreen->suspend();
 
@@ -249,11 +304,15 @@ void MigGame::onDestroyGraphics()
 
 	if (MigUtil::theFont != nullptr)
 		MigUtil::theFont->destroyGraphics();
+
+	if (MigUtil::theSprites != nullptr)
+		MigUtil::theSprites->destroyGraphics();
 }
 
 void MigGame::onDestroy()
 {
 	LOGINFO("(MigGame::onDestroy) MigTech game destroying");
+	PerfMon::doReport();
 
 	if (_currScreen != nullptr)
 	{
@@ -261,11 +320,14 @@ void MigGame::onDestroy()
 		delete _currScreen;
 	}
 
+	Profiler::term();
+	AssetLoader::term();
 	if (MigUtil::theFont != nullptr)
 	{
 		MigUtil::theFont->destroy();
 		delete MigUtil::theFont;
 	}
+	ResourceCache::term();
 
 	if (_cfgDoc != nullptr)
 		delete _cfgDoc;
@@ -334,21 +396,29 @@ void MigGame::update()
 	// pet the watchdog
 	MigUtil::petWatchdog();
 
+	PROFILE_ZONE("update");
+
 	// run the animation in the animation list
 	if (MigUtil::theAnimList != nullptr)
+	{
+		PROFILE_ZONE("anims");
 		MigUtil::theAnimList->doAnimations();
+	}
 
 	// clear the dialog if it has expired
 	if (MigUtil::theDialog != nullptr && !MigUtil::theDialog->isActive())
 	{
+		PROFILE_ZONE("dialog");
 		delete MigUtil::theDialog;
 		MigUtil::theDialog = nullptr;
 	}
 
 	if (_currScreen != nullptr)
 	{
-		if (_newScreenOnNextUpdate)
+		// the old screen stays up (faded out) until the prefetched assets are in
+		if (_newScreenOnNextUpdate && isPrefetchReady())
 		{
+			PROFILE_ZONE("screen swap");
 			_currScreen->destroyGraphics();
 			_currScreen->destroy();
 
@@ -367,65 +437,156 @@ void MigGame::update()
 				throw std::runtime_error("(MigGame::update) Expired screen didn't provide a next screen");
 
 			_newScreenOnNextUpdate = false;
+			endPrefetch();
+
+			// whatever the old screen kept warm and the new one didn't pick up is freed now
+			ResourceCache::setKeepWarm(_currScreen->getKeepWarmList());
+			ResourceCache::trim();
 		}
 
+		PROFILE_ZONE("screen update");
 		if (!_currScreen->update())
 		{
 			_newScreenOnNextUpdate = true;
 		}
+
+		// fetch what the next screen needs while this one fades out
+		if (!_prefetchStarted && (_currScreen->isExiting() || _newScreenOnNextUpdate))
+			startPrefetch();
+	}
+}
+
+void MigGame::startPrefetch()
+{
+	_prefetchStarted = true;
+
+	// w/o any loader threads there's nothing to overlap the loads with
+	ScreenPrefetch prefetch;
+	if (!AssetLoader::isRunning() || !_currScreen->getLikelyNextScreen(prefetch))
+		return;
+	LOGINFO("(MigGame::startPrefetch) Prefetching screen (%s)", prefetch.screenName.c_str());
+
+	if (!prefetch.screenName.empty())
+	{
+		_prefetchDoc = prefetch.screenName + ".xml";
+		XMLDocFactory::prefetchDocument(_prefetchDoc);
+	}
+
+	// the prefetch holds its own reference, so images the current screen has survive its exit
+	for (size_t i = 0; i < prefetch.imageNames.size(); i++)
+	{
+		const std::string& name = prefetch.imageNames[i];
+		if (MigUtil::theRend->loadImageAsync(name, name, prefetch.imageFlags[i]) != nullptr)
+			_prefetchImages.push_back(name);
 	}
 }
 
+bool MigGame::isPrefetchReady()
+{
+	// abandoned loads never finish
+	if (!AssetLoader::isRunning())
+		return true;
+
+	if (!_prefetchDoc.empty() && XMLDocFactory::isPrefetchPending(_prefetchDoc))
+		return false;
+	for (size_t i = 0; i < _prefetchImages.size(); i++)
+	{
+		Image* img = MigUtil::theRend->getImage(_prefetchImages[i]);
+		if (img != nullptr && img->isPending())
+			return false;
+	}
+	return true;
+}
+
+void MigGame::endPrefetch()
+{
+	// anything the new screen didn't ask for goes
+	XMLDocFactory::clearPrefetched();
+	for (size_t i = 0; i < _prefetchImages.size(); i++)
+		MigUtil::theRend->unloadImage(_prefetchImages[i]);
+	_prefetchDoc.clear();
+	_prefetchImages.clear();
+	_prefetchStarted = false;
+}
+
 bool MigGame::render()
 {
 	if (_currScreen != nullptr)
 	{
+		PROFILE_ZONE("render");
+		PerfMon::doFrame(_currScreen->getScreenName());
 		const std::vector<RenderPass*>& passList = _currScreen->getPassList();
 
+		// finish any images that were decoded in the background
+		if (AssetLoader::isRunning())
+		{
+			PROFILE_ZONE("uploads");
+			AssetLoader::update();
+		}
+
 		// render the pre-render passes first, if any
-		for (int i = 0; i < (int) passList.size(); i++)
 		{
-			RenderPass* pass = passList[i];
-			if (pass != nullptr && pass->getType() == RenderPass::RENDER_PASS_PRE && pass->isValid())
+			PROFILE_ZONE("pre passes");
+			for (int i = 0; i < (int) passList.size(); i++)
 			{
-				MigUtil::theRend->preRender(i + 1, pass);
-				if (pass->preRender())
-					_currScreen->renderPass(i + 1, pass);
-				pass->postRender();
-				MigUtil::theRend->postRender(i + 1, pass);
+				RenderPass* pass = passList[i];
+				if (pass != nullptr && pass->getType() == RenderPass::RENDER_PASS_PRE && pass->isValid())
+				{
+					MigUtil::theRend->beginPass(i + 1, pass);
+					if (pass->preRender())
+						_currScreen->renderPass(i + 1, pass);
+					pass->postRender();
+					MigUtil::theRend->endPass(i + 1, pass);
+				}
 			}
 		}
 
 		// main rendering pass
-		MigUtil::theRend->preRender(0, nullptr);
-		_currScreen->render();
-		MigUtil::theRend->postRender(0, nullptr);
+		{
+			PROFILE_ZONE("main pass");
+			MigUtil::theRend->beginPass(0, nullptr);
+			_currScreen->render();
+			MigUtil::theRend->endPass(0, nullptr);
+		}
 
 		// render the post-render passes, if any
-		for (int i = 0; i < (int)passList.size(); i++)
 		{
-			RenderPass* pass = passList[i];
-			if (pass != nullptr && pass->getType() == RenderPass::RENDER_PASS_POST && pass->isValid())
+			PROFILE_ZONE("post passes");
+			for (int i = 0; i < (int)passList.size(); i++)
 			{
-				MigUtil::theRend->preRender(i + 1, pass);
-				if (pass->preRender())
-					_currScreen->renderPass(i + 1, pass);
-				pass->postRender();
-				MigUtil::theRend->postRender(i + 1, pass);
+				RenderPass* pass = passList[i];
+				if (pass != nullptr && pass->getType() == RenderPass::RENDER_PASS_POST && pass->isValid())
+				{
+					MigUtil::theRend->beginPass(i + 1, pass);
+					if (pass->preRender())
+						_currScreen->renderPass(i + 1, pass);
+					pass->postRender();
+					MigUtil::theRend->endPass(i + 1, pass);
+				}
 			}
 		}
 
 		// overlay rendering pass (including perf monitor)
-		MigUtil::theRend->preRender(-1, nullptr);
-		_currScreen->renderOverlays();
-		if (MigUtil::theDialog != nullptr)
-			MigUtil::theDialog->draw();
-		PerfMon::doFPS();
-		MigUtil::theRend->postRender(-1, nullptr);
+		{
+			PROFILE_ZONE("overlays");
+			MigUtil::theRend->beginPass(-1, nullptr);
+			_currScreen->renderOverlays();
+			if (MigUtil::theDialog != nullptr)
+				MigUtil::theDialog->draw();
+			PerfMon::doFPS();
+			Profiler::drawOverlay();
+			MigUtil::theRend->endPass(-1, nullptr);
+		}
 
 		// present the resulting image
-		MigUtil::theRend->present();
+		{
+			PROFILE_ZONE("present");
+			MigUtil::theRend->present();
+		}
 	}
 
+	// the frame is done, so collect the zones (this has to be outside of any zone)
+	Profiler::endFrame();
+
 	return true;
 }
@@ -52,6 +52,11 @@ namespace MigTech
 	protected:
 		virtual ScreenBase* createStartupScreen() = 0;
 
+		// next screen prefetching
+		void startPrefetch();
+		bool isPrefetchReady();
+		void endPrefetch();
+
 	protected:
 		std::string _appName;
 		tinyxml2::XMLDocument* _cfgDoc;
@@ -59,5 +64,10 @@ namespace MigTech
 
 		ScreenBase* _currScreen;
 		bool _newScreenOnNextUpdate;
+
+		// assets being fetched for the next screen
+		bool _prefetchStarted;
+		std::string _prefetchDoc;
+		std::vector<std::string> _prefetchImages;
 	};
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "Timer.h"
 
 #include <time.h>
+#include <atomic>
 
 using namespace MigTech;
 using namespace tinyxml2;
@@ -16,6 +17,7 @@ SoundEffect* MigUtil::theMusic = nullptr;
 PersistBase* MigUtil::thePersist = nullptr;
 AnimList* MigUtil::theAnimList = nullptr;
 Font* MigUtil::theFont = nullptr;
+SpriteBatch* MigUtil::theSprites = nullptr;
 DialogBase* MigUtil::theDialog = nullptr;
 
 ///////////////////////////////////////////////////////////////////////////
@@ -45,7 +47,7 @@ extern const std::string& plat_getExternalFilesDir();
 #ifdef LOG_TRACKING
 // static list of the most recent <X> logging lines
 static char logBufs[LOG_NUM_LINES][LOG_LINE_LENGTH];
-static int lastLine = 0;
+static std::atomic<unsigned int> nextLine(0);
 #endif // LOG_TRACKING
 
 bool MigUtil::init()
@@ -60,11 +62,10 @@ bool MigUtil::init()
 static char* getLoggingBuf()
 {
 #ifdef LOG_TRACKING
-	// move to the next available line
-	char* outbuf = logBufs[lastLine];
-	lastLine = (++lastLine % LOG_NUM_LINES);
+	// move to the next available line (the loader threads log too)
+	char* outbuf = logBufs[nextLine++ % LOG_NUM_LINES];
 #else
-	static char outbuf[LOG_LINE_LENGTH];
+	static thread_local char outbuf[LOG_LINE_LENGTH];
 #endif // LOG_TRACKING
 	return outbuf;
 }
@@ -78,7 +79,7 @@ void MigUtil::debug(const char* msg, ...)
 	if (plat_isDebuggerPresent())
 	{
 		// note that these don't appear in crash dumps
-		static char outbuf[1024];
+		static thread_local char outbuf[1024];
 
 		va_list args;
 		va_start(args, msg);
@@ -166,7 +167,7 @@ bool MigUtil::dumpLogToFile(const char* msg)
 
 	for (int i = 0; i < LOG_NUM_LINES; i++)
 	{
-		int index = (lastLine + i) % LOG_NUM_LINES;
+		int index = (nextLine + i) % LOG_NUM_LINES;
 		if (logBufs[index][0] != 0)
 		{
 			fputs(logBufs[index], pf);
@@ -537,6 +538,15 @@ std::string MigUtil::toUpper(const std::string& input)
 ///////////////////////////////////////////////////////////////////////////
 // other
 
+// seeded from the clock on first use, unless a fixed seed is given
+static bool randInit = false;
+
+void MigUtil::seedRandom(unsigned int seed)
+{
+	srand(seed);
+	randInit = true;
+}
+
 bool MigUtil::rollAgainstPercent(int percent)
 {
 	return (pickRandom(100) < percent);
@@ -547,7 +557,6 @@ int MigUtil::pickRandom(int max)
 	if (max == 0)
 		return 0;
 
-	static bool randInit = false;
 	if (!randInit)
 	{
 		srand((unsigned)time(nullptr));
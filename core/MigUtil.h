@@ -6,6 +6,7 @@
 #include "AudioBase.h"
 #include "PersistBase.h"
 #include "Dialog.h"
+#include "SpriteBatch.h"
 
 namespace MigTech
 {
@@ -40,6 +41,9 @@ namespace MigTech
 		// singleton dialog, when it's on-screen and active
 		static DialogBase* theDialog;
 
+		// shared sprite batch, owned by the renderer's lifetime
+		static SpriteBatch* theSprites;
+
 	///////////////////////////////////////////////////////////////////////////
 	// init MigUtil
 
@@ -106,6 +110,7 @@ namespace MigTech
 	///////////////////////////////////////////////////////////////////////////
 	// other
 
+		static void seedRandom(unsigned int seed);
 		static bool rollAgainstPercent(int percent);
 		static int pickRandom(int max);
 		static float pickFloat();
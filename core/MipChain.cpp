@@ -0,0 +1,206 @@
+﻿#include "pch.h"
+#include "MipChain.h"
+#include "TextureCodec.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MIPCHAIN_USE_SSE2
+#elif defined(_M_ARM) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MIPCHAIN_USE_NEON
+#endif
+
+using namespace MigTech;
+
+int MipChain::getFullLevelCount(int width, int height)
+{
+	int dim = (width > height ? width : height);
+	int levels = 1;
+	while (dim > 1)
+	{
+		dim >>= 1;
+		levels++;
+	}
+	return levels;
+}
+
+unsigned int MipChain::getLevelSize(const ImageData& data, int level)
+{
+	int width = getLevelDim(data.width, level);
+	int height = getLevelDim(data.height, level);
+	if (data.isCompressed())
+		return TextureCodec::getLevelSize(data.compression, data.blockWidth, data.blockHeight, width, height);
+	return (unsigned int) (width * height * getBytesPerPixel(data.format));
+}
+
+unsigned int MipChain::getLevelOffset(const ImageData& data, int level)
+{
+	unsigned int offset = 0;
+	for (int i = 0; i < level; i++)
+		offset += getLevelSize(data, i);
+	return offset;
+}
+
+unsigned int MipChain::getChainSize(const ImageData& data)
+{
+	return getLevelOffset(data, data.mipLevels);
+}
+
+int MipChain::getBytesPerPixel(IMG_FORMAT fmt)
+{
+	return ((fmt == IMG_FORMAT_ALPHA || fmt == IMG_FORMAT_GREYSCALE) ? 1 : (fmt == IMG_FORMAT_RGB ? 3 : 4));
+}
+
+// CPU only, this is called from the asset loader threads
+bool MipChain::generate(ImageData& data)
+{
+	if (data.isCompressed() || data.pixels == nullptr)
+		return false;
+
+	// cooked textures may already carry their levels
+	if (data.mipLevels > 1)
+		return true;
+
+	// the decoders reserve room for the chain up front, anything else is copied into a new buffer
+	unsigned int baseSize = getLevelSize(data, 0);
+	data.mipLevels = getFullLevelCount(data.width, data.height);
+	unsigned int chainSize = getChainSize(data);
+	byte* chain = data.pixels;
+	if (data.dataSize < chainSize)
+	{
+		chain = new byte[chainSize];
+		memcpy(chain, data.pixels, baseSize);
+	}
+
+	int bpp = getBytesPerPixel(data.format);
+	for (int level = 1; level < data.mipLevels; level++)
+	{
+		downsample(chain + getLevelOffset(data, level - 1), getLevelDim(data.width, level - 1), getLevelDim(data.height, level - 1),
+			chain + getLevelOffset(data, level), bpp);
+	}
+
+	if (chain != data.pixels)
+	{
+		data.release();
+		data.pixels = chain;
+	}
+	data.dataSize = chainSize;
+	return true;
+}
+
+// 4 byte pixels, returns the number of output pixels written (a multiple of 4)
+static int downsampleRow4(const byte* row0, const byte* row1, byte* out, int count)
+{
+	int x = 0;
+#if defined(MIPCHAIN_USE_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i two = _mm_set1_epi16(2);
+	for (; x + 4 <= count; x += 4)
+	{
+		__m128i a0 = _mm_loadu_si128((const __m128i*) (row0 + 8*x));
+		__m128i a1 = _mm_loadu_si128((const __m128i*) (row0 + 8*x + 16));
+		__m128i b0 = _mm_loadu_si128((const __m128i*) (row1 + 8*x));
+		__m128i b1 = _mm_loadu_si128((const __m128i*) (row1 + 8*x + 16));
+
+		// vertical sums of source pixels 0-1, 2-3, 4-5 and 6-7, widened to 16 bits
+		__m128i s01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+		__m128i s23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+		__m128i s45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+		__m128i s67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+		// even pixels from the low halves plus odd pixels from the high halves
+		__m128i h0 = _mm_add_epi16(_mm_unpacklo_epi64(s01, s23), _mm_unpackhi_epi64(s01, s23));
+		__m128i h1 = _mm_add_epi16(_mm_unpacklo_epi64(s45, s67), _mm_unpackhi_epi64(s45, s67));
+		h0 = _mm_srli_epi16(_mm_add_epi16(h0, two), 2);
+		h1 = _mm_srli_epi16(_mm_add_epi16(h1, two), 2);
+		_mm_storeu_si128((__m128i*) (out + 4*x), _mm_packus_epi16(h0, h1));
+	}
+#elif defined(MIPCHAIN_USE_NEON)
+	for (; x + 4 <= count; x += 4)
+	{
+		uint8x16_t a0 = vld1q_u8(row0 + 8*x);
+		uint8x16_t a1 = vld1q_u8(row0 + 8*x + 16);
+		uint8x16_t b0 = vld1q_u8(row1 + 8*x);
+		uint8x16_t b1 = vld1q_u8(row1 + 8*x + 16);
+
+		// vertical sums of source pixels 0-1, 2-3, 4-5 and 6-7, widened to 16 bits
+		uint16x8_t s01 = vaddl_u8(vget_low_u8(a0), vget_low_u8(b0));
+		uint16x8_t s23 = vaddl_u8(vget_high_u8(a0), vget_high_u8(b0));
+		uint16x8_t s45 = vaddl_u8(vget_low_u8(a1), vget_low_u8(b1));
+		uint16x8_t s67 = vaddl_u8(vget_high_u8(a1), vget_high_u8(b1));
+
+		// each pair of pixels, then a rounding narrow by 4
+		uint16x8_t h0 = vcombine_u16(vadd_u16(vget_low_u16(s01), vget_high_u16(s01)), vadd_u16(vget_low_u16(s23), vget_high_u16(s23)));
+		uint16x8_t h1 = vcombine_u16(vadd_u16(vget_low_u16(s45), vget_high_u16(s45)), vadd_u16(vget_low_u16(s67), vget_high_u16(s67)));
+		vst1q_u8(out + 4*x, vcombine_u8(vrshrn_n_u16(h0, 2), vrshrn_n_u16(h1, 2)));
+	}
+#endif
+	return x;
+}
+
+// 1 byte pixels, returns the number of output pixels written (a multiple of 16)
+static int downsampleRow1(const byte* row0, const byte* row1, byte* out, int count)
+{
+	int x = 0;
+#if defined(MIPCHAIN_USE_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+	const __m128i two = _mm_set1_epi16(2);
+	for (; x + 16 <= count; x += 16)
+	{
+		__m128i a0 = _mm_loadu_si128((const __m128i*) (row0 + 2*x));
+		__m128i a1 = _mm_loadu_si128((const __m128i*) (row0 + 2*x + 16));
+		__m128i b0 = _mm_loadu_si128((const __m128i*) (row1 + 2*x));
+		__m128i b1 = _mm_loadu_si128((const __m128i*) (row1 + 2*x + 16));
+
+		// vertical sums, then each even pixel plus its odd neighbour (madd against 1s)
+		__m128i p0 = _mm_madd_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero)), one);
+		__m128i p1 = _mm_madd_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero)), one);
+		__m128i p2 = _mm_madd_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero)), one);
+		__m128i p3 = _mm_madd_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero)), one);
+
+		__m128i h0 = _mm_srli_epi16(_mm_add_epi16(_mm_packs_epi32(p0, p1), two), 2);
+		__m128i h1 = _mm_srli_epi16(_mm_add_epi16(_mm_packs_epi32(p2, p3), two), 2);
+		_mm_storeu_si128((__m128i*) (out + x), _mm_packus_epi16(h0, h1));
+	}
+#elif defined(MIPCHAIN_USE_NEON)
+	for (; x + 16 <= count; x += 16)
+	{
+		// pairwise sums of each row, then a rounding narrow by 4
+		uint16x8_t s0 = vaddq_u16(vpaddlq_u8(vld1q_u8(row0 + 2*x)), vpaddlq_u8(vld1q_u8(row1 + 2*x)));
+		uint16x8_t s1 = vaddq_u16(vpaddlq_u8(vld1q_u8(row0 + 2*x + 16)), vpaddlq_u8(vld1q_u8(row1 + 2*x + 16)));
+		vst1q_u8(out + x, vcombine_u8(vrshrn_n_u16(s0, 2), vrshrn_n_u16(s1, 2)));
+	}
+#endif
+	return x;
+}
+
+void MipChain::downsample(const byte* src, int srcWidth, int srcHeight, byte* dst, int bpp)
+{
+	int dstWidth = getLevelDim(srcWidth, 1);
+	int dstHeight = getLevelDim(srcHeight, 1);
+	int srcStride = srcWidth * bpp;
+
+	// odd sizes drop the last row or column, a 1 pixel wide or high source pairs each pixel with itself
+	for (int y = 0; y < dstHeight; y++)
+	{
+		const byte* row0 = src + 2*y*srcStride;
+		const byte* row1 = (srcHeight > 1 ? row0 + srcStride : row0);
+		byte* out = dst + y*dstWidth*bpp;
+
+		int x = 0;
+		if (srcWidth > 1 && bpp == 4)
+			x = downsampleRow4(row0, row1, out, dstWidth);
+		else if (srcWidth > 1 && bpp == 1)
+			x = downsampleRow1(row0, row1, out, dstWidth);
+
+		// whatever the vector loops didn't cover, and all 3 byte pixels
+		for (; x < dstWidth; x++)
+		{
+			int x0 = 2*x*bpp;
+			int x1 = (srcWidth > 1 ? x0 + bpp : x0);
+			for (int c = 0; c < bpp; c++)
+				out[x*bpp + c] = (byte) ((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+		}
+	}
+}
@@ -0,0 +1,32 @@
+﻿#pragma once
+
+#include "MigDefines.h"
+#include "Image.h"
+
+namespace MigTech
+{
+	// mip chains for ImageData, the levels are packed one after another in pixels (base level first)
+	//  each level is half the size of the one above it (rounded down, never below 1) all the way to 1x1
+	class MipChain
+	{
+	public:
+		// number of levels in a full chain
+		static int getFullLevelCount(int width, int height);
+
+		// the size of a base level dimension at a given level
+		static int getLevelDim(int dim, int level) { int d = (dim >> level); return (d > 0 ? d : 1); }
+
+		// bytes in a level, where it starts, and the size of all data.mipLevels levels
+		static unsigned int getLevelSize(const ImageData& data, int level);
+		static unsigned int getLevelOffset(const ImageData& data, int level);
+		static unsigned int getChainSize(const ImageData& data);
+
+		static int getBytesPerPixel(IMG_FORMAT fmt);
+
+		// replaces the pixels with a full chain, compressed data can't be filtered and is left alone
+		static bool generate(ImageData& data);
+
+		// builds the next level down with a 2x2 box filter (SSE2/NEON for 1 and 4 byte pixels)
+		static void downsample(const byte* src, int srcWidth, int srcHeight, byte* dst, int bpp);
+	};
+}
@@ -7,13 +7,15 @@ using namespace MigTech;
 
 const std::string movieClipVertexShader = "mtvs_MovieClip";
 const std::string movieClipPixelShader = MIGTECH_PSHADER_TEX;
+const std::string movieClipInstVertexShader = "mtvs_MovieClipInst";
+const std::string movieClipInstPixelShader = MIGTECH_PSHADER_TEX_INST;
 
 MovieClip::MovieClip()
 	: _screenPoly1(nullptr), _screenPoly2(nullptr), _txtVerts(nullptr),
 	_rowCount(0), _colCount(0), _width(0), _height(0),
 	_frameCount(0), _blendFrames(false), _playHead(0), _visible(false),
 	_rX(0), _rY(0), _rZ(0), _sX(1), _sY(1),
-	_callback(nullptr)
+	_atlased(false), _vertFrame(-1), _callback(nullptr)
 {
 }
 
@@ -46,6 +48,7 @@ bool MovieClip::init(const std::string& bmpID, int rowCount, int colCount, float
 	{
 		if (MigUtil::theRend->loadImage(_bmpResID, _bmpResID, LOAD_IMAGE_NONE) != nullptr)
 		{
+			applyImageRect();
 			_screenPoly1->setImage(0, _bmpResID, TXT_FILTER_LINEAR, TXT_FILTER_LINEAR, TXT_WRAP_CLAMP);
 			if (_screenPoly2 != nullptr)
 				_screenPoly2->setImage(0, _bmpResID, TXT_FILTER_LINEAR, TXT_FILTER_LINEAR, TXT_WRAP_CLAMP);
@@ -63,6 +66,7 @@ bool MovieClip::init(const std::string& bmpID, float mcW, float mcH)
 void MovieClip::createGraphics()
 {
 	MigUtil::theRend->loadVertexShader(movieClipVertexShader, VDTYPE_POSITION_TEXTURE, SHADER_HINT_MVP);
+	MigUtil::theRend->loadVertexShader(movieClipInstVertexShader, VDTYPE_POSITION_TEXTURE, SHADER_HINT_VIEW | SHADER_HINT_PROJ | SHADER_HINT_INSTANCED);
 	//MigUtil::theRend->loadPixelShader(movieClipPixelShader, SHADER_HINT_NONE);
 
 	// load the texture map
@@ -73,6 +77,7 @@ void MovieClip::createGraphics()
 		if (_blendFrames)
 			_screenPoly2 = MigUtil::theRend->createObject();
 		_screenPoly1->addShaderSet(movieClipVertexShader, movieClipPixelShader);
+		_screenPoly1->addShaderSet(movieClipInstVertexShader, movieClipInstPixelShader);
 		if (_blendFrames)
 			_screenPoly2->addShaderSet(movieClipVertexShader, movieClipPixelShader);
 
@@ -82,13 +87,7 @@ void MovieClip::createGraphics()
 		_txtVerts[1].pos = Vector3(-_width / 2,  _height / 2, 0);
 		_txtVerts[2].pos = Vector3( _width / 2, -_height / 2, 0);
 		_txtVerts[3].pos = Vector3( _width / 2,  _height / 2, 0);
-		_txtVerts[0].uv = Vector2(0, 1);
-		_txtVerts[1].uv = Vector2(0, 0);
-		_txtVerts[2].uv = Vector2(1, 1);
-		_txtVerts[3].uv = Vector2(1, 0);
-		_screenPoly1->loadVertexBuffer(_txtVerts, 4, MigTech::VDTYPE_POSITION_TEXTURE);
-		if (_blendFrames)
-			_screenPoly2->loadVertexBuffer(_txtVerts, 4, MigTech::VDTYPE_POSITION_TEXTURE);
+		applyImageRect();
 
 		// load mesh indices
 		static const unsigned short txtIndices[] =
@@ -117,13 +116,17 @@ void MovieClip::destroyGraphics()
 	if (_txtVerts)
 		delete[] _txtVerts;
 	_txtVerts = nullptr;
+	_vertFrame = -1;
 	if (_screenPoly1)
+	{
+		// the image reference goes with the objects
 		MigUtil::theRend->deleteObject(_screenPoly1);
+		MigUtil::theRend->unloadImage(_bmpResID);
+	}
 	_screenPoly1 = nullptr;
 	if (_screenPoly2)
 		MigUtil::theRend->deleteObject(_screenPoly2);
 	_screenPoly2 = nullptr;
-	//MigUtil::theRend->unloadImage(_bmpResID);
 }
 
 void MovieClip::drawFrame(bool first, float param, float alpha) const
@@ -136,19 +139,101 @@ void MovieClip::drawFrame(bool first, float param, float alpha) const
 		_screenPoly2->render();
 }
 
-void MovieClip::drawFrames(bool depth, float alpha) const
+void MovieClip::getFrameUV(int frame, UVSet& uv) const
 {
-	MigUtil::theRend->setBlending(BLEND_STATE_SRC_ALPHA);
+	// same as the movie clip vertex shader
+	int row = frame / _colCount;
+	int col = frame % _colCount;
+	uv.u1 = col / (float)_colCount;
+	uv.v1 = row / (float)_rowCount;
+	uv.u2 = uv.u1 + 1.0f / _colCount;
+	uv.v2 = uv.v1 + 1.0f / _rowCount;
+
+	if (_atlased)
+	{
+		float w = _atlasUV.u2 - _atlasUV.u1;
+		float h = _atlasUV.v2 - _atlasUV.v1;
+		uv.u1 = _atlasUV.u1 + w*uv.u1;
+		uv.v1 = _atlasUV.v1 + h*uv.v1;
+		uv.u2 = _atlasUV.u1 + w*uv.u2;
+		uv.v2 = _atlasUV.v1 + h*uv.v2;
+	}
+}
+
+void MovieClip::applyImageRect()
+{
+	_atlased = MigUtil::theRend->getImageRect(_bmpResID, _texName, _atlasUV);
+
+	// an animated atlased clip reloads its vertices whenever the frame changes
+	BUFFER_USAGE usage = (_atlased && _frameCount > 1 ? BUFFER_USAGE_DYNAMIC : BUFFER_USAGE_STATIC);
+	_screenPoly1->setBufferUsage(usage);
+	if (_screenPoly2 != nullptr)
+		_screenPoly2->setBufferUsage(usage);
+
+	_vertFrame = -1;
+	loadFrameVerts();
+}
+
+// the vertices span the whole image (the shader picks the frame) unless it's atlased, then they carry the
+//  current frame's rect on the page and the shader uses them as is
+void MovieClip::loadFrameVerts()
+{
+	int frame = (int)_playHead;
+	if (_vertFrame >= 0 && (!_atlased || frame == _vertFrame))
+		return;
+	_vertFrame = frame;
+
+	setFrameVerts(frame);
+	_screenPoly1->loadVertexBuffer(_txtVerts, 4, MigTech::VDTYPE_POSITION_TEXTURE);
+	if (_screenPoly2 != nullptr)
+	{
+		setFrameVerts(frame + 1 < _frameCount ? frame + 1 : frame);
+		_screenPoly2->loadVertexBuffer(_txtVerts, 4, MigTech::VDTYPE_POSITION_TEXTURE);
+	}
+}
+
+void MovieClip::setFrameVerts(int frame)
+{
+	UVSet uv = { 0, 0, 1, 1 };
+	if (_atlased)
+		getFrameUV(frame, uv);
+	_txtVerts[0].uv = Vector2(uv.u1, uv.v2);
+	_txtVerts[1].uv = Vector2(uv.u1, uv.v1);
+	_txtVerts[2].uv = Vector2(uv.u2, uv.v2);
+	_txtVerts[3].uv = Vector2(uv.u2, uv.v1);
+}
 
+void MovieClip::drawFrames(const Matrix& mat, bool depth, float alpha) const
+{
 	// draw the first frame, and maybe the second if frame blending is enabled
 	float playHead = (_blendFrames ? _playHead : (int)_playHead);
 	float param = 1.0f - (playHead - (int)playHead);
 	bool needBothFrames = (_blendFrames && param < 1);
 
+	// outside of the render queue the frames go into the shared sprite batch
+	SpriteBatch* sprites = MigUtil::theSprites;
+	if (_screenPoly1 != nullptr && sprites != nullptr && sprites->isReady() && !MigUtil::theRend->isQueueing())
+	{
+		DEPTH_TEST_STATE depthTest = (depth ? DEPTH_TEST_STATE_LESS : DEPTH_TEST_STATE_NONE);
+		UVSet uv;
+		getFrameUV((int)_playHead, uv);
+		sprites->addQuad(_texName, mat, _width, _height, uv, Color(_color, _color.a*param*alpha),
+			BLEND_STATE_SRC_ALPHA, depthTest, (depth && !needBothFrames));
+		if (needBothFrames)
+		{
+			getFrameUV((int)_playHead + 1, uv);
+			sprites->addQuad(_texName, mat, _width, _height, uv, Color(_color, _color.a*(1.0f - param)*alpha),
+				BLEND_STATE_SRC_ALPHA, depthTest, depth);
+		}
+		return;
+	}
+
+	MigUtil::theRend->setModelMatrix(&mat);
+	MigUtil::theRend->setBlending(BLEND_STATE_SRC_ALPHA);
 	MigUtil::theRend->setDepthTesting(depth ? DEPTH_TEST_STATE_LESS : DEPTH_TEST_STATE_NONE, (depth && !needBothFrames));
 	MigUtil::theRend->setMiscValue(0, (float)((int)_playHead));
-	MigUtil::theRend->setMiscValue(1, (float)_rowCount);
-	MigUtil::theRend->setMiscValue(2, (float)_colCount);
+	MigUtil::theRend->setMiscValue(1, (float)(_atlased ? 1 : _rowCount));
+	MigUtil::theRend->setMiscValue(2, (float)(_atlased ? 1 : _colCount));
 	drawFrame(true, param, alpha);
 
 	if (needBothFrames)
@@ -163,22 +248,31 @@ void MovieClip::draw(const Matrix& worldMatrix, bool depth, float alpha) const
 {
 	if (_visible)
 	{
-		static Matrix localMat;
-		localMat.copy(_mat);
-		localMat.multiply(worldMatrix);
-		MigUtil::theRend->setModelMatrix(localMat);
+		Matrix localMat;
+		Matrix::multiply(_mat, worldMatrix, localMat);
 
-		drawFrames(depth, alpha);
+		drawFrames(localMat, depth, alpha);
 	}
 }
 
 void MovieClip::draw(float alpha) const
 {
 	if (_visible)
+		drawFrames(_mat, false, alpha);
+}
+
+void MovieClip::drawInstanced(const InstanceData* instances, unsigned int count, bool depth) const
+{
+	if (_visible && _screenPoly1 != nullptr && count > 0)
 	{
-		MigUtil::theRend->setModelMatrix(_mat);
+		MigUtil::theRend->setBlending(BLEND_STATE_SRC_ALPHA);
+		MigUtil::theRend->setDepthTesting(depth ? DEPTH_TEST_STATE_LESS : DEPTH_TEST_STATE_NONE, depth);
 
-		drawFrames(false, alpha);
+		// frame blending isn't supported here, the play head is truncated to the current frame
+		MigUtil::theRend->setMiscValue(0, (float)((int)_playHead));
+		MigUtil::theRend->setMiscValue(1, (float)(_atlased ? 1 : _rowCount));
+		MigUtil::theRend->setMiscValue(2, (float)(_atlased ? 1 : _colCount));
+		_screenPoly1->renderInstanced(1, instances, count);
 	}
 }
 
@@ -210,6 +304,8 @@ void MovieClip::jumpToFrame(float frame)
 		throw std::invalid_argument("(MovieClip::jumpToFrame) Frame cannot exceed frame count");
 	//LOGINFO("(MovieClip::jumpToFrame) Jumping to frame %f", frame);
 	_playHead = frame;
+	if (_atlased && _txtVerts != nullptr)
+		loadFrameVerts();
 }
 
 // plays to the given frame from the current play head position
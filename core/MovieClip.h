@@ -4,6 +4,7 @@
 #include "Object.h"
 #include "AnimList.h"
 #include "Matrix.h"
+#include "SpriteBatch.h"
 
 namespace MigTech
 {
@@ -16,12 +17,6 @@ namespace MigTech
 		virtual void movieComplete(MovieClip* mc) = 0;
 	};
 
-	struct UVSet
-	{
-		float u1, v1;
-		float u2, v2;
-	};
-
 	class MovieClip : public MigBase, public IAnimTarget
 	{
 	public:
@@ -37,6 +32,9 @@ namespace MigTech
 		virtual void draw(const Matrix& worldMatrix, bool depth, float alpha = 1) const;
 		virtual void draw(float alpha = 1) const;
 
+		// draws the current frame once per instance in a single call (instance color replaces the clip color)
+		void drawInstanced(const InstanceData* instances, unsigned int count, bool depth = false) const;
+
 		// IAnimTarget
 		virtual bool doFrame(int id, float newVal, void* optData);
 		virtual void animComplete(int id, void* optData);
@@ -62,10 +60,15 @@ namespace MigTech
 	protected:
 		void applyTransformations();
 		void drawFrame(bool first, float param, float alpha) const;
-		void drawFrames(bool depth, float alpha) const;
+		void drawFrames(const Matrix& mat, bool depth, float alpha) const;
+		void getFrameUV(int frame, UVSet& uv) const;
+		void applyImageRect();
+		void loadFrameVerts();
+		void setFrameVerts(int frame);
 
 	protected:
 		std::string _bmpResID;
+		std::string _texName;
 		Object* _screenPoly1;
 		Object* _screenPoly2;
 		VertexPositionTexture* _txtVerts;
@@ -85,6 +88,11 @@ namespace MigTech
 		float _sX, _sY;
 		Color _color;
 
+		// an atlased image is a sub-rect of the page (_texName), the vertices then carry the current frame
+		bool _atlased;
+		UVSet _atlasUV;
+		int _vertFrame;
+
 		AnimID _idAnim;
 		UVSet _uv1, _uv2;
 		IMovieClipCallback* _callback;
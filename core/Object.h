@@ -1,15 +1,26 @@
 #pragma once
 
 #include "MigDefines.h"
+#include "Matrix.h"
 
 namespace MigTech
 {
+	// per-instance data for instanced rendering, the shader set must be built from an instanced vertex shader
+	struct InstanceData
+	{
+		Matrix model;
+		Color color;
+	};
+
 	class Object
 	{
 	protected:
 		FACE_CULLING _cull;
+		BUFFER_USAGE _usage;
 
 	public:
+		Object() : _cull(FACE_CULLING_NONE), _usage(BUFFER_USAGE_STATIC) { }
+
 		virtual int addShaderSet(const std::string& vs, const std::string& ps) = 0;
 		virtual void setImage(int index, const std::string& name, TXT_FILTER minFilter, TXT_FILTER magFilter, TXT_WRAP wrap) = 0;
 		virtual void setCulling(FACE_CULLING newCull)
@@ -17,6 +28,16 @@ namespace MigTech
 			_cull = newCull;
 		};
 
+		// call before loading the buffers, dynamic objects can be reloaded cheaply
+		virtual void setBufferUsage(BUFFER_USAGE usage)
+		{
+			_usage = usage;
+		};
+		BUFFER_USAGE getBufferUsage() const { return _usage; }
+
+		// identifies the program and textures used by a shader set, so the render queue can group draws
+		virtual unsigned int getStateKey(int shaderSet) const { return 0; }
+
 		virtual void loadVertexBuffer(const void* pdata, unsigned int count, VDTYPE vdType) = 0;
 		virtual void loadIndexBuffer(const unsigned short* indices, unsigned int count, PRIMITIVE_TYPE type) = 0;
 
@@ -25,6 +46,7 @@ namespace MigTech
 		virtual int getIndexCount() const = 0;
 
 		virtual void render(int shaderSet = 0) = 0;
+		virtual void renderInstanced(int shaderSet, const InstanceData* instances, unsigned int count) = 0;
 
 		virtual void startRenderSet(int shaderSet = 0) = 0;
 		virtual void stopRenderSet() = 0;
@@ -1,6 +1,7 @@
 ﻿#include "pch.h"
 #include "OverlayBase.h"
 #include "MigUtil.h"
+#include "ResourceCache.h"
 
 using namespace MigTech;
 using namespace tinyxml2;
@@ -25,7 +26,7 @@ void OverlayBase::create()
 {
 	// open overlay configuration doc
 	std::string xmlFile = _overlayName + ".xml";
-	tinyxml2::XMLDocument* pdoc = XMLDocFactory::loadDocument(xmlFile);
+	tinyxml2::XMLDocument* pdoc = ResourceCache::loadDocument(xmlFile);
 	if (pdoc != nullptr)
 	{
 		XMLElement* elem = pdoc->FirstChildElement("Overlay");
@@ -55,6 +56,7 @@ void OverlayBase::create()
 			if (controls != nullptr)
 				_controls.loadFromXML(controls, _localFont);
 		}
+		ResourceCache::unloadDocument(xmlFile);
 	}
 
 	// lifecycle events
@@ -137,8 +139,7 @@ bool OverlayBase::update()
 
 void OverlayBase::render()
 {
-	static Matrix localMat;
-	localMat.identity();
+	Matrix localMat;
 	if (_scaleX != 1 || _scaleY != 1)
 		localMat.scale(_scaleX, _scaleY, 1);
 	if (_rotateX != 0)
@@ -155,6 +156,10 @@ void OverlayBase::render()
 	MigUtil::theRend->setDepthTesting(DEPTH_TEST_STATE_NONE, false);
 
 	draw(_alpha, localMat);
+
+	// end of the overlay, whatever sprites are left go out now
+	if (MigUtil::theSprites != nullptr)
+		MigUtil::theSprites->flush();
 }
 
 void OverlayBase::startIntroAnimation(long duration)
@@ -0,0 +1,218 @@
+﻿#include "pch.h"
+#include "ParticleEmitter.h"
+#include "MigUtil.h"
+#include "Timer.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define PARTICLE_USE_SSE2
+#elif defined(_M_ARM) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PARTICLE_USE_NEON
+#endif
+
+using namespace MigTech;
+
+ParticleEmitter::ParticleEmitter() : _capacity(0), _count(0), _lastUpdate(0), _flickerTime(0)
+{
+}
+
+void ParticleEmitter::init(int capacity, const ParticleSettings& settings)
+{
+	if (capacity <= 0)
+		throw std::invalid_argument("(ParticleEmitter::init) Capacity must be positive");
+
+	_settings = settings;
+	_capacity = ((capacity + 3) & ~3);
+	_count = 0;
+	_flickerTime = 0;
+
+	// the integrator works on whole groups of 4, so the padding lanes need sane values too
+	_posX.assign(_capacity, 0); _posY.assign(_capacity, 0); _posZ.assign(_capacity, 0);
+	_velX.assign(_capacity, 0); _velY.assign(_capacity, 0); _velZ.assign(_capacity, 0);
+	_age.assign(_capacity, 0);
+	_invLife.assign(_capacity, 0);
+	_alpha.assign(_capacity, 0);
+	_flicker.assign(_capacity, 1);
+	_color.assign(_capacity, Color());
+	_inst.resize(_capacity);
+}
+
+bool ParticleEmitter::spawn(const ParticleSpawn& particle)
+{
+	if (_count >= _capacity)
+		return false;
+
+	// the clock starts with the first particle, an idle emitter doesn't accumulate time
+	if (_count == 0)
+		_lastUpdate = Timer::gameTimeMillis();
+
+	int i = _count++;
+	_posX[i] = particle.pos.x; _posY[i] = particle.pos.y; _posZ[i] = particle.pos.z;
+	_velX[i] = particle.vel.x; _velY[i] = particle.vel.y; _velZ[i] = particle.vel.z;
+	_age[i] = 0;
+	_invLife[i] = (particle.life > 0 ? 1 / particle.life : 1000000.0f);
+	_alpha[i] = 1;
+	_flicker[i] = (_settings.flickerPeriod > 0 ? MigUtil::pickFloat() : 1);
+	_color[i] = particle.color;
+	return true;
+}
+
+void ParticleEmitter::clear()
+{
+	_count = 0;
+}
+
+void ParticleEmitter::update()
+{
+	long now = Timer::gameTimeMillis();
+	if (_count > 0 && now > _lastUpdate)
+	{
+		float dt = (now - _lastUpdate) / 1000.0f;
+		_flickerTime += dt;
+		if (_settings.flickerPeriod > 0 && _flickerTime >= _settings.flickerPeriod)
+		{
+			_flickerTime = 0;
+			flicker();
+		}
+
+		integrate(dt);
+		retire();
+	}
+	_lastUpdate = now;
+}
+
+void ParticleEmitter::flicker()
+{
+	for (int i = 0; i < _count; i++)
+		_flicker[i] = MigUtil::pickFloat();
+}
+
+// vel = vel*damp + gravity*dt, pos += vel*dt, age += dt, alpha = (1 - t^2)*flicker where t = age/life
+void ParticleEmitter::integrate(float dt)
+{
+	const float damp = (_settings.drag > 0 ? (float) exp(-_settings.drag * dt) : 1);
+	const float gx = _settings.gravity.x * dt;
+	const float gy = _settings.gravity.y * dt;
+	const float gz = _settings.gravity.z * dt;
+
+	// whole groups of 4 fit inside the pool, the lanes past the live count are harmless
+	const int count = ((_count + 3) & ~3);
+	float* px = &_posX[0]; float* py = &_posY[0]; float* pz = &_posZ[0];
+	float* vx = &_velX[0]; float* vy = &_velY[0]; float* vz = &_velZ[0];
+	float* age = &_age[0];
+	const float* invLife = &_invLife[0];
+	float* alpha = &_alpha[0];
+	const float* flick = &_flicker[0];
+
+	int i = 0;
+#if defined(PARTICLE_USE_SSE2)
+	const __m128 vDamp = _mm_set1_ps(damp);
+	const __m128 vDt = _mm_set1_ps(dt);
+	const __m128 vGx = _mm_set1_ps(gx);
+	const __m128 vGy = _mm_set1_ps(gy);
+	const __m128 vGz = _mm_set1_ps(gz);
+	const __m128 one = _mm_set1_ps(1);
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 nvx = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(vx + i), vDamp), vGx);
+		__m128 nvy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(vy + i), vDamp), vGy);
+		__m128 nvz = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(vz + i), vDamp), vGz);
+		_mm_storeu_ps(vx + i, nvx);
+		_mm_storeu_ps(vy + i, nvy);
+		_mm_storeu_ps(vz + i, nvz);
+		_mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(nvx, vDt)));
+		_mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(nvy, vDt)));
+		_mm_storeu_ps(pz + i, _mm_add_ps(_mm_loadu_ps(pz + i), _mm_mul_ps(nvz, vDt)));
+
+		__m128 nage = _mm_add_ps(_mm_loadu_ps(age + i), vDt);
+		_mm_storeu_ps(age + i, nage);
+		__m128 t = _mm_mul_ps(nage, _mm_loadu_ps(invLife + i));
+		__m128 fade = _mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(t, t)), zero);
+		_mm_storeu_ps(alpha + i, _mm_mul_ps(fade, _mm_loadu_ps(flick + i)));
+	}
+#elif defined(PARTICLE_USE_NEON)
+	const float32x4_t vDt = vdupq_n_f32(dt);
+	const float32x4_t vGx = vdupq_n_f32(gx);
+	const float32x4_t vGy = vdupq_n_f32(gy);
+	const float32x4_t vGz = vdupq_n_f32(gz);
+	const float32x4_t one = vdupq_n_f32(1);
+	const float32x4_t zero = vdupq_n_f32(0);
+	for (; i + 4 <= count; i += 4)
+	{
+		float32x4_t nvx = vmlaq_n_f32(vGx, vld1q_f32(vx + i), damp);
+		float32x4_t nvy = vmlaq_n_f32(vGy, vld1q_f32(vy + i), damp);
+		float32x4_t nvz = vmlaq_n_f32(vGz, vld1q_f32(vz + i), damp);
+		vst1q_f32(vx + i, nvx);
+		vst1q_f32(vy + i, nvy);
+		vst1q_f32(vz + i, nvz);
+		vst1q_f32(px + i, vmlaq_f32(vld1q_f32(px + i), nvx, vDt));
+		vst1q_f32(py + i, vmlaq_f32(vld1q_f32(py + i), nvy, vDt));
+		vst1q_f32(pz + i, vmlaq_f32(vld1q_f32(pz + i), nvz, vDt));
+
+		float32x4_t nage = vaddq_f32(vld1q_f32(age + i), vDt);
+		vst1q_f32(age + i, nage);
+		float32x4_t t = vmulq_f32(nage, vld1q_f32(invLife + i));
+		float32x4_t fade = vmaxq_f32(vmlsq_f32(one, t, t), zero);
+		vst1q_f32(alpha + i, vmulq_f32(fade, vld1q_f32(flick + i)));
+	}
+#endif
+
+	// whatever the vector loops didn't cover
+	for (; i < count; i++)
+	{
+		vx[i] = vx[i]*damp + gx;
+		vy[i] = vy[i]*damp + gy;
+		vz[i] = vz[i]*damp + gz;
+		px[i] += vx[i]*dt;
+		py[i] += vy[i]*dt;
+		pz[i] += vz[i]*dt;
+
+		age[i] += dt;
+		float t = age[i]*invLife[i];
+		float fade = 1 - t*t;
+		alpha[i] = (fade > 0 ? fade : 0) * flick[i];
+	}
+}
+
+// swaps the last live particle into each dead slot
+void ParticleEmitter::retire()
+{
+	int i = 0;
+	while (i < _count)
+	{
+		if (_age[i]*_invLife[i] >= 1)
+		{
+			int last = --_count;
+			_posX[i] = _posX[last]; _posY[i] = _posY[last]; _posZ[i] = _posZ[last];
+			_velX[i] = _velX[last]; _velY[i] = _velY[last]; _velZ[i] = _velZ[last];
+			_age[i] = _age[last];
+			_invLife[i] = _invLife[last];
+			_alpha[i] = _alpha[last];
+			_flicker[i] = _flicker[last];
+			_color[i] = _color[last];
+		}
+		else
+			i++;
+	}
+}
+
+void ParticleEmitter::draw(const MovieClip& sprite, const Matrix& base, bool depth)
+{
+	if (_count > 0)
+	{
+		for (int i = 0; i < _count; i++)
+		{
+			InstanceData& inst = _inst[i];
+			inst.model = base;
+			inst.model.translate(_posX[i], _posY[i], _posZ[i]);
+			if (_settings.sparkleChance > 0 && MigUtil::pickFloat() < _settings.sparkleChance)
+				inst.color = Color(1, 1, 1, 1);
+			else
+				inst.color = Color(_color[i], _alpha[i]);
+		}
+
+		sprite.drawInstanced(&_inst[0], _count, depth);
+	}
+}
@@ -0,0 +1,75 @@
+﻿#pragma once
+
+#include "MigDefines.h"
+#include "Object.h"
+#include "Matrix.h"
+#include "MovieClip.h"
+
+namespace MigTech
+{
+	// one particle's starting state
+	struct ParticleSpawn
+	{
+		Vector3 pos;
+		Vector3 vel;		// world units per second
+		Color color;
+		float life;			// seconds
+	};
+
+	// behaviour shared by every particle in an emitter
+	struct ParticleSettings
+	{
+		Vector3 gravity;		// world units per second^2
+		float drag;				// velocity damping rate (per second)
+		float flickerPeriod;	// seconds between random alpha changes (0 for none)
+		float sparkleChance;	// chance a particle is drawn white on any given frame
+
+		ParticleSettings() : drag(0), flickerPeriod(0), sparkleChance(0) { }
+	};
+
+	// CPU particles kept as structure of arrays in a fixed size pool, dead particles are swapped out with the last
+	//  live one so the live range stays packed, the integrator runs 4 particles at a time (SSE2/NEON)
+	//  alpha fades as 1 - (age/life)^2 and every live particle goes out in one instanced draw of the sprite clip
+	class ParticleEmitter
+	{
+	public:
+		ParticleEmitter();
+
+		// allocates the pool, the capacity is rounded up to a multiple of 4
+		void init(int capacity, const ParticleSettings& settings);
+
+		// returns false if the pool is full
+		bool spawn(const ParticleSpawn& particle);
+		void clear();
+
+		// advances the particles to the current game time and retires the dead ones
+		void update();
+
+		// instance models are the base matrix followed by a translation to each particle
+		void draw(const MovieClip& sprite, const Matrix& base, bool depth = false);
+
+		int getCount() const { return _count; }
+		int getCapacity() const { return _capacity; }
+		bool isEmpty() const { return (_count == 0); }
+
+	protected:
+		void integrate(float dt);
+		void retire();
+		void flicker();
+
+	protected:
+		ParticleSettings _settings;
+		int _capacity;
+		int _count;
+		long _lastUpdate;
+		float _flickerTime;
+
+		// structure of arrays, one entry per particle
+		std::vector<float> _posX, _posY, _posZ;
+		std::vector<float> _velX, _velY, _velZ;
+		std::vector<float> _age, _invLife, _alpha, _flicker;
+		std::vector<Color> _color;
+
+		std::vector<InstanceData> _inst;
+	};
+}
@@ -2,9 +2,26 @@
 #include "PerfMon.h"
 #include "MigUtil.h"
 #include "Timer.h"
+#include "ResourceCache.h"
 
 using namespace MigTech;
 
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+extern uint64 plat_getRawTicks();
+extern const std::string& plat_getFilesDir();
+
+// frame time histogram layout, values below 2^(HIST_SUB_BITS+1) us are exact and larger values keep
+// HIST_SUB_BITS bits of precision (~3%), up to about a minute
+#define HIST_SUB_BITS 5
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_MAX_SHIFT 21
+#define HIST_NUM_BUCKETS (2*HIST_SUB_COUNT + HIST_MAX_SHIFT*HIST_SUB_COUNT)
+#define HIST_BUDGET_60HZ 16600
+#define HIST_BUDGET_30HZ 33300
+#define PERF_REPORT_FILE "mtperf.json"
+
 // static initialization
 bool PerfMon::showFramesPerSecond = false;
 long PerfMon::delayFramesPerSecond = 1000;
@@ -15,15 +32,69 @@ long PerfMon::frameCount = 0;
 long PerfMon::totalFrameCount = 0;
 double PerfMon::bestFPS = 0;
 double PerfMon::worstFPS = 0;
+unsigned int* PerfMon::frameHistogram = nullptr;
+uint64 PerfMon::lastFrameStamp = 0;
+long PerfMon::histFrameCount = 0;
+long PerfMon::framesOverBudget = 0;
+long PerfMon::framesOverHalfRate = 0;
+uint64 PerfMon::longestStall = 0;
+std::string PerfMon::longestStallScreen;
+Text* PerfMon::lastTexMem = nullptr;
+std::map<std::string, uint64> PerfMon::screenTexturePeak;
+
+static int histBucketFromValue(uint64 us)
+{
+	if (us < 2*HIST_SUB_COUNT)
+		return (int)us;
+
+	// the shift that brings the value into [HIST_SUB_COUNT, 2*HIST_SUB_COUNT)
+	int shift = 0;
+	while ((us >> shift) >= 2*HIST_SUB_COUNT)
+		shift++;
+	if (shift > HIST_MAX_SHIFT)
+		return HIST_NUM_BUCKETS - 1;
+	return shift*HIST_SUB_COUNT + (int)(us >> shift);
+}
+
+static uint64 histValueFromBucket(int bucket)
+{
+	if (bucket < 2*HIST_SUB_COUNT)
+		return bucket;
+
+	// middle of the bucket's range
+	int shift = bucket / HIST_SUB_COUNT - 1;
+	uint64 sub = bucket % HIST_SUB_COUNT + HIST_SUB_COUNT;
+	return (sub << shift) + ((1 << shift) / 2);
+}
+
+static double histPercentile(const unsigned int* hist, long total, double pct)
+{
+	// the smallest value that's at least pct of the samples
+	long target = (long)(pct * total + 0.5);
+	if (target < 1)
+		target = 1;
+
+	long count = 0;
+	for (int i = 0; i < HIST_NUM_BUCKETS; i++)
+	{
+		count += hist[i];
+		if (count >= target)
+			return histValueFromBucket(i) / 1000.0;
+	}
+	return 0;
+}
 
 void PerfMon::init(Font* font)
 {
 	lastFPS = nullptr;
+	lastTexMem = nullptr;
 
 	if (font != nullptr)
 	{
 		lastFPS = font->createText();
 		lastFPS->init("", 0.85f, 0.95f, 0.05f, JUSTIFY_LEFT);
+		lastTexMem = font->createText();
+		lastTexMem->init("", 0.65f, 0.90f, 0.035f, JUSTIFY_LEFT);
 	}
 }
 
@@ -52,14 +123,57 @@ static char* formatFPSString(double fps)
 	return temp;
 }
 
-#pragma warning(pop)
+// not thread safe
+static char* formatTexMemString(uint64 resident, uint64 budget)
+{
+	static char temp[40];
+	if (budget > 0)
+		sprintf(temp, "TEX %.1f/%.0f MB", resident / (1024.0 * 1024.0), budget / (1024.0 * 1024.0));
+	else
+		sprintf(temp, "TEX %.1f MB", resident / (1024.0 * 1024.0));
+	return temp;
+}
 
-void PerfMon::doFPS()
+void PerfMon::doFrame(const std::string& screenName)
 {
 	totalFrameCount++;
 	if (startTimeStamp == 0)
 		startTimeStamp = Timer::gameTime();
 
+	// the raw ticks aren't clamped like the game time, so stalls show up at their real length
+	uint64 rawTime = plat_getRawTicks();
+	if (lastFrameStamp > 0 && rawTime > lastFrameStamp)
+	{
+		if (frameHistogram == nullptr)
+		{
+			frameHistogram = new unsigned int[HIST_NUM_BUCKETS];
+			memset(frameHistogram, 0, HIST_NUM_BUCKETS*sizeof(unsigned int));
+		}
+
+		uint64 us = (rawTime - lastFrameStamp) / (Timer::ticksPerSecond / 1000000);
+		frameHistogram[histBucketFromValue(us)]++;
+		histFrameCount++;
+
+		if (us > HIST_BUDGET_60HZ)
+			framesOverBudget++;
+		if (us > HIST_BUDGET_30HZ)
+			framesOverHalfRate++;
+		if (us > longestStall)
+		{
+			longestStall = us;
+			longestStallScreen = screenName;
+		}
+	}
+	lastFrameStamp = rawTime;
+
+	uint64 resident = ResourceCache::getResidentImageBytes();
+	uint64& peak = screenTexturePeak[screenName];
+	if (resident > peak)
+		peak = resident;
+}
+
+void PerfMon::doFPS()
+{
 	// are we even keeping track
 	if (showFramesPerSecond)
 	{
@@ -82,6 +196,8 @@ void PerfMon::doFPS()
 				double fps = (1000 * frameCount) / (double)diff;
 				if (lastFPS != nullptr)
 					lastFPS->update(formatFPSString(fps));
+				if (lastTexMem != nullptr)
+					lastTexMem->update(formatTexMemString(ResourceCache::getResidentImageBytes(), ResourceCache::getImageBudget()));
 
 				// reset
 				lastTimeStamp = gameTime;
@@ -101,11 +217,16 @@ void PerfMon::doFPS()
 		// draw the most recent value
 		if (lastFPS != nullptr)
 			lastFPS->draw(0.5f, 0.5f, 0.5f, 1);
+		if (lastTexMem != nullptr && !lastTexMem->getText().empty())
+			lastTexMem->draw(0.5f, 0.5f, 0.5f, 1);
 	}
 }
 
 void PerfMon::doReport()
 {
+	if (totalFrameCount == 0)
+		return;
+
 	// spit out a report
 	long diff = Timer::ticksToMilliSeconds(Timer::gameTime() - startTimeStamp);
 	double aveFPS = (1000 * totalFrameCount) / (double)diff;
@@ -115,70 +236,55 @@ void PerfMon::doReport()
 	if (worstFPS > 0)
 		LOGINFO("(PerfMon::doReport) Worst FPS was %s", formatFPSString(worstFPS));
 
+	// frame time distribution
+	if (histFrameCount > 0)
+	{
+		double p50 = histPercentile(frameHistogram, histFrameCount, 0.5);
+		double p90 = histPercentile(frameHistogram, histFrameCount, 0.9);
+		double p99 = histPercentile(frameHistogram, histFrameCount, 0.99);
+		double p999 = histPercentile(frameHistogram, histFrameCount, 0.999);
+		double stall = longestStall / 1000.0;
+		LOGINFO("(PerfMon::doReport) Frame times (ms) p50 %.2f, p90 %.2f, p99 %.2f, p99.9 %.2f over %ld frames", p50, p90, p99, p999, histFrameCount);
+		LOGINFO("(PerfMon::doReport) Frames over 16.6 ms: %ld, over 33.3 ms: %ld", framesOverBudget, framesOverHalfRate);
+		LOGINFO("(PerfMon::doReport) Longest stall was %.2f ms (%s)", stall, longestStallScreen.c_str());
+
+		std::map<std::string, uint64>::const_iterator iter;
+		for (iter = screenTexturePeak.begin(); iter != screenTexturePeak.end(); iter++)
+			LOGINFO("(PerfMon::doReport) Peak texture memory %.2f MB (%s)", iter->second / (1024.0 * 1024.0), iter->first.c_str());
+
+		// machine readable copy next to the log dump
+		std::string path = plat_getFilesDir() + "/" + PERF_REPORT_FILE;
+		FILE* pf = fopen(path.c_str(), "w");
+		if (pf != nullptr)
+		{
+			fprintf(pf, "{\n\t\"frames\": %ld,\n", histFrameCount);
+			fprintf(pf, "\t\"p50_ms\": %.3f,\n\t\"p90_ms\": %.3f,\n\t\"p99_ms\": %.3f,\n\t\"p999_ms\": %.3f,\n", p50, p90, p99, p999);
+			fprintf(pf, "\t\"over_16_6ms\": %ld,\n\t\"over_33_3ms\": %ld,\n", framesOverBudget, framesOverHalfRate);
+			fprintf(pf, "\t\"longest_stall_ms\": %.3f,\n\t\"longest_stall_screen\": \"%s\",\n", stall, longestStallScreen.c_str());
+			fprintf(pf, "\t\"texture_peak_mb\": {");
+			for (iter = screenTexturePeak.begin(); iter != screenTexturePeak.end(); iter++)
+				fprintf(pf, "%s\n\t\t\"%s\": %.3f", (iter == screenTexturePeak.begin() ? "" : ","), iter->first.c_str(), iter->second / (1024.0 * 1024.0));
+			fprintf(pf, "\n\t}\n}\n");
+			fclose(pf);
+		}
+		else
+			LOGWARN("(PerfMon::doReport) Could not open report file %s", path.c_str());
+	}
+
 	// reset everything that's global
 	startTimeStamp = 0;
 	totalFrameCount = 0;
 	bestFPS = worstFPS = 0;
 	frameCount = 0;
 	lastTimeStamp = 0;
+	if (frameHistogram != nullptr)
+		memset(frameHistogram, 0, HIST_NUM_BUCKETS*sizeof(unsigned int));
+	lastFrameStamp = 0;
+	histFrameCount = 0;
+	framesOverBudget = framesOverHalfRate = 0;
+	longestStall = 0;
+	longestStallScreen.clear();
+	screenTexturePeak.clear();
 }
 
-///////////////////////////////////////////////////////////////////////////
-// private performance monitor
-
-PerfMon::PerfMon()
-{
-	_perfTimeList = nullptr;
-	_numSlices = 0;
-}
-
-PerfMon::PerfMon(int numSlices)
-{
-	_perfTimeList = nullptr;
-	initSlicePerfTest(numSlices);
-}
-
-PerfMon::~PerfMon()
-{
-	if (_perfTimeList != nullptr)
-		delete[] _perfTimeList;
-}
-
-void PerfMon::initSlicePerfTest(int numSlices)
-{
-	if (_perfTimeList != nullptr)
-		delete[] _perfTimeList;
-	_perfTimeList = new long[numSlices];
-	_numSlices = numSlices;
-	_currTimeIndex = 0;
-}
-
-void PerfMon::startSlicePerfTest()
-{
-	_lastPerfStamp = Timer::gameTime();
-}
-
-void PerfMon::endSlicePerfTest()
-{
-	if (_perfTimeList != nullptr)
-	{
-		_perfTimeList[_currTimeIndex] = Timer::ticksToMilliSeconds(Timer::gameTime() - _lastPerfStamp);
-		_totalTimeCount++;
-
-		long totalTime = 0;
-		int count = 0;
-		for (int i = 0; i < _numSlices; i++)
-		{
-			if (_perfTimeList[i] > 0)
-			{
-				totalTime += _perfTimeList[i];
-				count++;
-			}
-		}
-		LOGWARN("(PerfMon::endSlicePerfTest) slice = %d ms, ave = %f ms (%d samples out of %d)", _perfTimeList[_currTimeIndex], (totalTime / (double)count), count, _totalTimeCount);
-
-		_currTimeIndex++;
-		if (_currTimeIndex >= _numSlices)
-			_currTimeIndex = 0;
-	}
-}
+#pragma warning(pop)
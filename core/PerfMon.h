@@ -23,30 +23,26 @@ namespace MigTech
 		static double bestFPS;
 		static double worstFPS;
 
+		// frame time histogram (log-linear microsecond buckets, like an HDR histogram)
+		static unsigned int* frameHistogram;
+		static uint64 lastFrameStamp;
+		static long histFrameCount;
+		static long framesOverBudget;
+		static long framesOverHalfRate;
+		static uint64 longestStall;
+		static std::string longestStallScreen;
+
+		// resident texture memory, the peak is tracked per screen
+		static Text* lastTexMem;
+		static std::map<std::string, uint64> screenTexturePeak;
+
 	public:
 		// static interface, used by Game class
 		static void init(Font* font);
 		static void showFPS(bool show);
 		static bool isFPSOn();
+		static void doFrame(const std::string& screenName);
 		static void doFPS();
 		static void doReport();
-
-	public:
-		PerfMon();
-		PerfMon(int numSlices);
-		~PerfMon();
-
-		// interface for slice performance testing
-		void initSlicePerfTest(int numSlices);
-		void startSlicePerfTest();
-		void endSlicePerfTest();
-
-	protected:
-		// variables for tracking slice performance tests
-		long* _perfTimeList;
-		int _numSlices;
-		uint64 _lastPerfStamp;
-		int _totalTimeCount;
-		int _currTimeIndex;
 	};
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 ﻿#include "pch.h"
 #include "MigUtil.h"
 #include "PersistBase.h"
+#include "AssetLoader.h"
 
 using namespace tinyxml2;
 using namespace MigTech;
@@ -13,7 +14,24 @@ extern byte* plat_loadFileBuffer(const char* filePath, int& length);
 ///////////////////////////////////////////////////////////////////////////
 // XML document factory
 
+std::map<std::string, tinyxml2::XMLDocument*> XMLDocFactory::prefetchList;
+
 tinyxml2::XMLDocument* XMLDocFactory::loadDocument(const std::string& docPath)
+{
+	// take over a prefetched copy, or abandon it if it hasn't arrived yet
+	std::map<std::string, tinyxml2::XMLDocument*>::iterator iter = prefetchList.find(docPath);
+	if (iter != prefetchList.end())
+	{
+		tinyxml2::XMLDocument* pdoc = iter->second;
+		prefetchList.erase(iter);
+		if (pdoc != nullptr)
+			return pdoc;
+	}
+
+	return parseDocument(docPath);
+}
+
+tinyxml2::XMLDocument* XMLDocFactory::parseDocument(const std::string& docPath)
 {
 	tinyxml2::XMLDocument* pdoc = nullptr;
 
@@ -38,6 +56,48 @@ tinyxml2::XMLDocument* XMLDocFactory::loadDocument(const std::string& docPath)
 	return pdoc;
 }
 
+void XMLDocFactory::prefetchDocument(const std::string& docPath)
+{
+	if (prefetchList.find(docPath) == prefetchList.end())
+	{
+		prefetchList[docPath] = nullptr;
+		AssetLoader::queueDocument(docPath);
+	}
+}
+
+bool XMLDocFactory::isPrefetchPending(const std::string& docPath)
+{
+	std::map<std::string, tinyxml2::XMLDocument*>::const_iterator iter = prefetchList.find(docPath);
+	return (iter != prefetchList.end() && iter->second == nullptr);
+}
+
+// documents that were never asked for are deleted, ones still loading will be dropped when they arrive
+void XMLDocFactory::clearPrefetched()
+{
+	std::map<std::string, tinyxml2::XMLDocument*>::iterator iter;
+	for (iter = prefetchList.begin(); iter != prefetchList.end(); iter++)
+	{
+		if (iter->second != nullptr)
+			delete iter->second;
+	}
+	prefetchList.clear();
+}
+
+void XMLDocFactory::addPrefetched(const std::string& docPath, tinyxml2::XMLDocument* pdoc)
+{
+	// a document that failed to load is forgotten, loadDocument() will report the failure
+	std::map<std::string, tinyxml2::XMLDocument*>::iterator iter = prefetchList.find(docPath);
+	if (iter != prefetchList.end() && iter->second == nullptr)
+	{
+		if (pdoc != nullptr)
+			iter->second = pdoc;
+		else
+			prefetchList.erase(iter);
+	}
+	else if (pdoc != nullptr)
+		delete pdoc;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // SimplePersist
 
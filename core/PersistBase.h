@@ -84,5 +84,20 @@ namespace MigTech
 	{
 	public:
 		static tinyxml2::XMLDocument* loadDocument(const std::string& docPath);
+
+		// safe to call from any thread
+		static tinyxml2::XMLDocument* parseDocument(const std::string& docPath);
+
+		// loads a document in the background, the next loadDocument() call for it takes it over
+		static void prefetchDocument(const std::string& docPath);
+		static bool isPrefetchPending(const std::string& docPath);
+		static void clearPrefetched();
+
+		// used by AssetLoader when a prefetched document arrives
+		static void addPrefetched(const std::string& docPath, tinyxml2::XMLDocument* pdoc);
+
+	private:
+		// a null document is still being loaded
+		static std::map<std::string, tinyxml2::XMLDocument*> prefetchList;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,442 @@
+﻿#include "pch.h"
+#include "Profiler.h"
+#include "MigUtil.h"
+#include "Timer.h"
+#include <algorithm>
+#include <atomic>
+
+using namespace MigTech;
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+extern uint64 plat_getRawTicks();
+extern const std::string& plat_getFilesDir();
+
+///////////////////////////////////////////////////////////////////////////
+// per-thread ring buffers
+
+// ring size must be a power of 2, zones that don't fit before the next drain are dropped
+#define PROFILE_RING_SIZE 2048
+#define PROFILE_HISTORY 128
+#define PROFILE_MAX_LINES 16
+#define PROFILE_TRACE_FILE "mttrace.json"
+
+// a completed zone, as recorded by the thread that ran it
+struct ProfileEvent
+{
+	const char* name;
+	uint64 start;
+	uint64 end;
+	int depth;
+};
+
+// single producer (the owning thread) and single consumer (the main thread in endFrame), so no locks
+struct ProfileRing
+{
+	ProfileEvent events[PROFILE_RING_SIZE];
+	std::atomic<unsigned int> head;
+	std::atomic<unsigned int> tail;
+	std::atomic<unsigned int> dropped;
+	unsigned int thread;
+	int depth;	// only touched by the owning thread
+	ProfileRing* next;
+};
+
+// rings are pushed onto this list once and live until the process exits, since threads may still hold them
+static std::atomic<ProfileRing*> ringList(nullptr);
+static std::atomic<unsigned int> ringCount(0);
+static thread_local ProfileRing* localRing = nullptr;
+
+static ProfileRing* getLocalRing()
+{
+	if (localRing == nullptr)
+	{
+		ProfileRing* ring = new ProfileRing();
+		ring->head = 0;
+		ring->tail = 0;
+		ring->dropped = 0;
+		ring->thread = ringCount++;
+		ring->depth = 0;
+
+		ProfileRing* first = ringList.load();
+		do
+		{
+			ring->next = first;
+		} while (!ringList.compare_exchange_weak(first, ring));
+		localRing = ring;
+	}
+	return localRing;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// aggregation (main thread only)
+
+// per-frame totals for one zone
+struct ZoneRecord
+{
+	const char* name;
+	unsigned int thread;
+	int depth;
+	int calls;
+	uint64 order;	// start of the first call, used to sort the zones into tree order
+	float history[PROFILE_HISTORY];
+	int histCount;
+	int histIndex;
+
+	// this frame (so far)
+	uint64 frameTicks;
+	int frameCalls;
+};
+
+// the key includes the thread and depth, so the same zone called from different places is kept apart
+typedef std::pair<const char*, unsigned int> ZoneKey;
+static std::map<ZoneKey, int> zoneMap;
+static std::vector<ZoneRecord> zoneList;
+
+// chrome trace capture
+struct TraceEvent
+{
+	ProfileEvent evt;
+	unsigned int thread;
+};
+static std::vector<TraceEvent> traceEvents;
+
+static double ticksToMs(uint64 ticks)
+{
+	return (ticks * 1000.0) / Timer::ticksPerSecond;
+}
+
+static void addEvent(const ProfileEvent& evt, unsigned int thread)
+{
+	ZoneKey key(evt.name, (thread << 8) | (evt.depth & 0xFF));
+	std::map<ZoneKey, int>::iterator iter = zoneMap.find(key);
+	if (iter == zoneMap.end())
+	{
+		ZoneRecord rec;
+		memset(&rec, 0, sizeof(rec));
+		rec.name = evt.name;
+		rec.thread = thread;
+		rec.depth = evt.depth;
+		rec.order = evt.start;
+		zoneMap[key] = (int)zoneList.size();
+		zoneList.push_back(rec);
+		iter = zoneMap.find(key);
+	}
+
+	ZoneRecord& rec = zoneList[iter->second];
+	if (rec.frameCalls == 0 || evt.start < rec.order)
+		rec.order = evt.start;
+	rec.frameTicks += (evt.end - evt.start);
+	rec.frameCalls++;
+}
+
+static bool orderZones(int a, int b)
+{
+	// main thread first, and then by where the zone started in the most recent frame it ran (so parents come first)
+	const ZoneRecord& recA = zoneList[a];
+	const ZoneRecord& recB = zoneList[b];
+	if (recA.thread != recB.thread)
+		return (recA.thread < recB.thread);
+	if (recA.order != recB.order)
+		return (recA.order < recB.order);
+	return (recA.depth < recB.depth);
+}
+
+static double getPercentile(const std::vector<float>& sorted, double pct)
+{
+	int index = (int)(pct * (sorted.size() - 1) + 0.5);
+	return sorted[index];
+}
+
+#pragma warning(push)
+#pragma warning(disable: 4996) // _CRT_SECURE_NO_WARNINGS
+
+static bool writeTrace(const std::string& path)
+{
+	FILE* pf = fopen(path.c_str(), "w");
+	if (pf == nullptr)
+	{
+		LOGWARN("(Profiler::writeTrace) Could not open trace file %s", path.c_str());
+		return false;
+	}
+
+	// chrome trace event format, complete ("X") events with timestamps in microseconds
+	fputs("{\"traceEvents\":[\n", pf);
+	for (unsigned int i = 0; i < traceEvents.size(); i++)
+	{
+		const TraceEvent& trace = traceEvents[i];
+		fputs("{\"name\":\"", pf);
+		for (const char* pch = trace.evt.name; *pch != 0; pch++)
+		{
+			if (*pch == '"' || *pch == '\\')
+				fputc('\\', pf);
+			fputc(*pch, pf);
+		}
+		fprintf(pf, "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.1f,\"dur\":%.1f}%s\n",
+			trace.thread, ticksToMs(trace.evt.start) * 1000, ticksToMs(trace.evt.end - trace.evt.start) * 1000,
+			(i + 1 < traceEvents.size() ? "," : ""));
+	}
+	fputs("],\"displayTimeUnit\":\"ms\"}\n", pf);
+
+	fclose(pf);
+	return true;
+}
+
+#pragma warning(pop)
+
+///////////////////////////////////////////////////////////////////////////
+// static interface
+
+// static initialization
+bool Profiler::profEnabled = false;
+bool Profiler::overlayOn = false;
+long Profiler::delayOverlay = 500;
+uint64 Profiler::lastOverlayStamp = 0;
+std::vector<Text*> Profiler::overlayLines;
+const Font* Profiler::overlayFont = nullptr;
+int Profiler::captureFrames = 0;
+std::string Profiler::capturePath;
+
+void Profiler::init(Font* font)
+{
+	term();
+
+	overlayFont = font;
+	if (font != nullptr)
+	{
+		for (int i = 0; i < PROFILE_MAX_LINES; i++)
+		{
+			Text* line = font->createText();
+			line->init("", 0.02f, 0.05f + i*0.035f, 0.03f, JUSTIFY_LEFT);
+			overlayLines.push_back(line);
+		}
+	}
+}
+
+void Profiler::term()
+{
+	if (overlayFont != nullptr)
+	{
+		for (unsigned int i = 0; i < overlayLines.size(); i++)
+			overlayFont->destroyText(overlayLines[i]);
+	}
+	overlayLines.clear();
+	overlayFont = nullptr;
+}
+
+void Profiler::enable(bool enable)
+{
+	profEnabled = enable;
+}
+
+void Profiler::showOverlay(bool show)
+{
+	overlayOn = show;
+}
+
+bool Profiler::isOverlayOn()
+{
+	return overlayOn;
+}
+
+bool Profiler::beginZone(uint64& start, int& depth)
+{
+	if (!profEnabled)
+		return false;
+
+	ProfileRing* ring = getLocalRing();
+	depth = ring->depth++;
+	start = plat_getRawTicks();
+	return true;
+}
+
+void Profiler::endZone(const char* name, uint64 start, int depth)
+{
+	uint64 end = plat_getRawTicks();
+	ProfileRing* ring = getLocalRing();
+	ring->depth = depth;
+
+	// the consumer only moves the tail forward, so a stale read here can only under-report the free space
+	unsigned int head = ring->head.load(std::memory_order_relaxed);
+	unsigned int tail = ring->tail.load(std::memory_order_acquire);
+	if (head - tail >= PROFILE_RING_SIZE)
+	{
+		ring->dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	ProfileEvent& evt = ring->events[head & (PROFILE_RING_SIZE - 1)];
+	evt.name = name;
+	evt.start = start;
+	evt.end = end;
+	evt.depth = depth;
+	ring->head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::endFrame()
+{
+	if (!profEnabled && zoneList.empty())
+		return;
+
+	// drain every thread's ring
+	for (ProfileRing* ring = ringList.load(); ring != nullptr; ring = ring->next)
+	{
+		unsigned int head = ring->head.load(std::memory_order_acquire);
+		unsigned int tail = ring->tail.load(std::memory_order_relaxed);
+		while (tail != head)
+		{
+			const ProfileEvent& evt = ring->events[tail & (PROFILE_RING_SIZE - 1)];
+			addEvent(evt, ring->thread);
+			if (captureFrames > 0)
+			{
+				TraceEvent trace;
+				trace.evt = evt;
+				trace.thread = ring->thread;
+				traceEvents.push_back(trace);
+			}
+			tail++;
+		}
+		ring->tail.store(tail, std::memory_order_release);
+
+		unsigned int dropped = ring->dropped.exchange(0);
+		if (dropped > 0)
+			LOGWARN("(Profiler::endFrame) Thread %d dropped %d zones", ring->thread, dropped);
+	}
+
+	// close out the frame for every zone that ran
+	for (unsigned int i = 0; i < zoneList.size(); i++)
+	{
+		ZoneRecord& rec = zoneList[i];
+		if (rec.frameCalls > 0)
+		{
+			rec.history[rec.histIndex] = (float)ticksToMs(rec.frameTicks);
+			rec.histIndex = (rec.histIndex + 1) % PROFILE_HISTORY;
+			if (rec.histCount < PROFILE_HISTORY)
+				rec.histCount++;
+			rec.calls = rec.frameCalls;
+			rec.frameTicks = 0;
+			rec.frameCalls = 0;
+		}
+	}
+
+	// write the capture out once it's complete
+	if (captureFrames > 0 && --captureFrames == 0)
+	{
+		if (writeTrace(capturePath))
+			LOGINFO("(Profiler::endFrame) Wrote %d trace events to %s", (int)traceEvents.size(), capturePath.c_str());
+		traceEvents.clear();
+	}
+}
+
+#pragma warning(push)
+#pragma warning(disable: 4996) // _CRT_SECURE_NO_WARNINGS
+
+void Profiler::drawOverlay()
+{
+	if (!overlayOn || overlayLines.empty())
+		return;
+
+	// refresh the text periodically, since it's unreadable when it changes every frame
+	uint64 sysTime = Timer::systemTime();
+	if (lastOverlayStamp == 0 || Timer::ticksToMilliSeconds(sysTime - lastOverlayStamp) >= delayOverlay)
+	{
+		lastOverlayStamp = sysTime;
+
+		std::vector<ProfileStats> stats;
+		getStats(stats);
+
+		// fonts may only have upper case glyphs
+		char line[128];
+		for (unsigned int i = 0; i < overlayLines.size(); i++)
+		{
+			line[0] = 0;
+			if (i == 0)
+				sprintf(line, "ZONE  MIN/AVG/P95/P99 (MS)");
+			else if (i - 1 < stats.size())
+			{
+				const ProfileStats& stat = stats[i - 1];
+				sprintf(line, "%*s%.40s  %.2f/%.2f/%.2f/%.2f", 2 * stat.depth, "", MigUtil::toUpper(stat.name).c_str(),
+					stat.minTime, stat.aveTime, stat.p95Time, stat.p99Time);
+			}
+			overlayLines[i]->update(line);
+		}
+	}
+
+	// reset the modeling matrix
+	MigUtil::theRend->setProjectionMatrix(nullptr);
+	MigUtil::theRend->setViewMatrix(nullptr);
+
+	for (unsigned int i = 0; i < overlayLines.size(); i++)
+	{
+		if (!overlayLines[i]->getText().empty())
+			overlayLines[i]->draw(0.9f, 0.9f, 0.5f, 1);
+	}
+}
+
+#pragma warning(pop)
+
+void Profiler::getStats(std::vector<ProfileStats>& stats)
+{
+	// sort into tree order, a parent starts before its children and siblings are ordered by start time
+	std::vector<int> sorted;
+	for (unsigned int i = 0; i < zoneList.size(); i++)
+	{
+		if (zoneList[i].histCount > 0)
+			sorted.push_back(i);
+	}
+	std::sort(sorted.begin(), sorted.end(), orderZones);
+
+	stats.clear();
+	std::vector<float> times;
+	for (unsigned int i = 0; i < sorted.size(); i++)
+	{
+		const ZoneRecord& rec = zoneList[sorted[i]];
+		times.assign(rec.history, rec.history + rec.histCount);
+		std::sort(times.begin(), times.end());
+
+		double total = 0;
+		for (unsigned int j = 0; j < times.size(); j++)
+			total += times[j];
+
+		ProfileStats stat;
+		stat.name = rec.name;
+		stat.thread = rec.thread;
+		stat.depth = rec.depth;
+		stat.calls = rec.calls;
+		stat.frames = rec.histCount;
+		stat.last = rec.history[(rec.histIndex + PROFILE_HISTORY - 1) % PROFILE_HISTORY];
+		stat.minTime = times[0];
+		stat.aveTime = total / times.size();
+		stat.p95Time = getPercentile(times, 0.95);
+		stat.p99Time = getPercentile(times, 0.99);
+		stats.push_back(stat);
+	}
+}
+
+void Profiler::resetStats()
+{
+	zoneMap.clear();
+	zoneList.clear();
+}
+
+void Profiler::startCapture(int frames, const std::string& path)
+{
+	if (frames <= 0)
+		return;
+
+	// zones recorded before this point aren't part of the capture
+	traceEvents.clear();
+	captureFrames = frames;
+	capturePath = path;
+	if (capturePath.empty())
+		capturePath = plat_getFilesDir() + "/" + PROFILE_TRACE_FILE;
+	enable(true);
+
+	LOGINFO("(Profiler::startCapture) Capturing %d frames to %s", frames, capturePath.c_str());
+}
+
+bool Profiler::isCapturing()
+{
+	return (captureFrames > 0);
+}
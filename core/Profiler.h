@@ -0,0 +1,89 @@
+﻿#pragma once
+
+#include "MigDefines.h"
+#include "Font.h"
+
+namespace MigTech
+{
+	// aggregated timing for one zone, times are per frame in milliseconds
+	struct ProfileStats
+	{
+		const char* name;
+		unsigned int thread;
+		int depth;
+		int calls;		// in the most recent frame it ran
+		int frames;		// number of frames in the history
+		double last;
+		double minTime;
+		double aveTime;
+		double p95Time;
+		double p99Time;
+	};
+
+	// hierarchical CPU profiler, zones are recorded into per-thread ring buffers and aggregated once per frame
+	class Profiler
+	{
+	private:
+		// enabled state, zones are nearly free when off
+		static bool profEnabled;
+
+		// overlay display
+		static bool overlayOn;
+		static long delayOverlay;
+		static uint64 lastOverlayStamp;
+		static std::vector<Text*> overlayLines;
+		static const Font* overlayFont;
+
+		// chrome trace capture
+		static int captureFrames;
+		static std::string capturePath;
+
+	public:
+		// static interface, used by Game class
+		static void init(Font* font);
+		static void term();
+		static void enable(bool enable);
+		static bool isEnabled() { return profEnabled; }
+		static void showOverlay(bool show);
+		static bool isOverlayOn();
+		static void endFrame();
+		static void drawOverlay();
+
+		// zone markers (use the PROFILE_ZONE macro instead)
+		static bool beginZone(uint64& start, int& depth);
+		static void endZone(const char* name, uint64 start, int depth);
+
+		// stats for every zone seen so far, in hierarchical order
+		static void getStats(std::vector<ProfileStats>& stats);
+		static void resetStats();
+
+		// records the next few frames and writes them out as chrome trace event JSON
+		static void startCapture(int frames, const std::string& path = "");
+		static bool isCapturing();
+	};
+
+	// marks a zone for the lifetime of the object, the name must outlive the profiler (use a string literal)
+	class ProfileZone
+	{
+	public:
+		ProfileZone(const char* name) : _name(name)
+		{
+			_active = Profiler::beginZone(_start, _depth);
+		}
+		~ProfileZone()
+		{
+			if (_active)
+				Profiler::endZone(_name, _start, _depth);
+		}
+
+	private:
+		const char* _name;
+		uint64 _start;
+		int _depth;
+		bool _active;
+	};
+}
+
+#define PROFILE_ZONE_CONCAT2(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT2(a, b)
+#define PROFILE_ZONE(name) MigTech::ProfileZone PROFILE_ZONE_CONCAT(profZone, __LINE__)(name)
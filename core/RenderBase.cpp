@@ -1,6 +1,10 @@
 ﻿#include "pch.h"
 #include "MigUtil.h"
 #include "RenderBase.h"
+#include "AssetLoader.h"
+#include "ResourceCache.h"
+
+#include <algorithm>
 
 using namespace MigTech;
 
@@ -14,8 +18,8 @@ RenderPass::RenderPass(RenderPassType type) : _type(type), _target(nullptr), _cl
 
 RenderPass::~RenderPass()
 {
-	// this will unload and destroy the render target image
-	if (!_name.empty() && MigUtil::theRend != nullptr)
+	// this will unload and destroy the render target image, unless destroyGraphics() already did
+	if (_target != nullptr && MigUtil::theRend != nullptr)
 		MigUtil::theRend->unloadImage(_name);
 }
 
@@ -69,7 +73,7 @@ void RenderPass::createGraphics()
 
 void RenderPass::destroyGraphics()
 {
-	if (MigUtil::theRend != nullptr && _name.length() > 0)
+	if (MigUtil::theRend != nullptr && _target != nullptr)
 		MigUtil::theRend->unloadImage(_name);
 	_target = nullptr;
 }
@@ -89,11 +93,407 @@ bool RenderPass::isValid() const
 
 bool RenderPass::preRender()
 {
-	MigUtil::theRend->setProjectionMatrix(_proj);
-	MigUtil::theRend->setViewMatrix(_view);
+	MigUtil::theRend->setProjectionMatrix(&_proj);
+	MigUtil::theRend->setViewMatrix(&_view);
 	return true;
 }
 
 void RenderPass::postRender()
 {
 }
+
+///////////////////////////////////////////////////////////////////////////
+// RenderBase
+
+// sort key layout, from the most significant bit down
+//  - 4 bits pass, 12 bits layer (draws without depth testing each get their own layer to keep their order)
+//  - 1 bit transparent (blended draws go after the opaque ones in a layer)
+//  - opaque: 32 bits state key (program/textures) then 15 bits of front-to-back depth
+//  - transparent: 32 bits of back-to-front depth then 15 bits of state key
+static const int KEY_PASS_SHIFT = 60;
+static const int KEY_LAYER_SHIFT = 48;
+static const int KEY_TRANSPARENT_SHIFT = 47;
+static const int KEY_MID_SHIFT = 15;
+static const unsigned int KEY_MAX_LAYER = 0xFFE;
+
+// positive floats sort the same as their bit patterns
+static unsigned int depthToBits(float dist)
+{
+	unsigned int bits = 0;
+	if (dist > 0)
+		memcpy(&bits, &dist, sizeof(bits));
+	return bits;
+}
+
+RenderBase::RenderBase() :
+	_compressionCaps(0), _queueEnabled(false), _queueOpen(false), _submitting(false),
+	_queuePass(0), _queueLayer(0)
+{
+}
+
+void RenderBase::setProjectionMatrix(const Matrix* pmat)
+{
+	flushQueue();
+	applyProjectionMatrix(pmat);
+}
+
+void RenderBase::setProjectionMatrix(float angleY, float aspect, float nearZ, float farZ, bool useOrientation)
+{
+	flushQueue();
+	applyProjectionMatrix(angleY, aspect, nearZ, farZ, useOrientation);
+}
+
+void RenderBase::setViewMatrix(const Matrix* pmat)
+{
+	flushQueue();
+	if (pmat != nullptr)
+		_viewMat = *pmat;
+	else
+		_viewMat.identity();
+	applyViewMatrix(pmat);
+}
+
+void RenderBase::setViewMatrix(Vector3 eyePos, Vector3 focusPos, Vector3 upVector)
+{
+	flushQueue();
+	_viewMat.loadLookAtRH(eyePos, focusPos, upVector);
+	applyViewMatrix(eyePos, focusPos, upVector);
+}
+
+void RenderBase::setModelMatrix(const Matrix* pmat)
+{
+	flushSprites();
+	if (pmat != nullptr)
+		_drawState.model = *pmat;
+	else
+		_drawState.model.identity();
+	applyModelMatrix(pmat);
+}
+
+Image* RenderBase::loadImage(const std::string& name, const std::string& path, unsigned int loadFlags)
+{
+	// atlased images share their page (and its reference count)
+	const AtlasEntry* entry = _atlas.find(name);
+	if (entry != nullptr)
+	{
+		if (loadFlags != LOAD_IMAGE_NONE)
+			LOGWARN("(RenderBase::loadImage) Load flags are ignored for atlased image '%s'", name.c_str());
+		return loadImage(entry->page, entry->page, LOAD_IMAGE_NONE);
+	}
+
+	// an image that already exists only gains a reference
+	Image* pi = getImage(name);
+	if (pi != nullptr)
+	{
+		if (!ResourceCache::addRef(RESOURCE_IMAGE, name))
+			ResourceCache::add(RESOURCE_IMAGE, name, pi);
+		return pi;
+	}
+
+	Image* newImage = loadNewImage(name, path, loadFlags);
+	if (newImage != nullptr)
+		ResourceCache::add(RESOURCE_IMAGE, name, newImage);
+	return newImage;
+}
+
+Image* RenderBase::createRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint)
+{
+	// if the render target already exists, that is considered an error
+	if (getImage(name) != nullptr)
+		return nullptr;
+
+	Image* newTarget = createNewRenderTarget(name, fmtHint, width, height, depthBitsHint);
+	if (newTarget != nullptr)
+		ResourceCache::add(RESOURCE_IMAGE, name, newTarget);
+	return newTarget;
+}
+
+Image* RenderBase::getImage(const std::string& name)
+{
+	return findImage(resolveImageName(name));
+}
+
+// the image is only destroyed once the last reference is gone
+void RenderBase::unloadImage(const std::string& name)
+{
+	const std::string& resolved = resolveImageName(name);
+	if (!ResourceCache::release(RESOURCE_IMAGE, resolved))
+		destroyImage(resolved);
+}
+
+Image* RenderBase::loadImageAsync(const std::string& name, const std::string& path, unsigned int loadFlags, IImageLoadCallback* callback)
+{
+	const AtlasEntry* entry = _atlas.find(name);
+	if (entry != nullptr)
+	{
+		if (loadFlags != LOAD_IMAGE_NONE)
+			LOGWARN("(RenderBase::loadImageAsync) Load flags are ignored for atlased image '%s'", name.c_str());
+		return loadImageAsync(entry->page, entry->page, LOAD_IMAGE_NONE, callback);
+	}
+
+	// an image that already exists is either ready, failed or on its way
+	Image* pi = getImage(name);
+	if (pi != nullptr)
+	{
+		if (!ResourceCache::addRef(RESOURCE_IMAGE, name))
+			ResourceCache::add(RESOURCE_IMAGE, name, pi);
+		if (callback != nullptr)
+		{
+			if (pi->isPending())
+				pi->_callbacks.push_back(callback);
+			else
+				callback->imageLoaded(name, pi, pi->isReady());
+		}
+		return pi;
+	}
+
+	Image* newImage = createPendingImage(name);
+	if (newImage != nullptr)
+	{
+		ResourceCache::add(RESOURCE_IMAGE, name, newImage);
+		if (callback != nullptr)
+			newImage->_callbacks.push_back(callback);
+		AssetLoader::queueImage(newImage, name, path, loadFlags);
+	}
+	return newImage;
+}
+
+bool RenderBase::loadAtlasIndex(const std::string& indexPath)
+{
+	return _atlas.load(indexPath);
+}
+
+const std::string& RenderBase::resolveImageName(const std::string& name) const
+{
+	const AtlasEntry* entry = _atlas.find(name);
+	return (entry != nullptr ? entry->page : name);
+}
+
+bool RenderBase::getImageRect(const std::string& name, std::string& page, UVSet& uv) const
+{
+	const AtlasEntry* entry = _atlas.find(name);
+	if (entry != nullptr)
+	{
+		page = entry->page;
+		uv = entry->uv;
+		return true;
+	}
+
+	page = name;
+	uv.u1 = uv.v1 = 0;
+	uv.u2 = uv.v2 = 1;
+	return false;
+}
+
+void RenderBase::setViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer)
+{
+	flushQueue();
+	applyViewport(newPort, clearRenderBuffer, clearDepthBuffer);
+}
+
+void RenderBase::setObjectColor(const Color& objCol)
+{
+	flushSprites();
+	_drawState.objColor = objCol;
+	applyObjectColor(objCol);
+}
+
+void RenderBase::setBlending(BLEND_STATE blend)
+{
+	flushSprites();
+	_drawState.blend = blend;
+	applyBlending(blend);
+}
+
+void RenderBase::setDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite)
+{
+	flushSprites();
+	_drawState.depth = depth;
+	_drawState.depthWrite = enableWrite;
+	applyDepthTesting(depth, enableWrite);
+}
+
+void RenderBase::setMiscValue(int index, float value)
+{
+	flushSprites();
+	// the backend throws on a bad index
+	if (index >= 0 && index < 4)
+		_drawState.misc[index] = value;
+	applyMiscValue(index, value);
+}
+
+void RenderBase::setAmbientColor(const Color& ambientCol)
+{
+	flushQueue();
+	applyAmbientColor(ambientCol);
+}
+
+void RenderBase::setLightColor(int index, const Color& litCol)
+{
+	flushQueue();
+	applyLightColor(index, litCol);
+}
+
+void RenderBase::setLightDirPos(int index, const Vector3& litDirPos, bool isDir)
+{
+	flushQueue();
+	applyLightDirPos(index, litDirPos, isDir);
+}
+
+void RenderBase::beginPass(int pass, RenderPass* passObj)
+{
+	preRender(pass, passObj);
+
+	_queuePass = pass;
+	_queueOpen = true;
+}
+
+void RenderBase::endPass(int pass, RenderPass* passObj)
+{
+	flushQueue();
+	_queueOpen = false;
+
+	postRender(pass, passObj);
+}
+
+void RenderBase::setRenderQueue(bool enable)
+{
+	flushSprites();
+	if (!enable)
+		flushQueue();
+	_queueEnabled = enable;
+}
+
+bool RenderBase::queueDraw(Object* obj, int shaderSet)
+{
+	return queuePacket(obj, shaderSet, nullptr, 0);
+}
+
+bool RenderBase::queueDrawInstanced(Object* obj, int shaderSet, const InstanceData* instances, unsigned int count)
+{
+	return queuePacket(obj, shaderSet, instances, count);
+}
+
+bool RenderBase::queuePacket(Object* obj, int shaderSet, const InstanceData* instances, unsigned int count)
+{
+	// sprites collected so far go first to keep the draw order
+	flushSprites();
+
+	if (!isQueueing() || obj == nullptr)
+		return false;
+
+	// dynamic buffers may be reloaded before the queue is submitted, so those draw now (after what's queued)
+	if (obj->getBufferUsage() == BUFFER_USAGE_DYNAMIC)
+	{
+		flushQueue();
+		return false;
+	}
+
+	// out of layers, so submit what we have and start over
+	if (_queueLayer >= KEY_MAX_LAYER)
+		flushQueue();
+
+	DrawPacket packet;
+	packet.obj = obj;
+	packet.shaderSet = shaderSet;
+	packet.indexOffset = obj->getIndexOffset();
+	packet.indexCount = obj->getIndexCount();
+	packet.instStart = _queueInst.size();
+	packet.instCount = count;
+	packet.state = _drawState;
+
+	// the caller owns the instance data and may reuse it right away
+	if (count > 0)
+		_queueInst.insert(_queueInst.end(), instances, instances + count);
+
+	// instanced draws are sorted on their first instance
+	packet.key = makeSortKey(obj, shaderSet, (count > 0 ? instances[0].model : _drawState.model));
+
+	_queueOrder.push_back(std::make_pair(packet.key, (unsigned int)_queue.size()));
+	_queue.push_back(packet);
+	return true;
+}
+
+uint64 RenderBase::makeSortKey(Object* obj, int shaderSet, const Matrix& model)
+{
+	uint64 key = ((uint64)((_queuePass + 1) & 0xF) << KEY_PASS_SHIFT);
+	if (_drawState.depth == DEPTH_TEST_STATE_NONE)
+	{
+		// draw order matters without depth testing, so this gets a layer to itself
+		_queueLayer++;
+		key |= ((uint64)_queueLayer << KEY_LAYER_SHIFT);
+		_queueLayer++;
+		return key;
+	}
+	key |= ((uint64)_queueLayer << KEY_LAYER_SHIFT);
+
+	// distance from the camera to the object's origin
+	const float* m = model.getData();
+	Vector3 pt(m[12], m[13], m[14]);
+	_viewMat.transform(pt);
+	unsigned int depthBits = depthToBits(-pt.z);
+
+	unsigned int stateKey = obj->getStateKey(shaderSet);
+	if (_drawState.blend == BLEND_STATE_NONE)
+		key |= ((uint64)stateKey << KEY_MID_SHIFT) | (depthBits >> 17);
+	else
+		key |= ((uint64)1 << KEY_TRANSPARENT_SHIFT) | ((uint64)(~depthBits) << KEY_MID_SHIFT) | (stateKey & 0x7FFF);
+	return key;
+}
+
+void RenderBase::applyDrawState(const DrawState& state)
+{
+	applyModelMatrix(&state.model);
+	applyObjectColor(state.objColor);
+	for (int i = 0; i < 4; i++)
+		applyMiscValue(i, state.misc[i]);
+	applyBlending(state.blend);
+	applyDepthTesting(state.depth, state.depthWrite);
+}
+
+void RenderBase::flushSprites()
+{
+	if (MigUtil::theSprites == nullptr || !MigUtil::theSprites->isPending())
+		return;
+
+	// the batch sets its own state through the setters below, which leaves things as they would be after
+	//  drawing each sprite on its own
+	MigUtil::theSprites->flush();
+}
+
+void RenderBase::flushQueue()
+{
+	flushSprites();
+	if (_queue.empty() || _submitting)
+		return;
+
+	// the index breaks ties so equal keys keep their submission order
+	std::sort(_queueOrder.begin(), _queueOrder.end());
+
+	_submitting = true;
+	for (unsigned int i = 0; i < _queueOrder.size(); i++)
+	{
+		const DrawPacket& packet = _queue[_queueOrder[i].second];
+		applyDrawState(packet.state);
+
+		// the index range is object state too, so put back whatever the caller has set since
+		Object* obj = packet.obj;
+		int offset = obj->getIndexOffset();
+		int count = obj->getIndexCount();
+		obj->setIndexOffset(packet.indexOffset, packet.indexCount);
+		if (packet.instCount > 0)
+			obj->renderInstanced(packet.shaderSet, &_queueInst[packet.instStart], packet.instCount);
+		else
+			obj->render(packet.shaderSet);
+		obj->setIndexOffset(offset, count);
+	}
+	_submitting = false;
+
+	_queue.clear();
+	_queueInst.clear();
+	_queueOrder.clear();
+	_queueLayer = 0;
+
+	// leave the backend with the state the caller last set
+	applyDrawState(_drawState);
+}
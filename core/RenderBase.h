@@ -6,6 +6,7 @@
 #include "Image.h"
 #include "Shader.h"
 #include "Object.h"
+#include "TextureAtlas.h"
 
 namespace MigTech
 {
@@ -76,54 +77,127 @@ namespace MigTech
 		Rect _viewPort;
 	};
 
+	// the per draw state that is captured when a draw is queued
+	struct DrawState
+	{
+		Matrix model;
+		Color objColor;
+		float misc[4];
+		BLEND_STATE blend;
+		DEPTH_TEST_STATE depth;
+		bool depthWrite;
+
+		DrawState() : blend(BLEND_STATE_NONE), depth(DEPTH_TEST_STATE_NONE), depthWrite(false) { misc[0] = misc[1] = misc[2] = misc[3] = 0; }
+	};
+
+	// a single queued draw, submitted in key order when the pass ends
+	struct DrawPacket
+	{
+		uint64 key;
+		Object* obj;
+		int shaderSet;
+		int indexOffset;
+		int indexCount;
+		unsigned int instStart;		// into the queue's instance data
+		unsigned int instCount;		// 0 for a regular draw
+		DrawState state;
+	};
+
 	class RenderBase
 	{
+		friend class ResourceCache;
+
 	protected:
 		virtual void createDeviceIndependentResources() = 0;
 		virtual void createDeviceResources() = 0;
 		virtual void createWindowSizeDependentResources() = 0;
 
+		// the backends own the images, the public calls below count the references first
+		virtual Image* loadNewImage(const std::string& name, const std::string& path, unsigned int loadFlags) = 0;
+		virtual Image* createNewRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint) = 0;
+		virtual void destroyImage(const std::string& name) = 0;
+
+		// the backend's own lookup, getImage() resolves atlased names to their page first
+		virtual Image* findImage(const std::string& name) = 0;
+
+		// registers an empty image under this name for an asynchronous load
+		virtual Image* createPendingImage(const std::string& name) = 0;
+
+		// the backends implement these, the public setters below track the state first
+		virtual void applyProjectionMatrix(const Matrix* pmat) = 0;
+		virtual void applyProjectionMatrix(float angleY, float aspect, float nearZ, float farZ, bool useOrientation) = 0;
+		virtual void applyViewMatrix(const Matrix* pmat) = 0;
+		virtual void applyViewMatrix(Vector3 eyePos, Vector3 focusPos, Vector3 upVector) = 0;
+		virtual void applyModelMatrix(const Matrix* pmat) = 0;
+		virtual void applyViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer) = 0;
+		virtual void applyObjectColor(const Color& objCol) = 0;
+		virtual void applyBlending(BLEND_STATE blend) = 0;
+		virtual void applyDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite) = 0;
+		virtual void applyMiscValue(int index, float value) = 0;
+		virtual void applyAmbientColor(const Color& ambientCol) = 0;
+		virtual void applyLightColor(int index, const Color& litCol) = 0;
+		virtual void applyLightDirPos(int index, const Vector3& litDirPos, bool isDir) = 0;
+
 	public:
-		RenderBase() { }
+		RenderBase();
 		virtual ~RenderBase() { }
 
 		virtual bool initRenderer() = 0;
 		virtual void termRenderer() = 0;
 
-		virtual IMatrix* createMatrix() = 0;
-		virtual void deleteMatrix(IMatrix* pmat) = 0;
-		virtual void setProjectionMatrix(const IMatrix* pmat) = 0;
-		virtual void setProjectionMatrix(float angleY, float aspect, float nearZ, float farZ, bool useOrientation) = 0;
-		virtual void setViewMatrix(const IMatrix* pmat) = 0;
-		virtual void setViewMatrix(Vector3 eyePos, Vector3 focusPos, Vector3 upVector) = 0;
-		virtual void setModelMatrix(const IMatrix* pmat) = 0;
+		void setProjectionMatrix(const Matrix* pmat);
+		void setProjectionMatrix(float angleY, float aspect, float nearZ, float farZ, bool useOrientation);
+		void setViewMatrix(const Matrix* pmat);
+		void setViewMatrix(Vector3 eyePos, Vector3 focusPos, Vector3 upVector);
+		void setModelMatrix(const Matrix* pmat);
 
 		virtual Shader* loadVertexShader(const std::string& name, VDTYPE vdType, unsigned int shaderHints) = 0;
 		virtual Shader* loadPixelShader(const std::string& name, unsigned int shaderHints) = 0;
 		virtual Shader* getShader(const std::string& name) = 0;
 
-		virtual Image* loadImage(const std::string& name, const std::string& path, unsigned int loadFlags) = 0;
-		virtual Image* getImage(const std::string& name) = 0;
-		virtual Image* createRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint) = 0;
-		virtual void unloadImage(const std::string& name) = 0;
+		// every load or render target creation must be matched by an unloadImage()
+		//  an image named in the atlas index loads (or references) its page instead, see getImageRect()
+		Image* loadImage(const std::string& name, const std::string& path, unsigned int loadFlags);
+		Image* getImage(const std::string& name);
+		Image* createRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint);
+		void unloadImage(const std::string& name);
+
+		// returns right away with a pending image, the callback (optional) is made once it's uploaded
+		Image* loadImageAsync(const std::string& name, const std::string& path, unsigned int loadFlags, IImageLoadCallback* callback = nullptr);
+
+		// texture atlases written by tools/atlascooker, load the index before any of its images
+		bool loadAtlasIndex(const std::string& indexPath);
+		const std::string& resolveImageName(const std::string& name) const;
+
+		// returns true if the image is a sub-rect of an atlas page, otherwise the page is the image itself (full UVs)
+		bool getImageRect(const std::string& name, std::string& page, UVSet& uv) const;
+
+		// used by the asset loader, decodeImage() is called from worker threads
+		//  fitSize is the output size when the load was requested (see LOAD_IMAGE_FIT_OUTPUT)
+		virtual bool decodeImage(const std::string& path, unsigned int loadFlags, const Size& fitSize, ImageData& data) = 0;
+		virtual void uploadImage(Image* img, const ImageData& data) = 0;
+
+		// block compressed formats the GPU takes as is, anything else in a KTX file is decoded on the CPU
+		bool isCompressionSupported(TEX_COMPRESSION comp) const { return ((_compressionCaps & (1 << comp)) != 0); }
+		unsigned int getCompressionCaps() const { return _compressionCaps; }
 
 		virtual Object* createObject() = 0;
 		virtual void deleteObject(Object* pobj) = 0;
 
 		virtual void setOutputSize(Size newSize) = 0;
 		virtual Size getOutputSize() = 0;
-		virtual void setViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer) = 0;
+		void setViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer);
 
 		virtual void setClearColor(const Color& clearCol) = 0;
-		virtual void setObjectColor(const Color& objCol) = 0;
-		virtual void setBlending(BLEND_STATE blend) = 0;
-		virtual void setDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite) = 0;
+		void setObjectColor(const Color& objCol);
+		void setBlending(BLEND_STATE blend);
+		void setDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite);
 		virtual void setFaceCulling(FACE_CULLING cull) = 0;
 
-		virtual void setMiscValue(int index, float value) = 0;
-		virtual void setAmbientColor(const Color& ambientCol) = 0;
-		virtual void setLightColor(int index, const Color& litCol) = 0;
-		virtual void setLightDirPos(int index, const Vector3& litDirPos, bool isDir) = 0;
+		void setMiscValue(int index, float value);
+		void setAmbientColor(const Color& ambientCol);
+		void setLightColor(int index, const Color& litCol);
+		void setLightDirPos(int index, const Vector3& litDirPos, bool isDir);
 
 		virtual void onSuspending() = 0;
 		virtual void onResuming() = 0;
@@ -131,5 +205,46 @@ namespace MigTech
 		virtual void preRender(int pass, RenderPass* passObj) = 0;
 		virtual void postRender(int pass, RenderPass* passObj) = 0;
 		virtual void present() = 0;
+
+		// wraps preRender/postRender, the render queue (if enabled) collects the draws in between
+		void beginPass(int pass, RenderPass* passObj);
+		void endPass(int pass, RenderPass* passObj);
+
+		// render queue, objects call queueDraw() from render() and draw immediately if it returns false
+		void setRenderQueue(bool enable);
+		bool isRenderQueueEnabled() const { return _queueEnabled; }
+		bool isQueueing() const { return (_queueEnabled && _queueOpen && !_submitting); }
+		bool queueDraw(Object* obj, int shaderSet);
+		bool queueDrawInstanced(Object* obj, int shaderSet, const InstanceData* instances, unsigned int count);
+		void flushQueue();
+
+		// draws whatever the sprite batch has collected, called ahead of any other draw or state change
+		void flushSprites();
+
+	protected:
+		bool queuePacket(Object* obj, int shaderSet, const InstanceData* instances, unsigned int count);
+		uint64 makeSortKey(Object* obj, int shaderSet, const Matrix& model);
+		void applyDrawState(const DrawState& state);
+
+	protected:
+		// state as last set by the caller
+		DrawState _drawState;
+		Matrix _viewMat;
+
+		// bits of (1 << TEX_COMPRESSION), set by initRenderer() before the loader threads start
+		unsigned int _compressionCaps;
+
+		// atlased image names
+		TextureAtlas _atlas;
+
+		// render queue
+		bool _queueEnabled;
+		bool _queueOpen;
+		bool _submitting;
+		int _queuePass;
+		unsigned int _queueLayer;
+		std::vector<DrawPacket> _queue;
+		std::vector<InstanceData> _queueInst;
+		std::vector<std::pair<uint64, unsigned int> > _queueOrder;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,274 @@
+﻿#include "pch.h"
+#include "ResourceCache.h"
+#include "MigUtil.h"
+#include "PersistBase.h"
+
+using namespace MigTech;
+
+std::map<std::string, ResourceCache::Entry> ResourceCache::entries[RESOURCE_TYPE_COUNT];
+std::map<std::string, bool> ResourceCache::keepWarmList[RESOURCE_TYPE_COUNT];
+uint64 ResourceCache::imageBudget = 0;
+uint64 ResourceCache::useClock = 0;
+bool ResourceCache::overBudget = false;
+
+#define BYTES_TO_MB(b) ((b) / (1024.0 * 1024.0))
+
+void ResourceCache::freeResource(RESOURCE_TYPE type, const std::string& name, void* res)
+{
+	switch (type)
+	{
+	case RESOURCE_IMAGE:
+		if (MigUtil::theRend != nullptr)
+			MigUtil::theRend->destroyImage(name);
+		break;
+	case RESOURCE_SOUND:
+		if (MigUtil::theAudio != nullptr && res != nullptr)
+			MigUtil::theAudio->deleteMedia((SoundEffect*)res);
+		break;
+	case RESOURCE_DOCUMENT:
+		if (res != nullptr)
+			delete (tinyxml2::XMLDocument*)res;
+		break;
+	default:
+		break;
+	}
+}
+
+// with a budget, idle images stay resident in case they're needed again (render targets and failed loads don't)
+bool ResourceCache::isIdleCacheable(RESOURCE_TYPE type, const Entry& entry)
+{
+	if (type != RESOURCE_IMAGE || imageBudget == 0 || entry.res == nullptr)
+		return false;
+
+	const Image* img = (const Image*)entry.res;
+	return ((img->getCaps() & IMAGE_CAPS_RENDER_TARGET) == 0 && img->getLoadState() != IMAGE_LOAD_FAILED);
+}
+
+void ResourceCache::enforceBudget()
+{
+	if (imageBudget == 0)
+		return;
+
+	std::map<std::string, Entry>& images = entries[RESOURCE_IMAGE];
+	uint64 resident = getResidentImageBytes();
+	while (resident > imageBudget)
+	{
+		// the least recently used idle image, ones the current screen keeps warm go last
+		std::map<std::string, Entry>::iterator victim = images.end();
+		bool victimWarm = false;
+		for (std::map<std::string, Entry>::iterator iter = images.begin(); iter != images.end(); iter++)
+		{
+			if (iter->second.refs > 0)
+				continue;
+
+			bool warm = isKeptWarm(RESOURCE_IMAGE, iter->first);
+			if (victim == images.end() || (victimWarm && !warm) ||
+				(warm == victimWarm && iter->second.lastUsed < victim->second.lastUsed))
+			{
+				victim = iter;
+				victimWarm = warm;
+			}
+		}
+
+		if (victim == images.end())
+		{
+			if (!overBudget)
+				LOGWARN("(ResourceCache::enforceBudget) Images in use (%.1f MB) exceed the texture budget (%.1f MB)",
+					BYTES_TO_MB(resident), BYTES_TO_MB(imageBudget));
+			overBudget = true;
+			return;
+		}
+
+		std::string name = victim->first;
+		void* res = victim->second.res;
+		resident -= (res != nullptr ? ((Image*)res)->getByteSize() : 0);
+		images.erase(victim);
+		LOGDBG("(ResourceCache::enforceBudget) Evicting %s", name.c_str());
+		freeResource(RESOURCE_IMAGE, name, res);
+	}
+	overBudget = false;
+}
+
+bool ResourceCache::addRef(RESOURCE_TYPE type, const std::string& name)
+{
+	std::map<std::string, Entry>::iterator iter = entries[type].find(name);
+	if (iter == entries[type].end())
+		return false;
+
+	iter->second.refs++;
+	iter->second.lastUsed = ++useClock;
+	return true;
+}
+
+void ResourceCache::add(RESOURCE_TYPE type, const std::string& name, void* res)
+{
+	if (entries[type].find(name) != entries[type].end())
+		throw std::invalid_argument("(ResourceCache::add) resource is already cached");
+
+	Entry newEntry;
+	newEntry.refs = 1;
+	newEntry.res = res;
+	newEntry.lastUsed = ++useClock;
+	entries[type][name] = newEntry;
+
+	// the new image is referenced, so this only pushes out idle ones
+	if (type == RESOURCE_IMAGE)
+		enforceBudget();
+}
+
+bool ResourceCache::release(RESOURCE_TYPE type, const std::string& name)
+{
+	std::map<std::string, Entry>::iterator iter = entries[type].find(name);
+	if (iter == entries[type].end())
+		return false;
+
+	if (iter->second.refs > 0)
+		iter->second.refs--;
+	iter->second.lastUsed = ++useClock;
+	if (iter->second.refs == 0 && !isKeptWarm(type, name) && !isIdleCacheable(type, iter->second))
+	{
+		// erased first, freeing an image comes back through RenderBase
+		void* res = iter->second.res;
+		entries[type].erase(iter);
+		freeResource(type, name, res);
+	}
+	else if (type == RESOURCE_IMAGE)
+		enforceBudget();
+	return true;
+}
+
+void* ResourceCache::find(RESOURCE_TYPE type, const std::string& name)
+{
+	std::map<std::string, Entry>::const_iterator iter = entries[type].find(name);
+	return (iter != entries[type].end() ? iter->second.res : nullptr);
+}
+
+int ResourceCache::getRefCount(RESOURCE_TYPE type, const std::string& name)
+{
+	std::map<std::string, Entry>::const_iterator iter = entries[type].find(name);
+	return (iter != entries[type].end() ? iter->second.refs : 0);
+}
+
+void ResourceCache::setKeepWarm(const ResourceList& list)
+{
+	for (int i = 0; i < RESOURCE_TYPE_COUNT; i++)
+		keepWarmList[i].clear();
+	for (size_t i = 0; i < list.size(); i++)
+	{
+		// atlased images are cached under their page
+		if (list[i].type == RESOURCE_IMAGE && MigUtil::theRend != nullptr)
+			keepWarmList[RESOURCE_IMAGE][MigUtil::theRend->resolveImageName(list[i].name)] = true;
+		else
+			keepWarmList[list[i].type][list[i].name] = true;
+	}
+}
+
+bool ResourceCache::isKeptWarm(RESOURCE_TYPE type, const std::string& name)
+{
+	return (keepWarmList[type].find(name) != keepWarmList[type].end());
+}
+
+void ResourceCache::trim()
+{
+	for (int i = 0; i < RESOURCE_TYPE_COUNT; i++)
+	{
+		RESOURCE_TYPE type = (RESOURCE_TYPE)i;
+		std::map<std::string, Entry>::iterator iter = entries[type].begin();
+		while (iter != entries[type].end())
+		{
+			if (iter->second.refs == 0 && !isKeptWarm(type, iter->first) && !isIdleCacheable(type, iter->second))
+			{
+				std::string name = iter->first;
+				void* res = iter->second.res;
+				iter = entries[type].erase(iter);
+				freeResource(type, name, res);
+			}
+			else
+				iter++;
+		}
+	}
+	enforceBudget();
+}
+
+void ResourceCache::setImageBudget(uint64 bytes)
+{
+	imageBudget = bytes;
+	overBudget = false;
+	enforceBudget();
+}
+
+uint64 ResourceCache::getImageBudget()
+{
+	return imageBudget;
+}
+
+uint64 ResourceCache::getResidentImageBytes()
+{
+	uint64 total = 0;
+	std::map<std::string, Entry>::const_iterator iter;
+	for (iter = entries[RESOURCE_IMAGE].begin(); iter != entries[RESOURCE_IMAGE].end(); iter++)
+	{
+		if (iter->second.res != nullptr)
+			total += ((const Image*)iter->second.res)->getByteSize();
+	}
+	return total;
+}
+
+int ResourceCache::getResidentImageCount()
+{
+	return (int)entries[RESOURCE_IMAGE].size();
+}
+
+unsigned int ResourceCache::getImageBytes(const std::string& name)
+{
+	const Image* img = (const Image*)find(RESOURCE_IMAGE, (MigUtil::theRend != nullptr ? MigUtil::theRend->resolveImageName(name) : name));
+	return (img != nullptr ? img->getByteSize() : 0);
+}
+
+void ResourceCache::term()
+{
+	// w/o a budget nothing idle is held back
+	imageBudget = 0;
+	setKeepWarm(ResourceList());
+	trim();
+}
+
+void ResourceCache::clear(RESOURCE_TYPE type)
+{
+	entries[type].clear();
+}
+
+SoundEffect* ResourceCache::loadSound(const std::string& name)
+{
+	if (addRef(RESOURCE_SOUND, name))
+		return (SoundEffect*)find(RESOURCE_SOUND, name);
+
+	SoundEffect* peff = nullptr;
+	if (MigUtil::theAudio != nullptr)
+		peff = MigUtil::theAudio->loadMedia(name, AudioBase::AUDIO_CHANNEL_SOUND);
+	if (peff != nullptr)
+		add(RESOURCE_SOUND, name, peff);
+	return peff;
+}
+
+void ResourceCache::unloadSound(const std::string& name)
+{
+	release(RESOURCE_SOUND, name);
+}
+
+// the document is shared, callers must not change it
+tinyxml2::XMLDocument* ResourceCache::loadDocument(const std::string& docPath)
+{
+	if (addRef(RESOURCE_DOCUMENT, docPath))
+		return (tinyxml2::XMLDocument*)find(RESOURCE_DOCUMENT, docPath);
+
+	tinyxml2::XMLDocument* pdoc = XMLDocFactory::loadDocument(docPath);
+	if (pdoc != nullptr)
+		add(RESOURCE_DOCUMENT, docPath, pdoc);
+	return pdoc;
+}
+
+void ResourceCache::unloadDocument(const std::string& docPath)
+{
+	release(RESOURCE_DOCUMENT, docPath);
+}
@@ -0,0 +1,92 @@
+﻿#pragma once
+
+#include "MigDefines.h"
+#include "Image.h"
+#include "SoundEffect.h"
+#include "tinyxml/tinyxml2.h"
+
+namespace MigTech
+{
+	enum RESOURCE_TYPE
+	{
+		RESOURCE_IMAGE,
+		RESOURCE_SOUND,
+		RESOURCE_DOCUMENT,
+		RESOURCE_TYPE_COUNT
+	};
+
+	struct ResourceKey
+	{
+		RESOURCE_TYPE type;
+		std::string name;
+
+		ResourceKey(RESOURCE_TYPE t, const std::string& n) : type(t), name(n) { }
+	};
+	typedef std::vector<ResourceKey> ResourceList;
+
+	// reference counts for resources shared between screens (main thread only)
+	//  a resource is freed when its last owner releases it, unless the current screen keeps it warm
+	//  with a texture budget, idle images stay resident until the budget forces them out (least recently used first)
+	class ResourceCache
+	{
+	private:
+		struct Entry
+		{
+			int refs;
+			void* res;
+			uint64 lastUsed;
+		};
+
+		static std::map<std::string, Entry> entries[RESOURCE_TYPE_COUNT];
+		static std::map<std::string, bool> keepWarmList[RESOURCE_TYPE_COUNT];
+
+		// texture budget in bytes (0 for none), the use clock orders the entries for eviction
+		static uint64 imageBudget;
+		static uint64 useClock;
+		static bool overBudget;
+
+	private:
+		static void freeResource(RESOURCE_TYPE type, const std::string& name, void* res);
+		static bool isIdleCacheable(RESOURCE_TYPE type, const Entry& entry);
+		static void enforceBudget();
+
+	public:
+		// adds a reference, returns false if the resource isn't cached
+		static bool addRef(RESOURCE_TYPE type, const std::string& name);
+
+		// caches a newly loaded resource with one reference
+		static void add(RESOURCE_TYPE type, const std::string& name, void* res);
+
+		// drops a reference, returns false if the resource wasn't cached
+		static bool release(RESOURCE_TYPE type, const std::string& name);
+
+		static void* find(RESOURCE_TYPE type, const std::string& name);
+		static int getRefCount(RESOURCE_TYPE type, const std::string& name);
+
+		// set by the game for the current screen, trim() frees idle resources that aren't in the list
+		static void setKeepWarm(const ResourceList& list);
+		static bool isKeptWarm(RESOURCE_TYPE type, const std::string& name);
+		static void trim();
+
+		// texture memory budget, images that are still referenced are never evicted so the budget can be exceeded
+		static void setImageBudget(uint64 bytes);
+		static uint64 getImageBudget();
+
+		// texture memory (including render targets) of the cached images
+		static uint64 getResidentImageBytes();
+		static int getResidentImageCount();
+		static unsigned int getImageBytes(const std::string& name);
+
+		// frees everything idle, anything still referenced is freed when its owner releases it
+		static void term();
+
+		// forgets every resource of this type w/o freeing them, used when the owning system goes away
+		static void clear(RESOURCE_TYPE type);
+
+		// sound effects (sound channel) and parsed documents, images go through RenderBase
+		static SoundEffect* loadSound(const std::string& name);
+		static void unloadSound(const std::string& name);
+		static tinyxml2::XMLDocument* loadDocument(const std::string& docPath);
+		static void unloadDocument(const std::string& docPath);
+	};
+}
@@ -12,6 +12,7 @@ ScreenBase::ScreenBase(const std::string& name)
 	_overlayHandler(nullptr),
 	_fadeOverlay(nullptr),
 	_fadeDuration(MigTech::defFadeDuration),
+	_exiting(false),
 	_overlay(nullptr),
 	_expiredOverlay(nullptr),
 	_musicFade(false),
@@ -39,6 +40,29 @@ ScreenBase* ScreenBase::getNextScreen()
 	return nullptr;
 }
 
+// override to describe the screen getNextScreen() will most likely return, asked for once the exit fade starts
+bool ScreenBase::getLikelyNextScreen(ScreenPrefetch& prefetch)
+{
+	return false;
+}
+
+// resources kept loaded for the screens that follow, see ResourceCache
+const ResourceList& ScreenBase::getKeepWarmList() const
+{
+	return _keepWarm;
+}
+
+// call from create(), the list takes effect once this screen is current
+void ScreenBase::keepWarm(RESOURCE_TYPE type, const std::string& name)
+{
+	_keepWarm.push_back(ResourceKey(type, name));
+}
+
+void ScreenBase::keepWarm(const ResourceList& list)
+{
+	_keepWarm.insert(_keepWarm.end(), list.begin(), list.end());
+}
+
 // returns screen name for debugging
 const std::string& ScreenBase::getScreenName()
 {
@@ -55,7 +79,7 @@ void ScreenBase::create()
 
 	// open screen configuration doc
 	std::string xmlFile = _screenName + ".xml";
-	tinyxml2::XMLDocument* pdoc = XMLDocFactory::loadDocument(xmlFile);
+	tinyxml2::XMLDocument* pdoc = ResourceCache::loadDocument(xmlFile);
 	if (pdoc != nullptr)
 	{
 		XMLElement* elem = pdoc->FirstChildElement("Screen");
@@ -97,6 +121,7 @@ void ScreenBase::create()
 			if (controls != nullptr)
 				_controls.loadFromXML(controls, _localFont);
 		}
+		ResourceCache::unloadDocument(xmlFile);
 	}
 
 	// lifecycle events
@@ -509,6 +534,7 @@ void ScreenBase::startFadeIn(long duration)
 
 	startFadeScreen(duration, 1, 0, _musicFade);
 	_musicFade = false;
+	_exiting = false;
 }
 
 // starts fading out the screen
@@ -519,6 +545,7 @@ void ScreenBase::startFadeOut(long duration)
 		duration = _fadeDuration;
 
 	startFadeScreen(duration, 0, 1, _musicStopOnExit);
+	_exiting = true;
 }
 
 // starts a fade animation
@@ -8,6 +8,7 @@
 #include "OverlayBase.h"
 #include "Controls.h"
 #include "RenderBase.h"
+#include "ResourceCache.h"
 
 namespace MigTech
 {
@@ -17,6 +18,23 @@ namespace MigTech
 		FADE_STYLE_OUT
 	};
 
+	// assets the next screen is expected to load, fetched in the background while the current one fades out
+	struct ScreenPrefetch
+	{
+		// the screen's xml document is named after it
+		std::string screenName;
+
+		// images are loaded by name with the same flags the next screen will use
+		std::vector<std::string> imageNames;
+		std::vector<unsigned int> imageFlags;
+
+		void addImage(const std::string& name, unsigned int loadFlags)
+		{
+			imageNames.push_back(name);
+			imageFlags.push_back(loadFlags);
+		}
+	};
+
 	class ScreenBase : public IAnimTarget, public IOverlayCallback, public IControlsCallback
 	{
 	public:
@@ -26,6 +44,9 @@ namespace MigTech
 		// screen management
 		virtual ScreenBase* getNextScreen();
 		virtual const std::string& getScreenName();
+		virtual bool getLikelyNextScreen(ScreenPrefetch& prefetch);
+		bool isExiting() const { return _exiting; }
+		const ResourceList& getKeepWarmList() const;
 
 		// life cycle events
 		virtual void create();
@@ -94,6 +115,10 @@ namespace MigTech
 		virtual void fadeComplete(float fadeAlpha, FADE_STYLE fadeStyle);
 
 	protected:
+		// resources that stay loaded with no owners while this screen is current
+		void keepWarm(RESOURCE_TYPE type, const std::string& name);
+		void keepWarm(const ResourceList& list);
+
 		// starts background music for this screen
 		void startMusic(const std::string& musicResourceID, bool loop = true);
 
@@ -125,6 +150,7 @@ namespace MigTech
 		AnimID _idFadeAnim;
 		long _fadeDuration;
 		FADE_STYLE _fadeStyle;
+		bool _exiting;
 
 		// overlay
 		OverlayBase* _overlay;
@@ -151,5 +177,8 @@ namespace MigTech
 
 		// render pass list
 		std::vector<RenderPass*> _renderPasses;
+
+		// keep warm list
+		ResourceList _keepWarm;
 	};
 }
\ No newline at end of file
@@ -10,12 +10,16 @@ namespace MigTech
 	static const std::string MIGTECH_VSHADER_POS_TRANSFORM = "mtvs_PosTransform";
 	static const std::string MIGTECH_VSHADER_POS_TEX_NO_TRANSFORM = "mtvs_PosTexNoTransform";
 	static const std::string MIGTECH_VSHADER_POS_TEX_TRANSFORM = "mtvs_PosTexTransform";
+	static const std::string MIGTECH_VSHADER_POS_TRANSFORM_INST = "mtvs_PosTransformInst";
+	static const std::string MIGTECH_VSHADER_SPRITE = "mtvs_Sprite";
 
 	// built in pixel shaders
 	static const std::string MIGTECH_PSHADER_PREFIX = "mtps_";
 	static const std::string MIGTECH_PSHADER_COLOR = "mtps_Color";
 	static const std::string MIGTECH_PSHADER_TEX = "mtps_Tex";
 	static const std::string MIGTECH_PSHADER_TEX_ALPHA = "mtps_TexAlpha";
+	static const std::string MIGTECH_PSHADER_COLOR_INST = "mtps_ColorInst";
+	static const std::string MIGTECH_PSHADER_TEX_INST = "mtps_TexInst";
 
 	class Shader
 	{
@@ -0,0 +1,105 @@
+﻿#include "pch.h"
+#include "SpriteBatch.h"
+#include "MigUtil.h"
+
+using namespace MigTech;
+
+SpriteBatch::SpriteBatch() : _obj(nullptr), _quadCount(0), _blend(BLEND_STATE_NONE), _depth(DEPTH_TEST_STATE_NONE), _depthWrite(false)
+{
+}
+
+SpriteBatch::~SpriteBatch()
+{
+}
+
+void SpriteBatch::createGraphics()
+{
+	MigUtil::theRend->loadVertexShader(MIGTECH_VSHADER_SPRITE, VDTYPE_POSITION_COLOR_TEXTURE, SHADER_HINT_MVP);
+
+	_verts.resize(4 * MAX_SPRITES);
+	_quadCount = 0;
+
+	_obj = MigUtil::theRend->createObject();
+	_obj->addShaderSet(MIGTECH_VSHADER_SPRITE, MIGTECH_PSHADER_TEX_INST);
+	_obj->setBufferUsage(BUFFER_USAGE_DYNAMIC);
+
+	// the vertex buffer is reloaded at every flush, but the indices never change
+	std::vector<unsigned short> indices(6 * MAX_SPRITES);
+	for (int i = 0; i < MAX_SPRITES; i++)
+	{
+		unsigned short base = (unsigned short) (4 * i);
+		indices[6*i + 0] = base;
+		indices[6*i + 1] = base + 2;
+		indices[6*i + 2] = base + 1;
+		indices[6*i + 3] = base + 1;
+		indices[6*i + 4] = base + 2;
+		indices[6*i + 5] = base + 3;
+	}
+	_obj->loadVertexBuffer(&_verts[0], _verts.size(), VDTYPE_POSITION_COLOR_TEXTURE);
+	_obj->loadIndexBuffer(&indices[0], indices.size(), PRIMITIVE_TYPE_TRIANGLE_LIST);
+
+	// same as a movie clip, the quads are already in world space so the winding still holds
+	_obj->setCulling(FACE_CULLING_BACK);
+}
+
+void SpriteBatch::destroyGraphics()
+{
+	_quadCount = 0;
+	_texture.clear();
+	if (_obj != nullptr)
+		MigUtil::theRend->deleteObject(_obj);
+	_obj = nullptr;
+}
+
+void SpriteBatch::addQuad(const std::string& texture, const Matrix& model, float width, float height, const UVSet& uv,
+	const Color& color, BLEND_STATE blend, DEPTH_TEST_STATE depth, bool depthWrite)
+{
+	if (_obj == nullptr)
+		throw std::invalid_argument("(SpriteBatch::addQuad) Graphics not created");
+
+	if (_quadCount > 0 && (_quadCount == MAX_SPRITES || texture != _texture || blend != _blend || depth != _depth || depthWrite != _depthWrite))
+		flush();
+	if (_quadCount == 0)
+	{
+		_texture = texture;
+		_blend = blend;
+		_depth = depth;
+		_depthWrite = depthWrite;
+	}
+
+	// same corner order and UV mapping as the movie clip geometry
+	Vector3 corners[4] =
+	{
+		Vector3(-width / 2, -height / 2, 0),
+		Vector3(-width / 2,  height / 2, 0),
+		Vector3( width / 2, -height / 2, 0),
+		Vector3( width / 2,  height / 2, 0),
+	};
+	model.transform(corners, corners, 4);
+
+	VertexPositionColorTexture* verts = &_verts[4 * _quadCount];
+	verts[0] = VertexPositionColorTexture(corners[0], color, Vector2(uv.u1, uv.v2));
+	verts[1] = VertexPositionColorTexture(corners[1], color, Vector2(uv.u1, uv.v1));
+	verts[2] = VertexPositionColorTexture(corners[2], color, Vector2(uv.u2, uv.v2));
+	verts[3] = VertexPositionColorTexture(corners[3], color, Vector2(uv.u2, uv.v1));
+	_quadCount++;
+}
+
+void SpriteBatch::flush()
+{
+	if (_quadCount == 0 || _obj == nullptr)
+		return;
+
+	// cleared before the draw, the renderer flushes the batch ahead of every other draw (this one included)
+	int quadCount = _quadCount;
+	_quadCount = 0;
+
+	_obj->loadVertexBuffer(&_verts[0], 4 * quadCount, VDTYPE_POSITION_COLOR_TEXTURE);
+	_obj->setIndexOffset(0, 6 * quadCount);
+	_obj->setImage(0, _texture, TXT_FILTER_LINEAR, TXT_FILTER_LINEAR, TXT_WRAP_CLAMP);
+
+	MigUtil::theRend->setModelMatrix(nullptr);
+	MigUtil::theRend->setBlending(_blend);
+	MigUtil::theRend->setDepthTesting(_depth, _depthWrite);
+	_obj->render();
+}
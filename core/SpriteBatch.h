@@ -0,0 +1,45 @@
+﻿#pragma once
+
+#include "MigDefines.h"
+#include "Object.h"
+#include "Matrix.h"
+
+namespace MigTech
+{
+	// collects textured quads into one dynamic vertex buffer and draws them with a single call, quads are
+	//  transformed on the CPU so each one can carry its own matrix, UVs and color (frame blending is just alpha)
+	//  the batch is flushed when the texture or blend/depth state changes, when it's full, and by the renderer
+	//  before anything else is drawn or the matrices change (see RenderBase::flushSprites())
+	class SpriteBatch
+	{
+	public:
+		// quads per draw, the indices are 16 bits
+		static const int MAX_SPRITES = 256;
+
+	public:
+		SpriteBatch();
+		~SpriteBatch();
+
+		void createGraphics();
+		void destroyGraphics();
+
+		// the quad is width x height centered on the origin of the model matrix, the texture is sampled linear/clamped
+		void addQuad(const std::string& texture, const Matrix& model, float width, float height, const UVSet& uv,
+			const Color& color, BLEND_STATE blend, DEPTH_TEST_STATE depth, bool depthWrite);
+		void flush();
+
+		bool isReady() const { return (_obj != nullptr); }
+		bool isPending() const { return (_quadCount > 0); }
+
+	protected:
+		Object* _obj;
+		std::vector<VertexPositionColorTexture> _verts;
+		int _quadCount;
+
+		// state shared by the pending quads
+		std::string _texture;
+		BLEND_STATE _blend;
+		DEPTH_TEST_STATE _depth;
+		bool _depthWrite;
+	};
+}
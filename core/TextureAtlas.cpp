@@ -0,0 +1,71 @@
+﻿#include "pch.h"
+#include "TextureAtlas.h"
+#include "MigUtil.h"
+#include "PersistBase.h"
+
+using namespace MigTech;
+using namespace tinyxml2;
+
+bool TextureAtlas::load(const std::string& indexPath)
+{
+	clear();
+
+	XMLDocument* pdoc = XMLDocFactory::parseDocument(indexPath);
+	if (pdoc == nullptr)
+		return false;
+
+	XMLElement* root = pdoc->FirstChildElement("AtlasIndex");
+	if (root == nullptr)
+	{
+		LOGWARN("(TextureAtlas::load) %s isn't an atlas index", indexPath.c_str());
+		delete pdoc;
+		return false;
+	}
+
+	for (XMLElement* page = root->FirstChildElement("Page"); page != nullptr; page = page->NextSiblingElement("Page"))
+	{
+		const char* file = page->Attribute("File");
+		float width = page->FloatAttribute("Width");
+		float height = page->FloatAttribute("Height");
+		if (file == nullptr || width <= 0 || height <= 0)
+		{
+			LOGWARN("(TextureAtlas::load) Skipping an invalid page in %s", indexPath.c_str());
+			continue;
+		}
+
+		for (XMLElement* image = page->FirstChildElement("Image"); image != nullptr; image = image->NextSiblingElement("Image"))
+		{
+			const char* name = image->Attribute("Name");
+			if (name == nullptr)
+				continue;
+
+			// the rects are in pixels, v runs down the page like the image rows
+			AtlasEntry& entry = _entries[name];
+			entry.page = file;
+			entry.uv.u1 = image->FloatAttribute("X") / width;
+			entry.uv.v1 = image->FloatAttribute("Y") / height;
+			entry.uv.u2 = entry.uv.u1 + image->FloatAttribute("W") / width;
+			entry.uv.v2 = entry.uv.v1 + image->FloatAttribute("H") / height;
+		}
+		_pageCount++;
+	}
+	delete pdoc;
+
+	LOGINFO("(TextureAtlas::load) %d images in %d atlas pages", (int)_entries.size(), _pageCount);
+	return true;
+}
+
+void TextureAtlas::clear()
+{
+	_entries.clear();
+	_pageCount = 0;
+}
+
+const AtlasEntry* TextureAtlas::find(const std::string& name) const
+{
+	if (_entries.empty())
+		return nullptr;
+
+	std::map<std::string, AtlasEntry>::const_iterator iter = _entries.find(name);
+	return (iter != _entries.end() ? &iter->second : nullptr);
+}
@@ -0,0 +1,35 @@
+﻿#pragma once
+
+#include "MigDefines.h"
+
+namespace MigTech
+{
+	// where an atlased image lives
+	struct AtlasEntry
+	{
+		std::string page;	// image name (and path) of the page
+		UVSet uv;			// the image's rect on the page
+	};
+
+	// the index written by tools/atlascooker, images named in it are loaded as a sub-rect of a shared page
+	//  (main thread only, the loader threads only ever see the page paths)
+	class TextureAtlas
+	{
+	public:
+		TextureAtlas() : _pageCount(0) { }
+
+		// replaces any index already loaded, returns false if the index couldn't be read
+		bool load(const std::string& indexPath);
+		void clear();
+
+		// returns null if the image isn't atlased
+		const AtlasEntry* find(const std::string& name) const;
+
+		int getPageCount() const { return _pageCount; }
+		bool isEmpty() const { return _entries.empty(); }
+
+	protected:
+		std::map<std::string, AtlasEntry> _entries;
+		int _pageCount;
+	};
+}
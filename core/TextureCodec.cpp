@@ -0,0 +1,350 @@
+﻿#include "pch.h"
+#include "TextureCodec.h"
+#include "MipChain.h"
+
+using namespace MigTech;
+
+// ETC1/ETC2 modifier tables (small, large) and the T/H mode distances
+static const int etcModifiers[8][2] = { { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 } };
+static const int etcDistances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+// EAC alpha modifier tables
+static const int eacModifiers[16][8] =
+{
+	{ -3, -6, -9, -15, 2, 5, 8, 14 },
+	{ -3, -7, -10, -13, 2, 6, 9, 12 },
+	{ -2, -5, -8, -13, 1, 4, 7, 12 },
+	{ -2, -4, -6, -13, 1, 3, 5, 12 },
+	{ -3, -6, -8, -12, 2, 5, 7, 11 },
+	{ -3, -7, -9, -11, 2, 6, 8, 10 },
+	{ -4, -7, -8, -11, 3, 6, 7, 10 },
+	{ -3, -5, -8, -11, 2, 4, 7, 10 },
+	{ -2, -6, -8, -10, 1, 5, 7, 9 },
+	{ -2, -5, -8, -10, 1, 4, 7, 9 },
+	{ -2, -4, -8, -10, 1, 3, 7, 9 },
+	{ -2, -5, -7, -10, 1, 4, 6, 9 },
+	{ -3, -4, -7, -10, 2, 3, 6, 9 },
+	{ -1, -2, -3, -10, 0, 1, 2, 9 },
+	{ -4, -6, -8, -9, 3, 5, 7, 8 },
+	{ -3, -5, -7, -9, 2, 4, 6, 8 }
+};
+
+static inline byte clampByte(int v)
+{
+	return (byte) (v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static inline int extend4(int v) { return (v << 4) | v; }
+static inline int extend5(int v) { return (v << 3) | (v >> 2); }
+static inline int extend6(int v) { return (v << 2) | (v >> 4); }
+static inline int extend7(int v) { return (v << 1) | (v >> 6); }
+static inline int signExtend3(int v) { return ((v & 4) ? v - 8 : v); }
+
+static inline void putTexel(byte* rgba, int stride, int x, int y, int r, int g, int b)
+{
+	byte* p = rgba + 4*(y*stride + x);
+	p[0] = clampByte(r);
+	p[1] = clampByte(g);
+	p[2] = clampByte(b);
+	p[3] = 255;
+}
+
+// ETC selectors are stored column by column, the high bits in the first half
+static inline int etcSelector(unsigned int bits, int x, int y)
+{
+	int p = x*4 + y;
+	return (((bits >> (16 + p)) & 1) << 1) | ((bits >> p) & 1);
+}
+
+// individual and differential modes, two sub-blocks each with a base color and modifier table
+static void decodeETCSubBlocks(const byte* block, unsigned int bits, const int base1[3], const int base2[3], byte* rgba, int stride)
+{
+	bool flip = ((block[3] & 1) != 0);
+	int table1 = block[3] >> 5;
+	int table2 = (block[3] >> 2) & 7;
+	for (int y = 0; y < 4; y++)
+	{
+		for (int x = 0; x < 4; x++)
+		{
+			bool second = (flip ? y >= 2 : x >= 2);
+			const int* base = (second ? base2 : base1);
+			int sel = etcSelector(bits, x, y);
+			int mod = etcModifiers[second ? table2 : table1][sel & 1];
+			if (sel & 2)
+				mod = -mod;
+			putTexel(rgba, stride, x, y, base[0] + mod, base[1] + mod, base[2] + mod);
+		}
+	}
+}
+
+// T and H modes, each texel picks one of four paint colors
+static void decodeETCPaint(unsigned int bits, const int paint[4][3], byte* rgba, int stride)
+{
+	for (int y = 0; y < 4; y++)
+	{
+		for (int x = 0; x < 4; x++)
+		{
+			const int* c = paint[etcSelector(bits, x, y)];
+			putTexel(rgba, stride, x, y, c[0], c[1], c[2]);
+		}
+	}
+}
+
+static void decodeETCPlanar(const byte* block, byte* rgba, int stride)
+{
+	int ro = extend6((block[0] >> 1) & 0x3f);
+	int go = extend7(((block[0] & 1) << 6) | ((block[1] >> 1) & 0x3f));
+	int bo = extend6(((block[1] & 1) << 5) | (block[2] & 0x18) | ((block[2] << 1) & 0x6) | (block[3] >> 7));
+	int rh = extend6(((block[3] >> 1) & 0x3e) | (block[3] & 1));
+	int gh = extend7(block[4] >> 1);
+	int bh = extend6(((block[4] & 1) << 5) | (block[5] >> 3));
+	int rv = extend6(((block[5] & 7) << 3) | (block[6] >> 5));
+	int gv = extend7(((block[6] & 0x1f) << 2) | (block[7] >> 6));
+	int bv = extend6(block[7] & 0x3f);
+	for (int y = 0; y < 4; y++)
+	{
+		for (int x = 0; x < 4; x++)
+		{
+			putTexel(rgba, stride, x, y,
+				(x*(rh - ro) + y*(rv - ro) + 4*ro + 2) >> 2,
+				(x*(gh - go) + y*(gv - go) + 4*go + 2) >> 2,
+				(x*(bh - bo) + y*(bv - bo) + 4*bo + 2) >> 2);
+		}
+	}
+}
+
+// ETC1 blocks are valid ETC2 blocks, the extra modes hide in differential blocks that overflow
+void TextureCodec::decodeETC2Block(const byte* block, byte* rgba, int stride)
+{
+	unsigned int bits = (block[4] << 24) | (block[5] << 16) | (block[6] << 8) | block[7];
+	if ((block[3] & 2) == 0)
+	{
+		int base1[3] = { extend4(block[0] >> 4), extend4(block[1] >> 4), extend4(block[2] >> 4) };
+		int base2[3] = { extend4(block[0] & 15), extend4(block[1] & 15), extend4(block[2] & 15) };
+		decodeETCSubBlocks(block, bits, base1, base2, rgba, stride);
+		return;
+	}
+
+	int r = block[0] >> 3, g = block[1] >> 3, b = block[2] >> 3;
+	int r2 = r + signExtend3(block[0] & 7);
+	int g2 = g + signExtend3(block[1] & 7);
+	int b2 = b + signExtend3(block[2] & 7);
+	if (r2 < 0 || r2 > 31)
+	{
+		// T mode
+		int c1[3] = { extend4(((block[0] >> 1) & 0xc) | (block[0] & 3)), extend4(block[1] >> 4), extend4(block[1] & 15) };
+		int c2[3] = { extend4(block[2] >> 4), extend4(block[2] & 15), extend4(block[3] >> 4) };
+		int d = etcDistances[((block[3] >> 1) & 6) | (block[3] & 1)];
+		int paint[4][3] =
+		{
+			{ c1[0], c1[1], c1[2] },
+			{ c2[0] + d, c2[1] + d, c2[2] + d },
+			{ c2[0], c2[1], c2[2] },
+			{ c2[0] - d, c2[1] - d, c2[2] - d }
+		};
+		decodeETCPaint(bits, paint, rgba, stride);
+	}
+	else if (g2 < 0 || g2 > 31)
+	{
+		// H mode, the last bit of the distance comes from the order of the colors
+		int r1 = (block[0] >> 3) & 15;
+		int g1 = ((block[0] << 1) & 0xe) | ((block[1] >> 4) & 1);
+		int b1 = (block[1] & 8) | ((block[1] << 1) & 6) | (block[2] >> 7);
+		int rr2 = (block[2] >> 3) & 15;
+		int gg2 = ((block[2] << 1) & 0xe) | (block[3] >> 7);
+		int bb2 = (block[3] >> 3) & 15;
+		int order = (((r1 << 8) | (g1 << 4) | b1) >= ((rr2 << 8) | (gg2 << 4) | bb2) ? 1 : 0);
+		int d = etcDistances[(block[3] & 4) | ((block[3] << 1) & 2) | order];
+		int c1[3] = { extend4(r1), extend4(g1), extend4(b1) };
+		int c2[3] = { extend4(rr2), extend4(gg2), extend4(bb2) };
+		int paint[4][3] =
+		{
+			{ c1[0] + d, c1[1] + d, c1[2] + d },
+			{ c1[0] - d, c1[1] - d, c1[2] - d },
+			{ c2[0] + d, c2[1] + d, c2[2] + d },
+			{ c2[0] - d, c2[1] - d, c2[2] - d }
+		};
+		decodeETCPaint(bits, paint, rgba, stride);
+	}
+	else if (b2 < 0 || b2 > 31)
+		decodeETCPlanar(block, rgba, stride);
+	else
+	{
+		int base1[3] = { extend5(r), extend5(g), extend5(b) };
+		int base2[3] = { extend5(r2), extend5(g2), extend5(b2) };
+		decodeETCSubBlocks(block, bits, base1, base2, rgba, stride);
+	}
+}
+
+void TextureCodec::decodeEACAlphaBlock(const byte* block, byte* rgba, int stride)
+{
+	int base = block[0];
+	int mult = block[1] >> 4;
+	const int* mods = eacModifiers[block[1] & 15];
+
+	uint64 bits = 0;
+	for (int i = 2; i < 8; i++)
+		bits = (bits << 8) | block[i];
+
+	// 3 bit selectors, column by column from the top bits down
+	for (int p = 0; p < 16; p++)
+	{
+		int sel = (int) ((bits >> (45 - 3*p)) & 7);
+		rgba[4*((p & 3)*stride + (p >> 2)) + 3] = clampByte(base + mods[sel]*mult);
+	}
+}
+
+void TextureCodec::decodeBC1Block(const byte* block, byte* rgba, int stride, bool allowAlpha)
+{
+	unsigned int c0 = block[0] | (block[1] << 8);
+	unsigned int c1 = block[2] | (block[3] << 8);
+	int colors[4][4];
+	colors[0][0] = extend5(c0 >> 11); colors[0][1] = extend6((c0 >> 5) & 63); colors[0][2] = extend5(c0 & 31); colors[0][3] = 255;
+	colors[1][0] = extend5(c1 >> 11); colors[1][1] = extend6((c1 >> 5) & 63); colors[1][2] = extend5(c1 & 31); colors[1][3] = 255;
+
+	// BC3 color blocks always use four colors
+	if (c0 > c1 || !allowAlpha)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			colors[2][i] = (2*colors[0][i] + colors[1][i]) / 3;
+			colors[3][i] = (colors[0][i] + 2*colors[1][i]) / 3;
+		}
+		colors[2][3] = colors[3][3] = 255;
+	}
+	else
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			colors[2][i] = (colors[0][i] + colors[1][i]) / 2;
+			colors[3][i] = 0;
+		}
+		colors[2][3] = 255;
+		colors[3][3] = 0;
+	}
+
+	unsigned int bits = block[4] | (block[5] << 8) | (block[6] << 16) | (block[7] << 24);
+	for (int p = 0; p < 16; p++)
+	{
+		const int* c = colors[(bits >> (2*p)) & 3];
+		byte* out = rgba + 4*((p >> 2)*stride + (p & 3));
+		out[0] = (byte) c[0];
+		out[1] = (byte) c[1];
+		out[2] = (byte) c[2];
+		out[3] = (byte) c[3];
+	}
+}
+
+void TextureCodec::decodeBC3AlphaBlock(const byte* block, byte* rgba, int stride)
+{
+	int alphas[8];
+	alphas[0] = block[0];
+	alphas[1] = block[1];
+	if (alphas[0] > alphas[1])
+	{
+		for (int i = 2; i < 8; i++)
+			alphas[i] = ((8 - i)*alphas[0] + (i - 1)*alphas[1]) / 7;
+	}
+	else
+	{
+		for (int i = 2; i < 6; i++)
+			alphas[i] = ((6 - i)*alphas[0] + (i - 1)*alphas[1]) / 5;
+		alphas[6] = 0;
+		alphas[7] = 255;
+	}
+
+	uint64 bits = 0;
+	for (int i = 7; i >= 2; i--)
+		bits = (bits << 8) | block[i];
+	for (int p = 0; p < 16; p++)
+		rgba[4*((p >> 2)*stride + (p & 3)) + 3] = (byte) alphas[(bits >> (3*p)) & 7];
+}
+
+// decodes one level, blocks at the right and bottom edges may hang over
+static void decodeLevel(TEX_COMPRESSION comp, const byte* block, int width, int height, int channels, byte* pixels)
+{
+	int blockBytes = TextureCodec::getBlockBytes(comp);
+	int blocksWide = (width + 3) / 4;
+	int blocksHigh = (height + 3) / 4;
+
+	byte texels[4*4*4];
+	for (int by = 0; by < blocksHigh; by++)
+	{
+		for (int bx = 0; bx < blocksWide; bx++, block += blockBytes)
+		{
+			switch (comp)
+			{
+			case TEX_COMPRESSION_ETC2_RGBA:
+				TextureCodec::decodeETC2Block(block + 8, texels, 4);
+				TextureCodec::decodeEACAlphaBlock(block, texels, 4);
+				break;
+			case TEX_COMPRESSION_BC1:
+				TextureCodec::decodeBC1Block(block, texels, 4, true);
+				break;
+			case TEX_COMPRESSION_BC3:
+				TextureCodec::decodeBC1Block(block + 8, texels, 4, false);
+				TextureCodec::decodeBC3AlphaBlock(block, texels, 4);
+				break;
+			default:
+				TextureCodec::decodeETC2Block(block, texels, 4);
+				break;
+			}
+
+			for (int y = 0; y < 4 && by*4 + y < height; y++)
+			{
+				byte* out = pixels + channels*((by*4 + y)*width + bx*4);
+				for (int x = 0; x < 4 && bx*4 + x < width; x++, out += channels)
+					memcpy(out, texels + 4*(y*4 + x), channels);
+			}
+		}
+	}
+}
+
+bool TextureCodec::decompress(const ImageData& src, ImageData& dst)
+{
+	if (src.pixels == nullptr || src.blockWidth != 4 || src.blockHeight != 4)
+		return false;
+	if (src.compression != TEX_COMPRESSION_ETC1 && src.compression != TEX_COMPRESSION_ETC2_RGB && src.compression != TEX_COMPRESSION_ETC2_RGBA &&
+		src.compression != TEX_COMPRESSION_BC1 && src.compression != TEX_COMPRESSION_BC3)
+		return false;
+
+	dst.format = src.format;
+	dst.width = src.width;
+	dst.height = src.height;
+	dst.compression = TEX_COMPRESSION_NONE;
+	dst.blockWidth = dst.blockHeight = 1;
+	dst.mipLevels = src.mipLevels;
+	dst.dataSize = MipChain::getChainSize(dst);
+	dst.pixels = new byte[dst.dataSize];
+
+	// every level is decoded, each one is packed right after the one before it
+	int channels = (src.format == IMG_FORMAT_RGB ? 3 : 4);
+	for (int level = 0; level < src.mipLevels; level++)
+	{
+		decodeLevel(src.compression, src.pixels + MipChain::getLevelOffset(src, level),
+			MipChain::getLevelDim(src.width, level), MipChain::getLevelDim(src.height, level), channels,
+			dst.pixels + MipChain::getLevelOffset(dst, level));
+	}
+	return true;
+}
+
+int TextureCodec::getBlockBytes(TEX_COMPRESSION comp)
+{
+	switch (comp)
+	{
+	case TEX_COMPRESSION_ETC1: return 8;
+	case TEX_COMPRESSION_ETC2_RGB: return 8;
+	case TEX_COMPRESSION_BC1: return 8;
+	case TEX_COMPRESSION_ETC2_RGBA: return 16;
+	case TEX_COMPRESSION_BC3: return 16;
+	case TEX_COMPRESSION_ASTC: return 16;
+	default: return 0;
+	}
+}
+
+unsigned int TextureCodec::getLevelSize(TEX_COMPRESSION comp, int blockWidth, int blockHeight, int width, int height)
+{
+	unsigned int blocksWide = (width + blockWidth - 1) / blockWidth;
+	unsigned int blocksHigh = (height + blockHeight - 1) / blockHeight;
+	return blocksWide * blocksHigh * getBlockBytes(comp);
+}
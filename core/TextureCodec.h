@@ -0,0 +1,25 @@
+﻿#pragma once
+
+#include "MigDefines.h"
+#include "Image.h"
+
+namespace MigTech
+{
+	// CPU decoders for GPU block compressed textures, used when the driver can't take the blocks as is
+	//  the block decoders write a 4x4 block of RGBA texels, stride is the output row length in texels
+	class TextureCodec
+	{
+	public:
+		// decodes every level to RGB (ETC1, ETC2 RGB) or RGBA pixels, false if there's no decoder for the format (ASTC)
+		static bool decompress(const ImageData& src, ImageData& dst);
+
+		// bytes in one block, and in a whole level
+		static int getBlockBytes(TEX_COMPRESSION comp);
+		static unsigned int getLevelSize(TEX_COMPRESSION comp, int blockWidth, int blockHeight, int width, int height);
+
+		static void decodeETC2Block(const byte* block, byte* rgba, int stride);
+		static void decodeEACAlphaBlock(const byte* block, byte* rgba, int stride);
+		static void decodeBC1Block(const byte* block, byte* rgba, int stride, bool allowAlpha);
+		static void decodeBC3AlphaBlock(const byte* block, byte* rgba, int stride);
+	};
+}
@@ -115,10 +115,21 @@ bool CreditsBg::doFrame(int id, float newVal, void* optData)
 	return true;
 }
 
-static void loadNewImage(Object* poly, const std::string& img)
+void CreditsBg::imageLoaded(const std::string& name, Image* img, bool success)
 {
-	if (MigUtil::theRend->loadImage(img, img, LOAD_IMAGE_NONE) != nullptr)
-		poly->setImage(0, img, TXT_FILTER_LINEAR, TXT_FILTER_LINEAR, TXT_WRAP_CLAMP);
+	// the previous image keeps showing until the new one is ready
+	if (!success)
+		return;
+	if (name == _bgResID && _screenPoly != nullptr)
+	{
+		_screenPoly->setImage(0, name, TXT_FILTER_LINEAR, TXT_FILTER_LINEAR, TXT_WRAP_CLAMP);
+		_bgImage = img;
+	}
+	else if (name == _bgRes2ID && _screenPoly2 != nullptr)
+	{
+		_screenPoly2->setImage(0, name, TXT_FILTER_LINEAR, TXT_FILTER_LINEAR, TXT_WRAP_CLAMP);
+		_bgImage2 = img;
+	}
 }
 
 void CreditsBg::animComplete(int id, void* optData)
@@ -150,7 +161,7 @@ void CreditsBg::animComplete(int id, void* optData)
 
 			// new background image
 			BgBase::init("credits_bg3.jpg");
-			loadNewImage(_screenPoly, _bgResID);
+			MigUtil::theRend->loadImageAsync(_bgResID, _bgResID, LOAD_IMAGE_FIT_OUTPUT, this);
 
 			_stage = STAGE_ACTION_FADE_IN2;
 		}
@@ -163,7 +174,7 @@ void CreditsBg::animComplete(int id, void* optData)
 
 			// new other background image
 			_bgRes2ID = "credits_bg4.jpg";
-			loadNewImage(_screenPoly2, _bgRes2ID);
+			MigUtil::theRend->loadImageAsync(_bgRes2ID, _bgRes2ID, LOAD_IMAGE_FIT_OUTPUT, this);
 
 			_stage = STAGE_ACTION_MAIN;
 			_colOther = Color(1, 1, 1, 0);
@@ -250,8 +261,7 @@ void CreditsCube::animComplete(int id, void* optData)
 void CreditsCube::applyTransform(Matrix& worldMatrix) const
 {
 	// we need the transformation applied a little differently here
-	static Matrix locMatrix;
-	locMatrix.identity();
+	Matrix locMatrix;
 	if (_scale != 1)
 		locMatrix.scale(_scale, _scale, _scale);
 	if (_rotX != 0)
@@ -265,7 +275,7 @@ void CreditsCube::applyTransform(Matrix& worldMatrix) const
 	locMatrix.multiply(worldMatrix);
 	worldMatrix.copy(locMatrix);
 
-	MigUtil::theRend->setModelMatrix(worldMatrix);
+	MigUtil::theRend->setModelMatrix(&worldMatrix);
 }
 
 void CreditsCube::startIntroAnimation(int dur)
@@ -354,6 +364,12 @@ ScreenBase* CreditsScreen::getNextScreen()
 	return new SplashScreen();
 }
 
+bool CreditsScreen::getLikelyNextScreen(ScreenPrefetch& prefetch)
+{
+	SplashScreen::describeAssets(prefetch);
+	return true;
+}
+
 void CreditsScreen::create()
 {
 	// init background
@@ -398,8 +414,8 @@ bool CreditsScreen::render()
 	drawBackgroundScreen();
 
 	// cube
-	MigUtil::theRend->setProjectionMatrix(_projMatrix);
-	MigUtil::theRend->setViewMatrix(_viewMatrix);
+	MigUtil::theRend->setProjectionMatrix(&_projMatrix);
+	MigUtil::theRend->setViewMatrix(&_viewMatrix);
 	_cube.draw();
 
 	// movie clip
@@ -16,7 +16,7 @@ namespace Cuboingo
 		virtual void cubeExitComplete() = 0;
 	};
 
-	class CreditsBg : public CycleBg
+	class CreditsBg : public CycleBg, public IImageLoadCallback
 	{
 	public:
 		static const int STAGE_ACTION_FLASH		= 0;
@@ -40,6 +40,9 @@ namespace Cuboingo
 		virtual bool doFrame(int id, float newVal, void* optData);
 		virtual void animComplete(int id, void* optData);
 
+		// IImageLoadCallback
+		virtual void imageLoaded(const std::string& name, Image* img, bool success);
+
 		virtual void render()const;
 
 	protected:
@@ -88,6 +91,7 @@ namespace Cuboingo
 		CreditsScreen();
 
 		virtual ScreenBase* getNextScreen();
+		virtual bool getLikelyNextScreen(ScreenPrefetch& prefetch);
 
 		virtual void create();
 		virtual void createGraphics();
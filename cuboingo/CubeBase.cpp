@@ -153,9 +153,9 @@ void CubeBase::createGraphics()
 	MigUtil::theRend->loadVertexShader(_vertexShader, VDTYPE_POSITION_NORMAL_TEXTURE, SHADER_HINT_MVP | SHADER_HINT_MODEL | SHADER_HINT_LIGHTS);
 	MigUtil::theRend->loadPixelShader(_pixelShader, SHADER_HINT_NONE);
 
-	// load the silver map
-	MigUtil::theRend->loadImage(_textureName, _textureName, LOAD_IMAGE_NONE);
-	MigUtil::theRend->loadImage(_reflectName, _reflectName, LOAD_IMAGE_NONE);
+	// load the silver and reflection maps, both are minified on the far faces of the cube
+	MigUtil::theRend->loadImage(_textureName, _textureName, LOAD_IMAGE_MIPMAPS);
+	MigUtil::theRend->loadImage(_reflectName, _reflectName, LOAD_IMAGE_MIPMAPS);
 
 	// create the cube object and assign the shaders
 	Object* cubeObj = MigUtil::theRend->createObject();
@@ -174,8 +174,8 @@ void CubeBase::createGraphics()
 	cubeObj->loadIndexBuffer(txtIndices, indArraySize, MigTech::PRIMITIVE_TYPE_TRIANGLE_LIST);
 
 	// assign texturing
-	cubeObj->setImage(0, _textureName, TXT_FILTER_LINEAR, TXT_FILTER_LINEAR, TXT_WRAP_CLAMP);
-	cubeObj->setImage(1, _reflectName, TXT_FILTER_LINEAR, TXT_FILTER_LINEAR, TXT_WRAP_REPEAT);
+	cubeObj->setImage(0, _textureName, TXT_FILTER_LINEAR_MIPMAP_NEAREST, TXT_FILTER_LINEAR, TXT_WRAP_CLAMP);
+	cubeObj->setImage(1, _reflectName, TXT_FILTER_LINEAR_MIPMAP_NEAREST, TXT_FILTER_LINEAR, TXT_WRAP_REPEAT);
 
 	// culling
 	cubeObj->setCulling(FACE_CULLING_BACK);
@@ -187,8 +187,8 @@ void CubeBase::destroyGraphics()
 	if (_cubeObj != nullptr)
 		MigUtil::theRend->deleteObject(_cubeObj);
 	_cubeObj = nullptr;
-	//MigUtil::theRend->unloadImage(_textureName);
-	//MigUtil::theRend->unloadImage(_reflectName);
+	MigUtil::theRend->unloadImage(_textureName);
+	MigUtil::theRend->unloadImage(_reflectName);
 }
 
 void CubeBase::draw(Matrix& mat, const Color& col) const
@@ -221,8 +221,7 @@ void CubeBase::draw(Matrix& mat) const
 
 void CubeBase::draw() const
 {
-	static Matrix locMatrix;
-	locMatrix.identity();
+	Matrix locMatrix;
 	draw(locMatrix);
 }
 
@@ -270,8 +269,7 @@ void CubeBase::animComplete(int id, void* optData)
 
 void CubeBase::applyTransform(Matrix& worldMatrix) const
 {
-	static Matrix locMatrix;
-	locMatrix.identity();
+	Matrix locMatrix;
 	if (_translate.x != 0 || _translate.y != 0 || _translate.z != 0)
 		locMatrix.translate(_translate);
 	if (_rotX != 0)
@@ -283,7 +281,7 @@ void CubeBase::applyTransform(Matrix& worldMatrix) const
 	if (_scale != 1)
 		locMatrix.scale(_scale, _scale, _scale);
 	locMatrix.multiply(worldMatrix);
-	MigUtil::theRend->setModelMatrix(locMatrix);
+	MigUtil::theRend->setModelMatrix(&locMatrix);
 
 	// after this call the worldMatrix will have the cube transformation applied
 	worldMatrix.copy(locMatrix);
@@ -102,3 +102,18 @@ const char* CubeUtil::axisToString(AxisOrient axis)
 		return "Y";
 	return "Z";
 }
+
+// the splash and game screens share these, keeping them warm saves reloading them on every round trip
+void CubeUtil::getSharedResources(ResourceList& list)
+{
+	list.push_back(ResourceKey(RESOURCE_IMAGE, "silvermap.jpg"));
+	list.push_back(ResourceKey(RESOURCE_IMAGE, "holemap.png"));
+	list.push_back(ResourceKey(RESOURCE_IMAGE, "reflect.jpg"));
+	list.push_back(ResourceKey(RESOURCE_IMAGE, "arrow.png"));
+	list.push_back(ResourceKey(RESOURCE_SOUND, "rotate.wav"));
+	list.push_back(ResourceKey(RESOURCE_SOUND, "match.wav"));
+	list.push_back(ResourceKey(RESOURCE_SOUND, "same.wav"));
+	list.push_back(ResourceKey(RESOURCE_SOUND, "error.wav"));
+	list.push_back(ResourceKey(RESOURCE_DOCUMENT, "SplashScreen.xml"));
+	list.push_back(ResourceKey(RESOURCE_DOCUMENT, "GameScreen.xml"));
+}
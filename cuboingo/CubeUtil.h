@@ -36,5 +36,7 @@ namespace Cuboingo
 		static std::string getUpperSubString(const std::string& str, int len);
 
 		static const char* axisToString(AxisOrient axis);
+
+		static void getSharedResources(ResourceList& list);
 	};
 }
\ No newline at end of file
@@ -110,6 +110,14 @@ void DemoGameplay::windowSizeChanged()
 	CubeUtil::loadDefaultViewMatrix(_viewMatrix, MigUtil::convertToRadians(-45));
 }
 
+void DemoGameplay::destroy()
+{
+	DemoScreen::destroy();
+
+	// drop the reference taken by the preload in create()
+	MigUtil::theRend->unloadImage("cursor.png");
+}
+
 bool DemoGameplay::doFrame(int id, float newVal, void* optData)
 {
 	if (_idTextAnim == id)
@@ -189,8 +197,8 @@ bool DemoGameplay::render()
 	drawBackgroundScreen();
 
 	// set up the projection matrix
-	MigUtil::theRend->setProjectionMatrix(_projMatrix);
-	MigUtil::theRend->setViewMatrix(_viewMatrix);
+	MigUtil::theRend->setProjectionMatrix(&_projMatrix);
+	MigUtil::theRend->setViewMatrix(&_viewMatrix);
 
 	// game cube
 	_gameCube.draw();
@@ -31,6 +31,7 @@ namespace Cuboingo
 		virtual void create();
 		virtual void createGraphics();
 		virtual void windowSizeChanged();
+		virtual void destroy();
 
 		// IAnimTarget
 		virtual bool doFrame(int id, float newVal, void* optData);
@@ -20,6 +20,20 @@ ScreenBase* LoseScreen::getNextScreen()
 	return new SplashScreen();
 }
 
+bool LoseScreen::getLikelyNextScreen(ScreenPrefetch& prefetch)
+{
+	SplashScreen::describeAssets(prefetch);
+	return true;
+}
+
+// same flags the cycling background uses
+void LoseScreen::describeAssets(ScreenPrefetch& prefetch)
+{
+	prefetch.screenName = "LoseScreen";
+	prefetch.addImage("gameover1.jpg", LOAD_IMAGE_FIT_OUTPUT);
+	prefetch.addImage("gameover2.jpg", LOAD_IMAGE_SET_ALPHA | LOAD_IMAGE_FIT_OUTPUT);
+}
+
 void LoseScreen::create()
 {
 	ScreenBase::create();
@@ -102,6 +116,20 @@ ScreenBase* WinScreen::getNextScreen()
 	return new SplashScreen();
 }
 
+// the credits screen only follows a rare win
+bool WinScreen::getLikelyNextScreen(ScreenPrefetch& prefetch)
+{
+	SplashScreen::describeAssets(prefetch);
+	return true;
+}
+
+void WinScreen::describeAssets(ScreenPrefetch& prefetch)
+{
+	prefetch.screenName = "WinScreen";
+	prefetch.addImage("gamewin1.png", LOAD_IMAGE_FIT_OUTPUT);
+	prefetch.addImage("gamewin2.png", LOAD_IMAGE_SET_ALPHA | LOAD_IMAGE_FIT_OUTPUT);
+}
+
 void WinScreen::onOverlayComplete(OVERLAY_TRANSITION_TYPE transType, long duration)
 {
 	ScreenBase::onOverlayComplete(transType, duration);
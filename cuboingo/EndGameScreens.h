@@ -14,6 +14,8 @@ namespace Cuboingo
 		LoseScreen() : ScreenBase("LoseScreen"), _text(nullptr) { }
 
 		virtual ScreenBase* getNextScreen();
+		virtual bool getLikelyNextScreen(ScreenPrefetch& prefetch);
+		static void describeAssets(ScreenPrefetch& prefetch);
 
 		virtual void create();
 
@@ -36,6 +38,8 @@ namespace Cuboingo
 		WinScreen(int userScore) : ScreenBase("WinScreen") { _userScore = userScore; }
 
 		virtual ScreenBase* getNextScreen();
+		virtual bool getLikelyNextScreen(ScreenPrefetch& prefetch);
+		static void describeAssets(ScreenPrefetch& prefetch);
 
 		virtual void onOverlayComplete(OVERLAY_TRANSITION_TYPE transType, long duration);
 
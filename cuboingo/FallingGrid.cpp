@@ -51,8 +51,7 @@ float FallingGrid::checkTap(float x, float y, const Matrix& proj, const Matrix&
 		pos.z = getTotalDist() + defCubeRadius;
 
 		// compute world matrix
-		static Matrix mat;
-		mat.identity();
+		Matrix mat;
 		switch (_orient)
 		{
 		case AXISORIENT_Z:
@@ -38,6 +38,24 @@ ScreenBase* GameScreen::getNextScreen()
 	return new LoseScreen();
 }
 
+bool GameScreen::getLikelyNextScreen(ScreenPrefetch& prefetch)
+{
+	if (!_gameIsOver)
+		SplashScreen::describeAssets(prefetch);
+	else if (_gameWon)
+		WinScreen::describeAssets(prefetch);
+	else
+		LoseScreen::describeAssets(prefetch);
+	return true;
+}
+
+// the background comes from the script and the cube's maps are already loaded by the splash screen
+void GameScreen::describeAssets(ScreenPrefetch& prefetch)
+{
+	prefetch.screenName = "GameScreen";
+	prefetch.addImage("arrow.png", LOAD_IMAGE_NONE);
+}
+
 void GameScreen::create()
 {
 	// debugging aid - if no script has been loaded, then load the testing one
@@ -52,6 +70,10 @@ void GameScreen::create()
 	// this will call create() on the background/overlay handlers
 	ScreenBase::create();
 
+	ResourceList shared;
+	CubeUtil::getSharedResources(shared);
+	keepWarm(shared);
+
 	// preload sound effects and update the current time since this could take a while
 	_sounds.loadSound("rotate");
 	_sounds.loadSound("match");
@@ -239,6 +261,7 @@ void GameScreen::fadeComplete(float fadeAlpha, FADE_STYLE fadeStyle)
 bool GameScreen::update()
 {
 	_scoreKeeper.update();
+	_sparks.update();
 
 	// if there's no launcher and stamping then the game is already over
 	if (!_gameIsOver)
@@ -262,8 +285,11 @@ bool GameScreen::render()
 	drawBackgroundScreen();
 
 	// set up the view matrix
-	MigUtil::theRend->setProjectionMatrix(_projMatrix);
-	MigUtil::theRend->setViewMatrix(_viewMatrix);
+	MigUtil::theRend->setProjectionMatrix(&_projMatrix);
+	MigUtil::theRend->setViewMatrix(&_viewMatrix);
+
+	// the 3D scene goes through the render queue so draws get grouped by state
+	MigUtil::theRend->setRenderQueue(true);
 
 	// draw any 3D text strings
 	if (_bgHandler != nullptr && _bgHandler->isVisible())
@@ -284,6 +310,9 @@ bool GameScreen::render()
 	// particles
 	_sparks.draw();
 
+	// submit the 3D scene
+	MigUtil::theRend->setRenderQueue(false);
+
 	// back to 2D drawing (TODO: should this be in renderOverlays() instead?)
 	MigUtil::theRend->setProjectionMatrix(nullptr);
 	MigUtil::theRend->setViewMatrix(nullptr);
@@ -301,8 +330,10 @@ bool GameScreen::render()
 bool GameScreen::renderPass(int index, RenderPass* pass)
 {
 	// just the cube and falling pieces
+	MigUtil::theRend->setRenderQueue(true);
 	_cube.draw();
 	_launcher.draw();
+	MigUtil::theRend->setRenderQueue(false);
 
 	return true;
 }
@@ -22,6 +22,8 @@ namespace Cuboingo
 
 		// screen management
 		virtual ScreenBase* getNextScreen();
+		virtual bool getLikelyNextScreen(ScreenPrefetch& prefetch);
+		static void describeAssets(ScreenPrefetch& prefetch);
 
 		// life cycle events
 		virtual void create();
@@ -11,6 +11,8 @@ const std::string silverMapName = "silvermap.jpg";
 const std::string holeMapName = "holemap.png";
 const std::string gridVertexShader = "cvs_Grid";
 const std::string gridPixelShader = "cps_Grid";
+const std::string gridInstVertexShader = "cvs_GridInst";
+const std::string gridInstPixelShader = "cps_GridInst";
 
 // center coordinate for slots, depending on (dimension - 1)
 const float CENTER_BY_LVL[3] = { 0.0f, 0.5f, 0.65f };
@@ -21,6 +23,8 @@ const float RADIUS_BY_LVL[3] = { 0.9f, 0.4f, 0.24f };
 // static init
 Object* GridBase::_objFace = nullptr;
 Object* GridBase::_objSides = nullptr;
+std::vector<InstanceData> GridBase::_faceInst;
+std::vector<InstanceData> GridBase::_sideInst;
 
 // used to determine the X center of a slot 
 static float getSlotXCenterByIndex(int dimen, int index)
@@ -390,18 +394,24 @@ void GridBase::createGraphics()
 	// load the shaders first
 	MigUtil::theRend->loadVertexShader(gridVertexShader, VDTYPE_POSITION_NORMAL_TEXTURE, SHADER_HINT_MVP);
 	MigUtil::theRend->loadPixelShader(gridPixelShader, SHADER_HINT_NONE);
+	MigUtil::theRend->loadVertexShader(gridInstVertexShader, VDTYPE_POSITION_NORMAL_TEXTURE, SHADER_HINT_VIEW | SHADER_HINT_PROJ | SHADER_HINT_INSTANCED);
+	MigUtil::theRend->loadPixelShader(gridInstPixelShader, SHADER_HINT_NONE);
 
 	// load the maps
-	MigUtil::theRend->loadImage(silverMapName, silverMapName, LOAD_IMAGE_NONE);
+	MigUtil::theRend->loadImage(silverMapName, silverMapName, LOAD_IMAGE_MIPMAPS);
 	MigUtil::theRend->loadImage(holeMapName, holeMapName, LOAD_IMAGE_NONE);
 
-	// create the objects and assign the shaders
+	// create the objects and assign the shaders (sets 2 and 3 are the instanced versions of 0 and 1)
 	Object* faceObj = MigUtil::theRend->createObject();
 	faceObj->addShaderSet(gridVertexShader, gridPixelShader);
 	faceObj->addShaderSet(MIGTECH_VSHADER_POS_TRANSFORM, MIGTECH_PSHADER_COLOR);
+	faceObj->addShaderSet(gridInstVertexShader, gridInstPixelShader);
+	faceObj->addShaderSet(MIGTECH_VSHADER_POS_TRANSFORM_INST, MIGTECH_PSHADER_COLOR_INST);
 	Object* sideObj = MigUtil::theRend->createObject();
 	sideObj->addShaderSet(gridVertexShader, gridPixelShader);
 	sideObj->addShaderSet(MIGTECH_VSHADER_POS_TRANSFORM, MIGTECH_PSHADER_COLOR);
+	sideObj->addShaderSet(gridInstVertexShader, gridInstPixelShader);
+	sideObj->addShaderSet(MIGTECH_VSHADER_POS_TRANSFORM_INST, MIGTECH_PSHADER_COLOR_INST);
 	
 	// load mesh vertices
 	VertexPositionNormalTexture* txtVertices = createVertices(1, 1);
@@ -424,7 +434,7 @@ void GridBase::createGraphics()
 
 	// assign texturing
 	faceObj->setImage(0, holeMapName, TXT_FILTER_NEAREST, TXT_FILTER_NEAREST, TXT_WRAP_CLAMP);
-	sideObj->setImage(0, silverMapName, TXT_FILTER_LINEAR, TXT_FILTER_LINEAR, TXT_WRAP_CLAMP);
+	sideObj->setImage(0, silverMapName, TXT_FILTER_LINEAR_MIPMAP_NEAREST, TXT_FILTER_LINEAR, TXT_WRAP_CLAMP);
 
 	// culling
 	faceObj->setCulling(FACE_CULLING_BACK);
@@ -448,33 +458,39 @@ void GridBase::destroyGraphics()
 
 void GridBase::draw(const Matrix& mat) const
 {
-	static Color sideColor(0.5f, 0.5f, 0.5f, 1);
-	static Matrix locMatrix;
-
-	MigUtil::theRend->setBlending(BLEND_STATE_NONE);
-	MigUtil::theRend->setDepthTesting(DEPTH_TEST_STATE_LESS, true);
-	MigUtil::theRend->setMiscValue(0, (float)_mapIndex);
+	static const Color sideColor(0.5f, 0.5f, 0.5f, 1);
 
+	// gather the per-slot transforms and colors so the whole grid goes out in one draw call
+	_faceInst.clear();
+	_sideInst.clear();
 	int numSlots = getSlotCount();
 	for (int i = 0; i < numSlots; i++)
 	{
 		const Slot& theSlot = _theSlots[i];
 		if (!theSlot.invis)
 		{
-			applyTransform(locMatrix, mat, theSlot);
-			MigUtil::theRend->setModelMatrix(locMatrix);
-
-			MigUtil::theRend->setObjectColor(getSlotDrawColor(theSlot, i));
-			_objFace->render(CubeUtil::renderPass);
+			InstanceData inst;
+			applyTransform(inst.model, mat, theSlot);
+			inst.color = getSlotDrawColor(theSlot, i);
+			_faceInst.push_back(inst);
 
 			if (_gridDepth > 0)
 			{
-				sideColor.a = theSlot.color.a;
-				MigUtil::theRend->setObjectColor(sideColor);
-				_objSides->render(CubeUtil::renderPass);
+				inst.color = Color(sideColor, theSlot.color.a);
+				_sideInst.push_back(inst);
 			}
 		}
 	}
+	if (_faceInst.empty())
+		return;
+
+	MigUtil::theRend->setBlending(BLEND_STATE_NONE);
+	MigUtil::theRend->setDepthTesting(DEPTH_TEST_STATE_LESS, true);
+	MigUtil::theRend->setMiscValue(0, (float)_mapIndex);
+
+	_objFace->renderInstanced(2 + CubeUtil::renderPass, &_faceInst[0], _faceInst.size());
+	if (!_sideInst.empty())
+		_objSides->renderInstanced(2 + CubeUtil::renderPass, &_sideInst[0], _sideInst.size());
 }
 
 bool GridBase::setEmptyColors(float r, float g, float b)
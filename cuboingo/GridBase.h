@@ -124,5 +124,9 @@ namespace Cuboingo
 		// shared amongst all instances
 		static Object* _objFace;
 		static Object* _objSides;
+
+		// per-draw instance scratch, shared since grids only draw on the main thread
+		static std::vector<InstanceData> _faceInst;
+		static std::vector<InstanceData> _sideInst;
 	};
 }
\ No newline at end of file
@@ -1094,6 +1094,6 @@ void Launcher::draw(const Matrix& mat) const
 
 void Launcher::draw() const
 {
-	static Matrix locMatrix;
+	Matrix locMatrix;
 	draw(locMatrix);
 }
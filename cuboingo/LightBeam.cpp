@@ -89,8 +89,7 @@ void LightBeam::destroyGraphics()
 
 static void loadMatrix(const GridInfo& gridInfo, float xCenter, float yCenter, float zOffset, float glowParam, const Matrix& worldMatrix)
 {
-	static Matrix locMatrix;
-	locMatrix.identity();
+	Matrix locMatrix;
 
 	// make sure the center of the shaft is always facing the user
 	if (gridInfo.orient == AXISORIENT_X || gridInfo.orient == AXISORIENT_Y)
@@ -110,7 +109,7 @@ static void loadMatrix(const GridInfo& gridInfo, float xCenter, float yCenter, f
 		locMatrix.rotateX(-rad90);
 
 	locMatrix.multiply(worldMatrix);
-	MigUtil::theRend->setModelMatrix(locMatrix);
+	MigUtil::theRend->setModelMatrix(&locMatrix);
 }
 
 void LightBeam::draw(const GridInfo& gridInfo, float xCenter, float yCenter, float glowParam, bool isGrowing, const Matrix& worldMatrix) const
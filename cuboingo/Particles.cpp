@@ -2,7 +2,6 @@
 #include "CubeUtil.h"
 #include "Particles.h"
 #include "../core/MigUtil.h"
-#include "../core/Timer.h"
 
 using namespace MigTech;
 using namespace Cuboingo;
@@ -11,90 +10,13 @@ static const int SPARK_MIN_COUNT = 10;        // minimum number of sparks to dis
 static const int SPARK_MAX_COUNT = 20;        // maximum number of sparks to display
 static const int SPARK_DURATION = 500;        // approximate duration of a spark
 static const int SPARK_FLICKER_DELAY = 50;    // period of the flicker effect
-static const int SPARK_GRAVITY = 2;           // gravity (world coordinates per second^2)
+static const float SPARK_GRAVITY = 4;         // gravity (world coordinates per second^2)
+static const float SPARK_DRAG = 7;            // velocity damping, most of the travel happens early on
+static const float SPARK_WHITE_CHANCE = 0.1f; // chance of a spark flashing white on any given frame
+static const int SPARK_POOL_SIZE = 128;       // maximum number of live sparks
 
 static const float rotCamera2 = 30;
 
-///////////////////////////////////////////////////////////////////////////
-// Spark
-
-Spark::Spark()
-{
-	_callback = nullptr;
-	_startTime = 0;
-	_flickerScale = 0;
-	_lastFlickerUpdate = 0;
-}
-
-void Spark::init(const Vector3& pos, const Vector3& vel, const Color& col, long dur, ISparkCallback* callback)
-{
-	_origPos = _currPos = pos;
-	_vel = vel;
-	_color = Color(col.r, col.g, col.b, 1);
-	_callback = callback;
-
-	// create an animation for the movement
-	float tParams[] = { 0.0f, 0.6f, 0.8f, 0.9f, 1.0f };
-	AnimItem animItem(this);
-	animItem.configParametricAnim(0, 1, dur, tParams, ARRAYSIZE(tParams));
-	_idPosAnim = MigUtil::theAnimList->addItem(animItem);
-
-	// create an animation for the alpha channel
-	float aParams[] = { 1.0f, 0.9f, 0.8f, 0.6f, 0.0f };
-	AnimItem animItemA(this);
-	animItemA.configParametricAnim(0, 1, dur, aParams, ARRAYSIZE(aParams));
-	_idAlphaAnim = MigUtil::theAnimList->addItem(animItemA);
-
-	// note start time for gravity effect
-	_startTime = Timer::gameTimeMillis();
-}
-
-void Spark::draw(MovieClip& mc) const
-{
-	mc.setPos(_currPos);
-	mc.setColor(MigUtil::pickRandom(10) == 0 ? colWhite : _color);
-	mc.draw();
-}
-
-bool Spark::doFrame(int id, float newVal, void* optData)
-{
-	if (_idPosAnim == id)
-	{
-		Vector3 delta = _vel * newVal;
-		float fallTime = (Timer::gameTimeMillis() - _startTime) / 1000.0f;
-		_currPos = Vector3(
-			_origPos.x + delta.x,
-			_origPos.y + delta.y - (fallTime * fallTime * SPARK_GRAVITY),   // gravity
-			_origPos.z + delta.z);
-	}
-	else if (_idAlphaAnim == id)
-	{
-		long gameTime = Timer::gameTimeMillis();
-		if (gameTime > _lastFlickerUpdate + SPARK_FLICKER_DELAY)
-		{
-			_lastFlickerUpdate = gameTime;
-			_flickerScale = MigUtil::pickFloat();
-		}
-		_color.a = newVal * _flickerScale;
-	}
-	return true;
-}
-
-void Spark::animComplete(int id, void* optData)
-{
-	if (_idPosAnim == id)
-	{
-		_idPosAnim = 0;
-		if (_callback != nullptr)
-			_callback->sparkComplete(this);
-	}
-	else if (_idAlphaAnim == id)
-		_idAlphaAnim = 0;
-}
-
-///////////////////////////////////////////////////////////////////////////
-// SparkList
-
 SparkList::SparkList() : _showParticles(true)
 {
 }
@@ -110,6 +32,18 @@ void SparkList::init()
 		const float DIAMETER = 0.2f;
 		_mcSpark.init("spark.png", DIAMETER, DIAMETER);
 		_mcSpark.setRot(MigUtil::convertToRadians(-rotCamera2), rad45, 0);
+
+		// every spark shares the clip rotation, only the position differs
+		_sparkRot.identity();
+		_sparkRot.rotateX(MigUtil::convertToRadians(-rotCamera2));
+		_sparkRot.rotateY(rad45);
+
+		ParticleSettings settings;
+		settings.gravity = Vector3(0, -SPARK_GRAVITY, 0);
+		settings.drag = SPARK_DRAG;
+		settings.flickerPeriod = SPARK_FLICKER_DELAY / 1000.0f;
+		settings.sparkleChance = SPARK_WHITE_CHANCE;
+		_sparks.init(SPARK_POOL_SIZE, settings);
 	}
 }
 
@@ -182,38 +116,33 @@ void SparkList::sideComplete(AxisOrient orient, const Color& col)
 			velocity *= (defCubeRadius * velocityScale);
 
 			// randomize the spark duration
-			long duration = (long)(SPARK_DURATION * (0.5 + MigUtil::pickFloat()));
-
-			// add a new spark
-			Spark* newSpark = new Spark();
-			newSpark->init(position, velocity, col, duration, this);
-			_sparkList.push_back(newSpark);
+			float duration = (SPARK_DURATION * (0.5f + MigUtil::pickFloat())) / 1000.0f;
+
+			// the velocity above is the total distance travelled, with drag the starting speed that covers
+			//  that distance over the spark's life is scaled by k/(1 - e^(-kT))
+			velocity *= (SPARK_DRAG / (1 - (float) exp(-SPARK_DRAG * duration)));
+
+			// add a new spark, if the pool is full the rest are dropped
+			ParticleSpawn spark;
+			spark.pos = position;
+			spark.vel = velocity;
+			spark.color = Color(col, 1);
+			spark.life = duration;
+			if (!_sparks.spawn(spark))
+				break;
 		}
 	}
 }
 
-void SparkList::draw()
+void SparkList::update()
 {
 	if (_showParticles)
-	{
-		_mcSpark.startRenderSet();
-
-		std::list<Spark*>::const_iterator iter = _sparkList.begin();
-		while (iter != _sparkList.end())
-		{
-			(*iter)->draw(_mcSpark);
-			iter++;
-		}
-
-		_mcSpark.stopRenderSet();
-	}
+		_sparks.update();
 }
 
-void SparkList::sparkComplete(Spark* spark)
+void SparkList::draw()
 {
-	if (spark != nullptr)
-	{
-		_sparkList.remove(spark);
-		delete spark;
-	}
+	// all of the sparks go out in a single instanced draw
+	if (_showParticles)
+		_sparks.draw(_mcSpark, _sparkRot);
 }
@@ -1,47 +1,15 @@
 ﻿#pragma once
 
 #include "../core/MigInclude.h"
-#include "../core/AnimList.h"
-#include "../core/Object.h"
 #include "../core/MovieClip.h"
+#include "../core/ParticleEmitter.h"
 #include "CubeConst.h"
 
 using namespace MigTech;
 
 namespace Cuboingo
 {
-	class Spark;
-
-	class ISparkCallback
-	{
-	public:
-		virtual void sparkComplete(Spark* spark) = 0;
-	};
-
-	class Spark : public IAnimTarget
-	{
-	public:
-		Spark();
-
-		void init(const Vector3& pos, const Vector3& vel, const Color& col, long dur, ISparkCallback* callback);
-		void draw(MovieClip& mc) const;
-
-		// IAnimTarget
-		virtual bool doFrame(int id, float newVal, void* optData);
-		virtual void animComplete(int id, void* optData);
-
-	protected:
-		ISparkCallback* _callback;
-		Vector3 _origPos, _currPos, _vel;
-		Color _color;
-
-		AnimID _idPosAnim, _idAlphaAnim;
-		long _startTime;
-		float _flickerScale;
-		long _lastFlickerUpdate;
-	};
-
-	class SparkList : public MigBase, public ISparkCallback
+	class SparkList : public MigBase
 	{
 	public:
 		SparkList();
@@ -53,18 +21,15 @@ namespace Cuboingo
 		void destroyGraphics();
 
 		void sideComplete(AxisOrient orient, const Color& col);
+		void update();
 		void draw();
 
 		void setShowParticles(bool show) { _showParticles = show; }
 
-		// ISparkCallback
-		virtual void sparkComplete(Spark* spark);
-
-	protected:
-
 	protected:
-		std::list<Spark*> _sparkList;
+		ParticleEmitter _sparks;
 		MovieClip _mcSpark;
+		Matrix _sparkRot;
 		bool _showParticles;
 	};
 }
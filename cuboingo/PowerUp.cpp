@@ -102,8 +102,7 @@ void PowerUp::drawIcon() const
 {
 	if (_scale > 0 && _drawType != POWERUPTYPE_NONE)
 	{
-		static Matrix mat;
-		mat.identity();
+		Matrix mat;
 		mat.scale(_scale*_sizeIcon.width, _scale*_sizeIcon.height, 1);
 		mat.translate(_ptCenter);
 		_mcIcons.jumpToFrame(getIconFrameIndex(_drawType));
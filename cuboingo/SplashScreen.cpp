@@ -58,7 +58,7 @@ void SplashLauncher::startGridLaunch(GridInfo& newGrid)
 
 void SplashLauncher::draw() const
 {
-	static Matrix identity;
+	Matrix identity;
 
 	// draw the obsolete falling grids, while they are still visible
 	std::list<FallingGrid*>::const_iterator iter = _fallList.begin();
@@ -118,10 +118,30 @@ ScreenBase* SplashScreen::getNextScreen()
 	return (demoScreen != nullptr ? demoScreen : new GameScreen());
 }
 
+bool SplashScreen::getLikelyNextScreen(ScreenPrefetch& prefetch)
+{
+	// demos aren't worth prefetching
+	if (!GameScripts::getCurrScript().demoID.empty())
+		return false;
+
+	GameScreen::describeAssets(prefetch);
+	return true;
+}
+
+void SplashScreen::describeAssets(ScreenPrefetch& prefetch)
+{
+	prefetch.screenName = "SplashScreen";
+	prefetch.addImage("splash.png", LOAD_IMAGE_FIT_OUTPUT);
+}
+
 void SplashScreen::create()
 {
 	ScreenBase::create();
 
+	ResourceList shared;
+	CubeUtil::getSharedResources(shared);
+	keepWarm(shared);
+
 	_cube.init();
 	_cube.startRotation();
 
@@ -186,8 +206,8 @@ bool SplashScreen::render()
 	// background screen
 	drawBackgroundScreen();
 
-	MigUtil::theRend->setProjectionMatrix(_projMatrix);
-	MigUtil::theRend->setViewMatrix(_viewMatrix);
+	MigUtil::theRend->setProjectionMatrix(&_projMatrix);
+	MigUtil::theRend->setViewMatrix(&_viewMatrix);
 	_shadowPass.draw();
 	_cube.draw();
 
@@ -37,6 +37,8 @@ namespace Cuboingo
 		SplashScreen();
 
 		virtual ScreenBase* getNextScreen();
+		virtual bool getLikelyNextScreen(ScreenPrefetch& prefetch);
+		static void describeAssets(ScreenPrefetch& prefetch);
 
 		virtual void create();
 		virtual void createGraphics();
@@ -184,8 +184,7 @@ bool ScriptOverlay::update()
 
 void ScriptOverlay::draw(float alpha, const Matrix& mat)
 {
-	static Matrix localMat;
-	localMat.identity();
+	Matrix localMat;
 	if (_transX != 0)
 		localMat.translate(_transX, 0, 0);
 	localMat.multiply(mat);
@@ -0,0 +1,496 @@
+﻿#include "pch.h"
+#include "../../core/MigUtil.h"
+#include "../../core/Timer.h"
+#include "../../core/DemoBase.h"
+#include "../../core/AssetLoader.h"
+#include "../../headless/HeadlessApp.h"
+#include "../../headless/NullRender.h"
+#include "../../headless/SoftRender.h"
+#include "../../headless/NullAudio.h"
+#include "../CuboingoGame.h"
+#include "../GameScreen.h"
+#include "../GameScripts.h"
+#include "CuboingoSoftShaders.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+
+using namespace MigTech;
+using namespace Cuboingo;
+
+///////////////////////////////////////////////////////////////////////////
+// allocation counting, every allocation in the process goes through here
+
+static std::atomic<unsigned long> allocCount(0);
+static std::atomic<unsigned long> allocBytes(0);
+
+void* operator new(size_t size)
+{
+	allocCount++;
+	allocBytes += size;
+	void* p = malloc(size > 0 ? size : 1);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	free(p);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// benchmark configuration
+
+struct BenchConfig
+{
+	std::string contentDir;
+	std::string scriptID;
+	std::vector<std::string> demoIDs;
+	std::string csvPath;
+	int frames;
+	int warmup;
+	double stepMs;
+	unsigned int seed;
+	int logLevel;
+	int loaderThreads;
+	Size outputSize;
+
+	// software rasterizer, frames and heatmaps are written every shotEvery frames if there's a shot directory
+	bool softRender;
+	std::string shotDir;
+	int shotEvery;
+};
+
+// the heatmap ramps top out at these
+static const float heatmapMaxOverdraw = 8;
+static const float heatmapMaxFillBytes = 64;
+
+static BenchConfig benchCfg;
+
+///////////////////////////////////////////////////////////////////////////
+// game screen driven by the demo scripts
+
+class BenchGameScreen : public GameScreen, public IDemoScriptCallback
+{
+public:
+	BenchGameScreen() : _script(this), _nextDemo(0) { }
+
+	virtual ScreenBase* getNextScreen()
+	{
+		// keep playing the same script, the win/lose screens aren't part of the benchmark
+		//  (cleared first like the splash screen does, the old screen deleted the script's handlers)
+		GameScripts::clearGameScript();
+		GameScripts::loadGameScript(benchCfg.scriptID);
+		return new BenchGameScreen();
+	}
+
+	virtual bool getLikelyNextScreen(ScreenPrefetch& prefetch)
+	{
+		GameScreen::describeAssets(prefetch);
+		return true;
+	}
+
+	virtual bool update()
+	{
+		// cycle through the demo scripts, each one is a recorded stream of swipes and taps
+		if (!benchCfg.demoIDs.empty() && (!_script.isStarted() || _script.isDone()))
+		{
+			_script.start(benchCfg.demoIDs[_nextDemo]);
+			_nextDemo = (_nextDemo + 1) % benchCfg.demoIDs.size();
+		}
+		_script.update();
+
+		return GameScreen::update();
+	}
+
+	// IDemoScriptCallback
+	virtual void onStartScript() { }
+	virtual void onStopScript() { }
+	virtual void onMove(float u, float v, DEMO_EVENT evt)
+	{
+		// same as the real input path, so dialogs see it too
+		if (evt == DEMO_EVENT_FINGER_DOWN)
+			MigUtil::theGame->onPointerPressed(u, v);
+		else if (evt == DEMO_EVENT_FINGER_UP)
+			MigUtil::theGame->onPointerReleased(u, v);
+		else if (_script.isFingerDown())
+			MigUtil::theGame->onPointerMoved(u, v, true);
+	}
+
+protected:
+	DemoScript _script;
+	unsigned int _nextDemo;
+};
+
+class BenchGame : public CuboingoGame
+{
+public:
+	virtual ScreenBase* createStartupScreen()
+	{
+		if (!GameScripts::loadGameScript(benchCfg.scriptID))
+			throw std::runtime_error("(BenchGame::createStartupScreen) Unable to load the game script");
+		return new BenchGameScreen();
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////
+// per-frame samples and the summary
+
+struct FrameSample
+{
+	double updateMs;
+	double renderMs;
+	unsigned int drawCalls;
+	unsigned int stateChanges;
+	unsigned long allocs;
+	unsigned long allocBytes;
+	int anims;
+
+	// software rasterizer only
+	double overdraw;
+	double fillBytes;
+};
+
+static double getPercentile(std::vector<double> vals, double pct)
+{
+	if (vals.empty())
+		return 0;
+	std::sort(vals.begin(), vals.end());
+	return vals[(int)(pct * (vals.size() - 1) + 0.5)];
+}
+
+static void printSummary(const char* name, const std::vector<double>& vals)
+{
+	double total = 0, maxVal = 0;
+	for (unsigned int i = 0; i < vals.size(); i++)
+	{
+		total += vals[i];
+		maxVal = std::max(maxVal, vals[i]);
+	}
+	printf("%-14s avg %10.3f  p50 %10.3f  p99 %10.3f  max %10.3f\n", name,
+		(vals.empty() ? 0 : total / vals.size()), getPercentile(vals, 0.5), getPercentile(vals, 0.99), maxVal);
+}
+
+static void reportSamples(const std::vector<FrameSample>& samples)
+{
+	std::vector<double> update, render, draws, states, allocs, bytes, anims, overdraw, fill;
+	for (unsigned int i = 0; i < samples.size(); i++)
+	{
+		update.push_back(samples[i].updateMs);
+		render.push_back(samples[i].renderMs);
+		draws.push_back(samples[i].drawCalls);
+		states.push_back(samples[i].stateChanges);
+		allocs.push_back(samples[i].allocs);
+		bytes.push_back(samples[i].allocBytes);
+		anims.push_back(samples[i].anims);
+		overdraw.push_back(samples[i].overdraw);
+		fill.push_back(samples[i].fillBytes / (1024 * 1024));
+	}
+
+	printf("script %s, %d frames (+%d warmup) at %.3f ms per frame, seed %u\n",
+		benchCfg.scriptID.c_str(), (int)samples.size(), benchCfg.warmup, benchCfg.stepMs, benchCfg.seed);
+	printSummary("update ms", update);
+	printSummary("render ms", render);
+	printSummary("draw calls", draws);
+	printSummary("state changes", states);
+	printSummary("allocs", allocs);
+	printSummary("alloc bytes", bytes);
+	printSummary("anim items", anims);
+	if (benchCfg.softRender)
+	{
+		printSummary("overdraw", overdraw);
+		printSummary("fill MB", fill);
+	}
+}
+
+static void reportLoader()
+{
+	AssetLoaderStats stats;
+	AssetLoader::getStats(stats);
+	printf("images %d, fit to %.0fx%.0f at 1/1 %d  1/2 %d  1/4 %d  1/8 %d, %.1f Mpixels skipped\n", stats.imagesLoaded,
+		benchCfg.outputSize.width, benchCfg.outputSize.height, stats.fitScales[0], stats.fitScales[1], stats.fitScales[2], stats.fitScales[3],
+		stats.pixelsSkipped / 1000000.0);
+}
+
+static bool writeSamples(const std::vector<FrameSample>& samples, const std::string& path)
+{
+	FILE* pf = fopen(path.c_str(), "w");
+	if (pf == nullptr)
+		return false;
+
+	fputs("frame,update_ms,render_ms,draw_calls,state_changes,allocs,alloc_bytes,anim_items", pf);
+	fputs((benchCfg.softRender ? ",overdraw,fill_bytes\n" : "\n"), pf);
+	for (unsigned int i = 0; i < samples.size(); i++)
+	{
+		const FrameSample& s = samples[i];
+		fprintf(pf, "%u,%.4f,%.4f,%u,%u,%lu,%lu,%d", i, s.updateMs, s.renderMs, s.drawCalls, s.stateChanges, s.allocs, s.allocBytes, s.anims);
+		if (benchCfg.softRender)
+			fprintf(pf, ",%.4f,%.0f", s.overdraw, s.fillBytes);
+		fputs("\n", pf);
+	}
+	fclose(pf);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// entry point
+
+static void printUsage()
+{
+	printf("usage: cuboingo_bench [options]\n");
+	printf("  --content <dir>    cuboingo content directory\n");
+	printf("  --script <n|file>  game script, 2-6 or a script file name (default 3)\n");
+	printf("  --demo <a,b,...>   demo scripts used for input (default all of them)\n");
+	printf("  --frames <n>       frames to measure (default 3600)\n");
+	printf("  --warmup <n>       frames to run before measuring (default 60)\n");
+	printf("  --step <ms>        fixed timestep (default 16.667)\n");
+	printf("  --seed <n>         random seed (default 1)\n");
+	printf("  --csv <file>       write the per-frame samples to a file\n");
+	printf("  --log <level>      engine log level, 0=debug to 4=fatal (default 2)\n");
+	printf("  --loader <n>       background image loader threads, 0 loads synchronously (default 0)\n");
+	printf("  --size <w>x<h>     output size (default 1280x720)\n");
+	printf("  --render <null|soft>  recording renderer or the software rasterizer (default null)\n");
+	printf("  --shots <dir>      software rasterizer frames and overdraw/fill heatmaps are written here\n");
+	printf("  --shot-every <n>   frames between shots (default 600)\n");
+}
+
+static bool parseArgs(int argc, char** argv)
+{
+#ifdef CUBOINGO_CONTENT_DIR
+	benchCfg.contentDir = CUBOINGO_CONTENT_DIR;
+#endif
+	benchCfg.scriptID = "script3.xml";
+	benchCfg.frames = 3600;
+	benchCfg.warmup = 60;
+	benchCfg.stepMs = 1000 / 60.0;
+	benchCfg.seed = 1;
+	benchCfg.logLevel = 2;
+	benchCfg.loaderThreads = 0;
+	benchCfg.outputSize = Size(1280, 720);
+	benchCfg.softRender = false;
+	benchCfg.shotEvery = 600;
+
+	static const char* defDemos[] = { "demo1.xml", "demo2_part1.xml", "demo2_part2.xml", "demo2_part3.xml",
+		"demo3_part1.xml", "demo3_part2.xml", "demo4_part1.xml", "demo4_part2.xml" };
+	benchCfg.demoIDs.assign(defDemos, defDemos + ARRAYSIZE(defDemos));
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--help" || arg == "-h")
+			return false;
+		if (i + 1 >= argc)
+		{
+			fprintf(stderr, "missing value for %s\n", arg.c_str());
+			return false;
+		}
+
+		std::string val = argv[++i];
+		if (arg == "--content")
+			benchCfg.contentDir = val;
+		else if (arg == "--script")
+			benchCfg.scriptID = (val.find('.') == std::string::npos ? "script" + val + ".xml" : val);
+		else if (arg == "--demo")
+		{
+			benchCfg.demoIDs.clear();
+			size_t start = 0;
+			while (start <= val.length())
+			{
+				size_t comma = val.find(',', start);
+				std::string demo = val.substr(start, (comma == std::string::npos ? std::string::npos : comma - start));
+				if (!demo.empty())
+					benchCfg.demoIDs.push_back(demo);
+				if (comma == std::string::npos)
+					break;
+				start = comma + 1;
+			}
+		}
+		else if (arg == "--frames")
+			benchCfg.frames = atoi(val.c_str());
+		else if (arg == "--warmup")
+			benchCfg.warmup = atoi(val.c_str());
+		else if (arg == "--step")
+			benchCfg.stepMs = atof(val.c_str());
+		else if (arg == "--seed")
+			benchCfg.seed = (unsigned int)atoi(val.c_str());
+		else if (arg == "--csv")
+			benchCfg.csvPath = val;
+		else if (arg == "--log")
+			benchCfg.logLevel = atoi(val.c_str());
+		else if (arg == "--loader")
+			benchCfg.loaderThreads = std::max(atoi(val.c_str()), 0);
+		else if (arg == "--size")
+		{
+			int w = 0, h = 0;
+			if (sscanf(val.c_str(), "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0)
+			{
+				fprintf(stderr, "bad output size %s\n", val.c_str());
+				return false;
+			}
+			benchCfg.outputSize = Size((float)w, (float)h);
+		}
+		else if (arg == "--render")
+		{
+			if (val != "null" && val != "soft")
+			{
+				fprintf(stderr, "unknown renderer %s\n", val.c_str());
+				return false;
+			}
+			benchCfg.softRender = (val == "soft");
+		}
+		else if (arg == "--shots")
+			benchCfg.shotDir = val;
+		else if (arg == "--shot-every")
+			benchCfg.shotEvery = std::max(atoi(val.c_str()), 1);
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", arg.c_str());
+			return false;
+		}
+	}
+
+	if (!benchCfg.shotDir.empty() && !benchCfg.softRender)
+	{
+		fprintf(stderr, "--shots needs --render soft\n");
+		return false;
+	}
+	return (benchCfg.frames > 0 && benchCfg.stepMs > 0);
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	if (!parseArgs(argc, argv))
+	{
+		printUsage();
+		return 1;
+	}
+
+	// the platform is fully deterministic apart from how long things take
+	HeadlessUtil_setContentDir(benchCfg.contentDir);
+	HeadlessUtil_setFilesDir(".");
+	HeadlessUtil_setFixedTimestep(Timer::milliSecondsToTicks(benchCfg.stepMs));
+	HeadlessUtil_setLogLevel(benchCfg.logLevel);
+	MigUtil::seedRandom(benchCfg.seed);
+
+	NullAudio* audio = new NullAudio();
+	SimplePersist* persist = new SimplePersist();
+	SoftRender* softRend = (benchCfg.softRender ? new SoftRender() : nullptr);
+	NullRender* rend = (softRend != nullptr ? softRend : new NullRender());
+	if (softRend != nullptr)
+		registerSoftShaders(softRend);
+	std::vector<FrameSample> samples;
+	int ret = 0;
+
+	try
+	{
+		if (!MigGame::initGameEngine(audio, persist) || !MigGame::initRenderer(rend))
+			throw std::runtime_error("(main) Unable to start the game engine");
+		rend->setOutputSize(benchCfg.outputSize);
+
+		BenchGame* game = new BenchGame();
+		game->onCreate();
+
+		// async loads finish whenever the workers get to them, which changes what gets drawn
+		AssetLoader::term();
+		if (benchCfg.loaderThreads > 0)
+			AssetLoader::init(benchCfg.loaderThreads, 4000);
+		game->onCreateGraphics();
+		game->onWindowSizeChanged();
+
+		samples.reserve(benchCfg.frames);
+		for (int frame = 0; frame < benchCfg.warmup + benchCfg.frames; frame++)
+		{
+			unsigned long allocs = allocCount;
+			unsigned long bytes = allocBytes;
+
+			std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+			game->update();
+			std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+			game->render();
+			std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+			if (frame >= benchCfg.warmup)
+			{
+				FrameSample sample;
+				sample.updateMs = elapsedMs(t0, t1);
+				sample.renderMs = elapsedMs(t1, t2);
+				sample.drawCalls = rend->getLastFrameStats().drawCalls;
+				sample.stateChanges = rend->getLastFrameStats().stateChanges;
+				sample.allocs = allocCount - allocs;
+				sample.allocBytes = allocBytes - bytes;
+				sample.anims = (MigUtil::theAnimList != nullptr ? MigUtil::theAnimList->getItemCount() : 0);
+				sample.overdraw = 0;
+				sample.fillBytes = 0;
+				if (softRend != nullptr)
+				{
+					const SoftFrameStats& raster = softRend->getLastRasterStats();
+					sample.overdraw = raster.pixelsWritten / (benchCfg.outputSize.width * benchCfg.outputSize.height);
+					sample.fillBytes = (double) raster.fillBytes;
+				}
+				samples.push_back(sample);
+
+				// the back buffer and its counters hold this frame until the next one starts
+				int measured = frame - benchCfg.warmup;
+				if (!benchCfg.shotDir.empty() && (measured % benchCfg.shotEvery) == 0)
+				{
+					char name[32];
+					sprintf(name, "/frame%05d", measured);
+					std::string path = benchCfg.shotDir + name;
+					if (!softRend->saveFrame(path + ".png") ||
+						!softRend->saveHeatmap(path + "_overdraw.png", SOFT_HEATMAP_OVERDRAW, heatmapMaxOverdraw) ||
+						!softRend->saveHeatmap(path + "_fill.png", SOFT_HEATMAP_FILL, heatmapMaxFillBytes))
+						fprintf(stderr, "unable to write the shots for frame %d\n", measured);
+				}
+			}
+		}
+
+		game->onDestroyGraphics();
+		game->onDestroy();
+		delete game;
+
+		MigGame::termRenderer();
+		MigGame::termGameEngine();
+	}
+	catch (std::exception& ex)
+	{
+		fprintf(stderr, "benchmark failed: %s\n", ex.what());
+		ret = 2;
+	}
+
+	if (!samples.empty())
+	{
+		reportSamples(samples);
+		reportLoader();
+		if (!benchCfg.csvPath.empty() && !writeSamples(samples, benchCfg.csvPath))
+			fprintf(stderr, "unable to write %s\n", benchCfg.csvPath.c_str());
+	}
+	return ret;
+}
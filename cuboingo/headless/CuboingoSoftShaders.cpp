@@ -0,0 +1,188 @@
+﻿#include "pch.h"
+#include "CuboingoSoftShaders.h"
+
+using namespace MigTech;
+
+///////////////////////////////////////////////////////////////////////////
+// vertex shaders
+
+// colObject lit by the first light, the normal goes along for the reflections
+static void lightVertex(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	const float* m = u.model.getData();
+	Vector3 norm(in.norm.x*m[0] + in.norm.y*m[4] + in.norm.z*m[8],
+		in.norm.x*m[1] + in.norm.y*m[5] + in.norm.z*m[9],
+		in.norm.x*m[2] + in.norm.y*m[6] + in.norm.z*m[10]);
+	const Vector3& dir = u.litDirPos[0];
+	float dotProd = -(dir.x*norm.x + dir.y*norm.y + dir.z*norm.z);
+
+	out.color = Color(u.objColor.r*dotProd, u.objColor.g*dotProd, u.objColor.b*dotProd, u.objColor.a);
+	out.norm = norm;
+}
+
+static void setClipPos(SoftVarying& out)
+{
+	out.pos = Vector3(out.clip[0], out.clip[1], out.clip[2]);
+}
+
+// cfgVal.x is the rendering pass, only the final pass (0) is lit
+static void cvsCube(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	u.transform(in.pos, out);
+	if (u.cfg[0] == 0)
+		lightVertex(u, in, out);
+	else
+		out.color = u.objColor;
+	setClipPos(out);
+	out.uv1 = in.uv1;
+}
+
+static void cvsShield(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	u.transform(in.pos, out);
+	lightVertex(u, in, out);
+	setClipPos(out);
+	out.uv1 = in.uv1;
+}
+
+static void cvsStamp(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	u.transform(in.pos, out);
+	lightVertex(u, in, out);
+	out.uv1 = in.uv1;
+}
+
+// misc.x is the map index (-1 = no map, 0-7 otherwise)
+static void gridTexCoord(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	if (u.misc[0] != -1)
+		out.uv1 = Vector2(0.125f*(u.misc[0] + in.uv1.x), in.uv1.y);
+	else
+		out.uv1 = Vector2(-1, -1);
+}
+
+static void cvsGrid(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	u.transform(in.pos, out);
+	out.color = u.objColor;
+	gridTexCoord(u, in, out);
+}
+
+static void cvsGridInst(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	u.transform(in.pos, out);
+	out.color = u.inst->color;
+	gridTexCoord(u, in, out);
+}
+
+static void cvsBeam(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	u.transform(in.pos, out);
+	out.uv1 = in.uv1;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// pixel shaders
+
+static Color modulate(const Color& a, const Color& b)
+{
+	return Color(a.r*b.r, a.g*b.g, a.b*b.b, a.a*b.a);
+}
+
+static float convertToUV(float arg)
+{
+	return (arg / 1.4142f) + 0.5f;
+}
+
+// the reflection ray flattened onto the two axes other than its largest one
+static Vector2 getReflectionCoords(const float* eye, const Vector3& pos, const Vector3& norm)
+{
+	Vector3 dir(pos.x - eye[0], pos.y - eye[1], pos.z - eye[2]);
+	dir.normalize();
+	float f2ndoti = 2 * (norm.x*dir.x + norm.y*dir.y + norm.z*dir.z);
+	Vector3 ray(dir.x - f2ndoti*norm.x, dir.y - f2ndoti*norm.y, dir.z - f2ndoti*norm.z);
+
+	float ax = fabs(ray.x), ay = fabs(ray.y), az = fabs(ray.z);
+	if (ax > ay && ax > az)
+		return Vector2(convertToUV(ray.y), convertToUV(ray.z));
+	else if (ay > ax && ay > az)
+		return Vector2(convertToUV(ray.x), convertToUV(ray.z));
+	return Vector2(convertToUV(ray.x), convertToUV(ray.y));
+}
+
+// misc.xyz is the eye and misc.w the reflection amount
+static Color cpsCube(const SoftUniforms& u, const SoftVarying& in)
+{
+	Color retCol = modulate(u.sample(0, in.uv1.x, in.uv1.y), in.color);
+	if (u.misc[3] > 0)
+	{
+		Vector2 uv = getReflectionCoords(u.misc, in.pos, in.norm);
+		Color reflCol = modulate(u.sample(1, uv.x, uv.y), in.color);
+		float w = u.misc[3];
+		retCol = Color(retCol.r*(1 - w) + w*reflCol.r, retCol.g*(1 - w) + w*reflCol.g,
+			retCol.b*(1 - w) + w*reflCol.b, retCol.a*(1 - w) + w*reflCol.a);
+	}
+	return retCol;
+}
+
+static Color cpsShield(const SoftUniforms& u, const SoftVarying& in)
+{
+	Color retCol = in.color;
+	if (u.misc[3] > 0)
+	{
+		Vector2 uv = getReflectionCoords(u.misc, in.pos, in.norm);
+		Color reflCol = modulate(u.sample(1, uv.x, uv.y), in.color);
+		retCol = Color(0.5f*(retCol.r + reflCol.r), 0.5f*(retCol.g + reflCol.g),
+			0.5f*(retCol.b + reflCol.b), 0.5f*(retCol.a + reflCol.a));
+	}
+	return retCol;
+}
+
+static Color cpsStamp(const SoftUniforms& u, const SoftVarying& in)
+{
+	return modulate(u.sample(0, in.uv1.x, in.uv1.y), in.color);
+}
+
+static Color cpsGrid(const SoftUniforms& u, const SoftVarying& in)
+{
+	if (in.uv1.x >= 0)
+		return modulate(u.sample(0, in.uv1.x, in.uv1.y), in.color);
+	return in.color;
+}
+
+// misc.x is the beam length and misc.y turns on the highlight at its tip
+static Color cpsBeam(const SoftUniforms& u, const SoftVarying& in)
+{
+	Color retCol = u.objColor;
+	retCol.a = 0.5f * in.uv1.x * u.misc[0];
+	if (u.misc[1] > 0 && in.uv1.y <= u.misc[0])
+	{
+		const float range = 0.1f;
+		float val = (in.uv1.y - (u.misc[0] - range)) / range;
+		if (val > 0)
+		{
+			retCol.r = retCol.r + (1 - retCol.r)*val / 2;
+			retCol.g = retCol.g + (1 - retCol.g)*val / 2;
+			retCol.b = retCol.b + (1 - retCol.b)*val / 2;
+			retCol.a *= (1 + val);
+		}
+	}
+	return retCol;
+}
+
+void Cuboingo::registerSoftShaders(SoftRender* rend)
+{
+	rend->registerVertexProc("cvs_Cube", cvsCube);
+	rend->registerVertexProc("cvs_Shield", cvsShield);
+	rend->registerVertexProc("cvs_Stamp", cvsStamp);
+	rend->registerVertexProc("cvs_Grid", cvsGrid);
+	rend->registerVertexProc("cvs_GridInst", cvsGridInst);
+	rend->registerVertexProc("cvs_Beam", cvsBeam);
+
+	rend->registerPixelProc("cps_Cube", cpsCube);
+	rend->registerPixelProc("cps_Shield", cpsShield);
+	rend->registerPixelProc("cps_Stamp", cpsStamp);
+	rend->registerPixelProc("cps_Grid", cpsGrid);
+	rend->registerPixelProc("cps_GridInst", cpsGrid);
+	rend->registerPixelProc("cps_Beam", cpsBeam);
+}
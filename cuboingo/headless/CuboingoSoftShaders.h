@@ -0,0 +1,10 @@
+﻿#pragma once
+
+#include "../../headless/SoftRender.h"
+
+namespace Cuboingo
+{
+	// software rasterizer stand-ins for the game's shaders (cvs_*.vert and cps_*.frag in the Android assets)
+	//  call this after the renderer is created and before the game loads its graphics
+	void registerSoftShaders(MigTech::SoftRender* rend);
+}
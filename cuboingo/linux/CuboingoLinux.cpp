@@ -0,0 +1,245 @@
+﻿#include "pch.h"
+#include "../../core/MigUtil.h"
+#include "../../core/Timer.h"
+#include "../../android/OglRender.h"
+#include "../../linux/LinuxApp.h"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace MigTech;
+
+///////////////////////////////////////////////////////////////////////////
+// run configuration
+
+struct LinuxConfig
+{
+	std::string contentDir;
+	std::vector<std::string> shaderDirs;
+	std::string csvPath;
+	int frames;
+	int warmup;
+	double stepMs;
+	unsigned int seed;
+	int logLevel;
+	int width;
+	int height;
+};
+
+static LinuxConfig linuxCfg;
+
+///////////////////////////////////////////////////////////////////////////
+// per-frame samples and the summary
+
+struct FrameSample
+{
+	double stepMs;
+	double finishMs;
+	unsigned int callsIssued;
+	unsigned int callsElided;
+};
+
+static double getPercentile(std::vector<double> vals, double pct)
+{
+	if (vals.empty())
+		return 0;
+	std::sort(vals.begin(), vals.end());
+	return vals[(int)(pct * (vals.size() - 1) + 0.5)];
+}
+
+static void printSummary(const char* name, const std::vector<double>& vals)
+{
+	double total = 0, maxVal = 0;
+	for (unsigned int i = 0; i < vals.size(); i++)
+	{
+		total += vals[i];
+		maxVal = std::max(maxVal, vals[i]);
+	}
+	printf("%-14s avg %10.3f  p50 %10.3f  p99 %10.3f  max %10.3f\n", name,
+		(vals.empty() ? 0 : total / vals.size()), getPercentile(vals, 0.5), getPercentile(vals, 0.99), maxVal);
+}
+
+static void reportSamples(const std::vector<FrameSample>& samples)
+{
+	std::vector<double> step, finish, issued, elided;
+	for (unsigned int i = 0; i < samples.size(); i++)
+	{
+		step.push_back(samples[i].stepMs);
+		finish.push_back(samples[i].finishMs);
+		issued.push_back(samples[i].callsIssued);
+		elided.push_back(samples[i].callsElided);
+	}
+
+	printf("%d frames (+%d warmup) at %dx%d, %.3f ms per frame, seed %u\n",
+		(int)samples.size(), linuxCfg.warmup, linuxCfg.width, linuxCfg.height, linuxCfg.stepMs, linuxCfg.seed);
+	printSummary("step ms", step);
+	printSummary("finish ms", finish);
+	printSummary("gl calls", issued);
+	printSummary("gl elided", elided);
+}
+
+static bool writeSamples(const std::vector<FrameSample>& samples, const std::string& path)
+{
+	FILE* pf = fopen(path.c_str(), "w");
+	if (pf == nullptr)
+		return false;
+
+	fputs("frame,step_ms,finish_ms,gl_calls,gl_elided\n", pf);
+	for (unsigned int i = 0; i < samples.size(); i++)
+	{
+		const FrameSample& s = samples[i];
+		fprintf(pf, "%u,%.4f,%.4f,%u,%u\n", i, s.stepMs, s.finishMs, s.callsIssued, s.callsElided);
+	}
+	fclose(pf);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// entry point
+
+static void printUsage()
+{
+	printf("usage: cuboingo_gl [options]\n");
+	printf("  --content <dir>    cuboingo content directory\n");
+	printf("  --shaders <dir>    extra GLSL shader directory, searched first\n");
+	printf("  --frames <n>       frames to measure (default 600)\n");
+	printf("  --warmup <n>       frames to run before measuring (default 60)\n");
+	printf("  --step <ms>        fixed timestep, 0 runs on the wall clock (default 16.667)\n");
+	printf("  --seed <n>         random seed (default 1)\n");
+	printf("  --csv <file>       write the per-frame samples to a file\n");
+	printf("  --log <level>      engine log level, 0=debug to 4=fatal (default 2)\n");
+	printf("  --size <w>x<h>     pbuffer size (default 1280x720)\n");
+}
+
+static bool parseArgs(int argc, char** argv)
+{
+#ifdef CUBOINGO_CONTENT_DIR
+	linuxCfg.contentDir = CUBOINGO_CONTENT_DIR;
+#endif
+	linuxCfg.frames = 600;
+	linuxCfg.warmup = 60;
+	linuxCfg.stepMs = 1000 / 60.0;
+	linuxCfg.seed = 1;
+	linuxCfg.logLevel = 2;
+	linuxCfg.width = 1280;
+	linuxCfg.height = 720;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--help" || arg == "-h")
+			return false;
+		if (i + 1 >= argc)
+		{
+			fprintf(stderr, "missing value for %s\n", arg.c_str());
+			return false;
+		}
+
+		std::string val = argv[++i];
+		if (arg == "--content")
+			linuxCfg.contentDir = val;
+		else if (arg == "--shaders")
+			linuxCfg.shaderDirs.push_back(val);
+		else if (arg == "--frames")
+			linuxCfg.frames = atoi(val.c_str());
+		else if (arg == "--warmup")
+			linuxCfg.warmup = atoi(val.c_str());
+		else if (arg == "--step")
+			linuxCfg.stepMs = atof(val.c_str());
+		else if (arg == "--seed")
+			linuxCfg.seed = (unsigned int)atoi(val.c_str());
+		else if (arg == "--csv")
+			linuxCfg.csvPath = val;
+		else if (arg == "--log")
+			linuxCfg.logLevel = atoi(val.c_str());
+		else if (arg == "--size")
+		{
+			if (sscanf(val.c_str(), "%dx%d", &linuxCfg.width, &linuxCfg.height) != 2 || linuxCfg.width <= 0 || linuxCfg.height <= 0)
+			{
+				fprintf(stderr, "bad output size %s\n", val.c_str());
+				return false;
+			}
+		}
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", arg.c_str());
+			return false;
+		}
+	}
+
+	// the game's shaders are packaged with the Android app, the engine's are built into it
+#ifdef CUBOINGO_SHADER_DIR
+	linuxCfg.shaderDirs.push_back(CUBOINGO_SHADER_DIR);
+#endif
+#ifdef MIGTECH_SHADER_DIR
+	linuxCfg.shaderDirs.push_back(MIGTECH_SHADER_DIR);
+#endif
+
+	return (linuxCfg.frames > 0 && linuxCfg.stepMs >= 0);
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	if (!parseArgs(argc, argv))
+	{
+		printUsage();
+		return 1;
+	}
+
+	LinuxUtil_setContentDir(linuxCfg.contentDir);
+	for (unsigned int i = 0; i < linuxCfg.shaderDirs.size(); i++)
+		LinuxUtil_addShaderDir(linuxCfg.shaderDirs[i]);
+	LinuxUtil_setFilesDir(".");
+	LinuxUtil_setFixedTimestep(Timer::milliSecondsToTicks(linuxCfg.stepMs));
+	LinuxUtil_setLogLevel(linuxCfg.logLevel);
+	MigUtil::seedRandom(linuxCfg.seed);
+
+	std::vector<FrameSample> samples;
+	int ret = 0;
+	if (LinuxApp_create() && LinuxApp_createGraphics(linuxCfg.width, linuxCfg.height))
+	{
+		samples.reserve(linuxCfg.frames);
+		for (int frame = 0; frame < linuxCfg.warmup + linuxCfg.frames; frame++)
+		{
+			std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+			if (!LinuxApp_step())
+				break;
+			std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+			LinuxApp_finish();
+			std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+			if (frame >= linuxCfg.warmup)
+			{
+				const OglRender* rend = (const OglRender*) MigUtil::theRend;
+
+				FrameSample sample;
+				sample.stepMs = elapsedMs(t0, t1);
+				sample.finishMs = elapsedMs(t1, t2);
+				sample.callsIssued = rend->getCallsIssued();
+				sample.callsElided = rend->getCallsElided();
+				samples.push_back(sample);
+			}
+		}
+	}
+
+	if (!LinuxApp_isRunning())
+	{
+		fprintf(stderr, "cuboingo_gl failed, see the log\n");
+		ret = 2;
+	}
+	LinuxApp_destroyGraphics();
+	LinuxApp_destroy();
+
+	if (!samples.empty())
+	{
+		reportSamples(samples);
+		if (!linuxCfg.csvPath.empty() && !writeSamples(samples, linuxCfg.csvPath))
+			fprintf(stderr, "unable to write %s\n", linuxCfg.csvPath.c_str());
+	}
+	return ret;
+}
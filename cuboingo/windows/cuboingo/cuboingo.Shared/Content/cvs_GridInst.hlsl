@@ -0,0 +1,66 @@
+// A constant buffer that stores the basic column-major matrices for composing geometry.
+cbuffer ShaderConstantBasic : register(b0)
+{
+	float4 color;
+	float4 misc;
+	int4 config;
+};
+
+// A constant buffer that stores the basic column-major matrices for composing geometry.
+cbuffer ShaderConstantMatrix : register(b1)
+{
+	matrix model;
+	matrix view;
+	matrix proj;
+	matrix mvp;
+};
+
+// Per-vertex data used as input to the vertex shader.
+struct VertexShaderInput
+{
+	float3 pos : POSITION;
+	float3 norm : NORMAL;
+	float2 uv : TEXCOORD0;
+};
+
+// Per-instance data used as input to the vertex shader (see InstanceData).
+struct InstanceInput
+{
+	float4 model0 : INSTMODEL0;
+	float4 model1 : INSTMODEL1;
+	float4 model2 : INSTMODEL2;
+	float4 model3 : INSTMODEL3;
+	float4 color : INSTCOLOR;
+};
+
+// Per-pixel color data passed through the pixel shader.
+struct PixelShaderInput
+{
+	float4 pos : SV_POSITION;
+	float2 uv : TEXCOORD0;
+	float4 color : COLOR0;
+};
+
+// Simple shader to do vertex processing on the GPU.
+PixelShaderInput main(VertexShaderInput input, InstanceInput inst)
+{
+	PixelShaderInput output;
+
+	// transform the vertex position by the instance model matrix, then into projected space
+	float4x4 instModel = float4x4(inst.model0, inst.model1, inst.model2, inst.model3);
+	float4 pos = mul(float4(input.pos, 1.0f), instModel);
+	output.pos = mul(mul(pos, view), proj);
+	output.color = inst.color;
+
+	// misc.x is the map index (-1 = no map, 0-7 otherwise)
+	// config.x is the rendering pass (0 = final)
+	if (misc.x != -1 && config.x == 0)
+	{
+		output.uv.x = 0.125*(misc.x + input.uv.x);
+		output.uv.y = input.uv.y;
+	}
+	else
+		output.uv.x = output.uv.y = -1;
+
+	return output;
+}
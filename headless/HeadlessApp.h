@@ -0,0 +1,16 @@
+﻿#pragma once
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+#include "pch.h"
+
+// configuration for the headless platform, set by the host program before the game engine starts
+void HeadlessUtil_setContentDir(const std::string& dir);
+void HeadlessUtil_setFilesDir(const std::string& dir);
+
+// a non-zero step makes the game timer advance by exactly that many ticks per frame
+void HeadlessUtil_setFixedTimestep(uint64 ticks);
+
+// log messages below this level (0=debug, 1=info, 2=warn, 3=error, 4=fatal) are dropped
+void HeadlessUtil_setLogLevel(int level);
@@ -0,0 +1,61 @@
+﻿#include "pch.h"
+#include "../core/MigUtil.h"
+#include "NullAudio.h"
+
+using namespace MigTech;
+
+NullAudio::NullAudio() : _soundVolume(1), _musicVolume(1)
+{
+}
+
+NullAudio::~NullAudio()
+{
+}
+
+bool NullAudio::initAudio()
+{
+	LOGINFO("(NullAudio::initAudio) Headless audio initialized");
+	return true;
+}
+
+void NullAudio::termAudio()
+{
+}
+
+void NullAudio::onSuspending()
+{
+}
+
+void NullAudio::onResuming()
+{
+}
+
+SoundEffect* NullAudio::loadMedia(const std::string& name, Channel channel)
+{
+	return new NullSoundEffect(name);
+}
+
+bool NullAudio::playMedia(const std::string& name, Channel channel)
+{
+	return true;
+}
+
+void NullAudio::deleteMedia(SoundEffect* pMedia)
+{
+	// SoundEffect doesn't have a virtual destructor
+	if (pMedia != nullptr)
+		delete (NullSoundEffect*)pMedia;
+}
+
+float NullAudio::getChannelVolume(Channel channel)
+{
+	return (channel == AUDIO_CHANNEL_MUSIC ? _musicVolume : _soundVolume);
+}
+
+void NullAudio::setChannelVolume(Channel channel, float volume)
+{
+	if (channel == AUDIO_CHANNEL_MUSIC)
+		_musicVolume = volume;
+	else if (channel == AUDIO_CHANNEL_SOUND)
+		_soundVolume = volume;
+}
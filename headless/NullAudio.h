@@ -0,0 +1,55 @@
+﻿#pragma once
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+#include "../core/AudioBase.h"
+
+namespace MigTech
+{
+	// a sound that keeps its state but never makes a sound
+	class NullSoundEffect : public SoundEffect
+	{
+	public:
+		NullSoundEffect(const std::string& name) : SoundEffect(name), _playing(false), _volume(1) { }
+
+		virtual void playSound(bool loop) { _playing = true; }
+		virtual void pauseSound() { _playing = false; }
+		virtual void resumeSound() { _playing = true; }
+		virtual void stopSound() { _playing = false; }
+		virtual bool isPlaying() { return _playing; }
+
+		virtual void setVolume(float volume) { _volume = volume; }
+		virtual void fadeVolume(float fade) { }
+		virtual float getVolume() { return _volume; }
+
+	protected:
+		bool _playing;
+		float _volume;
+	};
+
+	// headless version of the MigTech audio manager, for machines with no audio device
+	class NullAudio : public AudioBase
+	{
+	public:
+		NullAudio();
+		virtual ~NullAudio();
+
+		virtual bool initAudio();
+		virtual void termAudio();
+
+		virtual void onSuspending();
+		virtual void onResuming();
+
+		virtual SoundEffect* loadMedia(const std::string& name, Channel channel);
+		virtual bool playMedia(const std::string& name, Channel channel);
+		virtual void deleteMedia(SoundEffect* pMedia);
+
+		virtual float getChannelVolume(Channel channel);
+		virtual void setChannelVolume(Channel channel, float volume);
+
+	protected:
+		float _soundVolume;
+		float _musicVolume;
+	};
+}
@@ -0,0 +1,64 @@
+﻿#include "pch.h"
+#include "../core/MigUtil.h"
+#include "../core/MipChain.h"
+#include "NullImage.h"
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+using namespace MigTech;
+
+NullImage::NullImage() : _fmt(IMG_FORMAT_NONE)
+{
+}
+
+NullImage::~NullImage()
+{
+}
+
+void NullImage::loadTexture(IMG_FORMAT fmt, int width, int height, int mipLevels)
+{
+	if (fmt == IMG_FORMAT_NONE || width <= 0 || height <= 0)
+		throw std::invalid_argument("(NullImage::loadTexture) Invalid args");
+
+	_fmt = fmt;
+	_width = width;
+	_height = height;
+	_mipLevels = mipLevels;
+
+	// sized like the GLES renderer, RGB stays 3 bytes
+	int bpp = MipChain::getBytesPerPixel(fmt);
+	_byteSize = 0;
+	for (int level = 0; level < mipLevels; level++)
+		_byteSize += (unsigned int) (bpp*MipChain::getLevelDim(width, level)*MipChain::getLevelDim(height, level));
+}
+
+void NullImage::loadCompressedTexture(IMG_FORMAT fmt, int width, int height, unsigned int dataSize, int mipLevels)
+{
+	loadTexture(fmt, width, height, mipLevels);
+	_byteSize = dataSize;
+}
+
+NullRenderTarget::NullRenderTarget() : _depthBits(0)
+{
+	_caps = IMAGE_CAPS_RENDER_TARGET | IMAGE_CAPS_BOTTOM_UP;
+}
+
+NullRenderTarget::~NullRenderTarget()
+{
+}
+
+bool NullRenderTarget::init(IMG_FORMAT fmtHint, int width, int height, int depthBitsHint)
+{
+	if (fmtHint == IMG_FORMAT_NONE || width <= 0 || height <= 0)
+	{
+		LOGWARN("(NullRenderTarget::init) Invalid args");
+		return false;
+	}
+
+	loadTexture(fmtHint, width, height);
+	_depthBits = depthBitsHint;
+	if (depthBitsHint > 0)
+		_byteSize += (unsigned int) (2*width*height);
+	return true;
+}
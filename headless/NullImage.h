@@ -0,0 +1,40 @@
+﻿#pragma once
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+#include "../core/MigDefines.h"
+#include "../core/Image.h"
+
+namespace MigTech
+{
+	// headless version of a MigTech image map (dimensions only, no pixels)
+	class NullImage : public Image
+	{
+	protected:
+		IMG_FORMAT _fmt;
+
+	public:
+		NullImage();
+		virtual ~NullImage();
+
+		void loadTexture(IMG_FORMAT fmt, int width, int height, int mipLevels = 1);
+		void loadCompressedTexture(IMG_FORMAT fmt, int width, int height, unsigned int dataSize, int mipLevels);
+
+		IMG_FORMAT getFormat() const { return _fmt; }
+	};
+
+	// headless version of a render target
+	class NullRenderTarget : public NullImage
+	{
+	protected:
+		int _depthBits;
+
+	public:
+		NullRenderTarget();
+		virtual ~NullRenderTarget();
+
+		bool init(IMG_FORMAT fmtHint, int width, int height, int depthBitsHint);
+		int getDepthBits() const { return _depthBits; }
+	};
+}
@@ -0,0 +1,230 @@
+﻿#include "pch.h"
+#include "../core/MigUtil.h"
+#include "NullObject.h"
+#include "NullRender.h"
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+using namespace MigTech;
+
+static unsigned int vertexStride(VDTYPE vdType)
+{
+	switch (vdType)
+	{
+	case VDTYPE_POSITION: return sizeof(VertexPosition);
+	case VDTYPE_POSITION_COLOR: return sizeof(VertexPositionColor);
+	case VDTYPE_POSITION_COLOR_TEXTURE: return sizeof(VertexPositionColorTexture);
+	case VDTYPE_POSITION_NORMAL: return sizeof(VertexPositionNormal);
+	case VDTYPE_POSITION_NORMAL_TEXTURE: return sizeof(VertexPositionNormalTexture);
+	case VDTYPE_POSITION_TEXTURE: return sizeof(VertexPositionTexture);
+	case VDTYPE_POSITION_TEXTURE_TEXTURE: return sizeof(VertexPositionTextureTexture);
+	default: break;
+	}
+	return 0;
+}
+
+NullObject::NullObject() :
+	_vdType(VDTYPE_UNKNOWN),
+	_type(PRIMITIVE_TYPE_UNKNOWN),
+	_numPts(0),
+	_numInd(0),
+	_offInd(0),
+	_offIndCount(0),
+	_inRenderSet(false)
+{
+	memset(_mappings, 0, sizeof(_mappings));
+}
+
+NullObject::~NullObject()
+{
+}
+
+int NullObject::addShaderSet(const std::string& vs, const std::string& ps)
+{
+	NullShader* vertexShader = (NullShader*) MigUtil::theRend->getShader(vs);
+	if (vertexShader == nullptr)
+		throw std::invalid_argument("(NullObject::addShaderSet) Vertex shader doesn't exist");
+	if (vertexShader->getType() != Shader::SHADER_TYPE_VERTEX)
+		throw std::invalid_argument("(NullObject::addShaderSet) Specified shader isn't a vertex shader");
+
+	NullShader* pixelShader = (NullShader*) MigUtil::theRend->getShader(ps);
+	if (pixelShader == nullptr)
+		throw std::invalid_argument("(NullObject::addShaderSet) Pixel shader doesn't exist");
+	if (pixelShader->getType() != Shader::SHADER_TYPE_PIXEL)
+		throw std::invalid_argument("(NullObject::addShaderSet) Specified shader isn't a pixel shader");
+
+	NullShaderSet newSet;
+	newSet.vs = vertexShader;
+	newSet.ps = pixelShader;
+	_shaderSets.push_back(newSet);
+	return _shaderSets.size() - 1;
+}
+
+void NullObject::setImage(int index, const std::string& name, TXT_FILTER minFilter, TXT_FILTER magFilter, TXT_WRAP wrap)
+{
+	if (index < 0 || index >= MAX_TEXTURE_MAPS)
+		throw std::invalid_argument("(NullObject::setImage) Invalid index");
+	if (minFilter == TXT_FILTER_NONE || magFilter == TXT_FILTER_NONE)
+		throw std::invalid_argument("(NullObject::setImage) Invalid filter");
+	if (wrap == TXT_WRAP_NONE)
+		throw std::invalid_argument("(NullObject::setImage) Invalid wrap");
+
+	NullImage* pimg = (NullImage*) MigUtil::theRend->getImage(name);
+	if (pimg == nullptr)
+		throw std::invalid_argument("(NullObject::setImage) Invalid image");
+
+	_mappings[index].pimg = pimg;
+	_mappings[index].minFilter = minFilter;
+	_mappings[index].magFilter = magFilter;
+	_mappings[index].wrap = wrap;
+}
+
+void NullObject::loadVertexBuffer(const void* pdata, unsigned int count, VDTYPE vdType)
+{
+	if (pdata == nullptr || count == 0)
+		throw std::invalid_argument("(NullObject::loadVertexBuffer) Invalid vertex data");
+	if (vdType == VDTYPE_UNKNOWN)
+		throw std::invalid_argument("(NullObject::loadVertexBuffer) Invalid vertex data type");
+
+	_vdType = vdType;
+	_numPts = count;
+
+	NullRender* rendObj = (NullRender*)MigUtil::theRend;
+	rendObj->record(NULL_CMD_VERTEX_LOAD, this, count, count*vertexStride(vdType));
+}
+
+void NullObject::loadIndexBuffer(const unsigned short* indices, unsigned int count, PRIMITIVE_TYPE type)
+{
+	if (indices == nullptr || count == 0)
+		throw std::invalid_argument("(NullObject::loadIndexBuffer) Invalid vertex data");
+	if (type == PRIMITIVE_TYPE_UNKNOWN)
+		throw std::invalid_argument("(NullObject::loadIndexBuffer) Invalid primitive type");
+
+	_type = type;
+	_numInd = _offIndCount = count;
+	_offInd = 0;
+
+	NullRender* rendObj = (NullRender*)MigUtil::theRend;
+	rendObj->record(NULL_CMD_INDEX_LOAD, this, count, type);
+}
+
+void NullObject::setIndexOffset(unsigned int offset, unsigned int count)
+{
+	_offInd = offset;
+	_offIndCount = count;
+}
+
+int NullObject::getIndexOffset() const
+{
+	return _offInd;
+}
+
+int NullObject::getIndexCount() const
+{
+	return _offIndCount;
+}
+
+void NullObject::prepareRender(int shaderSet)
+{
+	NullRender* rendObj = (NullRender*)MigUtil::theRend;
+
+	// check to be sure the requested shader set has been loaded
+	if (shaderSet < 0 || shaderSet >= (int) _shaderSets.size())
+		throw std::invalid_argument("(NullObject::prepareRender) Invalid shader set");
+	if (_numPts == 0)
+		throw std::runtime_error("(NullObject::prepareRender) No vertex data loaded");
+
+	// activate the program
+	rendObj->record(NULL_CMD_PROGRAM, _shaderSets[shaderSet].vs, shaderSet, 0);
+
+	// bind the textures
+	for (int i = 0; i < MAX_TEXTURE_MAPS; i++)
+	{
+		if (_mappings[i].pimg != nullptr)
+		{
+			int bits = (_mappings[i].minFilter << 16) | (_mappings[i].magFilter << 8) | _mappings[i].wrap;
+			rendObj->record(NULL_CMD_TEXTURE, _mappings[i].pimg, i, bits);
+		}
+	}
+
+	rendObj->setFaceCulling(_cull);
+}
+
+void NullObject::render(int shaderSet)
+{
+	// the render queue will call back in here when it's submitted
+	if (MigUtil::theRend->queueDraw(this, shaderSet))
+		return;
+
+	// if we're not in a render sequence then prepare the render
+	if (!_inRenderSet)
+		prepareRender(shaderSet);
+
+	// the vertex shader hints decide which uniforms would be uploaded
+	NullRender* rendObj = (NullRender*)MigUtil::theRend;
+	rendObj->recordUniforms(_shaderSets[shaderSet].vs->getHints());
+
+	if (_numInd > 0)
+		rendObj->recordDraw(this, _offIndCount, _type);
+	else
+		rendObj->recordDraw(this, _numPts, PRIMITIVE_TYPE_TRIANGLE_LIST);
+	onDraw(shaderSet, nullptr, 0);
+}
+
+void NullObject::renderInstanced(int shaderSet, const InstanceData* instances, unsigned int count)
+{
+	if (instances == nullptr)
+		throw std::invalid_argument("(NullObject::renderInstanced) Invalid instance data");
+	if (count == 0)
+		return;
+	if (MigUtil::theRend->queueDrawInstanced(this, shaderSet, instances, count))
+		return;
+
+	// if we're not in a render sequence then prepare the render
+	if (!_inRenderSet)
+		prepareRender(shaderSet);
+
+	unsigned int hints = _shaderSets[shaderSet].vs->getHints();
+	if (!(hints & SHADER_HINT_INSTANCED))
+		throw std::invalid_argument("(NullObject::renderInstanced) Shader set doesn't take instance data");
+
+	// the instance data goes up as one buffer, the uniforms are shared by all instances
+	NullRender* rendObj = (NullRender*)MigUtil::theRend;
+	rendObj->record(NULL_CMD_VERTEX_LOAD, this, count, count*sizeof(InstanceData));
+	rendObj->recordUniforms(hints);
+
+	if (_numInd > 0)
+		rendObj->recordDraw(this, _offIndCount, _type, count);
+	else
+		rendObj->recordDraw(this, _numPts, PRIMITIVE_TYPE_TRIANGLE_LIST, count);
+	onDraw(shaderSet, instances, count);
+}
+
+void NullObject::startRenderSet(int shaderSet)
+{
+	// queued draws are prepared individually when they're submitted
+	if (MigUtil::theRend->isQueueing())
+		return;
+
+	prepareRender(shaderSet);
+
+	_inRenderSet = true;
+}
+
+void NullObject::stopRenderSet()
+{
+	_inRenderSet = false;
+}
+
+unsigned int NullObject::getStateKey(int shaderSet) const
+{
+	if (shaderSet < 0 || shaderSet >= (int)_shaderSets.size())
+		return 0;
+
+	// folds the shader and texture pointers, same as the D3D version
+	const NullShaderSet& shaderItem = _shaderSets[shaderSet];
+	size_t shaders = ((size_t)shaderItem.vs >> 4) ^ ((size_t)shaderItem.ps >> 4);
+	size_t txt = ((size_t)_mappings[0].pimg >> 4);
+	return (((unsigned int)(shaders ^ (shaders >> 16)) & 0xFFFF) << 16) | ((unsigned int)(txt ^ (txt >> 16)) & 0xFFFF);
+}
@@ -0,0 +1,73 @@
+﻿#pragma once
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+#include "../core/MigDefines.h"
+#include "../core/Object.h"
+#include "NullImage.h"
+#include "NullShader.h"
+
+namespace MigTech
+{
+	struct NullTxtMapping
+	{
+		NullImage* pimg;
+		TXT_FILTER minFilter;
+		TXT_FILTER magFilter;
+		TXT_WRAP wrap;
+	};
+
+	struct NullShaderSet
+	{
+		NullShader* vs;
+		NullShader* ps;
+	};
+
+	// headless version of a MigTech object
+	class NullObject : public Object
+	{
+	protected:
+		std::vector<NullShaderSet> _shaderSets;
+
+		// model data description (the data itself isn't kept)
+		VDTYPE _vdType;
+		PRIMITIVE_TYPE _type;
+		unsigned int _numPts;
+		unsigned int _numInd;
+		unsigned int _offInd;
+		unsigned int _offIndCount;
+
+		// texture mappings
+		NullTxtMapping _mappings[MAX_TEXTURE_MAPS];
+
+		bool _inRenderSet;
+
+	protected:
+		void prepareRender(int shaderSet);
+
+		// called once a draw has been recorded, while the state it was recorded with is still applied
+		virtual void onDraw(int shaderSet, const InstanceData* instances, unsigned int count) { }
+
+	public:
+		NullObject();
+		virtual ~NullObject();
+
+		virtual int addShaderSet(const std::string& vs, const std::string& ps);
+		virtual void setImage(int index, const std::string& name, TXT_FILTER minFilter, TXT_FILTER magFilter, TXT_WRAP wrap);
+		virtual void loadVertexBuffer(const void* pdata, unsigned int count, VDTYPE vdType);
+		virtual void loadIndexBuffer(const unsigned short* indices, unsigned int count, PRIMITIVE_TYPE type);
+
+		virtual void setIndexOffset(unsigned int offset, unsigned int count);
+		virtual int getIndexOffset() const;
+		virtual int getIndexCount() const;
+
+		virtual void render(int shaderSet = 0);
+		virtual void renderInstanced(int shaderSet, const InstanceData* instances, unsigned int count);
+
+		virtual void startRenderSet(int shaderSet = 0);
+		virtual void stopRenderSet();
+
+		virtual unsigned int getStateKey(int shaderSet) const;
+	};
+}
@@ -0,0 +1,667 @@
+﻿#include "pch.h"
+#include "../core/MigUtil.h"
+#include "../core/AssetLoader.h"
+#include "../core/ImageDecoder.h"
+#include "../core/KtxFile.h"
+#include "../core/MipChain.h"
+#include "NullRender.h"
+#include "NullShader.h"
+#include "NullObject.h"
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+using namespace MigTech;
+
+extern byte* plat_loadFileBuffer(const char* filePath, int& length);
+
+NullRender::NullRender() :
+	_outputSize(), _clearColor(0, 0, 0), _currPass(0), _keepLog(false)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		_misc[i] = 0;
+		_cfg[i] = 0;
+		_litIsDir[i] = true;
+	}
+}
+
+NullRender::~NullRender()
+{
+}
+
+void NullRender::createDeviceIndependentResources()
+{
+}
+
+void NullRender::createDeviceResources()
+{
+}
+
+void NullRender::createWindowSizeDependentResources()
+{
+}
+
+bool NullRender::initRenderer()
+{
+	LOGINFO("(NullRender::initRenderer) Headless renderer, nothing will be drawn");
+
+	// every compressed format is taken as is, like a device that supports them all
+	_compressionCaps = ((1 << TEX_COMPRESSION_COUNT) - 1) & ~(1 << TEX_COMPRESSION_NONE);
+
+	createDeviceIndependentResources();
+	createDeviceResources();
+
+	_log.reserve(4096);
+	resetStats();
+	return true;
+}
+
+void NullRender::termRenderer()
+{
+	{
+		std::map<std::string, NullShader*>::const_iterator iter;
+		for (iter = _shaders.begin(); iter != _shaders.end(); iter++)
+		{
+			delete iter->second;
+		}
+	}
+	_shaders.clear();
+
+	{
+		std::map<std::string, NullImage*>::const_iterator iter;
+		for (iter = _images.begin(); iter != _images.end(); iter++)
+		{
+			delete iter->second;
+		}
+	}
+	_images.clear();
+
+	_log.clear();
+}
+
+void NullRender::applyProjectionMatrix(const Matrix* pmat)
+{
+	if (pmat != nullptr)
+		_perspective = *pmat;
+	else
+		_perspective.identity();
+}
+
+void NullRender::applyProjectionMatrix(float angleY, float aspect, float nearZ, float farZ, bool useOrientation)
+{
+	_perspective.loadPerspectiveFovRH(angleY, aspect, nearZ, farZ);
+}
+
+void NullRender::applyViewMatrix(const Matrix* pmat)
+{
+	if (pmat != nullptr)
+		_view = *pmat;
+	else
+		_view.identity();
+}
+
+void NullRender::applyViewMatrix(Vector3 eyePos, Vector3 focusPos, Vector3 upVector)
+{
+	_view.loadLookAtRH(eyePos, focusPos, upVector);
+}
+
+void NullRender::applyModelMatrix(const Matrix* pmat)
+{
+	if (pmat != nullptr)
+		_model = *pmat;
+	else
+		_model.identity();
+}
+
+void NullRender::setOutputSize(Size newSize)
+{
+	_outputSize = newSize;
+
+	NullCommand& cmd = record(NULL_CMD_VIEWPORT, nullptr, 0, 0);
+	cmd.data[2] = newSize.width;
+	cmd.data[3] = newSize.height;
+}
+
+Size NullRender::getOutputSize()
+{
+	return _outputSize;
+}
+
+void NullRender::applyViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer)
+{
+	// reset the viewport
+	NullCommand& cmd = record(NULL_CMD_VIEWPORT, nullptr, 0, 0);
+	if (newPort != nullptr)
+	{
+		cmd.data[0] = newPort->corner.x * _outputSize.width;
+		cmd.data[1] = newPort->corner.y * _outputSize.height;
+		cmd.data[2] = newPort->size.width * _outputSize.width;
+		cmd.data[3] = newPort->size.height * _outputSize.height;
+	}
+	else
+	{
+		cmd.data[2] = _outputSize.width;
+		cmd.data[3] = _outputSize.height;
+	}
+
+	if (clearRenderBuffer || clearDepthBuffer)
+		record(NULL_CMD_CLEAR, nullptr, clearRenderBuffer, clearDepthBuffer);
+}
+
+Shader* NullRender::loadVertexShader(const std::string& name, VDTYPE vdType, unsigned int shaderHints)
+{
+	if (vdType == VDTYPE_UNKNOWN)
+		throw std::invalid_argument("(NullRender::loadVertexShader) No input layout specified");
+
+	// see if the shader already exists
+	Shader* ps = getShader(name);
+	if (ps != nullptr)
+	{
+		// must match requested shader type
+		if (ps->getType() != Shader::SHADER_TYPE_VERTEX)
+			throw std::runtime_error("(NullRender::loadVertexShader) Existing shader doesn't match requested shader type");
+		return ps;
+	}
+
+	// nothing to compile, the hints are all that matter
+	ps = new NullShader(Shader::SHADER_TYPE_VERTEX, vdType, shaderHints);
+	_shaders[name] = (NullShader*) ps;
+	return ps;
+}
+
+Shader* NullRender::loadPixelShader(const std::string& name, unsigned int shaderHints)
+{
+	// see if the shader already exists
+	Shader* ps = getShader(name);
+	if (ps != nullptr)
+	{
+		// must match requested shader type
+		if (ps->getType() != Shader::SHADER_TYPE_PIXEL)
+			throw std::runtime_error("(NullRender::loadPixelShader) Existing shader doesn't match requested shader type");
+		return ps;
+	}
+
+	ps = new NullShader(Shader::SHADER_TYPE_PIXEL, VDTYPE_UNKNOWN, shaderHints);
+	_shaders[name] = (NullShader*) ps;
+	return ps;
+}
+
+Shader* NullRender::getShader(const std::string& name)
+{
+	std::map<std::string, NullShader*>::const_iterator iter = _shaders.find(name);
+	if (iter != _shaders.end() && iter->second != nullptr)
+		return iter->second;
+	return nullptr;
+}
+
+static int readBigEndian(const byte* pdata, int size)
+{
+	int val = 0;
+	for (int i = 0; i < size; i++)
+		val = (val << 8) | pdata[i];
+	return val;
+}
+
+// reads the dimensions out of the JPEG start of frame marker, the image isn't decoded
+static bool readJPEGHeader(const byte* pFile, int len, int& width, int& height)
+{
+	if (len < 4 || pFile[0] != 0xFF || pFile[1] != 0xD8)
+		return false;
+
+	int pos = 2;
+	while (pos + 9 < len)
+	{
+		if (pFile[pos] != 0xFF)
+			return false;
+		byte marker = pFile[pos + 1];
+		if (marker == 0xFF)
+		{
+			// fill byte
+			pos++;
+			continue;
+		}
+
+		// any SOFn marker except DHT (C4), JPG (C8) and DAC (CC)
+		if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+		{
+			height = readBigEndian(&pFile[pos + 5], 2);
+			width = readBigEndian(&pFile[pos + 7], 2);
+			return (width > 0 && height > 0);
+		}
+
+		pos += 2 + readBigEndian(&pFile[pos + 2], 2);
+	}
+	return false;
+}
+
+// reads the dimensions and color type out of the PNG IHDR chunk, the image isn't decoded
+static bool readPNGHeader(const byte* pFile, int len, int& width, int& height, int& colorType)
+{
+	static const byte pngSig[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+	if (len < 26 || memcmp(pFile, pngSig, 8) != 0 || memcmp(&pFile[12], "IHDR", 4) != 0)
+		return false;
+
+	width = readBigEndian(&pFile[16], 4);
+	height = readBigEndian(&pFile[20], 4);
+	colorType = pFile[25];
+	return (width > 0 && height > 0);
+}
+
+static bool loadImageHeader(const std::string& name, bool isPNG, unsigned int loadFlags, const Size& fitSize, ImageData& data)
+{
+	int len = 0;
+	byte* pFile = plat_loadFileBuffer(name.c_str(), len);
+	if (pFile == nullptr)
+	{
+		LOGWARN("(NullRender::loadImageHeader) image '%s' doesn't exist", name.c_str());
+		return false;
+	}
+
+	int width = 0, height = 0, colorType = 2;
+	bool isValid = (isPNG ? readPNGHeader(pFile, len, width, height, colorType) : readJPEGHeader(pFile, len, width, height));
+	delete [] pFile;
+	if (!isValid)
+	{
+		LOGWARN("(NullRender::loadImageHeader) image '%s' has an unrecognized header", name.c_str());
+		return false;
+	}
+
+	// JPEGs come out at the size libjpeg would scale them to
+	int scale = 1;
+	if (!isPNG && (loadFlags & LOAD_IMAGE_FIT_OUTPUT))
+	{
+		scale = ImageDecoder::getFitScale(width, height, fitSize);
+		width = ImageDecoder::getScaledDim(width, scale);
+		height = ImageDecoder::getScaledDim(height, scale);
+	}
+	LOGINFO("(NullRender::loadImageHeader) Image=%s, w=%d, h=%d, scale=1/%d", name.c_str(), width, height, scale);
+
+	// same output formats the real loaders would produce
+	IMG_FORMAT fmt = IMG_FORMAT_RGBA;
+	if (loadFlags & LOAD_IMAGE_DROP_COLOR)
+		fmt = IMG_FORMAT_ALPHA;
+	else if (!isPNG && (loadFlags & LOAD_IMAGE_PIXEL_FLAGS) == 0)
+		fmt = IMG_FORMAT_RGB;
+	else if (isPNG && colorType == 0)
+		fmt = IMG_FORMAT_GREYSCALE;
+
+	// there are never any pixels
+	data.format = fmt;
+	data.width = width;
+	data.height = height;
+	data.decodeScale = scale;
+	return true;
+}
+
+Image* NullRender::loadNewImage(const std::string& name, const std::string& path, unsigned int loadFlags)
+{
+	// see if the image already exists
+	Image* pi = findImage(name);
+	if (pi != nullptr)
+		return pi;
+
+	ImageData data;
+	if (!decodeImage(path, loadFlags, getOutputSize(), data))
+		return nullptr;
+	AssetLoader::recordImage(path, loadFlags, data);
+
+	NullImage* newImage = new NullImage();
+	uploadImage(newImage, data);
+	data.release();
+	_images[name] = newImage;
+
+	return newImage;
+}
+
+// this is called from the asset loader threads
+bool NullRender::decodeImage(const std::string& path, unsigned int loadFlags, const Size& fitSize, ImageData& data)
+{
+	bool decoded = false;
+	size_t findDot = path.rfind(".");
+	if (findDot != std::string::npos)
+	{
+		std::string ext = path.substr(findDot + 1);
+		if (0 == ext.compare("jpg") ||
+			0 == ext.compare("jpeg"))
+		{
+			decoded = loadImageHeader(path, false, loadFlags, fitSize, data);
+		}
+		else if (0 == ext.compare("png"))
+		{
+			decoded = loadImageHeader(path, true, loadFlags, fitSize, data);
+		}
+		else if (0 == ext.compare("ktx") ||
+			0 == ext.compare("ktx2"))
+		{
+			decoded = KtxFile::loadImage(path, loadFlags, _compressionCaps, data);
+		}
+	}
+
+	// headers only, so there's nothing to filter, but the chain still counts toward the texture memory
+	if (decoded && (loadFlags & LOAD_IMAGE_MIPMAPS))
+	{
+		if (data.pixels != nullptr)
+			MipChain::generate(data);
+		else if (!data.isCompressed())
+			data.mipLevels = MipChain::getFullLevelCount(data.width, data.height);
+	}
+	return decoded;
+}
+
+void NullRender::uploadImage(Image* img, const ImageData& data)
+{
+	if (data.isCompressed())
+		((NullImage*)img)->loadCompressedTexture(data.format, data.width, data.height, data.dataSize, data.mipLevels);
+	else
+		((NullImage*)img)->loadTexture(data.format, data.width, data.height, data.mipLevels);
+}
+
+Image* NullRender::createPendingImage(const std::string& name)
+{
+	NullImage* newImage = new NullImage();
+	_images[name] = newImage;
+	return newImage;
+}
+
+Image* NullRender::findImage(const std::string& name)
+{
+	std::map<std::string, NullImage*>::const_iterator iter = _images.find(name);
+	if (iter != _images.end() && iter->second != nullptr)
+		return iter->second;
+	return nullptr;
+}
+
+Image* NullRender::createNewRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint)
+{
+	// if the render target already exists, that is considered an error
+	if (findImage(name) != nullptr)
+		return nullptr;
+
+	NullRenderTarget* newTarget = new NullRenderTarget();
+	if (!newTarget->init(fmtHint, width, height, depthBitsHint))
+	{
+		delete newTarget;
+		return nullptr;
+	}
+
+	_images[name] = newTarget;
+	return newTarget;
+}
+
+void NullRender::destroyImage(const std::string& name)
+{
+	std::map<std::string, NullImage*>::iterator iter = _images.find(name);
+	if (iter != _images.end() && iter->second != nullptr)
+	{
+		delete iter->second;
+		_images.erase(iter);
+	}
+}
+
+Object* NullRender::createObject()
+{
+	return new NullObject();
+}
+
+void NullRender::deleteObject(Object* pobj)
+{
+	delete (NullObject*)pobj;
+}
+
+void NullRender::setClearColor(const Color& clearCol)
+{
+	_clearColor = clearCol;
+}
+
+void NullRender::applyObjectColor(const Color& objCol)
+{
+	_objColor = objCol;
+}
+
+void NullRender::applyBlending(BLEND_STATE blend)
+{
+	record(NULL_CMD_BLEND, nullptr, blend, 0);
+}
+
+void NullRender::applyDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite)
+{
+	record(NULL_CMD_DEPTH, nullptr, depth, enableWrite);
+}
+
+void NullRender::setFaceCulling(FACE_CULLING cull)
+{
+	record(NULL_CMD_CULL, nullptr, cull, 0);
+}
+
+void NullRender::applyMiscValue(int index, float value)
+{
+	if (index < 0 || index > 3)
+		throw std::out_of_range("(NullRender::setMiscValue) Misc index out of bounds");
+	_misc[index] = value;
+}
+
+void NullRender::applyAmbientColor(const Color& ambientCol)
+{
+	_ambColor = ambientCol;
+}
+
+void NullRender::applyLightColor(int index, const Color& litCol)
+{
+	if (index < 0 || index > 3)
+		throw std::out_of_range("(NullRender::setLightColor) Light index out of bounds");
+	_litColor[index] = litCol;
+}
+
+void NullRender::applyLightDirPos(int index, const Vector3& litDirPos, bool isDir)
+{
+	if (index < 0 || index > 3)
+		throw std::out_of_range("(NullRender::setLightDirPos) Light index out of bounds");
+	_litDirPos[index] = litDirPos;
+	_litIsDir[index] = isDir;
+}
+
+void NullRender::onSuspending()
+{
+}
+
+void NullRender::onResuming()
+{
+}
+
+void NullRender::preRender(int pass, RenderPass* passObj)
+{
+	unsigned int configBits = 0;
+	if (pass > 0 && passObj != nullptr)
+		configBits = passObj->getConfigBits();
+
+	// get render target
+	Image* target = nullptr;
+	if (configBits & RenderPass::USE_RENDER_TARGET)
+		target = passObj->getRenderTarget();
+
+	_currPass = pass;
+	record(NULL_CMD_PASS_BEGIN, target, pass, configBits);
+	_frameStats.passes++;
+
+	// match the viewport to the render target or pass
+	NullCommand& vp = record(NULL_CMD_VIEWPORT, nullptr, 0, 0);
+	if (target != nullptr)
+	{
+		vp.data[2] = (float) target->getWidth();
+		vp.data[3] = (float) target->getHeight();
+	}
+	else if (configBits & RenderPass::USE_VIEW_PORT)
+	{
+		const Rect& viewPort = passObj->getViewPort();
+		vp.data[0] = viewPort.corner.x * _outputSize.width;
+		vp.data[1] = viewPort.corner.y * _outputSize.height;
+		vp.data[2] = viewPort.size.width * _outputSize.width;
+		vp.data[3] = viewPort.size.height * _outputSize.height;
+	}
+	else
+	{
+		vp.data[2] = _outputSize.width;
+		vp.data[3] = _outputSize.height;
+	}
+
+	// clear the render target buffers
+	bool clearColor = (pass == 0 || (configBits & RenderPass::USE_CLEAR_COLOR));
+	bool clearDepth = (pass == 0 || (configBits & RenderPass::USE_CLEAR_DEPTH));
+	if (clearColor || clearDepth)
+	{
+		const Color& col = ((configBits & RenderPass::USE_CLEAR_COLOR) ? passObj->getClearColor() : _clearColor);
+		NullCommand& cmd = record(NULL_CMD_CLEAR, nullptr, clearColor, clearDepth);
+		cmd.data[0] = col.r;
+		cmd.data[1] = col.g;
+		cmd.data[2] = col.b;
+		cmd.data[3] = col.a;
+	}
+
+	// first config int will contain the pass (1 based, 0 means final pass, -1 means overlay pass)
+	_cfg[0] = pass;
+}
+
+void NullRender::postRender(int pass, RenderPass* passObj)
+{
+	record(NULL_CMD_PASS_END, nullptr, pass, 0);
+}
+
+static void addStats(NullFrameStats& total, const NullFrameStats& frame)
+{
+	total.commands += frame.commands;
+	total.passes += frame.passes;
+	total.drawCalls += frame.drawCalls;
+	total.instances += frame.instances;
+	total.stateChanges += frame.stateChanges;
+	total.programChanges += frame.programChanges;
+	total.textureBinds += frame.textureBinds;
+	total.uniformUploads += frame.uniformUploads;
+	total.bufferUploads += frame.bufferUploads;
+	total.indices += frame.indices;
+	total.triangles += frame.triangles;
+}
+
+void NullRender::present()
+{
+	record(NULL_CMD_PRESENT, nullptr, _frameStats.frame, 0);
+
+	// roll the frame stats over
+	addStats(_totalStats, _frameStats);
+	_totalStats.frame = _frameStats.frame + 1;
+	_lastStats = _frameStats;
+	_frameStats = NullFrameStats();
+	_frameStats.frame = _lastStats.frame + 1;
+
+	if (!_keepLog)
+		_log.clear();
+}
+
+NullCommand& NullRender::record(NULL_CMD_TYPE type, const void* obj, int arg0, int arg1)
+{
+	_log.push_back(NullCommand());
+	NullCommand& cmd = _log.back();
+	memset(&cmd, 0, sizeof(NullCommand));
+	cmd.type = type;
+	cmd.pass = _currPass;
+	cmd.obj = obj;
+	cmd.arg0 = arg0;
+	cmd.arg1 = arg1;
+
+	_frameStats.commands++;
+	switch (type)
+	{
+	case NULL_CMD_BLEND:
+	case NULL_CMD_DEPTH:
+	case NULL_CMD_CULL:
+	case NULL_CMD_VIEWPORT:
+		_frameStats.stateChanges++;
+		break;
+	case NULL_CMD_PROGRAM:
+		_frameStats.stateChanges++;
+		_frameStats.programChanges++;
+		break;
+	case NULL_CMD_TEXTURE:
+		_frameStats.stateChanges++;
+		_frameStats.textureBinds++;
+		break;
+	case NULL_CMD_UNIFORM:
+		_frameStats.uniformUploads++;
+		break;
+	case NULL_CMD_VERTEX_LOAD:
+	case NULL_CMD_INDEX_LOAD:
+		_frameStats.bufferUploads++;
+		break;
+	default:
+		break;
+	}
+	return cmd;
+}
+
+static void copyColor(float* pdst, const Color& col)
+{
+	pdst[0] = col.r;
+	pdst[1] = col.g;
+	pdst[2] = col.b;
+	pdst[3] = col.a;
+}
+
+void NullRender::recordUniforms(unsigned int shaderHints)
+{
+	// basic object configuration
+	copyColor(record(NULL_CMD_UNIFORM, nullptr, NULL_UNIFORM_OBJECT_COLOR, 0).data, _objColor);
+	memcpy(record(NULL_CMD_UNIFORM, nullptr, NULL_UNIFORM_MISC, 0).data, _misc, sizeof(_misc));
+	float* pcfg = record(NULL_CMD_UNIFORM, nullptr, NULL_UNIFORM_CONFIG, 0).data;
+	for (int i = 0; i < 4; i++)
+		pcfg[i] = (float) _cfg[i];
+
+	// matrices
+	if (shaderHints & SHADER_HINT_MODEL)
+		memcpy(record(NULL_CMD_UNIFORM, nullptr, NULL_UNIFORM_MODEL, 0).data, _model.getData(), 16 * sizeof(float));
+	if (shaderHints & SHADER_HINT_VIEW)
+		memcpy(record(NULL_CMD_UNIFORM, nullptr, NULL_UNIFORM_VIEW, 0).data, _view.getData(), 16 * sizeof(float));
+	if (shaderHints & SHADER_HINT_PROJ)
+		memcpy(record(NULL_CMD_UNIFORM, nullptr, NULL_UNIFORM_PROJ, 0).data, _perspective.getData(), 16 * sizeof(float));
+	if (shaderHints & SHADER_HINT_MVP)
+	{
+		Matrix mvp;
+		Matrix::multiply(_model, _view, mvp);
+		mvp.multiply(_perspective);
+		memcpy(record(NULL_CMD_UNIFORM, nullptr, NULL_UNIFORM_MVP, 0).data, mvp.getData(), 16 * sizeof(float));
+	}
+
+	// lights
+	if (shaderHints & SHADER_HINT_LIGHTS)
+	{
+		copyColor(record(NULL_CMD_UNIFORM, nullptr, NULL_UNIFORM_AMBIENT, 0).data, _ambColor);
+		for (int i = 0; i < 4; i++)
+		{
+			copyColor(record(NULL_CMD_UNIFORM, nullptr, NULL_UNIFORM_LIGHT_COLOR, i).data, _litColor[i]);
+			float* pdata = record(NULL_CMD_UNIFORM, nullptr, NULL_UNIFORM_LIGHT_DIRPOS, i).data;
+			pdata[0] = _litDirPos[i].x;
+			pdata[1] = _litDirPos[i].y;
+			pdata[2] = _litDirPos[i].z;
+			pdata[3] = (_litIsDir[i] ? 0.0f : 1.0f);
+		}
+	}
+}
+
+void NullRender::recordDraw(const void* obj, unsigned int count, PRIMITIVE_TYPE type, unsigned int instances)
+{
+	record(NULL_CMD_DRAW, obj, count, type).data[0] = (float) instances;
+
+	_frameStats.drawCalls++;
+	_frameStats.instances += instances;
+	_frameStats.indices += count * instances;
+	if (type == PRIMITIVE_TYPE_TRIANGLE_LIST)
+		_frameStats.triangles += (count / 3) * instances;
+	else if (count > 2)
+		_frameStats.triangles += (count - 2) * instances;
+}
+
+void NullRender::resetStats()
+{
+	_frameStats = NullFrameStats();
+	_lastStats = NullFrameStats();
+	_totalStats = NullFrameStats();
+}
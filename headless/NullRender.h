@@ -0,0 +1,185 @@
+﻿#pragma once
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+#include <map>
+
+#include "../core/MigDefines.h"
+#include "../core/RenderBase.h"
+#include "NullShader.h"
+#include "NullImage.h"
+
+namespace MigTech
+{
+	// types of commands recorded by the headless renderer
+	enum NULL_CMD_TYPE
+	{
+		NULL_CMD_NONE,
+		NULL_CMD_PASS_BEGIN,		// arg0=pass, arg1=config bits, obj=render target
+		NULL_CMD_PASS_END,			// arg0=pass
+		NULL_CMD_VIEWPORT,			// data[0..3]=pixel rect
+		NULL_CMD_CLEAR,				// arg0=clear color, arg1=clear depth, data[0..3]=color
+		NULL_CMD_BLEND,				// arg0=BLEND_STATE
+		NULL_CMD_DEPTH,				// arg0=DEPTH_TEST_STATE, arg1=write enable
+		NULL_CMD_CULL,				// arg0=FACE_CULLING
+		NULL_CMD_PROGRAM,			// obj=vertex shader, arg0=shader set
+		NULL_CMD_TEXTURE,			// obj=image, arg0=texture unit, arg1=filter/wrap bits
+		NULL_CMD_UNIFORM,			// arg0=NULL_UNIFORM, arg1=index, data=values
+		NULL_CMD_VERTEX_LOAD,		// obj=object, arg0=vertex count, arg1=byte size
+		NULL_CMD_INDEX_LOAD,		// obj=object, arg0=index count, arg1=PRIMITIVE_TYPE
+		NULL_CMD_DRAW,				// obj=object, arg0=index count, arg1=PRIMITIVE_TYPE
+		NULL_CMD_PRESENT			// arg0=frame number
+	};
+
+	// uniforms that a draw call would upload
+	enum NULL_UNIFORM
+	{
+		NULL_UNIFORM_OBJECT_COLOR,
+		NULL_UNIFORM_MISC,
+		NULL_UNIFORM_CONFIG,
+		NULL_UNIFORM_MODEL,
+		NULL_UNIFORM_VIEW,
+		NULL_UNIFORM_PROJ,
+		NULL_UNIFORM_MVP,
+		NULL_UNIFORM_AMBIENT,
+		NULL_UNIFORM_LIGHT_COLOR,
+		NULL_UNIFORM_LIGHT_DIRPOS
+	};
+
+	// a single recorded command
+	struct NullCommand
+	{
+		NULL_CMD_TYPE type;
+		int pass;
+		const void* obj;
+		int arg0;
+		int arg1;
+		float data[16];		// for draws, data[0] is the instance count
+	};
+
+	// per frame counters, updated as commands are recorded
+	struct NullFrameStats
+	{
+		unsigned int frame;
+		unsigned int commands;
+		unsigned int passes;
+		unsigned int drawCalls;
+		unsigned int instances;
+		unsigned int stateChanges;
+		unsigned int programChanges;
+		unsigned int textureBinds;
+		unsigned int uniformUploads;
+		unsigned int bufferUploads;
+		unsigned int indices;
+		unsigned int triangles;
+
+		NullFrameStats() { memset(this, 0, sizeof(NullFrameStats)); }
+	};
+
+	// headless version of the MigTech renderer, nothing is drawn but everything is recorded
+	class NullRender : public RenderBase
+	{
+	protected:
+		virtual void createDeviceIndependentResources();
+		virtual void createDeviceResources();
+		virtual void createWindowSizeDependentResources();
+		virtual Image* loadNewImage(const std::string& name, const std::string& path, unsigned int loadFlags);
+		virtual Image* createNewRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint);
+		virtual void destroyImage(const std::string& name);
+		virtual Image* findImage(const std::string& name);
+		virtual Image* createPendingImage(const std::string& name);
+
+		virtual void applyProjectionMatrix(const Matrix* pmat);
+		virtual void applyProjectionMatrix(float angleY, float aspect, float nearZ, float farZ, bool useOrientation);
+		virtual void applyViewMatrix(const Matrix* pmat);
+		virtual void applyViewMatrix(Vector3 eyePos, Vector3 focusPos, Vector3 upVector);
+		virtual void applyModelMatrix(const Matrix* pmat);
+		virtual void applyViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer);
+		virtual void applyObjectColor(const Color& objCol);
+		virtual void applyBlending(BLEND_STATE blend);
+		virtual void applyDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite);
+		virtual void applyMiscValue(int index, float value);
+		virtual void applyAmbientColor(const Color& ambientCol);
+		virtual void applyLightColor(int index, const Color& litCol);
+		virtual void applyLightDirPos(int index, const Vector3& litDirPos, bool isDir);
+
+	public:
+		NullRender();
+		virtual ~NullRender();
+
+		virtual bool initRenderer();
+		virtual void termRenderer();
+
+		virtual Shader* loadVertexShader(const std::string& name, VDTYPE vdType, unsigned int shaderHints);
+		virtual Shader* loadPixelShader(const std::string& name, unsigned int shaderHints);
+		virtual Shader* getShader(const std::string& name);
+
+		virtual bool decodeImage(const std::string& path, unsigned int loadFlags, const Size& fitSize, ImageData& data);
+		virtual void uploadImage(Image* img, const ImageData& data);
+
+		virtual Object* createObject();
+		virtual void deleteObject(Object* pobj);
+
+		virtual void setOutputSize(Size newSize);
+		virtual Size getOutputSize();
+
+		virtual void setClearColor(const Color& clearCol);
+		virtual void setFaceCulling(FACE_CULLING cull);
+
+		virtual void onSuspending();
+		virtual void onResuming();
+
+		virtual void preRender(int pass, RenderPass* passObj);
+		virtual void postRender(int pass, RenderPass* passObj);
+		virtual void present();
+
+	public:
+		// headless specific
+		NullCommand& record(NULL_CMD_TYPE type, const void* obj, int arg0, int arg1);
+		void recordUniforms(unsigned int shaderHints);
+		void recordDraw(const void* obj, unsigned int count, PRIMITIVE_TYPE type, unsigned int instances = 1);
+
+		// the command log is cleared on present() unless it is being kept
+		const std::vector<NullCommand>& getCommandLog() const { return _log; }
+		void clearCommandLog() { _log.clear(); }
+		void setKeepCommandLog(bool keep) { _keepLog = keep; }
+
+		// stats for the frame in progress, the last presented frame and all frames
+		const NullFrameStats& getFrameStats() const { return _frameStats; }
+		const NullFrameStats& getLastFrameStats() const { return _lastStats; }
+		const NullFrameStats& getTotalStats() const { return _totalStats; }
+		void resetStats();
+
+	protected:
+		// Cached device properties.
+		Size	_outputSize;
+		Color   _clearColor;
+		Color   _objColor;
+		float	_misc[4];
+		int		_cfg[4];
+		Color   _ambColor;
+		Color   _litColor[4];
+		Vector3 _litDirPos[4];
+		bool    _litIsDir[4];
+		int		_currPass;
+
+		// Supported matrices
+		Matrix _perspective;
+		Matrix _view;
+		Matrix _model;
+
+		// Shader list
+		std::map<std::string, NullShader*> _shaders;
+
+		// Image map list
+		std::map<std::string, NullImage*> _images;
+
+		// Command log and counters
+		std::vector<NullCommand> _log;
+		bool _keepLog;
+		NullFrameStats _frameStats;
+		NullFrameStats _lastStats;
+		NullFrameStats _totalStats;
+	};
+}
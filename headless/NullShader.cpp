@@ -0,0 +1,23 @@
+﻿#include "pch.h"
+#include "NullShader.h"
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+using namespace MigTech;
+
+NullShader::NullShader(Type type, VDTYPE vdType, unsigned int hints) :
+	Shader(hints)
+{
+	_typeShader = type;
+	_vdType = vdType;
+}
+
+NullShader::~NullShader()
+{
+}
+
+Shader::Type NullShader::getType()
+{
+	return _typeShader;
+}
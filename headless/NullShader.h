@@ -0,0 +1,27 @@
+﻿#pragma once
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+#include "../core/MigDefines.h"
+#include "../core/Shader.h"
+
+namespace MigTech
+{
+	// headless version of the MigTech shader (nothing is compiled)
+	class NullShader : public Shader
+	{
+	protected:
+		Type _typeShader;
+		VDTYPE _vdType;
+
+	public:
+		VDTYPE getInputLayout() const { return _vdType; }
+
+	public:
+		NullShader(Type type, VDTYPE vdType, unsigned int hints);
+		virtual ~NullShader();
+
+		virtual Type getType();
+	};
+}
@@ -0,0 +1,168 @@
+﻿#include "pch.h"
+#include "../core/MigUtil.h"
+#include "../core/Timer.h"
+#include "HeadlessApp.h"
+
+#include <sys/stat.h>
+
+using namespace MigTech;
+
+///////////////////////////////////////////////////////////////////////////
+// headless configuration
+
+static std::string hlContentDir;
+static std::string hlFilesDir = ".";
+static uint64 hlFixedStep = 0;
+static int hlLogLevel = 1;
+
+void HeadlessUtil_setContentDir(const std::string& dir)
+{
+	hlContentDir = dir;
+	if (!hlContentDir.empty() && hlContentDir[hlContentDir.length() - 1] != '/')
+		hlContentDir += "/";
+}
+
+void HeadlessUtil_setFilesDir(const std::string& dir)
+{
+	hlFilesDir = dir;
+}
+
+void HeadlessUtil_setFixedTimestep(uint64 ticks)
+{
+	hlFixedStep = ticks;
+}
+
+void HeadlessUtil_setLogLevel(int level)
+{
+	hlLogLevel = level;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific configuration bits
+
+unsigned int plat_getBits()
+{
+	return PLAT_HEADLESS;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific timer functions
+
+static double startTime;
+static double lastTime;
+static double maxDelta;
+static uint64 totalTicks;
+
+static double getMonotonicTime()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1E9;
+}
+
+bool plat_initTimer()
+{
+	startTime = getMonotonicTime();
+	lastTime = startTime;
+	totalTicks = 0;
+
+	maxDelta = 0.1;
+	return true;
+}
+
+uint64 plat_getRawTicks()
+{
+	// the raw ticks are always wall clock, they're used for profiling and the watchdog
+	double timeDelta = getMonotonicTime() - startTime;
+	return (uint64)(timeDelta * Timer::ticksPerSecond);
+}
+
+uint64 plat_getCurrentTicks()
+{
+	// fixed timestep, so a run is the same no matter how long each frame really took
+	if (hlFixedStep > 0)
+	{
+		totalTicks += hlFixedStep;
+		return totalTicks;
+	}
+
+	// compute elapsed time since last update
+	double currentTime = getMonotonicTime();
+	double timeDelta = currentTime - lastTime;
+	lastTime = currentTime;
+
+	// clamp excessively large time deltas (e.g. after paused in the debugger)
+	if (timeDelta > maxDelta)
+		timeDelta = maxDelta;
+
+	totalTicks += (uint64)(timeDelta * Timer::ticksPerSecond);
+	return totalTicks;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific logging functions
+
+bool plat_isDebuggerPresent()
+{
+	// log output goes to stderr
+	return true;
+}
+
+void plat_outputDebugString(const char* msg, int level)
+{
+	static const char prefix[] = { 'd', 'i', 'w', 'e', 'f' };
+
+	if (level >= hlLogLevel)
+		fprintf(stderr, "[%c] %s\n", (level >= 0 && level < (int)sizeof(prefix) ? prefix[level] : '?'), msg);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific file IO utilities
+
+byte* plat_loadFileBuffer(const char* filePath, int& length)
+{
+	length = 0;
+
+	// compose the full path name
+	std::string fullPath = hlContentDir + filePath;
+
+	// retrieve the file size
+	struct stat st;
+	if (stat(fullPath.c_str(), &st) != 0)
+	{
+		LOGWARN("(::plat_loadFileBuffer) file '%s' doesn't exist", filePath);
+		return nullptr;
+	}
+
+	FILE* pf = fopen(fullPath.c_str(), "rb");
+	if (pf == nullptr)
+	{
+		LOGWARN("(::plat_loadFileBuffer) Could not open file %s", filePath);
+		return nullptr;
+	}
+
+	byte* pFile = new byte[st.st_size];
+	if (fread(pFile, 1, st.st_size, pf) < (size_t)st.st_size)
+	{
+		LOGWARN("(::plat_loadFileBuffer) Could not read file %s", filePath);
+		delete [] pFile;
+		pFile = nullptr;
+	}
+	else
+		length = st.st_size;
+
+	fclose(pf);
+	return pFile;
+}
+
+const std::string& plat_getFilesDir()
+{
+	return hlFilesDir;
+}
+
+const std::string& plat_getExternalFilesDir()
+{
+	// there is no external storage
+	static std::string externalDir;
+	return externalDir;
+}
@@ -0,0 +1,329 @@
+﻿#include "pch.h"
+#include "../core/MigUtil.h"
+#include "../core/MipChain.h"
+#include "SoftImage.h"
+
+#include <algorithm>
+
+extern "C" {
+#include "../core/libpng/png.h"
+}
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+using namespace MigTech;
+
+SoftImage::SoftImage()
+{
+}
+
+SoftImage::~SoftImage()
+{
+}
+
+static unsigned int makeTexel(byte r, byte g, byte b, byte a)
+{
+	return (unsigned int) r | ((unsigned int) g << 8) | ((unsigned int) b << 16) | ((unsigned int) a << 24);
+}
+
+void SoftImage::loadPixels(const ImageData& data)
+{
+	_texels.clear();
+	_levelOffset.clear();
+	if (data.pixels == nullptr)
+		return;
+	if (data.isCompressed())
+	{
+		LOGWARN("(SoftImage::loadPixels) Compressed texture data can't be sampled");
+		return;
+	}
+
+	// levels are packed one after another in both
+	int bpp = MipChain::getBytesPerPixel(data.format);
+	for (int level = 0; level < data.mipLevels; level++)
+	{
+		_levelOffset.push_back((unsigned int) _texels.size());
+
+		int count = MipChain::getLevelDim(data.width, level) * MipChain::getLevelDim(data.height, level);
+		const byte* psrc = data.pixels + MipChain::getLevelOffset(data, level);
+		for (int i = 0; i < count; i++, psrc += bpp)
+		{
+			switch (data.format)
+			{
+			case IMG_FORMAT_GREYSCALE: _texels.push_back(makeTexel(psrc[0], psrc[0], psrc[0], 255)); break;
+			case IMG_FORMAT_ALPHA: _texels.push_back(makeTexel(0, 0, 0, psrc[0])); break;
+			case IMG_FORMAT_RGB: _texels.push_back(makeTexel(psrc[0], psrc[1], psrc[2], 255)); break;
+			default: _texels.push_back(makeTexel(psrc[0], psrc[1], psrc[2], psrc[3])); break;
+			}
+		}
+	}
+}
+
+static byte toByte(float val)
+{
+	if (!(val > 0))
+		return 0;
+	if (val >= 1)
+		return 255;
+	return (byte) (val*255 + 0.5f);
+}
+
+unsigned int SoftImage::pack(const Color& col) const
+{
+	switch (_fmt)
+	{
+	case IMG_FORMAT_GREYSCALE: return makeTexel(toByte(col.r), toByte(col.r), toByte(col.r), 255);
+	case IMG_FORMAT_ALPHA: return makeTexel(0, 0, 0, toByte(col.a));
+	case IMG_FORMAT_RGB: return makeTexel(toByte(col.r), toByte(col.g), toByte(col.b), 255);
+	default: break;
+	}
+	return makeTexel(toByte(col.r), toByte(col.g), toByte(col.b), toByte(col.a));
+}
+
+Color SoftImage::unpack(unsigned int texel)
+{
+	const float scale = 1 / 255.0f;
+	return Color((texel & 0xFF)*scale, ((texel >> 8) & 0xFF)*scale, ((texel >> 16) & 0xFF)*scale, (texel >> 24)*scale);
+}
+
+static int wrapCoord(int i, int size, TXT_WRAP wrap)
+{
+	if (wrap == TXT_WRAP_REPEAT)
+	{
+		i %= size;
+		return (i < 0 ? i + size : i);
+	}
+	if (wrap == TXT_WRAP_MIRRORED_REPEAT)
+	{
+		int period = 2 * size;
+		i %= period;
+		if (i < 0)
+			i += period;
+		return (i < size ? i : period - 1 - i);
+	}
+	return (i < 0 ? 0 : (i >= size ? size - 1 : i));
+}
+
+// floor() without the libm call, the coordinates are already range checked
+static int floorInt(float val)
+{
+	int i = (int) val;
+	return (val < i ? i - 1 : i);
+}
+
+static Color lerpColor(const Color& a, const Color& b, float t)
+{
+	return Color(a.r + (b.r - a.r)*t, a.g + (b.g - a.g)*t, a.b + (b.b - a.b)*t, a.a + (b.a - a.a)*t);
+}
+
+Color SoftImage::sampleLevel(int level, float u, float v, bool linear, TXT_WRAP wrap) const
+{
+	int width = MipChain::getLevelDim(_width, level);
+	int height = MipChain::getLevelDim(_height, level);
+	const unsigned int* ptex = &_texels[_levelOffset[level]];
+
+	// keeps NaNs and wild coordinates out of the integer math
+	if (!(u > -65536.0f && u < 65536.0f))
+		u = 0;
+	if (!(v > -65536.0f && v < 65536.0f))
+		v = 0;
+
+	if (!linear)
+	{
+		int x = wrapCoord(floorInt(u*width), width, wrap);
+		int y = wrapCoord(floorInt(v*height), height, wrap);
+		return unpack(ptex[y*width + x]);
+	}
+
+	float fx = u*width - 0.5f;
+	float fy = v*height - 0.5f;
+	int xi = floorInt(fx);
+	int yi = floorInt(fy);
+	float ax = fx - xi;
+	float ay = fy - yi;
+	int x0 = wrapCoord(xi, width, wrap);
+	int x1 = wrapCoord(xi + 1, width, wrap);
+	int y0 = wrapCoord(yi, height, wrap);
+	int y1 = wrapCoord(yi + 1, height, wrap);
+
+	Color top = lerpColor(unpack(ptex[y0*width + x0]), unpack(ptex[y0*width + x1]), ax);
+	Color bottom = lerpColor(unpack(ptex[y1*width + x0]), unpack(ptex[y1*width + x1]), ax);
+	return lerpColor(top, bottom, ay);
+}
+
+Color SoftImage::sample(float u, float v, const SoftTexUnit& unit, unsigned int& bytesRead) const
+{
+	if (_texels.empty())
+		return Color(0, 0, 0, 1);
+
+	// the mag filter when magnified, mip filters fall back to their base filter without a chain (like OglObject)
+	bool minify = (unit.lod > 0);
+	TXT_FILTER filter = (minify ? unit.minFilter : unit.magFilter);
+	int levels = (int) _levelOffset.size();
+	bool mips = (minify && levels > 1);
+
+	bool linear = (filter == TXT_FILTER_LINEAR || filter == TXT_FILTER_LINEAR_MIPMAP_NEAREST || filter == TXT_FILTER_LINEAR_MIPMAP_LINEAR);
+	int level = 0, nextLevel = 0;
+	float frac = 0;
+	if (mips && (filter == TXT_FILTER_NEAREST_MIPMAP_NEAREST || filter == TXT_FILTER_LINEAR_MIPMAP_NEAREST))
+	{
+		level = (int) (unit.lod + 0.5f);
+		level = nextLevel = (level < levels ? level : levels - 1);
+	}
+	else if (mips && (filter == TXT_FILTER_NEAREST_MIPMAP_LINEAR || filter == TXT_FILTER_LINEAR_MIPMAP_LINEAR))
+	{
+		level = (int) unit.lod;
+		frac = unit.lod - level;
+		if (level >= levels - 1)
+		{
+			level = levels - 1;
+			frac = 0;
+		}
+		nextLevel = (frac > 0 ? level + 1 : level);
+	}
+
+	unsigned int texelBytes = getMemoryBytes(_fmt) * (linear ? 4 : 1);
+	Color col = sampleLevel(level, u, v, linear, unit.wrap);
+	bytesRead += texelBytes;
+	if (nextLevel != level)
+	{
+		col = lerpColor(col, sampleLevel(nextLevel, u, v, linear, unit.wrap), frac);
+		bytesRead += texelBytes;
+	}
+	return col;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// SoftRenderTarget
+
+SoftRenderTarget::SoftRenderTarget() : _depthBits(0)
+{
+	_caps = IMAGE_CAPS_RENDER_TARGET | IMAGE_CAPS_BOTTOM_UP;
+}
+
+SoftRenderTarget::~SoftRenderTarget()
+{
+}
+
+bool SoftRenderTarget::init(IMG_FORMAT fmtHint, int width, int height, int depthBitsHint)
+{
+	if (fmtHint == IMG_FORMAT_NONE || width <= 0 || height <= 0)
+	{
+		LOGWARN("(SoftRenderTarget::init) Invalid args");
+		return false;
+	}
+
+	loadTexture(fmtHint, width, height);
+	_depthBits = depthBitsHint;
+	if (depthBitsHint > 0)
+		_byteSize += (unsigned int) (2*width*height);
+
+	_texels.assign(width*height, pack(Color(0, 0, 0, 0)));
+	_levelOffset.assign(1, 0);
+	_depth.assign((depthBitsHint > 0 ? width*height : 0), 1.0f);
+	_overdraw.assign(width*height, 0);
+	_fillBytes.assign(width*height, 0);
+	return true;
+}
+
+void SoftRenderTarget::clear(bool clearColor, const Color& col, bool clearDepth)
+{
+	if (clearColor)
+		std::fill(_texels.begin(), _texels.end(), pack(col));
+	if (clearDepth)
+		std::fill(_depth.begin(), _depth.end(), 1.0f);
+}
+
+void SoftRenderTarget::resetCounters()
+{
+	std::fill(_overdraw.begin(), _overdraw.end(), 0);
+	std::fill(_fillBytes.begin(), _fillBytes.end(), 0);
+}
+
+static bool writePNG(const std::string& path, int width, int height, int channels, const std::vector<byte>& pixels)
+{
+	FILE* fp = fopen(path.c_str(), "wb");
+	if (fp == nullptr)
+		return false;
+
+	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	png_infop info_ptr = (png_ptr != nullptr ? png_create_info_struct(png_ptr) : nullptr);
+	if (info_ptr == nullptr)
+	{
+		png_destroy_write_struct(&png_ptr, nullptr);
+		fclose(fp);
+		return false;
+	}
+
+	std::vector<png_bytep> rows(height);
+	for (int y = 0; y < height; y++)
+		rows[y] = (png_bytep) &pixels[channels * y * width];
+
+	int colorType = (channels == 1 ? PNG_COLOR_TYPE_GRAY : (channels == 3 ? PNG_COLOR_TYPE_RGB : PNG_COLOR_TYPE_RGB_ALPHA));
+	png_init_io(png_ptr, fp);
+	png_set_IHDR(png_ptr, info_ptr, width, height, 8, colorType, PNG_INTERLACE_NONE,
+		PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	png_set_rows(png_ptr, info_ptr, &rows[0]);
+	png_write_png(png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, nullptr);
+
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+	fclose(fp);
+	return true;
+}
+
+bool SoftRenderTarget::savePNG(const std::string& path) const
+{
+	if (_texels.empty())
+		return false;
+
+	int channels = (_fmt == IMG_FORMAT_RGBA ? 4 : (_fmt == IMG_FORMAT_RGB ? 3 : 1));
+	std::vector<byte> pixels(channels*_width*_height);
+	byte* pdst = &pixels[0];
+	for (int y = _height - 1; y >= 0; y--)
+	{
+		const unsigned int* psrc = &_texels[y*_width];
+		for (int x = 0; x < _width; x++)
+		{
+			unsigned int texel = psrc[x];
+			if (channels == 1)
+				*pdst++ = (byte) (_fmt == IMG_FORMAT_ALPHA ? (texel >> 24) : (texel & 0xFF));
+			else
+			{
+				*pdst++ = (byte) (texel & 0xFF);
+				*pdst++ = (byte) ((texel >> 8) & 0xFF);
+				*pdst++ = (byte) ((texel >> 16) & 0xFF);
+				if (channels == 4)
+					*pdst++ = (byte) (texel >> 24);
+			}
+		}
+	}
+	return writePNG(path, _width, _height, channels, pixels);
+}
+
+bool SoftRenderTarget::saveHeatmap(const std::string& path, SOFT_HEATMAP type, float maxValue) const
+{
+	if (_overdraw.empty() || maxValue <= 0)
+		return false;
+
+	static const float ramp[7][3] = {
+		{ 0, 0, 0 }, { 0, 0, 1 }, { 0, 1, 1 }, { 0, 1, 0 }, { 1, 1, 0 }, { 1, 0, 0 }, { 1, 1, 1 }
+	};
+
+	std::vector<byte> pixels(3*_width*_height);
+	byte* pdst = &pixels[0];
+	for (int y = _height - 1; y >= 0; y--)
+	{
+		for (int x = 0; x < _width; x++)
+		{
+			int index = y*_width + x;
+			float val = (float) (type == SOFT_HEATMAP_OVERDRAW ? _overdraw[index] : _fillBytes[index]);
+			float t = (val < maxValue ? val / maxValue : 1) * 6;
+			int stop = (t < 6 ? (int) t : 5);
+			float frac = t - stop;
+			for (int c = 0; c < 3; c++)
+				*pdst++ = toByte(ramp[stop][c] + (ramp[stop + 1][c] - ramp[stop][c])*frac);
+		}
+	}
+	return writePNG(path, _width, _height, 3, pixels);
+}
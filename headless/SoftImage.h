@@ -0,0 +1,80 @@
+﻿#pragma once
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+#include "../core/MigDefines.h"
+#include "../core/Image.h"
+#include "NullImage.h"
+#include "SoftShader.h"
+
+namespace MigTech
+{
+	// per pixel counters that can be written out as heatmaps
+	enum SOFT_HEATMAP
+	{
+		SOFT_HEATMAP_OVERDRAW,		// fragments written to the pixel
+		SOFT_HEATMAP_FILL			// estimated bytes of memory traffic for the pixel (see SoftRender)
+	};
+
+	// software rasterizer version of a MigTech image map, every level is kept as RGBA8 (r in the low byte)
+	//  with the format applied at upload (alpha maps are 0,0,0,a and anything without alpha has a=255)
+	class SoftImage : public NullImage
+	{
+	protected:
+		std::vector<unsigned int> _texels;
+		std::vector<unsigned int> _levelOffset;
+
+	protected:
+		Color sampleLevel(int level, float u, float v, bool linear, TXT_WRAP wrap) const;
+
+	public:
+		SoftImage();
+		virtual ~SoftImage();
+
+		void loadPixels(const ImageData& data);
+		bool hasTexels() const { return !_texels.empty(); }
+
+		// texture2D() with the unit's filter, wrap and LOD, adds the texel memory read to bytesRead
+		Color sample(float u, float v, const SoftTexUnit& unit, unsigned int& bytesRead) const;
+
+		// RGBA8 values in and out, the format is applied on the way in
+		unsigned int pack(const Color& col) const;
+		static Color unpack(unsigned int texel);
+
+		// bytes a texel takes in GPU memory, RGB is padded out to 4 like most GPUs do
+		static unsigned int getMemoryBytes(IMG_FORMAT fmt) { return (fmt == IMG_FORMAT_ALPHA || fmt == IMG_FORMAT_GREYSCALE ? 1 : 4); }
+	};
+
+	// software render target, also used for the back buffer, rows are bottom up like GL
+	class SoftRenderTarget : public SoftImage
+	{
+	protected:
+		int _depthBits;
+		std::vector<float> _depth;
+
+		// counters since the last resetCounters()
+		std::vector<unsigned short> _overdraw;
+		std::vector<unsigned int> _fillBytes;
+
+	public:
+		SoftRenderTarget();
+		virtual ~SoftRenderTarget();
+
+		bool init(IMG_FORMAT fmtHint, int width, int height, int depthBitsHint);
+		int getDepthBits() const { return _depthBits; }
+
+		void clear(bool clearColor, const Color& col, bool clearDepth);
+		void resetCounters();
+
+		unsigned int* getColor() { return (_texels.empty() ? nullptr : &_texels[0]); }
+		float* getDepth() { return (_depth.empty() ? nullptr : &_depth[0]); }
+		unsigned short* getOverdraw() { return (_overdraw.empty() ? nullptr : &_overdraw[0]); }
+		unsigned int* getFillBytes() { return (_fillBytes.empty() ? nullptr : &_fillBytes[0]); }
+
+		// written top down, alpha maps come out as greyscale, the heatmap ramp runs black-blue-cyan-green-yellow-red-white
+		//  and tops out at maxValue
+		bool savePNG(const std::string& path) const;
+		bool saveHeatmap(const std::string& path, SOFT_HEATMAP type, float maxValue) const;
+	};
+}
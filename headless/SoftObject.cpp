@@ -0,0 +1,89 @@
+﻿#include "pch.h"
+#include "../core/MigUtil.h"
+#include "SoftObject.h"
+#include "SoftRender.h"
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+using namespace MigTech;
+
+SoftObject::SoftObject()
+{
+}
+
+SoftObject::~SoftObject()
+{
+}
+
+void SoftObject::loadVertexBuffer(const void* pdata, unsigned int count, VDTYPE vdType)
+{
+	NullObject::loadVertexBuffer(pdata, count, vdType);
+
+	// unpacked into one layout, the vertex procs don't care where the data came from
+	_verts.resize(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		SoftVertexIn& vert = _verts[i];
+		vert = SoftVertexIn();
+		vert.color.a = 1;
+
+		switch (vdType)
+		{
+		case VDTYPE_POSITION:
+			vert.pos = ((const VertexPosition*) pdata)[i].pos;
+			break;
+		case VDTYPE_POSITION_COLOR:
+			vert.pos = ((const VertexPositionColor*) pdata)[i].pos;
+			vert.color = ((const VertexPositionColor*) pdata)[i].color;
+			break;
+		case VDTYPE_POSITION_COLOR_TEXTURE:
+			vert.pos = ((const VertexPositionColorTexture*) pdata)[i].pos;
+			vert.color = ((const VertexPositionColorTexture*) pdata)[i].color;
+			vert.uv1 = ((const VertexPositionColorTexture*) pdata)[i].uv;
+			break;
+		case VDTYPE_POSITION_NORMAL:
+			vert.pos = ((const VertexPositionNormal*) pdata)[i].pos;
+			vert.norm = ((const VertexPositionNormal*) pdata)[i].norm;
+			break;
+		case VDTYPE_POSITION_NORMAL_TEXTURE:
+			vert.pos = ((const VertexPositionNormalTexture*) pdata)[i].pos;
+			vert.norm = ((const VertexPositionNormalTexture*) pdata)[i].norm;
+			vert.uv1 = ((const VertexPositionNormalTexture*) pdata)[i].uv;
+			break;
+		case VDTYPE_POSITION_TEXTURE:
+			vert.pos = ((const VertexPositionTexture*) pdata)[i].pos;
+			vert.uv1 = ((const VertexPositionTexture*) pdata)[i].uv;
+			break;
+		case VDTYPE_POSITION_TEXTURE_TEXTURE:
+			vert.pos = ((const VertexPositionTextureTexture*) pdata)[i].pos;
+			vert.uv1 = ((const VertexPositionTextureTexture*) pdata)[i].uv1;
+			vert.uv2 = ((const VertexPositionTextureTexture*) pdata)[i].uv2;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void SoftObject::loadIndexBuffer(const unsigned short* indices, unsigned int count, PRIMITIVE_TYPE type)
+{
+	NullObject::loadIndexBuffer(indices, count, type);
+	_indices.assign(indices, indices + count);
+}
+
+void SoftObject::onDraw(int shaderSet, const InstanceData* instances, unsigned int count)
+{
+	SoftRender* rendObj = (SoftRender*)MigUtil::theRend;
+	const SoftShader* vs = (const SoftShader*) _shaderSets[shaderSet].vs;
+	const SoftShader* ps = (const SoftShader*) _shaderSets[shaderSet].ps;
+
+	if (_numInd > 0)
+	{
+		if (_offInd + _offIndCount > _indices.size())
+			throw std::out_of_range("(SoftObject::onDraw) Index range out of bounds");
+		rendObj->drawTriangles(vs, ps, _mappings, &_verts[0], _verts.size(), &_indices[_offInd], _offIndCount, _type, instances, count);
+	}
+	else
+		rendObj->drawTriangles(vs, ps, _mappings, &_verts[0], _verts.size(), nullptr, _verts.size(), PRIMITIVE_TYPE_TRIANGLE_LIST, instances, count);
+}
@@ -0,0 +1,30 @@
+﻿#pragma once
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+#include "../core/MigDefines.h"
+#include "../core/Object.h"
+#include "NullObject.h"
+#include "SoftShader.h"
+
+namespace MigTech
+{
+	// software rasterizer version of a MigTech object, keeps a copy of the model data to draw from
+	class SoftObject : public NullObject
+	{
+	protected:
+		std::vector<SoftVertexIn> _verts;
+		std::vector<unsigned short> _indices;
+
+	protected:
+		virtual void onDraw(int shaderSet, const InstanceData* instances, unsigned int count);
+
+	public:
+		SoftObject();
+		virtual ~SoftObject();
+
+		virtual void loadVertexBuffer(const void* pdata, unsigned int count, VDTYPE vdType);
+		virtual void loadIndexBuffer(const unsigned short* indices, unsigned int count, PRIMITIVE_TYPE type);
+	};
+}
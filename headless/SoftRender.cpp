@@ -0,0 +1,711 @@
+﻿#include "pch.h"
+#include "../core/MigUtil.h"
+#include "../core/AssetLoader.h"
+#include "../core/ImageDecoder.h"
+#include "../core/KtxFile.h"
+#include "../core/MipChain.h"
+#include "SoftRender.h"
+#include "SoftShader.h"
+#include "SoftObject.h"
+
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+using namespace MigTech;
+
+SoftRender::SoftRender() :
+	_target(&_backBuffer), _countersStale(false),
+	_blend(BLEND_STATE_NONE), _depth(DEPTH_TEST_STATE_NONE), _depthWrite(false), _cull(FACE_CULLING_NONE)
+{
+	_viewport[0] = _viewport[1] = _viewport[2] = _viewport[3] = 0;
+}
+
+SoftRender::~SoftRender()
+{
+}
+
+bool SoftRender::initRenderer()
+{
+	if (!NullRender::initRenderer())
+		return false;
+	LOGINFO("(SoftRender::initRenderer) Software rasterizer, draws are emulated on the CPU");
+
+	// nothing is compressed on the GPU side, KTX files are decoded into pixels
+	_compressionCaps = 0;
+
+	_rasterStats = SoftFrameStats();
+	_lastRasterStats = SoftFrameStats();
+	_totalRasterStats = SoftFrameStats();
+	return true;
+}
+
+void SoftRender::registerVertexProc(const std::string& name, SoftVertexProc proc)
+{
+	_vertexProcs[name] = proc;
+}
+
+void SoftRender::registerPixelProc(const std::string& name, SoftPixelProc proc)
+{
+	_pixelProcs[name] = proc;
+}
+
+Shader* SoftRender::loadVertexShader(const std::string& name, VDTYPE vdType, unsigned int shaderHints)
+{
+	if (vdType == VDTYPE_UNKNOWN)
+		throw std::invalid_argument("(SoftRender::loadVertexShader) No input layout specified");
+
+	// see if the shader already exists
+	Shader* ps = getShader(name);
+	if (ps != nullptr)
+	{
+		// must match requested shader type
+		if (ps->getType() != Shader::SHADER_TYPE_VERTEX)
+			throw std::runtime_error("(SoftRender::loadVertexShader) Existing shader doesn't match requested shader type");
+		return ps;
+	}
+
+	// registered procs first, then the built in shaders
+	SoftVertexProc proc = nullptr;
+	std::map<std::string, SoftVertexProc>::const_iterator iter = _vertexProcs.find(name);
+	if (iter != _vertexProcs.end())
+		proc = iter->second;
+	else
+		proc = SoftShader::findVertexProc(name);
+	if (proc == nullptr)
+	{
+		LOGWARN("(SoftRender::loadVertexShader) No stand-in for '%s', going by the hints", name.c_str());
+		proc = SoftShader::getDefaultVertexProc(shaderHints);
+	}
+
+	ps = new SoftShader(vdType, shaderHints, proc);
+	_shaders[name] = (NullShader*) ps;
+	return ps;
+}
+
+Shader* SoftRender::loadPixelShader(const std::string& name, unsigned int shaderHints)
+{
+	// see if the shader already exists
+	Shader* ps = getShader(name);
+	if (ps != nullptr)
+	{
+		// must match requested shader type
+		if (ps->getType() != Shader::SHADER_TYPE_PIXEL)
+			throw std::runtime_error("(SoftRender::loadPixelShader) Existing shader doesn't match requested shader type");
+		return ps;
+	}
+
+	SoftPixelProc proc = nullptr;
+	std::map<std::string, SoftPixelProc>::const_iterator iter = _pixelProcs.find(name);
+	if (iter != _pixelProcs.end())
+		proc = iter->second;
+	else
+		proc = SoftShader::findPixelProc(name);
+	if (proc == nullptr)
+	{
+		LOGWARN("(SoftRender::loadPixelShader) No stand-in for '%s', going by the hints", name.c_str());
+		proc = SoftShader::getDefaultPixelProc(shaderHints);
+	}
+
+	ps = new SoftShader(shaderHints, proc);
+	_shaders[name] = (NullShader*) ps;
+	return ps;
+}
+
+Image* SoftRender::loadNewImage(const std::string& name, const std::string& path, unsigned int loadFlags)
+{
+	// see if the image already exists
+	Image* pi = findImage(name);
+	if (pi != nullptr)
+		return pi;
+
+	ImageData data;
+	if (!decodeImage(path, loadFlags, getOutputSize(), data))
+		return nullptr;
+	AssetLoader::recordImage(path, loadFlags, data);
+
+	SoftImage* newImage = new SoftImage();
+	uploadImage(newImage, data);
+	data.release();
+	_images[name] = newImage;
+
+	return newImage;
+}
+
+// the same decoding as the GLES renderer, this is called from the asset loader threads
+bool SoftRender::decodeImage(const std::string& path, unsigned int loadFlags, const Size& fitSize, ImageData& data)
+{
+	bool decoded = false;
+	size_t findDot = path.rfind(".");
+	if (findDot != std::string::npos)
+	{
+		std::string ext = path.substr(findDot + 1);
+		if (0 == ext.compare("jpg") ||
+			0 == ext.compare("jpeg"))
+		{
+			decoded = ImageDecoder::loadJPEG(path, loadFlags, true, fitSize, data);
+		}
+		else if (0 == ext.compare("png"))
+		{
+			decoded = ImageDecoder::loadPNG(path, loadFlags, data);
+		}
+		else if (0 == ext.compare("ktx") ||
+			0 == ext.compare("ktx2"))
+		{
+			decoded = KtxFile::loadImage(path, loadFlags, _compressionCaps, data);
+		}
+	}
+
+	if (decoded && (loadFlags & LOAD_IMAGE_MIPMAPS))
+		MipChain::generate(data);
+	return decoded;
+}
+
+void SoftRender::uploadImage(Image* img, const ImageData& data)
+{
+	NullRender::uploadImage(img, data);
+	((SoftImage*)img)->loadPixels(data);
+}
+
+Image* SoftRender::createPendingImage(const std::string& name)
+{
+	SoftImage* newImage = new SoftImage();
+	_images[name] = newImage;
+	return newImage;
+}
+
+Image* SoftRender::createNewRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint)
+{
+	// if the render target already exists, that is considered an error
+	if (findImage(name) != nullptr)
+		return nullptr;
+
+	SoftRenderTarget* newTarget = new SoftRenderTarget();
+	if (!newTarget->init(fmtHint, width, height, depthBitsHint))
+	{
+		delete newTarget;
+		return nullptr;
+	}
+
+	_images[name] = newTarget;
+	return newTarget;
+}
+
+Object* SoftRender::createObject()
+{
+	return new SoftObject();
+}
+
+void SoftRender::deleteObject(Object* pobj)
+{
+	delete (SoftObject*)pobj;
+}
+
+void SoftRender::setOutputSize(Size newSize)
+{
+	NullRender::setOutputSize(newSize);
+
+	// 16 bits of depth, same as the EGL config the device asks for
+	_backBuffer.init(IMG_FORMAT_RGB, (int) newSize.width, (int) newSize.height, 16);
+	_target = &_backBuffer;
+	_viewport[0] = _viewport[1] = 0;
+	_viewport[2] = (int) newSize.width;
+	_viewport[3] = (int) newSize.height;
+}
+
+void SoftRender::applyViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer)
+{
+	NullRender::applyViewport(newPort, clearRenderBuffer, clearDepthBuffer);
+
+	if (newPort != nullptr)
+	{
+		_viewport[0] = (int) (newPort->corner.x * _outputSize.width);
+		_viewport[1] = (int) (newPort->corner.y * _outputSize.height);
+		_viewport[2] = (int) (newPort->size.width * _outputSize.width);
+		_viewport[3] = (int) (newPort->size.height * _outputSize.height);
+	}
+	else
+	{
+		_viewport[0] = _viewport[1] = 0;
+		_viewport[2] = (int) _outputSize.width;
+		_viewport[3] = (int) _outputSize.height;
+	}
+
+	// like glClear() the whole target is cleared, not just the viewport
+	if (clearRenderBuffer || clearDepthBuffer)
+		_target->clear(clearRenderBuffer, _clearColor, clearDepthBuffer);
+}
+
+void SoftRender::applyBlending(BLEND_STATE blend)
+{
+	NullRender::applyBlending(blend);
+	_blend = blend;
+}
+
+void SoftRender::applyDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite)
+{
+	NullRender::applyDepthTesting(depth, enableWrite);
+	_depth = depth;
+	_depthWrite = enableWrite;
+}
+
+void SoftRender::setFaceCulling(FACE_CULLING cull)
+{
+	NullRender::setFaceCulling(cull);
+	_cull = cull;
+}
+
+void SoftRender::preRender(int pass, RenderPass* passObj)
+{
+	NullRender::preRender(pass, passObj);
+
+	// a new frame starts with fresh counters
+	if (_countersStale)
+	{
+		_backBuffer.resetCounters();
+		_countersStale = false;
+	}
+
+	unsigned int configBits = 0;
+	if (pass > 0 && passObj != nullptr)
+		configBits = passObj->getConfigBits();
+
+	// bind the render target or the back buffer, with the same viewport the GLES renderer would use
+	SoftRenderTarget* target = nullptr;
+	if (configBits & RenderPass::USE_RENDER_TARGET)
+		target = (SoftRenderTarget*) passObj->getRenderTarget();
+	if (target != nullptr)
+	{
+		_target = target;
+		_viewport[0] = _viewport[1] = 0;
+		_viewport[2] = target->getWidth();
+		_viewport[3] = target->getHeight();
+	}
+	else
+	{
+		_target = &_backBuffer;
+		if (configBits & RenderPass::USE_VIEW_PORT)
+		{
+			const Rect& viewPort = passObj->getViewPort();
+			_viewport[0] = (int) (viewPort.corner.x * _outputSize.width);
+			_viewport[1] = (int) (viewPort.corner.y * _outputSize.height);
+			_viewport[2] = (int) (viewPort.size.width * _outputSize.width);
+			_viewport[3] = (int) (viewPort.size.height * _outputSize.height);
+		}
+		else
+		{
+			_viewport[0] = _viewport[1] = 0;
+			_viewport[2] = (int) _outputSize.width;
+			_viewport[3] = (int) _outputSize.height;
+		}
+	}
+
+	// clear the render target buffers, a render target's counters start over with its contents
+	bool clearColor = (pass == 0 || (configBits & RenderPass::USE_CLEAR_COLOR));
+	bool clearDepth = (pass == 0 || (configBits & RenderPass::USE_CLEAR_DEPTH));
+	if (clearColor || clearDepth)
+	{
+		const Color& col = ((configBits & RenderPass::USE_CLEAR_COLOR) ? passObj->getClearColor() : _clearColor);
+		_target->clear(clearColor, col, clearDepth);
+		if (clearColor && _target != &_backBuffer)
+			_target->resetCounters();
+	}
+}
+
+static void addStats(SoftFrameStats& total, const SoftFrameStats& frame)
+{
+	total.triangles += frame.triangles;
+	total.trianglesCulled += frame.trianglesCulled;
+	total.trianglesClipped += frame.trianglesClipped;
+	total.fragments += frame.fragments;
+	total.depthRejected += frame.depthRejected;
+	total.pixelsWritten += frame.pixelsWritten;
+	total.pixelsBlended += frame.pixelsBlended;
+	total.texelBytes += frame.texelBytes;
+	total.fillBytes += frame.fillBytes;
+}
+
+void SoftRender::present()
+{
+	NullRender::present();
+
+	// roll the frame stats over, the back buffer keeps this frame's counters until the next one starts
+	addStats(_totalRasterStats, _rasterStats);
+	_totalRasterStats.frame = _rasterStats.frame + 1;
+	_lastRasterStats = _rasterStats;
+	_rasterStats = SoftFrameStats();
+	_rasterStats.frame = _lastRasterStats.frame + 1;
+	_countersStale = true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// rasterization
+
+void SoftRender::setupUniforms(const NullTxtMapping* mappings)
+{
+	SoftUniforms& u = _uniforms;
+	u.model = _model;
+	u.view = _view;
+	u.proj = _perspective;
+	Matrix::multiply(_model, _view, u.mvp);
+	u.mvp.multiply(_perspective);
+	u.objColor = _objColor;
+	for (int i = 0; i < 4; i++)
+	{
+		u.misc[i] = _misc[i];
+		u.cfg[i] = _cfg[i];
+		u.litColor[i] = _litColor[i];
+		u.litDirPos[i] = _litDirPos[i];
+		u.litIsDir[i] = _litIsDir[i];
+	}
+	u.ambColor = _ambColor;
+	u.inst = nullptr;
+	u.texelBytes = 0;
+
+	for (int i = 0; i < MAX_TEXTURE_MAPS; i++)
+	{
+		u.tex[i].img = (const SoftImage*) mappings[i].pimg;
+		u.tex[i].minFilter = mappings[i].minFilter;
+		u.tex[i].magFilter = mappings[i].magFilter;
+		u.tex[i].wrap = mappings[i].wrap;
+		u.tex[i].lod = 0;
+	}
+}
+
+void SoftRender::drawTriangles(const SoftShader* vs, const SoftShader* ps, const NullTxtMapping* mappings,
+	const SoftVertexIn* verts, unsigned int numVerts, const unsigned short* indices, unsigned int count,
+	PRIMITIVE_TYPE type, const InstanceData* instances, unsigned int instCount)
+{
+	if (_target->getColor() == nullptr || numVerts == 0 || count < 3)
+		return;
+
+	setupUniforms(mappings);
+	SoftVertexProc vertexProc = vs->getVertexProc();
+	SoftPixelProc pixelProc = ps->getPixelProc();
+
+	unsigned int loops = (instances != nullptr ? instCount : 1);
+	for (unsigned int inst = 0; inst < loops; inst++)
+	{
+		if (instances != nullptr)
+		{
+			_uniforms.inst = &instances[inst];
+			Matrix::multiply(instances[inst].model, _view, _uniforms.mvp);
+			_uniforms.mvp.multiply(_perspective);
+		}
+
+		// every vertex goes through the vertex stage, the output starts out zeroed with the object color
+		_varyings.resize(numVerts);
+		for (unsigned int i = 0; i < numVerts; i++)
+		{
+			SoftVarying& out = _varyings[i];
+			out = SoftVarying();
+			out.color = _uniforms.objColor;
+			vertexProc(_uniforms, verts[i], out);
+		}
+
+		// triangle assembly, odd strip triangles are flipped to keep the winding
+		unsigned int tris = (type == PRIMITIVE_TYPE_TRIANGLE_LIST ? count / 3 : count - 2);
+		for (unsigned int t = 0; t < tris; t++)
+		{
+			unsigned int i0, i1, i2;
+			if (type == PRIMITIVE_TYPE_TRIANGLE_STRIP)
+			{
+				i0 = ((t & 1) ? t + 1 : t);
+				i1 = ((t & 1) ? t : t + 1);
+				i2 = t + 2;
+			}
+			else if (type == PRIMITIVE_TYPE_TRIANGLE_FAN)
+			{
+				i0 = 0;
+				i1 = t + 1;
+				i2 = t + 2;
+			}
+			else
+			{
+				i0 = 3 * t;
+				i1 = 3 * t + 1;
+				i2 = 3 * t + 2;
+			}
+			if (indices != nullptr)
+			{
+				i0 = indices[i0];
+				i1 = indices[i1];
+				i2 = indices[i2];
+			}
+			if (i0 >= numVerts || i1 >= numVerts || i2 >= numVerts)
+				continue;
+
+			_rasterStats.triangles++;
+			clipTriangle(_varyings[i0], _varyings[i1], _varyings[i2], pixelProc);
+		}
+	}
+}
+
+static void lerpVarying(const SoftVarying& a, const SoftVarying& b, float t, SoftVarying& out)
+{
+	const float* pa = (const float*) &a;
+	const float* pb = (const float*) &b;
+	float* pout = (float*) &out;
+	for (unsigned int i = 0; i < sizeof(SoftVarying) / sizeof(float); i++)
+		pout[i] = pa[i] + (pb[i] - pa[i])*t;
+}
+
+// only the near plane (z >= -w) is clipped, the viewport bounds take care of the sides and depth the far plane
+void SoftRender::clipTriangle(const SoftVarying& v0, const SoftVarying& v1, const SoftVarying& v2, SoftPixelProc proc)
+{
+	const SoftVarying* in[3] = { &v0, &v1, &v2 };
+	float dist[3];
+	int inside = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		dist[i] = in[i]->clip[2] + in[i]->clip[3];
+		if (dist[i] >= 0)
+			inside++;
+	}
+
+	if (inside == 3)
+	{
+		rasterTriangle(v0, v1, v2, proc);
+		return;
+	}
+	_rasterStats.trianglesClipped++;
+	if (inside == 0)
+		return;
+
+	// Sutherland-Hodgman against the one plane, at most 4 vertices come out
+	SoftVarying poly[4];
+	int count = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		int next = (i + 1) % 3;
+		if (dist[i] >= 0)
+			poly[count++] = *in[i];
+		if ((dist[i] >= 0) != (dist[next] >= 0))
+			lerpVarying(*in[i], *in[next], dist[i] / (dist[i] - dist[next]), poly[count++]);
+	}
+	for (int i = 1; i + 1 < count; i++)
+		rasterTriangle(poly[0], poly[i], poly[i + 1], proc);
+}
+
+static float clampUnit(float val)
+{
+	return (val > 0 ? (val < 1 ? val : 1) : 0);
+}
+
+static bool depthPasses(DEPTH_TEST_STATE depth, float z, float stored)
+{
+	switch (depth)
+	{
+	case DEPTH_TEST_STATE_LESS: return (z < stored);
+	case DEPTH_TEST_STATE_LEQUAL: return (z <= stored);
+	case DEPTH_TEST_STATE_EQUAL: return (z == stored);
+	case DEPTH_TEST_STATE_GEQUAL: return (z >= stored);
+	case DEPTH_TEST_STATE_GREATER: return (z > stored);
+	case DEPTH_TEST_STATE_NEQUAL: return (z != stored);
+	default: break;
+	}
+	return true;
+}
+
+// same factors for color and alpha, like glBlendFunc()
+static Color blendColor(BLEND_STATE blend, const Color& src, const Color& dst)
+{
+	float srcFactor = 1;
+	switch (blend)
+	{
+	case BLEND_STATE_SRC_ALPHA: srcFactor = src.a; break;
+	case BLEND_STATE_ONE_MINUS_SRC_ALPHA: srcFactor = 1 - src.a; break;
+	case BLEND_STATE_DST_ALPHA: srcFactor = dst.a; break;
+	case BLEND_STATE_ONE_MINUS_DST_ALPHA: srcFactor = 1 - dst.a; break;
+	default: return src;
+	}
+	float dstFactor = 1 - srcFactor;
+	return Color(src.r*srcFactor + dst.r*dstFactor, src.g*srcFactor + dst.g*dstFactor,
+		src.b*srcFactor + dst.b*dstFactor, src.a*srcFactor + dst.a*dstFactor);
+}
+
+// the rule that decides which triangle owns a pixel center that lands on a shared edge (counter clockwise, y up)
+static bool isTopLeft(float ax, float ay, float bx, float by)
+{
+	return (by < ay || (by == ay && bx < ax));
+}
+
+void SoftRender::rasterTriangle(const SoftVarying& v0, const SoftVarying& v1, const SoftVarying& v2, SoftPixelProc proc)
+{
+	const SoftVarying* vert[3] = { &v0, &v1, &v2 };
+
+	// to window coordinates
+	float sx[3], sy[3], sz[3], invW[3];
+	for (int i = 0; i < 3; i++)
+	{
+		const float* clip = vert[i]->clip;
+		if (!(clip[3] > 1e-6f))
+			return;
+		invW[i] = 1 / clip[3];
+		sx[i] = _viewport[0] + (clip[0]*invW[i] + 1)*0.5f*_viewport[2];
+		sy[i] = _viewport[1] + (clip[1]*invW[i] + 1)*0.5f*_viewport[3];
+		sz[i] = (clip[2]*invW[i] + 1)*0.5f;
+	}
+
+	// counter clockwise is the front face, like GL's default
+	float area = (sx[1] - sx[0])*(sy[2] - sy[0]) - (sx[2] - sx[0])*(sy[1] - sy[0]);
+	if (!(area != 0))
+		return;
+	bool front = (area > 0);
+	if ((_cull == FACE_CULLING_BACK && !front) || (_cull == FACE_CULLING_FRONT && front))
+	{
+		_rasterStats.trianglesCulled++;
+		return;
+	}
+	if (!front)
+	{
+		std::swap(vert[1], vert[2]);
+		std::swap(sx[1], sx[2]);
+		std::swap(sy[1], sy[2]);
+		std::swap(sz[1], sz[2]);
+		std::swap(invW[1], invW[2]);
+		area = -area;
+	}
+
+	// pixel centers inside the bounds and the viewport
+	int width = _target->getWidth();
+	int height = _target->getHeight();
+	int minX = std::max((int) ceil(std::min(sx[0], std::min(sx[1], sx[2])) - 0.5f), std::max(_viewport[0], 0));
+	int maxX = std::min((int) floor(std::max(sx[0], std::max(sx[1], sx[2])) - 0.5f), std::min(_viewport[0] + _viewport[2], width) - 1);
+	int minY = std::max((int) ceil(std::min(sy[0], std::min(sy[1], sy[2])) - 0.5f), std::max(_viewport[1], 0));
+	int maxY = std::min((int) floor(std::max(sy[0], std::max(sy[1], sy[2])) - 0.5f), std::min(_viewport[1] + _viewport[3], height) - 1);
+	if (minX > maxX || minY > maxY)
+		return;
+
+	// one LOD per texture for the whole triangle, from the first UV set's area in texels over the area in pixels
+	float uvArea = fabs((vert[1]->uv1.x - vert[0]->uv1.x)*(vert[2]->uv1.y - vert[0]->uv1.y) -
+		(vert[2]->uv1.x - vert[0]->uv1.x)*(vert[1]->uv1.y - vert[0]->uv1.y));
+	for (int i = 0; i < MAX_TEXTURE_MAPS; i++)
+	{
+		const SoftImage* img = _uniforms.tex[i].img;
+		float texels = (img != nullptr ? uvArea*img->getWidth()*img->getHeight() : 0);
+		_uniforms.tex[i].lod = (texels > 0 ? 0.5f*(float) log(texels / area) / (float) log(2.0) : 0);
+	}
+
+	// edge functions, edge i is opposite vertex i
+	int e0[3] = { 1, 2, 0 };
+	int e1[3] = { 2, 0, 1 };
+	float dx[3], dy[3];
+	bool topLeft[3];
+	for (int i = 0; i < 3; i++)
+	{
+		dx[i] = sx[e1[i]] - sx[e0[i]];
+		dy[i] = sy[e1[i]] - sy[e0[i]];
+		topLeft[i] = isTopLeft(sx[e0[i]], sy[e0[i]], sx[e1[i]], sy[e1[i]]);
+	}
+
+	float* pdepth = _target->getDepth();
+	bool depthTest = (_depth != DEPTH_TEST_STATE_NONE && pdepth != nullptr);
+	bool depthWrite = (depthTest && _depthWrite);
+	unsigned int depthBytes = (unsigned int) (_target->getDepthBits() + 7) / 8;
+	unsigned int colorBytes = SoftImage::getMemoryBytes(_target->getFormat());
+	bool blend = (_blend != BLEND_STATE_NONE);
+
+	unsigned int* pcolor = _target->getColor();
+	unsigned short* poverdraw = _target->getOverdraw();
+	unsigned int* pfill = _target->getFillBytes();
+	const float invArea = 1 / area;
+	float* pvary[3] = { (float*) &vert[0]->color, (float*) &vert[1]->color, (float*) &vert[2]->color };
+
+	SoftVarying frag = SoftVarying();
+	float* pfrag = (float*) &frag.color;
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		// the edge functions at the first pixel center of the row, stepped across it
+		float py = y + 0.5f;
+		float px = minX + 0.5f;
+		float rowW[3];
+		for (int i = 0; i < 3; i++)
+			rowW[i] = dx[i]*(py - sy[e0[i]]) - dy[i]*(px - sx[e0[i]]);
+
+		// narrow the row down to where the edges cross it (with a pixel to spare), the test below is still exact
+		float spanStart = 0, spanEnd = (float) (maxX - minX);
+		for (int i = 0; i < 3; i++)
+		{
+			if (dy[i] > 0)
+				spanEnd = std::min(spanEnd, rowW[i] / dy[i] + 1);
+			else if (dy[i] < 0)
+				spanStart = std::max(spanStart, rowW[i] / dy[i] - 1);
+			else if (rowW[i] < 0)
+				spanStart = spanEnd + 1;
+		}
+		if (spanStart > spanEnd)
+			continue;
+		int startX = minX + (int) spanStart;
+		int endX = minX + (int) spanEnd;
+		for (int i = 0; i < 3; i++)
+			rowW[i] -= dy[i]*(startX - minX);
+
+		for (int x = startX; x <= endX; x++, rowW[0] -= dy[0], rowW[1] -= dy[1], rowW[2] -= dy[2])
+		{
+			// inside all three edges, ties go to top and left edges
+			const float* w = rowW;
+			if (!((w[0] > 0 || (w[0] == 0 && topLeft[0])) &&
+				(w[1] > 0 || (w[1] == 0 && topLeft[1])) &&
+				(w[2] > 0 || (w[2] == 0 && topLeft[2]))))
+				continue;
+
+			// depth is linear in screen space, outside the depth range is clipped
+			float b0 = w[0]*invArea, b1 = w[1]*invArea, b2 = w[2]*invArea;
+			float z = b0*sz[0] + b1*sz[1] + b2*sz[2];
+			if (z < 0 || z > 1)
+				continue;
+			_rasterStats.fragments++;
+
+			// early depth test, none of the shaders discard or write depth
+			int index = y*width + x;
+			unsigned int bytes = 0;
+			if (depthTest)
+			{
+				bytes += depthBytes;
+				if (!depthPasses(_depth, z, pdepth[index]))
+				{
+					_rasterStats.depthRejected++;
+					_rasterStats.fillBytes += bytes;
+					pfill[index] += bytes;
+					continue;
+				}
+			}
+
+			// perspective correct varyings
+			float p0 = b0*invW[0], p1 = b1*invW[1], p2 = b2*invW[2];
+			float norm = 1 / (p0 + p1 + p2);
+			p0 *= norm; p1 *= norm; p2 *= norm;
+			for (int i = 0; i < SOFT_VARYING_COUNT; i++)
+				pfrag[i] = p0*pvary[0][i] + p1*pvary[1][i] + p2*pvary[2][i];
+
+			_uniforms.texelBytes = 0;
+			Color col = proc(_uniforms, frag);
+			col = Color(clampUnit(col.r), clampUnit(col.g), clampUnit(col.b), clampUnit(col.a));
+			bytes += _uniforms.texelBytes;
+			_rasterStats.texelBytes += _uniforms.texelBytes;
+
+			if (blend)
+			{
+				col = blendColor(_blend, col, SoftImage::unpack(pcolor[index]));
+				bytes += colorBytes;
+				_rasterStats.pixelsBlended++;
+			}
+			pcolor[index] = _target->pack(col);
+			bytes += colorBytes;
+			if (depthWrite)
+			{
+				pdepth[index] = z;
+				bytes += depthBytes;
+			}
+
+			if (poverdraw[index] < 0xFFFF)
+				poverdraw[index]++;
+			pfill[index] += bytes;
+			_rasterStats.pixelsWritten++;
+			_rasterStats.fillBytes += bytes;
+		}
+	}
+}
@@ -0,0 +1,118 @@
+﻿#pragma once
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+#include "../core/MigDefines.h"
+#include "NullRender.h"
+#include "NullObject.h"
+#include "SoftShader.h"
+#include "SoftImage.h"
+
+namespace MigTech
+{
+	// per frame rasterizer counters, the fill estimate is the memory traffic an immediate mode GPU would have
+	//  for the fragments (depth read/write, texel fetches, blend read and color write), clears aren't counted
+	struct SoftFrameStats
+	{
+		unsigned int frame;
+		unsigned int triangles;
+		unsigned int trianglesCulled;
+		unsigned int trianglesClipped;		// crossed the near plane
+		unsigned int fragments;				// covered pixels inside the viewport
+		unsigned int depthRejected;
+		unsigned int pixelsWritten;
+		unsigned int pixelsBlended;
+		uint64 texelBytes;
+		uint64 fillBytes;
+
+		SoftFrameStats() { memset(this, 0, sizeof(SoftFrameStats)); }
+	};
+
+	// headless renderer that also draws, every recorded draw is rasterized on the CPU into the back buffer
+	//  (or the pass's render target) with the shaders replaced by procs, see SoftShader
+	//  - the back buffer is RGB with a depth buffer like the device config, GL's rules for depth, blending and culling
+	//  - the back buffer counters cover one frame (they're reset by the first preRender() after a present())
+	class SoftRender : public NullRender
+	{
+	protected:
+		virtual Image* loadNewImage(const std::string& name, const std::string& path, unsigned int loadFlags);
+		virtual Image* createNewRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint);
+		virtual Image* createPendingImage(const std::string& name);
+
+		virtual void applyViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer);
+		virtual void applyBlending(BLEND_STATE blend);
+		virtual void applyDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite);
+
+	public:
+		SoftRender();
+		virtual ~SoftRender();
+
+		virtual bool initRenderer();
+
+		virtual Shader* loadVertexShader(const std::string& name, VDTYPE vdType, unsigned int shaderHints);
+		virtual Shader* loadPixelShader(const std::string& name, unsigned int shaderHints);
+
+		virtual bool decodeImage(const std::string& path, unsigned int loadFlags, const Size& fitSize, ImageData& data);
+		virtual void uploadImage(Image* img, const ImageData& data);
+
+		virtual Object* createObject();
+		virtual void deleteObject(Object* pobj);
+
+		virtual void setOutputSize(Size newSize);
+		virtual void setFaceCulling(FACE_CULLING cull);
+
+		virtual void preRender(int pass, RenderPass* passObj);
+		virtual void present();
+
+	public:
+		// stand-ins for shaders the engine doesn't know (the game's own), these must be registered before the shader loads
+		void registerVertexProc(const std::string& name, SoftVertexProc proc);
+		void registerPixelProc(const std::string& name, SoftPixelProc proc);
+
+		// called by the objects for every draw they record, indices can be null for a plain triangle list
+		void drawTriangles(const SoftShader* vs, const SoftShader* ps, const NullTxtMapping* mappings,
+			const SoftVertexIn* verts, unsigned int numVerts, const unsigned short* indices, unsigned int count,
+			PRIMITIVE_TYPE type, const InstanceData* instances, unsigned int instCount);
+
+		// the back buffer holds the last frame until the next one starts
+		SoftRenderTarget& getBackBuffer() { return _backBuffer; }
+		bool saveFrame(const std::string& path) const { return _backBuffer.savePNG(path); }
+		bool saveHeatmap(const std::string& path, SOFT_HEATMAP type, float maxValue) const { return _backBuffer.saveHeatmap(path, type, maxValue); }
+
+		// stats for the frame in progress, the last presented frame and all frames
+		const SoftFrameStats& getRasterStats() const { return _rasterStats; }
+		const SoftFrameStats& getLastRasterStats() const { return _lastRasterStats; }
+		const SoftFrameStats& getTotalRasterStats() const { return _totalRasterStats; }
+
+	protected:
+		void setupUniforms(const NullTxtMapping* mappings);
+		void clipTriangle(const SoftVarying& v0, const SoftVarying& v1, const SoftVarying& v2, SoftPixelProc proc);
+		void rasterTriangle(const SoftVarying& v0, const SoftVarying& v1, const SoftVarying& v2, SoftPixelProc proc);
+
+	protected:
+		// where the draws go
+		SoftRenderTarget _backBuffer;
+		SoftRenderTarget* _target;
+		int _viewport[4];
+		bool _countersStale;
+
+		// fixed function state as last applied
+		BLEND_STATE _blend;
+		DEPTH_TEST_STATE _depth;
+		bool _depthWrite;
+		FACE_CULLING _cull;
+
+		// shader stand-ins registered by the host
+		std::map<std::string, SoftVertexProc> _vertexProcs;
+		std::map<std::string, SoftPixelProc> _pixelProcs;
+
+		// per draw scratch
+		SoftUniforms _uniforms;
+		std::vector<SoftVarying> _varyings;
+
+		SoftFrameStats _rasterStats;
+		SoftFrameStats _lastRasterStats;
+		SoftFrameStats _totalRasterStats;
+	};
+}
@@ -0,0 +1,220 @@
+﻿#include "pch.h"
+#include "../core/MigUtil.h"
+#include "SoftShader.h"
+#include "SoftImage.h"
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+using namespace MigTech;
+
+Color SoftUniforms::sample(int unit, float u, float v) const
+{
+	if (unit < 0 || unit >= MAX_TEXTURE_MAPS || tex[unit].img == nullptr)
+		return Color(0, 0, 0, 1);
+	return tex[unit].img->sample(u, v, tex[unit], texelBytes);
+}
+
+void SoftUniforms::transform(const Vector3& pos, SoftVarying& out) const
+{
+	const float* m = mvp.getData();
+	for (int i = 0; i < 4; i++)
+		out.clip[i] = pos.x*m[i] + pos.y*m[4 + i] + pos.z*m[8 + i] + m[12 + i];
+}
+
+///////////////////////////////////////////////////////////////////////////
+// the built in vertex shaders (android/shaders/mtvs_*.vert)
+
+static void passThrough(const Vector3& pos, SoftVarying& out)
+{
+	out.clip[0] = pos.x;
+	out.clip[1] = pos.y;
+	out.clip[2] = pos.z;
+	out.clip[3] = 1;
+}
+
+// misc.x is the frame index, misc.y the row count and misc.z the column count
+static Vector2 getUVSet(const float* misc, const Vector2& uvInc)
+{
+	if (misc[1] <= 1 && misc[2] <= 1)
+		return uvInc;
+
+	float row = (float) floor(misc[0] / misc[2]);
+	float col = misc[0] - misc[2]*(float) floor(misc[0] / misc[2]);
+
+	float u1 = (1 / misc[2]) * col;
+	float v1 = (1 / misc[1]) * row;
+	return Vector2((uvInc.x == 0 ? u1 : u1 + (1 / misc[2])), (uvInc.y == 0 ? v1 : v1 + (1 / misc[1])));
+}
+
+static void vsPosNoTransform(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	passThrough(in.pos, out);
+	out.uv1 = in.uv1;
+}
+
+static void vsPosTransform(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	u.transform(in.pos, out);
+	out.uv1 = in.uv1;
+}
+
+static void vsPosTransformInst(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	u.transform(in.pos, out);
+	out.color = u.inst->color;
+	out.uv1 = in.uv1;
+}
+
+static void vsSprite(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	u.transform(in.pos, out);
+	out.color = in.color;
+	out.uv1 = in.uv1;
+}
+
+static void vsMovieClip(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	u.transform(in.pos, out);
+	out.uv1 = getUVSet(u.misc, in.uv1);
+}
+
+static void vsMovieClipInst(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	u.transform(in.pos, out);
+	out.color = u.inst->color;
+	out.uv1 = getUVSet(u.misc, in.uv1);
+}
+
+static void vsOverlayBackground(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	passThrough(in.pos, out);
+	out.uv1 = Vector2(in.uv1.x + u.misc[0], in.uv1.y + u.misc[1]);
+}
+
+// lit by the first light like the game shaders, the color isn't clamped until it's written
+static void vsLit(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out)
+{
+	u.transform(in.pos, out);
+
+	const float* m = u.model.getData();
+	Vector3 norm(in.norm.x*m[0] + in.norm.y*m[4] + in.norm.z*m[8],
+		in.norm.x*m[1] + in.norm.y*m[5] + in.norm.z*m[9],
+		in.norm.x*m[2] + in.norm.y*m[6] + in.norm.z*m[10]);
+	const Vector3& dir = u.litDirPos[0];
+	float dotProd = -(dir.x*norm.x + dir.y*norm.y + dir.z*norm.z);
+
+	const Color& col = (u.inst != nullptr ? u.inst->color : u.objColor);
+	out.color = Color(col.r*dotProd, col.g*dotProd, col.b*dotProd, col.a);
+	out.norm = norm;
+	out.uv1 = in.uv1;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// the built in pixel shaders (android/shaders/mtps_*.frag)
+
+static Color modulate(const Color& a, const Color& b)
+{
+	return Color(a.r*b.r, a.g*b.g, a.b*b.b, a.a*b.a);
+}
+
+static Color psColor(const SoftUniforms& u, const SoftVarying& in)
+{
+	return u.objColor;
+}
+
+static Color psColorInst(const SoftUniforms& u, const SoftVarying& in)
+{
+	return in.color;
+}
+
+static Color psTex(const SoftUniforms& u, const SoftVarying& in)
+{
+	return modulate(u.sample(0, in.uv1.x, in.uv1.y), u.objColor);
+}
+
+static Color psTexAlpha(const SoftUniforms& u, const SoftVarying& in)
+{
+	float a = u.sample(0, in.uv1.x, in.uv1.y).a;
+	return Color(u.objColor.r*a, u.objColor.g*a, u.objColor.b*a, u.objColor.a*a);
+}
+
+static Color psTexInst(const SoftUniforms& u, const SoftVarying& in)
+{
+	return modulate(u.sample(0, in.uv1.x, in.uv1.y), in.color);
+}
+
+// the vertex color (object color when there isn't one) and the first texture if one is bound
+static Color psDefault(const SoftUniforms& u, const SoftVarying& in)
+{
+	if (u.tex[0].img != nullptr)
+		return modulate(u.sample(0, in.uv1.x, in.uv1.y), in.color);
+	return in.color;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// SoftShader
+
+SoftShader::SoftShader(VDTYPE vdType, unsigned int hints, SoftVertexProc proc) :
+	NullShader(Shader::SHADER_TYPE_VERTEX, vdType, hints), _vertexProc(proc), _pixelProc(nullptr)
+{
+}
+
+SoftShader::SoftShader(unsigned int hints, SoftPixelProc proc) :
+	NullShader(Shader::SHADER_TYPE_PIXEL, VDTYPE_UNKNOWN, hints), _vertexProc(nullptr), _pixelProc(proc)
+{
+}
+
+SoftShader::~SoftShader()
+{
+}
+
+SoftVertexProc SoftShader::findVertexProc(const std::string& name)
+{
+	if (name == MIGTECH_VSHADER_POS_NO_TRANSFORM || name == MIGTECH_VSHADER_POS_TEX_NO_TRANSFORM)
+		return vsPosNoTransform;
+	if (name == MIGTECH_VSHADER_POS_TRANSFORM || name == MIGTECH_VSHADER_POS_TEX_TRANSFORM)
+		return vsPosTransform;
+	if (name == MIGTECH_VSHADER_POS_TRANSFORM_INST)
+		return vsPosTransformInst;
+	if (name == MIGTECH_VSHADER_SPRITE)
+		return vsSprite;
+	if (name == "mtvs_MovieClip")
+		return vsMovieClip;
+	if (name == "mtvs_MovieClipInst")
+		return vsMovieClipInst;
+	if (name == "mtvs_OverlayBackground")
+		return vsOverlayBackground;
+	return nullptr;
+}
+
+SoftPixelProc SoftShader::findPixelProc(const std::string& name)
+{
+	if (name == MIGTECH_PSHADER_COLOR)
+		return psColor;
+	if (name == MIGTECH_PSHADER_COLOR_INST)
+		return psColorInst;
+	if (name == MIGTECH_PSHADER_TEX)
+		return psTex;
+	if (name == MIGTECH_PSHADER_TEX_ALPHA)
+		return psTexAlpha;
+	if (name == MIGTECH_PSHADER_TEX_INST)
+		return psTexInst;
+	return nullptr;
+}
+
+SoftVertexProc SoftShader::getDefaultVertexProc(unsigned int hints)
+{
+	if (hints & SHADER_HINT_LIGHTS)
+		return vsLit;
+	if (hints & SHADER_HINT_INSTANCED)
+		return vsPosTransformInst;
+	if (hints & SHADER_HINT_MVP)
+		return vsPosTransform;
+	return vsPosNoTransform;
+}
+
+SoftPixelProc SoftShader::getDefaultPixelProc(unsigned int hints)
+{
+	return psDefault;
+}
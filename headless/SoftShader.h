@@ -0,0 +1,105 @@
+﻿#pragma once
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+#include "../core/MigDefines.h"
+#include "../core/Matrix.h"
+#include "../core/Object.h"
+#include "NullShader.h"
+
+namespace MigTech
+{
+	class SoftImage;
+
+	// a vertex as the vertex stage sees it, attributes missing from the layout are GL's defaults (0, color 0,0,0,1)
+	struct SoftVertexIn
+	{
+		Vector3 pos;
+		Vector3 norm;
+		Color color;
+		Vector2 uv1;
+		Vector2 uv2;
+	};
+
+	// vertex stage output, everything after the clip position is interpolated (perspective correct)
+	struct SoftVarying
+	{
+		float clip[4];
+		Color color;
+		Vector2 uv1;
+		Vector2 uv2;
+		Vector3 norm;
+		Vector3 pos;
+	};
+
+	// number of interpolated floats that follow the clip position
+	static const int SOFT_VARYING_COUNT = (sizeof(SoftVarying) / sizeof(float)) - 4;
+
+	// a bound texture and how it's sampled
+	struct SoftTexUnit
+	{
+		const SoftImage* img;
+		TXT_FILTER minFilter;
+		TXT_FILTER magFilter;
+		TXT_WRAP wrap;
+		float lod;			// log2 of texels per pixel for the triangle being drawn
+	};
+
+	// the uniforms and samplers a shader can see, the same values the GLES programs get
+	//  for instanced draws mvp is the instance model * view * proj and inst is the instance
+	struct SoftUniforms
+	{
+		Matrix model;
+		Matrix view;
+		Matrix proj;
+		Matrix mvp;
+		Color objColor;
+		float misc[4];
+		int cfg[4];
+		Color ambColor;
+		Color litColor[4];
+		Vector3 litDirPos[4];
+		bool litIsDir[4];
+		const InstanceData* inst;
+		SoftTexUnit tex[MAX_TEXTURE_MAPS];
+
+		// memory read by sample() since the counter was last reset
+		mutable unsigned int texelBytes;
+
+		// texture2D(), an unbound or empty texture is 0,0,0,1 like an incomplete GL texture
+		Color sample(int unit, float u, float v) const;
+
+		// gl_Position = mvp * vec4(pos, 1)
+		void transform(const Vector3& pos, SoftVarying& out) const;
+	};
+
+	// fixed function stand-ins for the GLSL, a vertex proc fills in everything the pixel proc reads
+	typedef void (*SoftVertexProc)(const SoftUniforms& u, const SoftVertexIn& in, SoftVarying& out);
+	typedef Color (*SoftPixelProc)(const SoftUniforms& u, const SoftVarying& in);
+
+	// software rasterizer version of the MigTech shader, runs a proc in place of the compiled program
+	class SoftShader : public NullShader
+	{
+	protected:
+		SoftVertexProc _vertexProc;
+		SoftPixelProc _pixelProc;
+
+	public:
+		SoftShader(VDTYPE vdType, unsigned int hints, SoftVertexProc proc);
+		SoftShader(unsigned int hints, SoftPixelProc proc);
+		virtual ~SoftShader();
+
+		SoftVertexProc getVertexProc() const { return _vertexProc; }
+		SoftPixelProc getPixelProc() const { return _pixelProc; }
+
+	public:
+		// the procs for the built in (mtvs_/mtps_) shaders, nullptr if the name isn't one of them
+		static SoftVertexProc findVertexProc(const std::string& name);
+		static SoftPixelProc findPixelProc(const std::string& name);
+
+		// best guess from the hints for shaders nobody has described
+		static SoftVertexProc getDefaultVertexProc(unsigned int hints);
+		static SoftPixelProc getDefaultPixelProc(unsigned int hints);
+	};
+}
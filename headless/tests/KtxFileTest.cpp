@@ -0,0 +1,93 @@
+﻿#include "pch.h"
+#include "KtxFile.h"
+#include "HeadlessApp.h"
+
+#include <unistd.h>
+
+using namespace MigTech;
+
+///////////////////////////////////////////////////////////////////////////
+// load checks for KTX files whose size isn't a whole number of blocks
+
+#define GL_ENUM_ASTC_6x6 0x93B4
+
+static void putU32(byte* p, unsigned int v)
+{
+	memcpy(p, &v, 4);
+}
+
+// a 64x64 ASTC 6x6 KTX (v1) file, 11x11 blocks with partial blocks along the right and bottom edges
+static bool writeAstcKtx(const std::string& path)
+{
+	static const byte ident[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+	const unsigned int levelSize = 11*11*16;
+	std::vector<byte> file(64 + 4 + levelSize, 0);
+	memcpy(&file[0], ident, 12);
+	putU32(&file[12], 0x04030201);
+	putU32(&file[28], GL_ENUM_ASTC_6x6);
+	putU32(&file[32], 0x1908);
+	putU32(&file[36], 64);
+	putU32(&file[40], 64);
+	putU32(&file[52], 1);
+	putU32(&file[56], 1);
+	putU32(&file[64], levelSize);
+	for (unsigned int i = 0; i < levelSize; i++)
+		file[68 + i] = (byte) i;
+
+	FILE* pf = fopen(path.c_str(), "wb");
+	if (pf == nullptr)
+		return false;
+	bool ok = (fwrite(&file[0], 1, file.size(), pf) == file.size());
+	fclose(pf);
+	return ok;
+}
+
+static bool check(bool cond, const char* what)
+{
+	if (!cond)
+		printf("KtxFile: %s\n", what);
+	return cond;
+}
+
+int main()
+{
+	HeadlessUtil_setLogLevel(3);
+
+	char dir[] = "/tmp/mtktxXXXXXX";
+	if (mkdtemp(dir) == nullptr || !writeAstcKtx(std::string(dir) + "/astc6x6.ktx"))
+	{
+		printf("KtxFile: could not write the test file\n");
+		return 1;
+	}
+	HeadlessUtil_setContentDir(dir);
+
+	int failed = 0;
+
+	// GLES with ASTC takes the blocks as is, partial edge blocks included
+	ImageData data;
+	bool loaded = KtxFile::loadImage("astc6x6.ktx", LOAD_IMAGE_NONE, (1 << TEX_COMPRESSION_ASTC), data);
+	failed += (check(loaded, "ASTC 6x6 at 64x64 didn't load with ASTC caps") ? 0 : 1);
+	if (loaded)
+	{
+		failed += (check(data.compression == TEX_COMPRESSION_ASTC, "ASTC 6x6 wasn't kept compressed") ? 0 : 1);
+		failed += (check(data.blockWidth == 6 && data.blockHeight == 6, "ASTC 6x6 has the wrong block size") ? 0 : 1);
+		failed += (check(data.width == 64 && data.height == 64, "ASTC 6x6 has the wrong size") ? 0 : 1);
+		failed += (check(data.dataSize == 11*11*16 && data.pixels[11*11*16 - 1] == (byte) (11*11*16 - 1),
+			"ASTC 6x6 level data is wrong") ? 0 : 1);
+		data.release();
+	}
+
+	// a renderer that needs whole blocks has to decode it, and there's no CPU decoder for ASTC
+	ImageData wholeOnly;
+	loaded = KtxFile::loadImage("astc6x6.ktx", LOAD_IMAGE_NONE, (1 << TEX_COMPRESSION_ASTC) | TEX_CAPS_WHOLE_BLOCKS, wholeOnly);
+	failed += (check(!loaded, "ASTC 6x6 at 64x64 loaded for a renderer that needs whole blocks") ? 0 : 1);
+	if (loaded)
+		wholeOnly.release();
+
+	remove((std::string(dir) + "/astc6x6.ktx").c_str());
+	rmdir(dir);
+
+	if (failed > 0)
+		printf("%d KTX load checks failed\n", failed);
+	return (failed > 0 ? 1 : 0);
+}
@@ -0,0 +1,103 @@
+﻿#include "pch.h"
+#include "TextureCodec.h"
+
+using namespace MigTech;
+
+///////////////////////////////////////////////////////////////////////////
+// decoder checks against reference output for the ETC2 T, H and planar modes and EAC alpha
+//  the expected texels come from a separate decoder written against the bit layouts in the Khronos data format spec
+
+struct ETCCase
+{
+	const char* name;
+	byte block[8];
+	byte rgb[48];
+};
+
+static const ETCCase etcCases[] =
+{
+	{ "T", { 0xf2, 0x08, 0x94, 0xea, 0x27, 0xe6, 0x89, 0xc6 },
+	{
+		170, 0, 136, 170, 0, 136, 130, 45, 215, 170, 0, 136,
+		130, 45, 215, 153, 68, 238, 153, 68, 238, 153, 68, 238,
+		130, 45, 215, 130, 45, 215, 153, 68, 238, 170, 0, 136,
+		170, 0, 136, 130, 45, 215, 176, 91, 255, 176, 91, 255,
+	} },
+	{ "H", { 0x8a, 0xf2, 0x21, 0x1f, 0x9e, 0xe4, 0x91, 0xc5 },
+	{
+		0, 44, 27, 58, 126, 109, 0, 44, 27, 27, 0, 10,
+		58, 126, 109, 109, 75, 92, 109, 75, 92, 58, 126, 109,
+		27, 0, 10, 27, 0, 10, 109, 75, 92, 58, 126, 109,
+		58, 126, 109, 27, 0, 10, 109, 75, 92, 27, 0, 10,
+	} },
+	// bit 55 is filler in planar blocks, it must not leak into GO
+	{ "planar black", { 0x00, 0x80, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00 },
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	} },
+	{ "planar", { 0xb9, 0xbb, 0x0c, 0xba, 0xca, 0xc6, 0x63, 0xbc },
+	{
+		113, 187, 166, 113, 191, 149, 113, 195, 132, 113, 199, 114,
+		137, 147, 185, 137, 151, 168, 137, 155, 151, 137, 159, 134,
+		160, 108, 205, 160, 112, 187, 160, 116, 170, 160, 120, 153,
+		184, 68, 224, 184, 72, 207, 184, 76, 189, 184, 80, 172,
+	} },
+};
+
+static const byte eacBlock[8] = { 0x6d, 0x93, 0x2c, 0xde, 0xd6, 0x23, 0x7b, 0x2e };
+static const byte eacAlpha[16] =
+{
+	73, 217, 73, 136,
+	0, 0, 91, 118,
+	73, 55, 154, 136,
+	136, 154, 217, 154,
+};
+
+static bool checkETC(const ETCCase& test)
+{
+	byte rgba[64];
+	TextureCodec::decodeETC2Block(test.block, rgba, 4);
+	for (int i = 0; i < 16; i++)
+	{
+		const byte* exp = test.rgb + 3*i;
+		const byte* got = rgba + 4*i;
+		if (got[0] != exp[0] || got[1] != exp[1] || got[2] != exp[2] || got[3] != 255)
+		{
+			printf("ETC2 %s: texel (%d,%d) is %d,%d,%d,%d, expected %d,%d,%d,255\n", test.name, i % 4, i / 4,
+				got[0], got[1], got[2], got[3], exp[0], exp[1], exp[2]);
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool checkEAC()
+{
+	byte rgba[64];
+	memset(rgba, 0, sizeof(rgba));
+	TextureCodec::decodeEACAlphaBlock(eacBlock, rgba, 4);
+	for (int i = 0; i < 16; i++)
+	{
+		if (rgba[4*i + 3] != eacAlpha[i])
+		{
+			printf("EAC: texel (%d,%d) is %d, expected %d\n", i % 4, i / 4, rgba[4*i + 3], eacAlpha[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	int failed = 0;
+	for (unsigned int i = 0; i < sizeof(etcCases) / sizeof(etcCases[0]); i++)
+		failed += (checkETC(etcCases[i]) ? 0 : 1);
+	failed += (checkEAC() ? 0 : 1);
+
+	if (failed > 0)
+		printf("%d texture codec checks failed\n", failed);
+	return (failed > 0 ? 1 : 0);
+}
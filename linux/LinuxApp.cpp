@@ -0,0 +1,536 @@
+﻿#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <typeinfo>
+
+#include "pch.h"
+#include "../core/MigUtil.h"
+#include "../core/MigGame.h"
+#include "../core/PersistBase.h"
+#include "../android/OglRender.h"
+#include "../headless/NullAudio.h"
+#include "LinuxApp.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+using namespace MigTech;
+
+extern const std::string& plat_getFilesDir();
+extern const std::string& plat_getExternalFilesDir();
+
+static MigTech::MigGame* theGame = nullptr;
+static bool okToRun = true;
+
+static EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+static EGLSurface eglSurface = EGL_NO_SURFACE;
+static EGLContext eglContext = EGL_NO_CONTEXT;
+
+// the watchdog sleeps on a condition so shutting down doesn't have to wait out the period
+static pthread_t threadWatchdog;
+static pthread_mutex_t watchdogLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t watchdogWake = PTHREAD_COND_INITIALIZER;
+static bool watchdogRunning = false;
+
+///////////////////////////////////////////////////////////////////////////
+// watchdog thread
+
+static void* WatchdogThread(void* arg)
+{
+	int sleepPeriod = (int) reinterpret_cast<intptr_t>(arg);
+
+	pthread_mutex_lock(&watchdogLock);
+	while (watchdogRunning)
+	{
+		if (!MigUtil::checkWatchdog())
+		{
+			MigUtil::fatal("Watchdog triggered, dumping log file");
+			MigUtil::dumpLogToFile();
+
+			// log dumped so cancel the watchdog
+			break;
+		}
+
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += sleepPeriod;
+		pthread_cond_timedwait(&watchdogWake, &watchdogLock, &ts);
+	}
+	pthread_mutex_unlock(&watchdogLock);
+	return nullptr;
+}
+
+static void startWatchdog(int period)
+{
+	LOGINFO("(::startWatchdog) Starting watchdog thread, period is %d seconds", period);
+
+	watchdogRunning = true;
+	if (pthread_create(&threadWatchdog, nullptr, WatchdogThread, reinterpret_cast<void*>((intptr_t) period)) != 0)
+	{
+		LOGWARN("(::startWatchdog) Unable to start the watchdog thread");
+		watchdogRunning = false;
+	}
+}
+
+static void stopWatchdog()
+{
+	pthread_mutex_lock(&watchdogLock);
+	bool wasRunning = watchdogRunning;
+	watchdogRunning = false;
+	pthread_cond_signal(&watchdogWake);
+	pthread_mutex_unlock(&watchdogLock);
+
+	if (wasRunning)
+		pthread_join(threadWatchdog, nullptr);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// EGL context
+
+// checks a config attribute against a required value
+static bool checkConfigProperty(EGLDisplay display, EGLConfig config, EGLint attr, EGLint reqVal)
+{
+	EGLint retVal;
+	if (!eglGetConfigAttrib(display, config, attr, &retVal))
+		return false;
+	return (retVal >= reqVal);
+}
+
+// Mesa's surfaceless platform needs no window system or GPU (llvmpipe), otherwise falls back to the default display
+static EGLDisplay getDisplay()
+{
+	const char* clientExts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if (clientExts != nullptr && strstr(clientExts, "EGL_MESA_platform_surfaceless") != nullptr)
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay != nullptr)
+		{
+			EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+			if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr))
+				return display;
+			LOGWARN("(::getDisplay) Surfaceless display not available, trying the default display");
+		}
+	}
+
+	EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr))
+		return display;
+	return EGL_NO_DISPLAY;
+}
+
+// the game draws to the default framebuffer, so that's a pbuffer the size of the output
+static bool initEGL(int width, int height)
+{
+	// specify the attributes of the desired configuration
+	const EGLint attribs[] =
+	{
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_BLUE_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_RED_SIZE, 8,
+		EGL_DEPTH_SIZE, 16,
+		EGL_NONE
+	};
+
+	EGLDisplay display = getDisplay();
+	if (display == EGL_NO_DISPLAY)
+	{
+		LOGWARN("(::initEGL) No EGL display available");
+		return false;
+	}
+	eglDisplay = display;
+	LOGINFO("(::initEGL) %s %s", eglQueryString(display, EGL_VENDOR), eglQueryString(display, EGL_VERSION));
+
+	if (!eglBindAPI(EGL_OPENGL_ES_API))
+	{
+		LOGWARN("(::initEGL) eglBindAPI() failed");
+		return false;
+	}
+
+	// get the number of configurations available for this display
+	EGLint numConfigs = 0;
+	eglChooseConfig(display, attribs, nullptr, 0, &numConfigs);
+	LOGINFO("(::initEGL) eglChooseConfig() returned %d configs", numConfigs);
+	if (numConfigs <= 0)
+		return false;
+
+	// get the list
+	std::vector<EGLConfig> configs(numConfigs);
+	eglChooseConfig(display, attribs, &configs[0], numConfigs, &numConfigs);
+
+	// choose a configuration that matches the same profile as the Android app
+	EGLConfig finalConfig = 0;
+	for (int i = 0; i < numConfigs; i++)
+	{
+		// needs a depth buffer of at least 16 bits and rgb of 8 bits each
+		if (!checkConfigProperty(display, configs[i], EGL_DEPTH_SIZE, 16))
+			continue;
+		if (!checkConfigProperty(display, configs[i], EGL_RED_SIZE, 8))
+			continue;
+		if (!checkConfigProperty(display, configs[i], EGL_GREEN_SIZE, 8))
+			continue;
+		if (!checkConfigProperty(display, configs[i], EGL_BLUE_SIZE, 8))
+			continue;
+
+		finalConfig = configs[i];
+		LOGINFO("(::initEGL) Compatible EGL config found (%d)", i);
+		break;
+	}
+	if (finalConfig == 0)
+	{
+		LOGWARN("(::initEGL) No compatible EGL config");
+		return false;
+	}
+
+	// create the GL surface
+	const EGLint surfaceAttribs[] =
+	{
+		EGL_WIDTH, width,
+		EGL_HEIGHT, height,
+		EGL_NONE
+	};
+	eglSurface = eglCreatePbufferSurface(display, finalConfig, surfaceAttribs);
+	if (eglSurface == EGL_NO_SURFACE)
+	{
+		LOGWARN("(::initEGL) eglCreatePbufferSurface() failed");
+		return false;
+	}
+
+	// create the GL context (needs to support OpenGLES2)
+	const EGLint contextAttribs[] =
+	{
+		EGL_CONTEXT_CLIENT_VERSION, 2,
+		EGL_NONE
+	};
+	eglContext = eglCreateContext(display, finalConfig, EGL_NO_CONTEXT, contextAttribs);
+	if (eglContext == EGL_NO_CONTEXT)
+	{
+		LOGWARN("(::initEGL) eglCreateContext() failed");
+		return false;
+	}
+
+	// made that context the current context for the surface
+	if (eglMakeCurrent(display, eglSurface, eglSurface, eglContext) == EGL_FALSE)
+	{
+		LOGWARN("(::initEGL) eglMakeCurrent() failed");
+		return false;
+	}
+
+	LOGINFO("(::initEGL) %s (%s), surface is %dx%d", (const char*) glGetString(GL_RENDERER), (const char*) glGetString(GL_VERSION), width, height);
+	return true;
+}
+
+static void termEGL()
+{
+	if (eglDisplay != EGL_NO_DISPLAY)
+	{
+		eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (eglContext != EGL_NO_CONTEXT)
+			eglDestroyContext(eglDisplay, eglContext);
+		if (eglSurface != EGL_NO_SURFACE)
+			eglDestroySurface(eglDisplay, eglSurface);
+		eglTerminate(eglDisplay);
+	}
+	eglDisplay = EGL_NO_DISPLAY;
+	eglContext = EGL_NO_CONTEXT;
+	eglSurface = EGL_NO_SURFACE;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// entry points for the host program
+
+bool LinuxApp_create()
+{
+	// create the local files directory
+	const std::string& filesDir = plat_getFilesDir();
+	int resultCode = mkdir(filesDir.c_str(), 0770);
+	if (resultCode != 0 && errno != EEXIST)
+		LOGWARN("(LinuxApp_create) Unable to create local files dir '%s' %d", filesDir.c_str(), resultCode);
+
+	okToRun = true;
+	if (theGame == nullptr)
+	{
+		try
+		{
+			// initialize MigTech (renderer initialization will come later), there's no audio
+			MigTech::AudioBase* pAudio = new MigTech::NullAudio();
+			MigTech::PersistBase* pDataManager = new MigTech::SimplePersist();
+			if (!MigTech::MigGame::initGameEngine(pAudio, pDataManager))
+				okToRun = false;
+		}
+		catch (std::exception& ex)
+		{
+			MigTech::MigUtil::fatal("[%s] %s", typeid(ex).name(), ex.what());
+			MigTech::MigUtil::dumpLogToFile();
+			okToRun = false;
+		}
+	}
+	return okToRun;
+}
+
+bool LinuxApp_createGraphics(int width, int height)
+{
+	if (!okToRun)
+		return false;
+	if (!initEGL(width, height))
+	{
+		termEGL();
+		okToRun = false;
+		return false;
+	}
+
+	try
+	{
+		// initialize MigTech renderer
+		MigTech::RenderBase* pRtObj = new MigTech::OglRender();
+		MigTech::MigGame::initRenderer(pRtObj);
+		MigTech::MigUtil::theRend->setOutputSize(MigTech::Size(width, height));
+
+		if (theGame == nullptr)
+		{
+			// brand new game instance
+			theGame = allocGame();
+			theGame->onCreate();
+			theGame->onCreateGraphics();
+
+			// start watchdog thread
+			int watchdogPeriod = MigUtil::getWatchdogPeriod();
+			if (watchdogPeriod > 0)
+				startWatchdog(watchdogPeriod);
+		}
+		else
+			theGame->onCreateGraphics();
+
+		theGame->onWindowSizeChanged();
+	}
+	catch (std::exception& ex)
+	{
+		MigTech::MigUtil::fatal("[%s] %s", typeid(ex).name(), ex.what());
+		MigTech::MigUtil::dumpLogToFile();
+		okToRun = false;
+	}
+	return okToRun;
+}
+
+bool LinuxApp_step()
+{
+	try
+	{
+		if (okToRun && theGame != nullptr)
+		{
+			theGame->update();
+			theGame->render();
+
+			// nothing is shown, but the swap still ends the frame for the driver
+			eglSwapBuffers(eglDisplay, eglSurface);
+		}
+	}
+	catch (std::exception& ex)
+	{
+		MigTech::MigUtil::fatal("[%s] %s", typeid(ex).name(), ex.what());
+		MigTech::MigUtil::dumpLogToFile();
+		okToRun = false;
+	}
+	return okToRun;
+}
+
+void LinuxApp_finish()
+{
+	// blocks until the driver has finished the queued work, so frame timings include the rasterization
+	if (eglContext != EGL_NO_CONTEXT)
+		glFinish();
+}
+
+void LinuxApp_destroyGraphics()
+{
+	try
+	{
+		MigTech::MigUtil::suspendWatchdog();
+
+		if (theGame != nullptr)
+			theGame->onDestroyGraphics();
+		MigTech::MigGame::termRenderer();
+	}
+	catch (std::exception& ex)
+	{
+		MigTech::MigUtil::fatal("[%s] %s", typeid(ex).name(), ex.what());
+		MigTech::MigUtil::dumpLogToFile();
+		okToRun = false;
+	}
+
+	termEGL();
+}
+
+void LinuxApp_destroy()
+{
+	stopWatchdog();
+
+	try
+	{
+		if (theGame != nullptr)
+		{
+			theGame->onDestroy();
+			delete theGame;
+		}
+		theGame = nullptr;
+
+		MigTech::MigGame::termGameEngine();
+	}
+	catch (std::exception& ex)
+	{
+		MigTech::MigUtil::fatal("[%s] %s", typeid(ex).name(), ex.what());
+		MigTech::MigUtil::dumpLogToFile();
+	}
+
+	okToRun = false;
+}
+
+void LinuxApp_pointerPressed(float x, float y)
+{
+	try
+	{
+		if (theGame != nullptr)
+		{
+			MigTech::Size size = MigTech::MigUtil::theRend->getOutputSize();
+			theGame->onPointerPressed(x / size.width, y / size.height);
+		}
+	}
+	catch (std::exception& ex)
+	{
+		MigTech::MigUtil::fatal("[%s] %s", typeid(ex).name(), ex.what());
+		MigTech::MigUtil::dumpLogToFile();
+		okToRun = false;
+	}
+}
+
+void LinuxApp_pointerReleased(float x, float y)
+{
+	try
+	{
+		if (theGame != nullptr)
+		{
+			MigTech::Size size = MigTech::MigUtil::theRend->getOutputSize();
+			theGame->onPointerReleased(x / size.width, y / size.height);
+		}
+	}
+	catch (std::exception& ex)
+	{
+		MigTech::MigUtil::fatal("[%s] %s", typeid(ex).name(), ex.what());
+		MigTech::MigUtil::dumpLogToFile();
+		okToRun = false;
+	}
+}
+
+void LinuxApp_pointerMoved(float x, float y)
+{
+	try
+	{
+		if (theGame != nullptr)
+		{
+			MigTech::Size size = MigTech::MigUtil::theRend->getOutputSize();
+			theGame->onPointerMoved(x / size.width, y / size.height, true);
+		}
+	}
+	catch (std::exception& ex)
+	{
+		MigTech::MigUtil::fatal("[%s] %s", typeid(ex).name(), ex.what());
+		MigTech::MigUtil::dumpLogToFile();
+		okToRun = false;
+	}
+}
+
+bool LinuxApp_backKey()
+{
+	bool ret = false;
+	try
+	{
+		if (theGame != nullptr)
+			ret = theGame->onBackKey();
+	}
+	catch (std::exception& ex)
+	{
+		MigTech::MigUtil::fatal("[%s] %s", typeid(ex).name(), ex.what());
+		MigTech::MigUtil::dumpLogToFile();
+		okToRun = false;
+	}
+	return ret;
+}
+
+bool LinuxApp_isRunning()
+{
+	return okToRun;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// the utility functions the Ogl* classes expect from the Android app (see android/AndroidApp.h)
+
+static FILE* openAsset(const std::string& name)
+{
+	// shaders have their own directories, everything else comes from the content
+	FILE* pf = nullptr;
+	const std::vector<std::string>& shaderDirs = LinuxUtil_getShaderDirs();
+	for (unsigned int i = 0; i < shaderDirs.size() && pf == nullptr; i++)
+		pf = fopen((shaderDirs[i] + name).c_str(), "rb");
+	if (pf == nullptr)
+		pf = fopen((LinuxUtil_getContentDir() + name).c_str(), "rb");
+	return pf;
+}
+
+int AndroidUtil_getAssetBuffer(const std::string& name, void* buf, int bufLen)
+{
+	if (buf == nullptr && bufLen > 0)
+		throw std::invalid_argument("(AndroidUtil_getAssetBuffer) No buffer provided");
+	long len = -1;
+
+	FILE* pf = openAsset(name);
+	if (pf)
+	{
+		fseek(pf, 0, SEEK_END);
+		len = ftell(pf);
+		fseek(pf, 0, SEEK_SET);
+		if (len <= bufLen)
+		{
+			memset(buf, 0, bufLen);
+			if (fread(buf, 1, len, pf) < (size_t) len)
+			{
+				len = -1;  // this is an error
+				LOGWARN("(AndroidUtil_getAssetBuffer) Failed to read %s\n", name.c_str());
+			}
+		}
+		else if (bufLen > 0)
+			LOGWARN("(AndroidUtil_getAssetBuffer) Provided buffer size is too small\n");
+
+		fclose(pf);
+	}
+	else
+		LOGWARN("(AndroidUtil_getAssetBuffer) Failed to open %s\n", name.c_str());
+
+	return (int) len;
+}
+
+const std::string& AndroidUtil_getFilesDir()
+{
+	return plat_getFilesDir();
+}
+
+const std::string& AndroidUtil_getExtFilesDir()
+{
+	return plat_getExternalFilesDir();
+}
+
+GLenum checkGLError(const char* callerName, const char* funcName)
+{
+	GLenum err = glGetError();
+	if (err != GL_NO_ERROR)
+	{
+		std::string fmt = "(";
+		fmt += callerName;
+		fmt += ") ";
+		fmt += funcName;
+		fmt += " returned %d";
+		LOGWARN(fmt.c_str(), err);
+	}
+	return err;
+}
@@ -0,0 +1,44 @@
+﻿#pragma once
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific
+
+#include "pch.h"
+#include "../core/MigInclude.h"
+#include "../core/MigGame.h"
+
+///////////////////////////////////////////////////////////////////////////
+// application specific
+
+extern MigTech::MigGame* allocGame();
+
+///////////////////////////////////////////////////////////////////////////
+// configuration, set by the host program before LinuxApp_create()
+
+// game content, shaders are looked for in the shader directories (in the order added) before the content
+void LinuxUtil_setContentDir(const std::string& dir);
+void LinuxUtil_addShaderDir(const std::string& dir);
+void LinuxUtil_setFilesDir(const std::string& dir);
+const std::string& LinuxUtil_getContentDir();
+const std::vector<std::string>& LinuxUtil_getShaderDirs();
+
+// a non-zero step makes the game timer advance by exactly that many ticks per frame
+void LinuxUtil_setFixedTimestep(uint64 ticks);
+
+// log messages below this level (0=debug, 1=info, 2=warn, 3=error, 4=fatal) are dropped
+void LinuxUtil_setLogLevel(int level);
+
+///////////////////////////////////////////////////////////////////////////
+// entry points for the host program, same lifecycle as the Android app
+
+bool LinuxApp_create();
+bool LinuxApp_createGraphics(int width, int height);
+bool LinuxApp_step();
+void LinuxApp_finish();
+void LinuxApp_destroyGraphics();
+void LinuxApp_destroy();
+void LinuxApp_pointerPressed(float x, float y);
+void LinuxApp_pointerReleased(float x, float y);
+void LinuxApp_pointerMoved(float x, float y);
+bool LinuxApp_backKey();
+bool LinuxApp_isRunning();
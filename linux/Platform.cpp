@@ -0,0 +1,190 @@
+﻿#include "pch.h"
+#include "../core/MigUtil.h"
+#include "../core/Timer.h"
+#include "LinuxApp.h"
+
+#include <sys/stat.h>
+
+using namespace MigTech;
+
+///////////////////////////////////////////////////////////////////////////
+// linux configuration
+
+static std::string lxContentDir;
+static std::vector<std::string> lxShaderDirs;
+static std::string lxFilesDir = ".";
+static uint64 lxFixedStep = 0;
+static int lxLogLevel = 1;
+
+static std::string withSlash(const std::string& dir)
+{
+	if (!dir.empty() && dir[dir.length() - 1] != '/')
+		return dir + "/";
+	return dir;
+}
+
+void LinuxUtil_setContentDir(const std::string& dir)
+{
+	lxContentDir = withSlash(dir);
+}
+
+void LinuxUtil_addShaderDir(const std::string& dir)
+{
+	if (!dir.empty())
+		lxShaderDirs.push_back(withSlash(dir));
+}
+
+void LinuxUtil_setFilesDir(const std::string& dir)
+{
+	lxFilesDir = dir;
+}
+
+const std::string& LinuxUtil_getContentDir()
+{
+	return lxContentDir;
+}
+
+const std::vector<std::string>& LinuxUtil_getShaderDirs()
+{
+	return lxShaderDirs;
+}
+
+void LinuxUtil_setFixedTimestep(uint64 ticks)
+{
+	lxFixedStep = ticks;
+}
+
+void LinuxUtil_setLogLevel(int level)
+{
+	lxLogLevel = level;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific configuration bits
+
+unsigned int plat_getBits()
+{
+	return PLAT_LINUX;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific timer functions
+
+static double startTime;
+static double lastTime;
+static double maxDelta;
+static uint64 totalTicks;
+
+static double getMonotonicTime()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1E9;
+}
+
+bool plat_initTimer()
+{
+	startTime = getMonotonicTime();
+	lastTime = startTime;
+	totalTicks = 0;
+
+	maxDelta = 0.1;
+	return true;
+}
+
+uint64 plat_getRawTicks()
+{
+	// the raw ticks are always wall clock, they're used for profiling and the watchdog
+	double timeDelta = getMonotonicTime() - startTime;
+	return (uint64)(timeDelta * Timer::ticksPerSecond);
+}
+
+uint64 plat_getCurrentTicks()
+{
+	// fixed timestep, so a run is the same no matter how long each frame really took
+	if (lxFixedStep > 0)
+	{
+		totalTicks += lxFixedStep;
+		return totalTicks;
+	}
+
+	// compute elapsed time since last update
+	double currentTime = getMonotonicTime();
+	double timeDelta = currentTime - lastTime;
+	lastTime = currentTime;
+
+	// clamp excessively large time deltas (e.g. after paused in the debugger)
+	if (timeDelta > maxDelta)
+		timeDelta = maxDelta;
+
+	totalTicks += (uint64)(timeDelta * Timer::ticksPerSecond);
+	return totalTicks;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific logging functions
+
+bool plat_isDebuggerPresent()
+{
+	// log output goes to stderr
+	return true;
+}
+
+void plat_outputDebugString(const char* msg, int level)
+{
+	static const char prefix[] = { 'd', 'i', 'w', 'e', 'f' };
+
+	if (level >= lxLogLevel)
+		fprintf(stderr, "[%c] %s\n", (level >= 0 && level < (int)sizeof(prefix) ? prefix[level] : '?'), msg);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// platform specific file IO utilities
+
+byte* plat_loadFileBuffer(const char* filePath, int& length)
+{
+	length = 0;
+
+	// compose the full path name
+	std::string fullPath = lxContentDir + filePath;
+
+	// retrieve the file size
+	struct stat st;
+	if (stat(fullPath.c_str(), &st) != 0)
+	{
+		LOGWARN("(::plat_loadFileBuffer) file '%s' doesn't exist", filePath);
+		return nullptr;
+	}
+
+	FILE* pf = fopen(fullPath.c_str(), "rb");
+	if (pf == nullptr)
+	{
+		LOGWARN("(::plat_loadFileBuffer) Could not open file %s", filePath);
+		return nullptr;
+	}
+
+	byte* pFile = new byte[st.st_size];
+	if (fread(pFile, 1, st.st_size, pf) < (size_t)st.st_size)
+	{
+		LOGWARN("(::plat_loadFileBuffer) Could not read file %s", filePath);
+		delete [] pFile;
+		pFile = nullptr;
+	}
+	else
+		length = st.st_size;
+
+	fclose(pf);
+	return pFile;
+}
+
+const std::string& plat_getFilesDir()
+{
+	return lxFilesDir;
+}
+
+const std::string& plat_getExternalFilesDir()
+{
+	// there is no external storage
+	static std::string externalDir;
+	return externalDir;
+}
@@ -0,0 +1,23 @@
+﻿#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include <string>
+#include <stdexcept>
+#include <map>
+#include <list>
+#include <vector>
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+// included in Windows headers but not defined by POSIX
+#define uint64 uint64_t
+#define ARRAYSIZE(a) sizeof(a)/sizeof(a[0])
+#define byte unsigned char
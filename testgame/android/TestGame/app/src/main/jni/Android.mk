@@ -24,26 +24,36 @@ LOCAL_SRC_FILES := ../../../../../../main.cpp \
 				   ../../../../../../screen.cpp \
 				   ../../../../../../texture.cpp \
 				   ../../../../../../../core/AnimList.cpp \
+				   ../../../../../../../core/AssetLoader.cpp \
 				   ../../../../../../../core/AudioBase.cpp \
 				   ../../../../../../../core/BgBase.cpp \
 				   ../../../../../../../core/Controls.cpp \
+				   ../../../../../../../core/CurvePool.cpp \
 				   ../../../../../../../core/DemoBase.cpp \
 				   ../../../../../../../core/Dialog.cpp \
 				   ../../../../../../../core/Font.cpp \
+				   ../../../../../../../core/ImageDecoder.cpp \
+				   ../../../../../../../core/KtxFile.cpp \
 				   ../../../../../../../core/Matrix.cpp \
 				   ../../../../../../../core/MigBase.cpp \
 				   ../../../../../../../core/MigGame.cpp \
 				   ../../../../../../../core/MigUtil.cpp \
+				   ../../../../../../../core/MipChain.cpp \
 				   ../../../../../../../core/MovieClip.cpp \
 				   ../../../../../../../core/OverlayBase.cpp \
+				   ../../../../../../../core/ParticleEmitter.cpp \
 				   ../../../../../../../core/PerfMon.cpp \
 				   ../../../../../../../core/PersistBase.cpp \
+				   ../../../../../../../core/Profiler.cpp \
 				   ../../../../../../../core/RenderBase.cpp \
+				   ../../../../../../../core/ResourceCache.cpp \
 				   ../../../../../../../core/ScreenBase.cpp \
+				   ../../../../../../../core/SpriteBatch.cpp \
+				   ../../../../../../../core/TextureAtlas.cpp \
+				   ../../../../../../../core/TextureCodec.cpp \
 				   ../../../../../../../core/Timer.cpp \
 				   ../../../../../../../android/AndroidApp.cpp \
 				   ../../../../../../../android/OglImage.cpp \
-				   ../../../../../../../android/OglMatrix.cpp \
 				   ../../../../../../../android/OglObject.cpp \
 				   ../../../../../../../android/OglProgram.cpp \
 				   ../../../../../../../android/OglRender.cpp \
@@ -128,7 +128,7 @@ void Cube::Render()
 		m_matrix.identity();
 		m_matrix.rotateY(m_rotateDir*m_rotateY);
 		m_matrix.translate(m_translateX, m_translateY, 0);
-		MigUtil::theRend->setModelMatrix(m_matrix);
+		MigUtil::theRend->setModelMatrix(&m_matrix);
 
 		MigUtil::theRend->setObjectColor(Color(1, 1, 1, m_alpha));
 		MigUtil::theRend->setBlending(BLEND_STATE_SRC_ALPHA);
@@ -257,8 +257,8 @@ bool TestScreen::render()
 	MigUtil::theRend->setProjectionMatrix(nullptr);
 	MigUtil::theRend->setViewMatrix(nullptr);
 
-	MigUtil::theRend->setProjectionMatrix(m_projMatrix);
-	MigUtil::theRend->setViewMatrix(m_viewMatrix);
+	MigUtil::theRend->setProjectionMatrix(&m_projMatrix);
+	MigUtil::theRend->setViewMatrix(&m_viewMatrix);
 	m_btmText->draw(0.5f, 0.5f, 1, 0.5f);
 	if (m_txtObj != nullptr)
 		m_txtObj->Render();
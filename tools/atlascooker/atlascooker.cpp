@@ -0,0 +1,501 @@
+// atlascooker.cpp : packs the images declared in an atlas file into power of two pages plus an index the game loads
+//
+// usage: atlascooker <declaration xml> [-i <image dir>] [-o <output dir>]
+//   the declaration lists the atlases and the images that go into each one:
+//
+//     <Atlases Index="atlas.xml">
+//       <Atlas Name="ui" MaxSize="512" Padding="2">
+//         <Image File="checkbox.png" />
+//       </Atlas>
+//     </Atlases>
+//
+//   every atlas is written as one or more pages (ui_0.png, ui_1.png, ...) and the index maps each image name
+//   to its page and pixel rect, the padding around each image repeats its edge pixels so linear filtering
+//   doesn't pick up the neighbours
+//
+
+#include "stdafx.h"
+#include "../../core/libpng/png.h"
+#include "../../core/tinyxml/tinyxml2.h"
+
+using namespace tinyxml2;
+
+struct CookOptions
+{
+	std::string declPath;
+	std::string imageDir;
+	std::string outputDir;
+};
+
+struct SourceImage
+{
+	std::string name;
+	int width;
+	int height;
+	std::vector<byte> rgba;
+
+	// where it landed (pixel rect, padding not included)
+	int page;
+	int x, y;
+};
+
+struct AtlasPage
+{
+	std::string file;
+	int width;
+	int height;
+	std::vector<int> images;
+};
+
+// a skyline segment, the packed area below it is considered full
+struct SkyNode
+{
+	int x, y, w;
+};
+
+///////////////////////////////////////////////////////////////////////////
+// images
+
+static bool LoadPNG(const std::string& path, SourceImage& img)
+{
+	FILE* fp = fopen(path.c_str(), "rb");
+	if (fp == NULL)
+		return false;
+
+	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	png_infop info_ptr = (png_ptr != NULL ? png_create_info_struct(png_ptr) : NULL);
+	if (info_ptr == NULL)
+	{
+		png_destroy_read_struct(&png_ptr, NULL, NULL);
+		fclose(fp);
+		return false;
+	}
+
+	// everything comes out as 8 bit RGB or RGBA
+	png_init_io(png_ptr, fp);
+	png_read_png(png_ptr, info_ptr, PNG_TRANSFORM_EXPAND | PNG_TRANSFORM_STRIP_16 | PNG_TRANSFORM_PACKING | PNG_TRANSFORM_GRAY_TO_RGB, NULL);
+	img.width = png_get_image_width(png_ptr, info_ptr);
+	img.height = png_get_image_height(png_ptr, info_ptr);
+	int channels = png_get_channels(png_ptr, info_ptr);
+	png_bytepp rows = png_get_rows(png_ptr, info_ptr);
+
+	img.rgba.resize(4 * img.width * img.height);
+	for (int y = 0; y < img.height; y++)
+	{
+		for (int x = 0; x < img.width; x++)
+		{
+			byte* pdst = &img.rgba[4 * (y*img.width + x)];
+			const byte* psrc = rows[y] + channels*x;
+			pdst[0] = psrc[0];
+			pdst[1] = psrc[1];
+			pdst[2] = psrc[2];
+			pdst[3] = (channels == 4 ? psrc[3] : 255);
+		}
+	}
+
+	png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+	fclose(fp);
+	return (channels == 3 || channels == 4);
+}
+
+static bool SavePNG(const std::string& path, int width, int height, const std::vector<byte>& rgba)
+{
+	FILE* fp = fopen(path.c_str(), "wb");
+	if (fp == NULL)
+		return false;
+
+	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	png_infop info_ptr = (png_ptr != NULL ? png_create_info_struct(png_ptr) : NULL);
+	if (info_ptr == NULL)
+	{
+		png_destroy_write_struct(&png_ptr, NULL);
+		fclose(fp);
+		return false;
+	}
+
+	std::vector<png_bytep> rows(height);
+	for (int y = 0; y < height; y++)
+		rows[y] = (png_bytep) &rgba[4 * y * width];
+
+	png_init_io(png_ptr, fp);
+	png_set_IHDR(png_ptr, info_ptr, width, height, 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
+		PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	png_set_rows(png_ptr, info_ptr, &rows[0]);
+	png_write_png(png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
+
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+	fclose(fp);
+	return true;
+}
+
+// copies the image into the page and repeats its edges out into the padding
+static void BlitPadded(const SourceImage& img, int padding, int pageWidth, std::vector<byte>& page)
+{
+	for (int y = -padding; y < img.height + padding; y++)
+	{
+		int sy = (y < 0 ? 0 : (y >= img.height ? img.height - 1 : y));
+		for (int x = -padding; x < img.width + padding; x++)
+		{
+			int sx = (x < 0 ? 0 : (x >= img.width ? img.width - 1 : x));
+			const byte* psrc = &img.rgba[4 * (sy*img.width + sx)];
+			byte* pdst = &page[4 * ((img.y + y)*pageWidth + img.x + x)];
+			memcpy(pdst, psrc, 4);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////
+// packing
+
+static int NextPowerOf2(int n)
+{
+	int p = 1;
+	while (p < n)
+		p *= 2;
+	return p;
+}
+
+// bottom-left skyline placement, returns false if the rect doesn't fit anywhere
+static bool SkylineFind(const std::vector<SkyNode>& sky, int w, int h, int pageWidth, int pageHeight, int& bestNode, int& bestX, int& bestY)
+{
+	bestNode = -1;
+	bestY = pageHeight;
+	int bestWidth = pageWidth;
+	for (size_t i = 0; i < sky.size(); i++)
+	{
+		int x = sky[i].x;
+		if (x + w > pageWidth)
+			break;
+
+		// the rect sits on the highest segment it spans
+		int y = 0;
+		int left = w;
+		for (size_t j = i; left > 0; j++)
+		{
+			if (sky[j].y > y)
+				y = sky[j].y;
+			left -= sky[j].w;
+		}
+		if (y + h > pageHeight)
+			continue;
+
+		if (y < bestY || (y == bestY && sky[i].w < bestWidth))
+		{
+			bestNode = (int) i;
+			bestX = x;
+			bestY = y;
+			bestWidth = sky[i].w;
+		}
+	}
+	return (bestNode >= 0);
+}
+
+static void SkylineAdd(std::vector<SkyNode>& sky, int node, int x, int y, int w, int h)
+{
+	SkyNode newNode = { x, y + h, w };
+	sky.insert(sky.begin() + node, newNode);
+
+	// trim or remove the segments the new one covers
+	for (size_t i = node + 1; i < sky.size(); i++)
+	{
+		int overlap = (sky[i - 1].x + sky[i - 1].w) - sky[i].x;
+		if (overlap <= 0)
+			break;
+		sky[i].x += overlap;
+		sky[i].w -= overlap;
+		if (sky[i].w > 0)
+			break;
+		sky.erase(sky.begin() + i);
+		i--;
+	}
+
+	// merge neighbours at the same height
+	for (size_t i = 0; i + 1 < sky.size(); i++)
+	{
+		if (sky[i].y == sky[i + 1].y)
+		{
+			sky[i].w += sky[i + 1].w;
+			sky.erase(sky.begin() + i + 1);
+			i--;
+		}
+	}
+}
+
+// places as many of the pending images as will fit, returns the ones that were placed
+static std::vector<int> PackPage(std::vector<SourceImage>& images, const std::vector<int>& pending, int padding, int pageWidth, int pageHeight)
+{
+	std::vector<SkyNode> sky;
+	SkyNode root = { 0, 0, pageWidth };
+	sky.push_back(root);
+
+	std::vector<int> placed;
+	for (size_t i = 0; i < pending.size(); i++)
+	{
+		SourceImage& img = images[pending[i]];
+		int node, x, y;
+		if (SkylineFind(sky, img.width + 2*padding, img.height + 2*padding, pageWidth, pageHeight, node, x, y))
+		{
+			SkylineAdd(sky, node, x, y, img.width + 2*padding, img.height + 2*padding);
+			img.x = x + padding;
+			img.y = y + padding;
+			placed.push_back(pending[i]);
+		}
+	}
+	return placed;
+}
+
+static bool TallerFirst(const SourceImage* a, const SourceImage* b)
+{
+	if (a->height != b->height)
+		return (a->height > b->height);
+	if (a->width != b->width)
+		return (a->width > b->width);
+	return (a->name < b->name);
+}
+
+static bool SmallerPage(const std::pair<int, int>& a, const std::pair<int, int>& b)
+{
+	if (a.first * a.second != b.first * b.second)
+		return (a.first * a.second < b.first * b.second);
+	return (abs(a.first - a.second) < abs(b.first - b.second));
+}
+
+// fills the smallest page that takes everything that's left, or a full size page if nothing smaller will do
+static bool PackAtlas(std::vector<SourceImage>& images, int maxSize, int padding, std::vector<AtlasPage>& pages)
+{
+	std::vector<const SourceImage*> order;
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		if (images[i].width + 2*padding > maxSize || images[i].height + 2*padding > maxSize)
+		{
+			printf("  %s: %dx%d doesn't fit in a %dx%d page\n", images[i].name.c_str(), images[i].width, images[i].height, maxSize, maxSize);
+			return false;
+		}
+		order.push_back(&images[i]);
+	}
+	std::sort(order.begin(), order.end(), TallerFirst);
+
+	std::vector<int> pending;
+	for (size_t i = 0; i < order.size(); i++)
+		pending.push_back((int) (order[i] - &images[0]));
+
+	while (!pending.empty())
+	{
+		int area = 0;
+		for (size_t i = 0; i < pending.size(); i++)
+		{
+			const SourceImage& img = images[pending[i]];
+			area += (img.width + 2*padding) * (img.height + 2*padding);
+		}
+
+		// the smallest page (squarest first) that takes everything, otherwise a full size one
+		std::vector<std::pair<int, int> > sizes;
+		for (int w = 1; w <= maxSize; w *= 2)
+		{
+			for (int h = 1; h <= maxSize; h *= 2)
+			{
+				if (w * h >= area)
+					sizes.push_back(std::make_pair(w, h));
+			}
+		}
+		std::sort(sizes.begin(), sizes.end(), SmallerPage);
+
+		int w = maxSize, h = maxSize;
+		std::vector<int> placed;
+		for (size_t i = 0; i < sizes.size(); i++)
+		{
+			placed = PackPage(images, pending, padding, sizes[i].first, sizes[i].second);
+			if (placed.size() == pending.size())
+			{
+				w = sizes[i].first;
+				h = sizes[i].second;
+				break;
+			}
+		}
+		if (placed.size() != pending.size())
+			placed = PackPage(images, pending, padding, w, h);
+
+		AtlasPage page;
+		page.width = w;
+		page.height = h;
+		page.images = placed;
+		for (size_t i = 0; i < placed.size(); i++)
+			images[placed[i]].page = (int) pages.size();
+		pages.push_back(page);
+
+		std::vector<int> left;
+		for (size_t i = 0; i < pending.size(); i++)
+		{
+			if (std::find(placed.begin(), placed.end(), pending[i]) == placed.end())
+				left.push_back(pending[i]);
+		}
+		pending.swap(left);
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// cooking
+
+static bool CookAtlas(const CookOptions& opts, XMLElement* xml, XMLDocument& index, XMLElement* indexRoot)
+{
+	const char* name = xml->Attribute("Name");
+	if (name == NULL)
+	{
+		printf("Atlas has no name\n");
+		return false;
+	}
+	int maxSize = 1024;
+	int padding = 2;
+	xml->QueryIntAttribute("MaxSize", &maxSize);
+	xml->QueryIntAttribute("Padding", &padding);
+	if (maxSize != NextPowerOf2(maxSize) || padding < 0)
+	{
+		printf("Atlas %s: the max size must be a power of 2\n", name);
+		return false;
+	}
+
+	std::vector<SourceImage> images;
+	for (XMLElement* elem = xml->FirstChildElement("Image"); elem != NULL; elem = elem->NextSiblingElement("Image"))
+	{
+		const char* file = elem->Attribute("File");
+		if (file == NULL)
+			continue;
+
+		SourceImage img;
+		img.name = file;
+		img.page = -1;
+		if (!LoadPNG(opts.imageDir + "/" + file, img))
+		{
+			printf("  %s: could not load\n", file);
+			return false;
+		}
+		images.push_back(img);
+	}
+	if (images.empty())
+	{
+		printf("Atlas %s: no images\n", name);
+		return true;
+	}
+
+	std::vector<AtlasPage> pages;
+	if (!PackAtlas(images, maxSize, padding, pages))
+		return false;
+
+	printf("Atlas %s: %d images in %d page%s\n", name, (int) images.size(), (int) pages.size(), (pages.size() > 1 ? "s" : ""));
+	for (size_t p = 0; p < pages.size(); p++)
+	{
+		AtlasPage& page = pages[p];
+		char pageFile[256];
+		sprintf(pageFile, "%s_%d.png", name, (int) p);
+		page.file = pageFile;
+
+		// unused space stays transparent black
+		std::vector<byte> rgba(4 * page.width * page.height, 0);
+		int used = 0;
+		for (size_t i = 0; i < page.images.size(); i++)
+		{
+			const SourceImage& img = images[page.images[i]];
+			BlitPadded(img, padding, page.width, rgba);
+			used += img.width * img.height;
+		}
+
+		std::string outPath = opts.outputDir + "/" + page.file;
+		if (!SavePNG(outPath, page.width, page.height, rgba))
+		{
+			printf("  could not write %s\n", outPath.c_str());
+			return false;
+		}
+		printf("  %s: %dx%d, %d images, %.1f%% used\n", page.file.c_str(), page.width, page.height,
+			(int) page.images.size(), (100.0 * used) / (page.width * page.height));
+
+		XMLElement* pageElem = index.NewElement("Page");
+		pageElem->SetAttribute("File", page.file.c_str());
+		pageElem->SetAttribute("Width", page.width);
+		pageElem->SetAttribute("Height", page.height);
+		for (size_t i = 0; i < page.images.size(); i++)
+		{
+			const SourceImage& img = images[page.images[i]];
+			XMLElement* imageElem = index.NewElement("Image");
+			imageElem->SetAttribute("Name", img.name.c_str());
+			imageElem->SetAttribute("X", img.x);
+			imageElem->SetAttribute("Y", img.y);
+			imageElem->SetAttribute("W", img.width);
+			imageElem->SetAttribute("H", img.height);
+			pageElem->InsertEndChild(imageElem);
+		}
+		indexRoot->InsertEndChild(pageElem);
+	}
+	return true;
+}
+
+static void PrintUsage()
+{
+	printf("usage: atlascooker <declaration xml> [-i <image dir>] [-o <output dir>]\n");
+	printf("  -i   where the source images are, the declaration's folder by default\n");
+	printf("  -o   where the pages and the index go, the image dir by default\n");
+}
+
+int main(int argc, char* argv[])
+{
+	CookOptions opts;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "-i" && i + 1 < argc)
+			opts.imageDir = argv[++i];
+		else if (arg == "-o" && i + 1 < argc)
+			opts.outputDir = argv[++i];
+		else if (opts.declPath.empty() && arg[0] != '-')
+			opts.declPath = arg;
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (opts.declPath.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+	if (opts.imageDir.empty())
+	{
+		size_t slash = opts.declPath.find_last_of("/\\");
+		opts.imageDir = (slash != std::string::npos ? opts.declPath.substr(0, slash) : ".");
+	}
+	if (opts.outputDir.empty())
+		opts.outputDir = opts.imageDir;
+
+	XMLDocument decl;
+	if (decl.LoadFile(opts.declPath.c_str()) != XML_SUCCESS || decl.FirstChildElement("Atlases") == NULL)
+	{
+		printf("Could not read %s\n", opts.declPath.c_str());
+		return 1;
+	}
+	XMLElement* declRoot = decl.FirstChildElement("Atlases");
+	const char* indexName = declRoot->Attribute("Index");
+
+	XMLDocument index;
+	index.InsertEndChild(index.NewDeclaration());
+	XMLElement* indexRoot = index.NewElement("AtlasIndex");
+	index.InsertEndChild(indexRoot);
+
+	int failed = 0;
+	for (XMLElement* elem = declRoot->FirstChildElement("Atlas"); elem != NULL; elem = elem->NextSiblingElement("Atlas"))
+	{
+		if (!CookAtlas(opts, elem, index, indexRoot))
+			failed++;
+	}
+	if (failed > 0)
+		return 1;
+
+	std::string indexPath = opts.outputDir + "/" + (indexName != NULL ? indexName : "atlas.xml");
+	if (index.SaveFile(indexPath.c_str()) != XML_SUCCESS)
+	{
+		printf("Could not write %s\n", indexPath.c_str());
+		return 1;
+	}
+	printf("Index written to %s\n", indexPath.c_str());
+	return 0;
+}
@@ -0,0 +1,404 @@
+// encoder.cpp : block encoders for the texture cooker
+//
+
+#include "stdafx.h"
+#include "encoder.h"
+
+// ETC1 modifier tables (small, large)
+static const int etcModifiers[8][2] = { { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 } };
+
+// EAC alpha modifier tables
+static const int eacModifiers[16][8] =
+{
+	{ -3, -6, -9, -15, 2, 5, 8, 14 },
+	{ -3, -7, -10, -13, 2, 6, 9, 12 },
+	{ -2, -5, -8, -13, 1, 4, 7, 12 },
+	{ -2, -4, -6, -13, 1, 3, 5, 12 },
+	{ -3, -6, -8, -12, 2, 5, 7, 11 },
+	{ -3, -7, -9, -11, 2, 6, 8, 10 },
+	{ -4, -7, -8, -11, 3, 6, 7, 10 },
+	{ -3, -5, -8, -11, 2, 4, 7, 10 },
+	{ -2, -6, -8, -10, 1, 5, 7, 9 },
+	{ -2, -5, -8, -10, 1, 4, 7, 9 },
+	{ -2, -4, -8, -10, 1, 3, 7, 9 },
+	{ -2, -5, -7, -10, 1, 4, 6, 9 },
+	{ -3, -4, -7, -10, 2, 3, 6, 9 },
+	{ -1, -2, -3, -10, 0, 1, 2, 9 },
+	{ -4, -6, -8, -9, 3, 5, 7, 8 },
+	{ -3, -5, -7, -9, 2, 4, 6, 8 }
+};
+
+static inline int ClampByte(int v)
+{
+	return (v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static inline int Square(int v)
+{
+	return v*v;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// ETC1 / ETC2 RGB
+
+struct EtcSubBlock
+{
+	int base[3];		// quantized (4 or 5 bits)
+	int table;
+	int error;
+};
+
+// texels of a sub-block, as (x, y)
+static void GetSubBlockTexels(bool flip, int sub, int coords[8][2])
+{
+	int i = 0;
+	for (int y = 0; y < 4; y++)
+	{
+		for (int x = 0; x < 4; x++)
+		{
+			bool second = (flip ? y >= 2 : x >= 2);
+			if (second == (sub == 1))
+			{
+				coords[i][0] = x;
+				coords[i][1] = y;
+				i++;
+			}
+		}
+	}
+}
+
+// picks the modifier table with the least error around an (expanded) base color
+static void FitSubBlock(const byte* rgba, const int coords[8][2], const int color[3], EtcSubBlock& sub, int* selectors)
+{
+	sub.error = -1;
+	for (int t = 0; t < 8; t++)
+	{
+		int err = 0;
+		int sels[8];
+		for (int i = 0; i < 8; i++)
+		{
+			const byte* p = rgba + 4*(coords[i][1]*4 + coords[i][0]);
+			int best = -1;
+			for (int s = 0; s < 4; s++)
+			{
+				int mod = etcModifiers[t][s & 1] * ((s & 2) ? -1 : 1);
+				int e = Square(ClampByte(color[0] + mod) - p[0]) + Square(ClampByte(color[1] + mod) - p[1]) + Square(ClampByte(color[2] + mod) - p[2]);
+				if (best < 0 || e < best)
+				{
+					best = e;
+					sels[i] = s;
+				}
+			}
+			err += best;
+		}
+
+		if (sub.error < 0 || err < sub.error)
+		{
+			sub.error = err;
+			sub.table = t;
+			for (int i = 0; i < 8; i++)
+				selectors[coords[i][0]*4 + coords[i][1]] = sels[i];
+		}
+	}
+}
+
+static void PackETCBlock(byte* block, bool diff, bool flip, const EtcSubBlock& sub1, const EtcSubBlock& sub2, const int* selectors)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		if (diff)
+			block[i] = (byte) ((sub1.base[i] << 3) | ((sub2.base[i] - sub1.base[i]) & 7));
+		else
+			block[i] = (byte) ((sub1.base[i] << 4) | sub2.base[i]);
+	}
+	block[3] = (byte) ((sub1.table << 5) | (sub2.table << 2) | (diff ? 2 : 0) | (flip ? 1 : 0));
+
+	// selectors go column by column, high bits in the first half
+	unsigned int bits = 0;
+	for (int p = 0; p < 16; p++)
+	{
+		bits |= ((selectors[p] >> 1) & 1) << (16 + p);
+		bits |= (selectors[p] & 1) << p;
+	}
+	block[4] = (byte) (bits >> 24);
+	block[5] = (byte) (bits >> 16);
+	block[6] = (byte) (bits >> 8);
+	block[7] = (byte) bits;
+}
+
+void EncodeETCBlock(const byte* rgba, byte* block)
+{
+	int bestError = -1;
+	for (int f = 0; f < 2; f++)
+	{
+		bool flip = (f == 1);
+		int coords[2][8][2];
+		int avg[2][3];
+		for (int sub = 0; sub < 2; sub++)
+		{
+			GetSubBlockTexels(flip, sub, coords[sub]);
+			for (int c = 0; c < 3; c++)
+			{
+				int sum = 0;
+				for (int i = 0; i < 8; i++)
+					sum += rgba[4*(coords[sub][i][1]*4 + coords[sub][i][0]) + c];
+				avg[sub][c] = (sum + 4) / 8;
+			}
+		}
+
+		for (int d = 0; d < 2; d++)
+		{
+			bool diff = (d == 1);
+			EtcSubBlock subs[2];
+			for (int c = 0; c < 3; c++)
+			{
+				if (diff)
+				{
+					// the second color is a 3 bit signed offset from the first
+					subs[0].base[c] = (avg[0][c]*31 + 127) / 255;
+					int second = (avg[1][c]*31 + 127) / 255;
+					int delta = second - subs[0].base[c];
+					subs[1].base[c] = subs[0].base[c] + (delta < -4 ? -4 : (delta > 3 ? 3 : delta));
+				}
+				else
+				{
+					subs[0].base[c] = (avg[0][c]*15 + 127) / 255;
+					subs[1].base[c] = (avg[1][c]*15 + 127) / 255;
+				}
+			}
+
+			int selectors[16];
+			int error = 0;
+			for (int sub = 0; sub < 2; sub++)
+			{
+				int color[3];
+				for (int c = 0; c < 3; c++)
+				{
+					int v = subs[sub].base[c];
+					color[c] = (diff ? (v << 3) | (v >> 2) : (v << 4) | v);
+				}
+				FitSubBlock(rgba, coords[sub], color, subs[sub], selectors);
+				error += subs[sub].error;
+			}
+
+			if (bestError < 0 || error < bestError)
+			{
+				bestError = error;
+				PackETCBlock(block, diff, flip, subs[0], subs[1], selectors);
+			}
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////
+// EAC alpha (ETC2 RGBA)
+
+void EncodeEACAlphaBlock(const byte* rgba, byte* block)
+{
+	// texels in selector order, column by column
+	int alpha[16];
+	int minA = 255, maxA = 0;
+	for (int p = 0; p < 16; p++)
+	{
+		alpha[p] = rgba[4*((p & 3)*4 + (p >> 2)) + 3];
+		if (alpha[p] < minA)
+			minA = alpha[p];
+		if (alpha[p] > maxA)
+			maxA = alpha[p];
+	}
+
+	int bestError = -1, bestBase = 0, bestTable = 0, bestMult = 1;
+	int bestSels[16];
+	for (int t = 0; t < 16 && bestError != 0; t++)
+	{
+		for (int m = 1; m < 16 && bestError != 0; m++)
+		{
+			// center the table's range on the block's range
+			int lo = eacModifiers[t][3]*m, hi = eacModifiers[t][7]*m;
+			int base = ClampByte((minA - lo + maxA - hi + 1) / 2);
+
+			int err = 0;
+			int sels[16];
+			for (int p = 0; p < 16 && (bestError < 0 || err < bestError); p++)
+			{
+				int best = -1;
+				for (int s = 0; s < 8; s++)
+				{
+					int e = Square(ClampByte(base + eacModifiers[t][s]*m) - alpha[p]);
+					if (best < 0 || e < best)
+					{
+						best = e;
+						sels[p] = s;
+					}
+				}
+				err += best;
+			}
+
+			if (bestError < 0 || err < bestError)
+			{
+				bestError = err;
+				bestBase = base;
+				bestTable = t;
+				bestMult = m;
+				memcpy(bestSels, sels, sizeof(sels));
+			}
+		}
+	}
+
+	block[0] = (byte) bestBase;
+	block[1] = (byte) ((bestMult << 4) | bestTable);
+	uint64 bits = 0;
+	for (int p = 0; p < 16; p++)
+		bits |= (uint64) bestSels[p] << (45 - 3*p);
+	for (int i = 0; i < 6; i++)
+		block[2 + i] = (byte) (bits >> (40 - 8*i));
+}
+
+///////////////////////////////////////////////////////////////////////////
+// BC1 / BC3
+
+static int To565(const int c[3])
+{
+	return (((c[0]*31 + 127) / 255) << 11) | (((c[1]*63 + 127) / 255) << 5) | ((c[2]*31 + 127) / 255);
+}
+
+static void From565(int v, int c[3])
+{
+	int r = v >> 11, g = (v >> 5) & 63, b = v & 31;
+	c[0] = (r << 3) | (r >> 2);
+	c[1] = (g << 2) | (g >> 4);
+	c[2] = (b << 3) | (b >> 2);
+}
+
+void EncodeBC1Block(const byte* rgba, byte* block)
+{
+	// principal axis of the colors, by power iteration on the covariance
+	double mean[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 3; c++)
+			mean[c] += rgba[4*i + c] / 16.0;
+	}
+	double cov[3][3] = { { 0 } };
+	for (int i = 0; i < 16; i++)
+	{
+		double d[3] = { rgba[4*i] - mean[0], rgba[4*i + 1] - mean[1], rgba[4*i + 2] - mean[2] };
+		for (int a = 0; a < 3; a++)
+		{
+			for (int b = 0; b < 3; b++)
+				cov[a][b] += d[a]*d[b];
+		}
+	}
+	double axis[3] = { 1, 1, 1 };
+	for (int iter = 0; iter < 8; iter++)
+	{
+		double next[3];
+		for (int a = 0; a < 3; a++)
+			next[a] = cov[a][0]*axis[0] + cov[a][1]*axis[1] + cov[a][2]*axis[2];
+		double len = sqrt(next[0]*next[0] + next[1]*next[1] + next[2]*next[2]);
+		if (len < 1e-6)
+			break;
+		for (int a = 0; a < 3; a++)
+			axis[a] = next[a] / len;
+	}
+
+	// the extremes along the axis become the end points
+	int minI = 0, maxI = 0;
+	double minP = 0, maxP = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		double proj = rgba[4*i]*axis[0] + rgba[4*i + 1]*axis[1] + rgba[4*i + 2]*axis[2];
+		if (i == 0 || proj < minP)
+		{
+			minP = proj;
+			minI = i;
+		}
+		if (i == 0 || proj > maxP)
+		{
+			maxP = proj;
+			maxI = i;
+		}
+	}
+	int hiColor[3] = { rgba[4*maxI], rgba[4*maxI + 1], rgba[4*maxI + 2] };
+	int loColor[3] = { rgba[4*minI], rgba[4*minI + 1], rgba[4*minI + 2] };
+	int c0 = To565(hiColor), c1 = To565(loColor);
+	if (c0 < c1)
+	{
+		int temp = c0;
+		c0 = c1;
+		c1 = temp;
+	}
+
+	// four color mode needs c0 > c1, a solid block just uses the first color
+	int palette[4][3];
+	From565(c0, palette[0]);
+	From565(c1, palette[1]);
+	for (int c = 0; c < 3; c++)
+	{
+		palette[2][c] = (2*palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2*palette[1][c]) / 3;
+	}
+
+	unsigned int bits = 0;
+	for (int i = 0; i < 16 && c0 != c1; i++)
+	{
+		int best = -1, bestS = 0;
+		for (int s = 0; s < 4; s++)
+		{
+			int e = Square(palette[s][0] - rgba[4*i]) + Square(palette[s][1] - rgba[4*i + 1]) + Square(palette[s][2] - rgba[4*i + 2]);
+			if (best < 0 || e < best)
+			{
+				best = e;
+				bestS = s;
+			}
+		}
+		bits |= bestS << (2*i);
+	}
+
+	block[0] = (byte) c0;
+	block[1] = (byte) (c0 >> 8);
+	block[2] = (byte) c1;
+	block[3] = (byte) (c1 >> 8);
+	block[4] = (byte) bits;
+	block[5] = (byte) (bits >> 8);
+	block[6] = (byte) (bits >> 16);
+	block[7] = (byte) (bits >> 24);
+}
+
+void EncodeBC3AlphaBlock(const byte* rgba, byte* block)
+{
+	int a0 = 0, a1 = 255;
+	for (int i = 0; i < 16; i++)
+	{
+		if (rgba[4*i + 3] > a0)
+			a0 = rgba[4*i + 3];
+		if (rgba[4*i + 3] < a1)
+			a1 = rgba[4*i + 3];
+	}
+
+	// eight values between the extremes, a solid block just uses the first
+	int alphas[8] = { a0, a1 };
+	for (int i = 2; i < 8; i++)
+		alphas[i] = ((8 - i)*a0 + (i - 1)*a1) / 7;
+
+	uint64 bits = 0;
+	for (int i = 0; i < 16 && a0 != a1; i++)
+	{
+		int best = -1, bestS = 0;
+		for (int s = 0; s < 8; s++)
+		{
+			int e = Square(alphas[s] - rgba[4*i + 3]);
+			if (best < 0 || e < best)
+			{
+				best = e;
+				bestS = s;
+			}
+		}
+		bits |= (uint64) bestS << (3*i);
+	}
+
+	block[0] = (byte) a0;
+	block[1] = (byte) a1;
+	for (int i = 0; i < 6; i++)
+		block[2 + i] = (byte) (bits >> (8*i));
+}
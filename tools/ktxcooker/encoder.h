@@ -0,0 +1,9 @@
+#pragma once
+
+// block encoders, each one takes a 4x4 block of RGBA texels (row by row) and writes one block
+//  the ETC encoder only uses the individual and differential modes, so its blocks are valid ETC1 and ETC2
+
+void EncodeETCBlock(const byte* rgba, byte* block);
+void EncodeEACAlphaBlock(const byte* rgba, byte* block);
+void EncodeBC1Block(const byte* rgba, byte* block);
+void EncodeBC3AlphaBlock(const byte* rgba, byte* block);
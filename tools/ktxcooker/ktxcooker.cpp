@@ -0,0 +1,588 @@
+// ktxcooker.cpp : cooks the PNG and JPEG images in a content folder into KTX textures
+//
+// usage: ktxcooker <content dir> [-o <output dir>] [-f etc2|etc1|bc] [-m] [-2]
+//   etc2 (the default) is for GLES 3 devices, etc1 for older GLES 2 devices (images w/o alpha only),
+//   bc for D3D11 and desktop GL, -m stores a full mip chain, -2 writes KTX2 files instead of KTX
+//
+
+#include "stdafx.h"
+#include "encoder.h"
+#include "../../core/TextureCodec.h"
+#include "../../core/MipChain.h"
+#include "../../core/libpng/png.h"
+#include "../../core/libjpeg/jpeglib.h"
+
+using namespace MigTech;
+
+// GL internal formats written to KTX files
+#define GL_ENUM_RGB 0x1907
+#define GL_ENUM_RGBA 0x1908
+#define GL_ENUM_ETC1_RGB8 0x8D64
+#define GL_ENUM_ETC2_RGB8 0x9274
+#define GL_ENUM_ETC2_RGBA8_EAC 0x9278
+#define GL_ENUM_DXT1_RGBA 0x83F1
+#define GL_ENUM_DXT5_RGBA 0x83F3
+
+// Vulkan formats and data format descriptor models written to KTX2 files
+#define VK_FORMAT_BC1_RGB_UNORM 131
+#define VK_FORMAT_BC3_UNORM 137
+#define VK_FORMAT_ETC2_RGB8_UNORM 147
+#define VK_FORMAT_ETC2_RGBA8_UNORM 151
+#define KHR_DF_MODEL_BC1A 128
+#define KHR_DF_MODEL_BC3 130
+#define KHR_DF_MODEL_ETC2 161
+#define KHR_DF_CHANNEL_COLOR_BC 0
+#define KHR_DF_CHANNEL_COLOR_ETC2 2
+#define KHR_DF_CHANNEL_ALPHA 15
+
+static const byte ktx1Ident[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const byte ktx2Ident[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+enum CookFormat
+{
+	COOK_ETC2,
+	COOK_ETC1,
+	COOK_BC
+};
+
+struct CookOptions
+{
+	std::string contentDir;
+	std::string outputDir;
+	CookFormat format;
+	bool mipmaps;
+	bool ktx2;
+};
+
+struct SourceImage
+{
+	int width;
+	int height;
+	std::vector<byte> rgba;
+	bool hasAlpha;
+};
+
+///////////////////////////////////////////////////////////////////////////
+// source images
+
+static bool EndsWith(const std::string& s, const char* ext)
+{
+	size_t len = strlen(ext);
+	if (s.length() < len)
+		return false;
+	for (size_t i = 0; i < len; i++)
+	{
+		if (tolower(s[s.length() - len + i]) != ext[i])
+			return false;
+	}
+	return true;
+}
+
+static bool LoadPNG(const std::string& path, SourceImage& img)
+{
+	FILE* fp = fopen(path.c_str(), "rb");
+	if (fp == NULL)
+		return false;
+
+	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	png_infop info_ptr = (png_ptr != NULL ? png_create_info_struct(png_ptr) : NULL);
+	if (info_ptr == NULL)
+	{
+		png_destroy_read_struct(&png_ptr, NULL, NULL);
+		fclose(fp);
+		return false;
+	}
+
+	// everything comes out as 8 bit RGB or RGBA
+	png_init_io(png_ptr, fp);
+	png_read_png(png_ptr, info_ptr, PNG_TRANSFORM_EXPAND | PNG_TRANSFORM_STRIP_16 | PNG_TRANSFORM_PACKING | PNG_TRANSFORM_GRAY_TO_RGB, NULL);
+	img.width = png_get_image_width(png_ptr, info_ptr);
+	img.height = png_get_image_height(png_ptr, info_ptr);
+	int channels = png_get_channels(png_ptr, info_ptr);
+	png_bytepp rows = png_get_rows(png_ptr, info_ptr);
+
+	img.rgba.resize(4 * img.width * img.height);
+	img.hasAlpha = false;
+	for (int y = 0; y < img.height; y++)
+	{
+		for (int x = 0; x < img.width; x++)
+		{
+			byte* pdst = &img.rgba[4 * (y*img.width + x)];
+			const byte* psrc = rows[y] + channels*x;
+			pdst[0] = psrc[0];
+			pdst[1] = psrc[1];
+			pdst[2] = psrc[2];
+			pdst[3] = (channels == 4 ? psrc[3] : 255);
+			if (pdst[3] != 255)
+				img.hasAlpha = true;
+		}
+	}
+
+	png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+	fclose(fp);
+	return (channels == 3 || channels == 4);
+}
+
+static bool LoadJPEG(const std::string& path, SourceImage& img)
+{
+	FILE* fp = fopen(path.c_str(), "rb");
+	if (fp == NULL)
+		return false;
+
+	struct jpeg_decompress_struct cinfo;
+	struct jpeg_error_mgr jerr;
+	cinfo.err = jpeg_std_error(&jerr);
+	jpeg_create_decompress(&cinfo);
+	jpeg_stdio_src(&cinfo, fp);
+	jpeg_read_header(&cinfo, TRUE);
+	cinfo.out_color_space = JCS_RGB;
+	jpeg_start_decompress(&cinfo);
+
+	img.width = cinfo.output_width;
+	img.height = cinfo.output_height;
+	img.rgba.resize(4 * img.width * img.height);
+	img.hasAlpha = false;
+
+	std::vector<byte> row(3 * img.width);
+	JSAMPROW row_pointer[1] = { &row[0] };
+	while (cinfo.output_scanline < cinfo.output_height)
+	{
+		byte* pdst = &img.rgba[4 * cinfo.output_scanline * img.width];
+		jpeg_read_scanlines(&cinfo, row_pointer, 1);
+		for (int x = 0; x < img.width; x++)
+		{
+			pdst[4*x + 0] = row[3*x + 0];
+			pdst[4*x + 1] = row[3*x + 1];
+			pdst[4*x + 2] = row[3*x + 2];
+			pdst[4*x + 3] = 255;
+		}
+	}
+
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+	fclose(fp);
+	return true;
+}
+
+static bool ListImages(const std::string& dir, std::vector<std::string>& names)
+{
+#ifdef _WIN32
+	WIN32_FIND_DATAA fd;
+	HANDLE hFind = FindFirstFileA((dir + "\\*").c_str(), &fd);
+	if (hFind == INVALID_HANDLE_VALUE)
+		return false;
+	do
+	{
+		if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+			names.push_back(fd.cFileName);
+	} while (FindNextFileA(hFind, &fd));
+	FindClose(hFind);
+#else
+	DIR* pdir = opendir(dir.c_str());
+	if (pdir == NULL)
+		return false;
+	struct dirent* entry;
+	while ((entry = readdir(pdir)) != NULL)
+		names.push_back(entry->d_name);
+	closedir(pdir);
+#endif
+
+	// only the formats the game loads
+	std::vector<std::string> images;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		if (EndsWith(names[i], ".png") || EndsWith(names[i], ".jpg") || EndsWith(names[i], ".jpeg"))
+			images.push_back(names[i]);
+	}
+	std::sort(images.begin(), images.end());
+	names.swap(images);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// cooking
+
+static void PutU32(std::vector<byte>& out, unsigned int v)
+{
+	out.push_back((byte) v);
+	out.push_back((byte) (v >> 8));
+	out.push_back((byte) (v >> 16));
+	out.push_back((byte) (v >> 24));
+}
+
+static void PutU64(std::vector<byte>& out, uint64 v)
+{
+	PutU32(out, (unsigned int) v);
+	PutU32(out, (unsigned int) (v >> 32));
+}
+
+static void PadTo(std::vector<byte>& out, size_t align)
+{
+	while (out.size() % align)
+		out.push_back(0);
+}
+
+// the layout of the blocks for all the levels, there aren't any pixels
+static ImageData BlockLayout(const SourceImage& img, TEX_COMPRESSION comp, int levels)
+{
+	ImageData layout;
+	layout.format = ((comp == TEX_COMPRESSION_ETC1 || comp == TEX_COMPRESSION_ETC2_RGB) ? IMG_FORMAT_RGB : IMG_FORMAT_RGBA);
+	layout.width = img.width;
+	layout.height = img.height;
+	layout.compression = comp;
+	layout.blockWidth = layout.blockHeight = 4;
+	layout.mipLevels = levels;
+	return layout;
+}
+
+// appends the blocks for one level
+static void EncodeImage(const SourceImage& img, TEX_COMPRESSION comp, std::vector<byte>& blocks)
+{
+	int blockBytes = TextureCodec::getBlockBytes(comp);
+	int blocksWide = (img.width + 3) / 4;
+	int blocksHigh = (img.height + 3) / 4;
+	size_t start = blocks.size();
+	blocks.resize(start + blocksWide * blocksHigh * blockBytes);
+
+	byte texels[4*4*4];
+	byte* block = &blocks[start];
+	for (int by = 0; by < blocksHigh; by++)
+	{
+		for (int bx = 0; bx < blocksWide; bx++, block += blockBytes)
+		{
+			// edge blocks repeat the last row and column
+			for (int y = 0; y < 4; y++)
+			{
+				int sy = (by*4 + y < img.height ? by*4 + y : img.height - 1);
+				for (int x = 0; x < 4; x++)
+				{
+					int sx = (bx*4 + x < img.width ? bx*4 + x : img.width - 1);
+					memcpy(texels + 4*(y*4 + x), &img.rgba[4 * (sy*img.width + sx)], 4);
+				}
+			}
+
+			switch (comp)
+			{
+			case TEX_COMPRESSION_ETC2_RGBA:
+				EncodeEACAlphaBlock(texels, block);
+				EncodeETCBlock(texels, block + 8);
+				break;
+			case TEX_COMPRESSION_BC1:
+				EncodeBC1Block(texels, block);
+				break;
+			case TEX_COMPRESSION_BC3:
+				EncodeBC3AlphaBlock(texels, block);
+				EncodeBC1Block(texels, block + 8);
+				break;
+			default:
+				EncodeETCBlock(texels, block);
+				break;
+			}
+		}
+	}
+}
+
+// the levels are built with the same filter the runtime uses (see MipChain), each one is encoded on its own
+static int EncodeLevels(const SourceImage& img, TEX_COMPRESSION comp, bool mipmaps, std::vector<byte>& blocks)
+{
+	if (!mipmaps)
+	{
+		EncodeImage(img, comp, blocks);
+		return 1;
+	}
+
+	ImageData chain;
+	chain.format = IMG_FORMAT_RGBA;
+	chain.width = img.width;
+	chain.height = img.height;
+	chain.pixels = new byte[img.rgba.size()];
+	memcpy(chain.pixels, &img.rgba[0], img.rgba.size());
+	MipChain::generate(chain);
+
+	for (int level = 0; level < chain.mipLevels; level++)
+	{
+		SourceImage levelImg;
+		levelImg.width = MipChain::getLevelDim(img.width, level);
+		levelImg.height = MipChain::getLevelDim(img.height, level);
+		levelImg.hasAlpha = img.hasAlpha;
+		const byte* pLevel = chain.pixels + MipChain::getLevelOffset(chain, level);
+		levelImg.rgba.assign(pLevel, pLevel + MipChain::getLevelSize(chain, level));
+		EncodeImage(levelImg, comp, blocks);
+	}
+
+	int levels = chain.mipLevels;
+	chain.release();
+	return levels;
+}
+
+// decodes the base level again with the runtime decoder, so the number reflects what the game will show
+static double MeasurePSNR(const SourceImage& img, TEX_COMPRESSION comp, std::vector<byte>& blocks)
+{
+	ImageData src = BlockLayout(img, comp, 1);
+	src.dataSize = MipChain::getLevelSize(src, 0);
+	src.pixels = &blocks[0];
+
+	ImageData dst;
+	if (!TextureCodec::decompress(src, dst))
+		return 0;
+
+	int channels = (src.format == IMG_FORMAT_RGB ? 3 : 4);
+	double sum = 0;
+	for (int i = 0; i < img.width*img.height; i++)
+	{
+		for (int c = 0; c < channels; c++)
+		{
+			double d = (double) dst.pixels[channels*i + c] - img.rgba[4*i + c];
+			sum += d*d;
+		}
+	}
+	dst.release();
+
+	double mse = sum / ((double) img.width * img.height * channels);
+	return (mse > 0 ? 10 * log10(255.0 * 255.0 / mse) : 99);
+}
+
+static void WriteKTX1(std::vector<byte>& out, const SourceImage& img, TEX_COMPRESSION comp, const std::vector<byte>& blocks, int levels)
+{
+	unsigned int glInternalFormat = GL_ENUM_ETC2_RGB8;
+	switch (comp)
+	{
+	case TEX_COMPRESSION_ETC1: glInternalFormat = GL_ENUM_ETC1_RGB8; break;
+	case TEX_COMPRESSION_ETC2_RGBA: glInternalFormat = GL_ENUM_ETC2_RGBA8_EAC; break;
+	case TEX_COMPRESSION_BC1: glInternalFormat = GL_ENUM_DXT1_RGBA; break;
+	case TEX_COMPRESSION_BC3: glInternalFormat = GL_ENUM_DXT5_RGBA; break;
+	default: break;
+	}
+	bool alpha = (comp == TEX_COMPRESSION_ETC2_RGBA || comp == TEX_COMPRESSION_BC1 || comp == TEX_COMPRESSION_BC3);
+
+	out.insert(out.end(), ktx1Ident, ktx1Ident + 12);
+	PutU32(out, 0x04030201);				// endianness
+	PutU32(out, 0);							// glType
+	PutU32(out, 1);							// glTypeSize
+	PutU32(out, 0);							// glFormat
+	PutU32(out, glInternalFormat);
+	PutU32(out, (alpha ? GL_ENUM_RGBA : GL_ENUM_RGB));
+	PutU32(out, img.width);
+	PutU32(out, img.height);
+	PutU32(out, 0);							// pixelDepth
+	PutU32(out, 0);							// numberOfArrayElements
+	PutU32(out, 1);							// numberOfFaces
+	PutU32(out, levels);					// numberOfMipmapLevels
+	PutU32(out, 0);							// bytesOfKeyValueData
+
+	// whole blocks are always a multiple of 4 bytes, so there's never any mip padding
+	ImageData layout = BlockLayout(img, comp, levels);
+	for (int level = 0; level < levels; level++)
+	{
+		unsigned int levelOffset = MipChain::getLevelOffset(layout, level);
+		unsigned int levelSize = MipChain::getLevelSize(layout, level);
+		PutU32(out, levelSize);
+		out.insert(out.end(), blocks.begin() + levelOffset, blocks.begin() + levelOffset + levelSize);
+	}
+}
+
+static void WriteKTX2(std::vector<byte>& out, const SourceImage& img, TEX_COMPRESSION comp, const std::vector<byte>& blocks, int levels)
+{
+	// ETC1 data is written as ETC2, which it's a subset of
+	unsigned int vkFormat = VK_FORMAT_ETC2_RGB8_UNORM, model = KHR_DF_MODEL_ETC2;
+	unsigned int colorChannel = KHR_DF_CHANNEL_COLOR_ETC2;
+	bool alpha = false;
+	switch (comp)
+	{
+	case TEX_COMPRESSION_ETC2_RGBA: vkFormat = VK_FORMAT_ETC2_RGBA8_UNORM; alpha = true; break;
+	case TEX_COMPRESSION_BC1: vkFormat = VK_FORMAT_BC1_RGB_UNORM; model = KHR_DF_MODEL_BC1A; colorChannel = KHR_DF_CHANNEL_COLOR_BC; break;
+	case TEX_COMPRESSION_BC3: vkFormat = VK_FORMAT_BC3_UNORM; model = KHR_DF_MODEL_BC3; colorChannel = KHR_DF_CHANNEL_COLOR_BC; alpha = true; break;
+	default: break;
+	}
+	int blockBytes = TextureCodec::getBlockBytes(comp);
+
+	// basic data format descriptor, alpha comes first in the two sample formats
+	std::vector<byte> dfd;
+	int samples = (alpha ? 2 : 1);
+	PutU32(dfd, 4 + 24 + 16*samples);		// dfdTotalSize
+	PutU32(dfd, 0);							// vendorId, descriptorType
+	PutU32(dfd, 2 | ((24 + 16*samples) << 16));	// versionNumber, descriptorBlockSize
+	PutU32(dfd, model | (1 << 8) | (1 << 16));	// colorModel, BT709 primaries, linear transfer, straight alpha
+	PutU32(dfd, 3 | (3 << 8));				// texel block dimensions (minus 1)
+	PutU32(dfd, blockBytes);				// bytesPlane0
+	PutU32(dfd, 0);
+	for (int s = 0; s < samples; s++)
+	{
+		bool alphaSample = (alpha && s == 0);
+		PutU32(dfd, (s * 64) | (63 << 16) | ((alphaSample ? KHR_DF_CHANNEL_ALPHA : colorChannel) << 24));
+		PutU32(dfd, 0);						// sample position
+		PutU32(dfd, 0);						// sampleLower
+		PutU32(dfd, 0xFFFFFFFF);			// sampleUpper
+	}
+
+	// the level data is stored smallest level first, each one aligned to a block
+	ImageData layout = BlockLayout(img, comp, levels);
+	size_t dfdOffset = 80 + 24*levels;
+	std::vector<size_t> levelOffsets(levels);
+	size_t offset = dfdOffset + dfd.size();
+	for (int level = levels - 1; level >= 0; level--)
+	{
+		offset = (offset + blockBytes - 1) / blockBytes * blockBytes;
+		levelOffsets[level] = offset;
+		offset += MipChain::getLevelSize(layout, level);
+	}
+
+	// header, then the level index
+	out.insert(out.end(), ktx2Ident, ktx2Ident + 12);
+	PutU32(out, vkFormat);
+	PutU32(out, 1);							// typeSize
+	PutU32(out, img.width);
+	PutU32(out, img.height);
+	PutU32(out, 0);							// pixelDepth
+	PutU32(out, 0);							// layerCount
+	PutU32(out, 1);							// faceCount
+	PutU32(out, levels);					// levelCount
+	PutU32(out, 0);							// supercompressionScheme
+	PutU32(out, (unsigned int) dfdOffset);
+	PutU32(out, (unsigned int) dfd.size());
+	PutU32(out, 0);							// kvdByteOffset
+	PutU32(out, 0);							// kvdByteLength
+	PutU64(out, 0);							// sgdByteOffset
+	PutU64(out, 0);							// sgdByteLength
+	for (int level = 0; level < levels; level++)
+	{
+		unsigned int levelSize = MipChain::getLevelSize(layout, level);
+		PutU64(out, levelOffsets[level]);
+		PutU64(out, levelSize);
+		PutU64(out, levelSize);				// uncompressedByteLength
+	}
+
+	out.insert(out.end(), dfd.begin(), dfd.end());
+	for (int level = levels - 1; level >= 0; level--)
+	{
+		unsigned int levelOffset = MipChain::getLevelOffset(layout, level);
+		PadTo(out, blockBytes);
+		out.insert(out.end(), blocks.begin() + levelOffset, blocks.begin() + levelOffset + MipChain::getLevelSize(layout, level));
+	}
+}
+
+static bool CookImage(const CookOptions& opts, const std::string& name)
+{
+	std::string path = opts.contentDir + "/" + name;
+	SourceImage img;
+	bool loaded = (EndsWith(name, ".png") ? LoadPNG(path, img) : LoadJPEG(path, img));
+	if (!loaded || img.width <= 0 || img.height <= 0)
+	{
+		printf("  %s: could not be read\n", name.c_str());
+		return false;
+	}
+
+	TEX_COMPRESSION comp;
+	if (opts.format == COOK_BC)
+		comp = (img.hasAlpha ? TEX_COMPRESSION_BC3 : TEX_COMPRESSION_BC1);
+	else if (opts.format == COOK_ETC1)
+	{
+		if (img.hasAlpha)
+		{
+			printf("  %s: skipped, ETC1 has no alpha\n", name.c_str());
+			return true;
+		}
+		comp = TEX_COMPRESSION_ETC1;
+	}
+	else
+		comp = (img.hasAlpha ? TEX_COMPRESSION_ETC2_RGBA : TEX_COMPRESSION_ETC2_RGB);
+
+	std::vector<byte> blocks;
+	int levels = EncodeLevels(img, comp, opts.mipmaps, blocks);
+	double psnr = MeasurePSNR(img, comp, blocks);
+
+	std::vector<byte> out;
+	if (opts.ktx2)
+		WriteKTX2(out, img, comp, blocks, levels);
+	else
+		WriteKTX1(out, img, comp, blocks, levels);
+
+	std::string outName = name.substr(0, name.rfind('.')) + (opts.ktx2 ? ".ktx2" : ".ktx");
+	std::string outPath = opts.outputDir + "/" + outName;
+	FILE* fp = fopen(outPath.c_str(), "wb");
+	if (fp == NULL || fwrite(&out[0], 1, out.size(), fp) != out.size())
+	{
+		printf("  %s: could not write %s\n", name.c_str(), outPath.c_str());
+		if (fp != NULL)
+			fclose(fp);
+		return false;
+	}
+	fclose(fp);
+
+	unsigned int rawSize = 4 * img.width * img.height;
+	printf("  %s -> %s (%dx%d, %d level%s, %.1f KB -> %.1f KB, %.1f dB)\n", name.c_str(), outName.c_str(), img.width, img.height,
+		levels, (levels > 1 ? "s" : ""), rawSize / 1024.0, blocks.size() / 1024.0, psnr);
+	return true;
+}
+
+static void PrintUsage()
+{
+	printf("usage: ktxcooker <content dir> [-o <output dir>] [-f etc2|etc1|bc] [-m] [-2]\n");
+	printf("  -o   where the KTX files go, the content dir by default\n");
+	printf("  -f   block format, etc2 (default), etc1 or bc\n");
+	printf("  -m   store a full mip chain\n");
+	printf("  -2   write KTX2 files\n");
+}
+
+int main(int argc, char* argv[])
+{
+	CookOptions opts;
+	opts.format = COOK_ETC2;
+	opts.mipmaps = false;
+	opts.ktx2 = false;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "-o" && i + 1 < argc)
+			opts.outputDir = argv[++i];
+		else if (arg == "-f" && i + 1 < argc)
+		{
+			std::string fmt = argv[++i];
+			if (fmt == "etc2")
+				opts.format = COOK_ETC2;
+			else if (fmt == "etc1")
+				opts.format = COOK_ETC1;
+			else if (fmt == "bc")
+				opts.format = COOK_BC;
+			else
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+		else if (arg == "-m")
+			opts.mipmaps = true;
+		else if (arg == "-2")
+			opts.ktx2 = true;
+		else if (opts.contentDir.empty() && arg[0] != '-')
+			opts.contentDir = arg;
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (opts.contentDir.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+	if (opts.outputDir.empty())
+		opts.outputDir = opts.contentDir;
+
+	std::vector<std::string> names;
+	if (!ListImages(opts.contentDir, names))
+	{
+		printf("Could not read %s\n", opts.contentDir.c_str());
+		return 1;
+	}
+
+	int failed = 0;
+	printf("Cooking %d images from %s\n", (int) names.size(), opts.contentDir.c_str());
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		if (!CookImage(opts, names[i]))
+			failed++;
+	}
+	return (failed > 0 ? 1 : 0);
+}
@@ -0,0 +1,6 @@
+// pch.h : the core sources built into the tool include this instead of a platform pch.h
+//
+
+#pragma once
+
+#include "stdafx.h"
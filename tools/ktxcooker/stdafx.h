@@ -0,0 +1,31 @@
+// stdafx.h : include file for standard system include files,
+// or project specific include files that are used frequently, but
+// are changed infrequently
+//
+
+#pragma once
+
+#ifdef _WIN32
+#include "targetver.h"
+
+#define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+// C RunTime Header Files
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+// the core sources built into the tool expect these (see the platform pch.h files)
+#define uint64 uint64_t
+#define byte unsigned char
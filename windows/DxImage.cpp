@@ -1,5 +1,7 @@
 ﻿#include "pch.h"
 #include "../core/MigUtil.h"
+#include "../core/MipChain.h"
+#include "../core/TextureCodec.h"
 #include "DxDefines.h"
 #include "DxImage.h"
 #include "DxRender.h"
@@ -13,7 +15,8 @@ DxImage::DxImage()
 {
 }
 
-void DxImage::loadTexture(IMG_FORMAT fmt, int width, int height, void* pData)
+// the levels are packed one after another in pData (see MipChain)
+void DxImage::loadTexture(IMG_FORMAT fmt, int width, int height, void* pData, int mipLevels)
 {
 	DxRender* pdr = (DxRender*)MigUtil::theRend;
 	ID3D11Device1* d3dDevice = pdr->GetD3DDevice();
@@ -21,7 +24,7 @@ void DxImage::loadTexture(IMG_FORMAT fmt, int width, int height, void* pData)
 	D3D11_TEXTURE2D_DESC desc;
 	desc.Width = width;
 	desc.Height = height;
-	desc.MipLevels = 1;
+	desc.MipLevels = mipLevels;
 	desc.ArraySize = 1;
 	desc.Format = DXGI_FORMAT_UNKNOWN;
 	switch (fmt)
@@ -37,12 +40,24 @@ void DxImage::loadTexture(IMG_FORMAT fmt, int width, int height, void* pData)
 	desc.CPUAccessFlags = 0;
 	desc.MiscFlags = 0;
 
-	D3D11_SUBRESOURCE_DATA srData;
-	srData.pSysMem = pData;
-	srData.SysMemPitch = width*((fmt == IMG_FORMAT_GREYSCALE || fmt == IMG_FORMAT_ALPHA) ? 1 : 4);
-	srData.SysMemSlicePitch = 0;
+	// one subresource per level
+	int bpp = ((fmt == IMG_FORMAT_GREYSCALE || fmt == IMG_FORMAT_ALPHA) ? 1 : 4);
+	std::vector<D3D11_SUBRESOURCE_DATA> srData(mipLevels);
+	const byte* pLevel = (const byte*) pData;
+	_byteSize = 0;
+	for (int level = 0; level < mipLevels; level++)
+	{
+		int levelWidth = MipChain::getLevelDim(width, level);
+		srData[level].pSysMem = pLevel;
+		srData[level].SysMemPitch = levelWidth*bpp;
+		srData[level].SysMemSlicePitch = 0;
+
+		unsigned int levelSize = srData[level].SysMemPitch*MipChain::getLevelDim(height, level);
+		pLevel += levelSize;
+		_byteSize += levelSize;
+	}
 
-	HRESULT hres = d3dDevice->CreateTexture2D(&desc, &srData, &_texture2D);
+	HRESULT hres = d3dDevice->CreateTexture2D(&desc, &srData[0], &_texture2D);
 	if (hres != S_OK)
 		throw hres_error("(DxImage::loadTexture) Could not create texture", hres);
 
@@ -52,6 +67,50 @@ void DxImage::loadTexture(IMG_FORMAT fmt, int width, int height, void* pData)
 
 	_width = width;
 	_height = height;
+	_mipLevels = mipLevels;
+}
+
+void DxImage::loadCompressedTexture(DXGI_FORMAT fmt, const ImageData& data, int mipLevels)
+{
+	DxRender* pdr = (DxRender*)MigUtil::theRend;
+	ID3D11Device1* d3dDevice = pdr->GetD3DDevice();
+
+	D3D11_TEXTURE2D_DESC desc;
+	desc.Width = data.width;
+	desc.Height = data.height;
+	desc.MipLevels = mipLevels;
+	desc.ArraySize = 1;
+	desc.Format = fmt;
+	desc.SampleDesc.Count = 1;
+	desc.SampleDesc.Quality = 0;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.CPUAccessFlags = 0;
+	desc.MiscFlags = 0;
+
+	// the pitch of block compressed data is one row of blocks
+	std::vector<D3D11_SUBRESOURCE_DATA> srData(mipLevels);
+	_byteSize = 0;
+	for (int level = 0; level < mipLevels; level++)
+	{
+		int blocksWide = (MipChain::getLevelDim(data.width, level) + data.blockWidth - 1) / data.blockWidth;
+		srData[level].pSysMem = data.pixels + MipChain::getLevelOffset(data, level);
+		srData[level].SysMemPitch = blocksWide*TextureCodec::getBlockBytes(data.compression);
+		srData[level].SysMemSlicePitch = 0;
+		_byteSize += MipChain::getLevelSize(data, level);
+	}
+
+	HRESULT hres = d3dDevice->CreateTexture2D(&desc, &srData[0], &_texture2D);
+	if (hres != S_OK)
+		throw hres_error("(DxImage::loadCompressedTexture) Could not create texture", hres);
+
+	hres = d3dDevice->CreateShaderResourceView(_texture2D.Get(), nullptr, &_textureView);
+	if (hres != S_OK)
+		throw hres_error("(DxImage::loadCompressedTexture) Could not create shader resource view", hres);
+
+	_width = data.width;
+	_height = data.height;
+	_mipLevels = mipLevels;
 }
 
 ID3D11ShaderResourceView* DxImage::getShaderResourceView()
@@ -127,8 +186,10 @@ bool DxRenderTarget::init(IMG_FORMAT fmtHint, int width, int height, int depthBi
 		return false;
 	}
 
+	// no separate depth buffer yet, so only the color texture counts
 	_width = width;
 	_height = height;
+	_byteSize = (unsigned int) (width*height*(desc.Format == DXGI_FORMAT_R8G8B8A8_UNORM ? 4 : 1));
 	_viewPort = CD3D11_VIEWPORT(0.0f, 0.0f, (FLOAT)width, (FLOAT)height);
 	return true;
 }
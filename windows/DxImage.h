@@ -18,7 +18,8 @@ namespace MigTech
 	public:
 		DxImage();
 
-		void loadTexture(IMG_FORMAT fmt, int width, int height, void* pData);
+		void loadTexture(IMG_FORMAT fmt, int width, int height, void* pData, int mipLevels = 1);
+		void loadCompressedTexture(DXGI_FORMAT fmt, const ImageData& data, int mipLevels);
 		ID3D11ShaderResourceView* getShaderResourceView();
 	};
 
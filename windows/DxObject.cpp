@@ -19,6 +19,9 @@ using namespace Microsoft::WRL;
 using namespace MigTech;
 
 DxObject::DxObject() :
+	_vertexBufferSize(0),
+	_indexBufferSize(0),
+	_instanceBufferSize(0),
 	_vertexStride(0),
 	_vertexOffset(0),
 	_indexCount(0),
@@ -34,6 +37,7 @@ DxObject::~DxObject()
 {
 	_vertexBuffer.Reset();
 	_indexBuffer.Reset();
+	_instanceBuffer.Reset();
 }
 
 int DxObject::addShaderSet(const std::string& vs, const std::string& ps)
@@ -198,6 +202,45 @@ void* toD3DVertexData(const void* pdata, VDTYPE vdType, unsigned int count, unsi
 	return pout;
 }
 
+void DxObject::uploadBuffer(UINT bindFlags, BUFFER_USAGE usage, Microsoft::WRL::ComPtr<ID3D11Buffer>& buffer, unsigned int& bufferSize, const void* pdata, unsigned int size)
+{
+	DxRender* pdr = (DxRender*)MigUtil::theRend;
+
+	// dynamic buffers are rewritten in place if the new data fits
+	if (usage == BUFFER_USAGE_DYNAMIC && buffer != nullptr && size <= bufferSize)
+	{
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		HRESULT hres = pdr->GetD3DDeviceContext()->Map(buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+		if (hres != S_OK)
+			throw hres_error("(DxObject::uploadBuffer) Could not map buffer", hres);
+		memcpy(mapped.pData, pdata, size);
+		pdr->GetD3DDeviceContext()->Unmap(buffer.Get(), 0);
+		return;
+	}
+
+	CD3D11_BUFFER_DESC bufferDesc(size, bindFlags);
+	if (usage == BUFFER_USAGE_DYNAMIC)
+	{
+		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	}
+
+	D3D11_SUBRESOURCE_DATA bufferData = { 0 };
+	bufferData.pSysMem = pdata;
+	bufferData.SysMemPitch = 0;
+	bufferData.SysMemSlicePitch = 0;
+
+	buffer.Reset();
+	HRESULT hres = pdr->GetD3DDevice()->CreateBuffer(
+		&bufferDesc,
+		&bufferData,
+		&buffer
+		);
+	if (hres != S_OK)
+		throw hres_error("(DxObject::uploadBuffer) Could not create buffer", hres);
+	bufferSize = size;
+}
+
 void DxObject::loadVertexBuffer(const void* pdata, unsigned int count, VDTYPE vdType)
 {
 	if (pdata == nullptr || count == 0)
@@ -219,24 +262,9 @@ void DxObject::loadVertexBuffer(const void* pdata, unsigned int count, VDTYPE vd
 	if (_vertexStride == 0)
 		throw std::invalid_argument("(DxObject::LoadVertexBuffer) Invalid vertex data type");
 
-	unsigned int size = count*_vertexStride;
-	CD3D11_BUFFER_DESC vertexBufferDesc(size, D3D11_BIND_VERTEX_BUFFER);
-
-	D3D11_SUBRESOURCE_DATA vertexBufferData = { 0 };
-	vertexBufferData.pSysMem = toD3DVertexData(pdata, vdType, count, _vertexStride);
-	vertexBufferData.SysMemPitch = 0;
-	vertexBufferData.SysMemSlicePitch = 0;
-
-	DxRender* pdr = (DxRender*)MigUtil::theRend;
-	HRESULT hres = pdr->GetD3DDevice()->CreateBuffer(
-		&vertexBufferDesc,
-		&vertexBufferData,
-		&_vertexBuffer
-		);
-	if (hres != S_OK)
-		throw hres_error("(DxObject::loadVertexBuffer) Could not create vertex buffer", hres);
-
-	delete vertexBufferData.pSysMem;
+	void* pd3dData = toD3DVertexData(pdata, vdType, count, _vertexStride);
+	uploadBuffer(D3D11_BIND_VERTEX_BUFFER, _usage, _vertexBuffer, _vertexBufferSize, pd3dData, count*_vertexStride);
+	delete pd3dData;
 }
 
 void DxObject::loadIndexBuffer(const unsigned short* indices, unsigned int count, PRIMITIVE_TYPE type)
@@ -256,22 +284,7 @@ void DxObject::loadIndexBuffer(const unsigned short* indices, unsigned int count
 	if (_topology == D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED)
 		throw std::runtime_error("(DxObject::LoadIndexBuffer) Invalid primitive type");
 
-	D3D11_SUBRESOURCE_DATA indexBufferData = { 0 };
-	indexBufferData.pSysMem = indices;
-	indexBufferData.SysMemPitch = 0;
-	indexBufferData.SysMemSlicePitch = 0;
-
-	unsigned int sizeOfData = count*sizeof(unsigned short);
-	CD3D11_BUFFER_DESC indexBufferDesc(sizeOfData, D3D11_BIND_INDEX_BUFFER);
-
-	DxRender* pdr = (DxRender*)MigUtil::theRend;
-	HRESULT hres = pdr->GetD3DDevice()->CreateBuffer(
-		&indexBufferDesc,
-		&indexBufferData,
-		&_indexBuffer
-		);
-	if (hres != S_OK)
-		throw hres_error("(DxObject::loadIndexBuffer) Could not create index buffer", hres);
+	uploadBuffer(D3D11_BIND_INDEX_BUFFER, _usage, _indexBuffer, _indexBufferSize, indices, count*sizeof(unsigned short));
 }
 
 void DxObject::setIndexOffset(unsigned int offset, unsigned int count)
@@ -353,6 +366,10 @@ void DxObject::prepareRender(int shaderSet)
 
 void DxObject::render(int shaderSet)
 {
+	// the render queue will call back in here when it's submitted
+	if (MigUtil::theRend->queueDraw(this, shaderSet))
+		return;
+
 	// if we're not in a render sequence then prepare the render
 	if (!_inRenderSet)
 		prepareRender(shaderSet);
@@ -372,8 +389,58 @@ void DxObject::render(int shaderSet)
 		);
 }
 
+void DxObject::renderInstanced(int shaderSet, const InstanceData* instances, unsigned int count)
+{
+	if (instances == nullptr)
+		throw std::invalid_argument("(DxObject::renderInstanced) Invalid instance data");
+	if (count == 0)
+		return;
+	if (MigUtil::theRend->queueDrawInstanced(this, shaderSet, instances, count))
+		return;
+
+	// if we're not in a render sequence then prepare the render
+	if (!_inRenderSet)
+		prepareRender(shaderSet);
+
+	DxRender* pdr = (DxRender*)MigUtil::theRend;
+	ID3D11DeviceContext1* d3dContext = pdr->GetD3DDeviceContext();
+
+	const ShaderSet& shaderItem = _shaderSets[shaderSet];
+	if (!(shaderItem.vertexShader->getHints() & SHADER_HINT_INSTANCED))
+		throw std::invalid_argument("(DxObject::renderInstanced) Shader set doesn't take instance data");
+
+	// the instance data changes every time, so it always goes in a dynamic buffer
+	uploadBuffer(D3D11_BIND_VERTEX_BUFFER, BUFFER_USAGE_DYNAMIC, _instanceBuffer, _instanceBufferSize, instances, count*sizeof(InstanceData));
+
+	UINT instanceStride = sizeof(InstanceData);
+	UINT instanceOffset = 0;
+	d3dContext->IASetVertexBuffers(
+		1,
+		1,
+		_instanceBuffer.GetAddressOf(),
+		&instanceStride,
+		&instanceOffset
+		);
+
+	// send the constant buffers to the shader
+	pdr->SendConstantBuffersToShaders(shaderItem.vertexShader->getHints(), shaderItem.pixelShader->getHints());
+
+	// draw all of the instances at once
+	d3dContext->DrawIndexedInstanced(
+		_indexOffsetCount,
+		count,
+		_indexOffset,
+		0,
+		0
+		);
+}
+
 void DxObject::startRenderSet(int shaderSet)
 {
+	// queued draws are prepared individually when they're submitted
+	if (MigUtil::theRend->isQueueing())
+		return;
+
 	prepareRender(shaderSet);
 
 	_inRenderSet = true;
@@ -383,3 +450,15 @@ void DxObject::stopRenderSet()
 {
 	_inRenderSet = false;
 }
+
+unsigned int DxObject::getStateKey(int shaderSet) const
+{
+	if (shaderSet < 0 || shaderSet >= (int)_shaderSets.size())
+		return 0;
+
+	// there are no small IDs for D3D objects, so the shader and texture pointers get folded instead
+	const ShaderSet& shaderItem = _shaderSets[shaderSet];
+	size_t shaders = ((size_t)shaderItem.vertexShader >> 4) ^ ((size_t)shaderItem.pixelShader >> 4);
+	size_t txt = (!_mappings.empty() ? ((size_t)_mappings[0].pimg >> 4) : 0);
+	return (((unsigned int)(shaders ^ (shaders >> 16)) & 0xFFFF) << 16) | ((unsigned int)(txt ^ (txt >> 16)) & 0xFFFF);
+}
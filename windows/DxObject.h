@@ -30,6 +30,10 @@ namespace MigTech
 
 		Microsoft::WRL::ComPtr<ID3D11Buffer> _vertexBuffer;
 		Microsoft::WRL::ComPtr<ID3D11Buffer> _indexBuffer;
+		unsigned int _vertexBufferSize;
+		unsigned int _indexBufferSize;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> _instanceBuffer;
+		unsigned int _instanceBufferSize;
 
 		unsigned int _vertexStride;
 		unsigned int _vertexOffset;
@@ -44,6 +48,7 @@ namespace MigTech
 		bool _inRenderSet;
 
 	protected:
+		void uploadBuffer(UINT bindFlags, BUFFER_USAGE usage, Microsoft::WRL::ComPtr<ID3D11Buffer>& buffer, unsigned int& bufferSize, const void* pdata, unsigned int size);
 		void prepareRender(int shaderSet);
 
 	public:
@@ -60,8 +65,11 @@ namespace MigTech
 		virtual int getIndexCount() const;
 
 		virtual void render(int shaderSet = 0);
+		virtual void renderInstanced(int shaderSet, const InstanceData* instances, unsigned int count);
 
 		virtual void startRenderSet(int shaderSet = 0);
 		virtual void stopRenderSet();
+
+		virtual unsigned int getStateKey(int shaderSet) const;
 	};
 }
\ No newline at end of file
@@ -1,19 +1,14 @@
 ﻿#include "pch.h"
 #include "../core/MigUtil.h"
+#include "../core/AssetLoader.h"
+#include "../core/ImageDecoder.h"
+#include "../core/KtxFile.h"
+#include "../core/MipChain.h"
 #include "DxDefines.h"
 #include "DxRender.h"
-#include "DxMatrix.h"
 #include "DxShader.h"
 #include "DxObject.h"
 
-extern "C" {
-#include "../core/libjpeg/jpeglib.h"
-}
-
-extern "C" {
-#include "../core/libpng/png.h"
-}
-
 ///////////////////////////////////////////////////////////////////////////
 // platform specific
 
@@ -32,7 +27,6 @@ using namespace MigTech;
 
 // defined in Platform.cpp
 extern bool toWString(const std::string& inStr, std::wstring& outStr);
-extern const std::string& plat_getContentDir(int index);
 extern const std::string& plat_getShaderDir(int index);
 
 #if defined(_DEBUG)
@@ -122,9 +116,8 @@ DxRender::DxRender() :
 {
 	m_clearColor[0] = m_clearColor[1] = m_clearColor[2] = m_clearColor[3] = 0;
 
-	m_pmatModel = new DxMatrix();
-	m_pmatView = new DxMatrix();
-	m_pmatProj = new DxMatrix();
+	// Direct3D clip space depth is 0 to 1
+	Matrix::setDepthZeroToOne(true);
 
 	m_basicChanged = false;
 	m_modelChanged = false;
@@ -136,9 +129,6 @@ DxRender::DxRender() :
 
 DxRender::~DxRender()
 {
-	delete m_pmatModel;
-	delete m_pmatView;
-	delete m_pmatProj;
 }
 
 void DxRender::createDeviceIndependentResources()
@@ -505,6 +495,9 @@ void DxRender::createWindowSizeDependentResources()
 
 bool DxRender::initRenderer()
 {
+	// BC formats are always there in D3D11, ETC and ASTC never are, and the top level has to be whole blocks
+	_compressionCaps = (1 << TEX_COMPRESSION_BC1) | (1 << TEX_COMPRESSION_BC3) | TEX_CAPS_WHOLE_BLOCKS;
+
 	createDeviceIndependentResources();
 	createDeviceResources();
 
@@ -525,33 +518,23 @@ void DxRender::termRenderer()
 	m_shaders.clear();
 }
 
-IMatrix* DxRender::createMatrix()
-{
-	return (IMatrix*) new DxMatrix();
-}
-
-void DxRender::deleteMatrix(IMatrix* pmat)
-{
-	delete (DxMatrix*)pmat;
-}
-
-void DxRender::setProjectionMatrix(const IMatrix* pmat)
+void DxRender::applyProjectionMatrix(const Matrix* pmat)
 {
 	if (pmat != nullptr)
-		m_pmatProj->copy((DxMatrix*)pmat);
+		m_matProj = *pmat;
 	else
-		m_pmatProj->identity();
+		m_matProj.identity();
 	m_projChanged = m_mvpChanged = true;
 }
 
-void DxRender::setProjectionMatrix(float angleY, float aspect, float nearZ, float farZ, bool useOrientation)
+void DxRender::applyProjectionMatrix(float angleY, float aspect, float nearZ, float farZ, bool useOrientation)
 {
-	DxMatrix dxmat;
+	Matrix dxmat;
 	dxmat.loadPerspectiveFovRH(angleY, aspect, nearZ, farZ);
 
 	if (useOrientation)
 	{
-		DxMatrix dxomat;
+		Matrix dxomat;
 
 		DXGI_MODE_ROTATION displayRotation = ComputeDisplayRotation();
 		switch (displayRotation)
@@ -593,34 +576,34 @@ void DxRender::setProjectionMatrix(float angleY, float aspect, float nearZ, floa
 			break;
 		}
 
-		dxmat.multiply(&dxomat);
+		dxmat.multiply(dxomat);
 	}
 
-	setProjectionMatrix(&dxmat);
+	applyProjectionMatrix(&dxmat);
 }
 
-void DxRender::setViewMatrix(const IMatrix* pmat)
+void DxRender::applyViewMatrix(const Matrix* pmat)
 {
 	if (pmat != nullptr)
-		m_pmatView->copy((DxMatrix*)pmat);
+		m_matView = *pmat;
 	else
-		m_pmatView->identity();
+		m_matView.identity();
 	m_viewChanged = m_mvpChanged = true;
 }
 
-void DxRender::setViewMatrix(Vector3 eyePos, Vector3 focusPos, Vector3 upVector)
+void DxRender::applyViewMatrix(Vector3 eyePos, Vector3 focusPos, Vector3 upVector)
 {
-	DxMatrix dxmat;
+	Matrix dxmat;
 	dxmat.loadLookAtRH(eyePos, focusPos, upVector);
-	setViewMatrix(&dxmat);
+	applyViewMatrix(&dxmat);
 }
 
-void DxRender::setModelMatrix(const IMatrix* pmat)
+void DxRender::applyModelMatrix(const Matrix* pmat)
 {
 	if (pmat != nullptr)
-		m_pmatModel->copy((DxMatrix*)pmat);
+		m_matModel = *pmat;
 	else
-		m_pmatModel->identity();
+		m_matModel.identity();
 	m_modelChanged = m_mvpChanged = true;
 }
 
@@ -646,7 +629,7 @@ static const D3D11_VIEWPORT* toD3DViewport(const Rect& newPort, float width, flo
 	return &vp;
 }
 
-void DxRender::setViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer)
+void DxRender::applyViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer)
 {
 	// Reset the viewport
 	if (newPort != nullptr)
@@ -755,8 +738,8 @@ const D3D11_INPUT_ELEMENT_DESC* toD3DInputLayout(VDTYPE vdType, unsigned int& el
 		static const D3D11_INPUT_ELEMENT_DESC vertexDesc[] =
 		{
 			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-			{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-			{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+			{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+			{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 28, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 		};
 		desc = vertexDesc;
 		elemCount = ARRAYSIZE(vertexDesc);
@@ -851,6 +834,24 @@ Shader* DxRender::loadVertexShader(const std::string& name, VDTYPE vdType, unsig
 
 	unsigned int elemCount = 0;
 	const D3D11_INPUT_ELEMENT_DESC* vertexDesc = toD3DInputLayout(vdType, elemCount);
+
+	// instanced shaders also read the per-instance data from the second input slot
+	std::vector<D3D11_INPUT_ELEMENT_DESC> instanceDesc;
+	if (shaderHints & SHADER_HINT_INSTANCED)
+	{
+		instanceDesc.assign(vertexDesc, vertexDesc + elemCount);
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			D3D11_INPUT_ELEMENT_DESC modelDesc = { "INSTMODEL", i, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, offsetof(InstanceData, model) + 16 * i, D3D11_INPUT_PER_INSTANCE_DATA, 1 };
+			instanceDesc.push_back(modelDesc);
+		}
+		D3D11_INPUT_ELEMENT_DESC colorDesc = { "INSTCOLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, offsetof(InstanceData, color), D3D11_INPUT_PER_INSTANCE_DATA, 1 };
+		instanceDesc.push_back(colorDesc);
+
+		vertexDesc = &instanceDesc[0];
+		elemCount = instanceDesc.size();
+	}
+
 	ID3D11InputLayout* inputLayout;
 	hres = m_d3dDevice->CreateInputLayout(
 		vertexDesc,
@@ -956,264 +957,53 @@ Shader* DxRender::getShader(const std::string& name)
 		);
 }*/
 
-static DxImage* loadJPEGImage(const std::string& name, unsigned int loadFlags)
+// there's no 3 byte texture format, so RGB pixels (every level of them) are uploaded as RGBA
+static bool expandRGBImage(ImageData& data)
 {
-	// compose the complete path to the asset and open it
-	std::string path = plat_getContentDir(0) + name;
-	FILE* pFile = nullptr;
-	if (fopen_s(&pFile, path.c_str(), "rb"))
-	{
-		LOGWARN("(DxRender::loadJPEGImage) image '%s' doesn't exist", name.c_str());
-		return nullptr;
-	}
-
-	// initialize decompression
-	struct jpeg_decompress_struct cinfo;
-	struct jpeg_error_mgr jerr;
-	cinfo.err = jpeg_std_error(&jerr);
-	jpeg_create_decompress(&cinfo);
-	jpeg_stdio_src(&cinfo, pFile);
-	jpeg_read_header(&cinfo, TRUE);
-	jpeg_start_decompress(&cinfo);
-	LOGINFO("(DxRender::loadJPEGImage) Image=%s, w=%d, h=%d", name.c_str(), cinfo.output_width, cinfo.output_height);
-
-	// for now, only 24-bit JPEGs
-	byte* pData = nullptr;
-	if (cinfo.output_components == 3)
-	{
-		// read into the image buffer (note that DxImage only supports 4 byte per pixel images)
-		int row_stride = 4 * cinfo.output_width;
-		int numPixels = row_stride * cinfo.output_height;
-		pData = new byte[numPixels];
-		if (pData != nullptr)
-		{
-			byte* psrc = new byte[3 * cinfo.output_width];
-			JSAMPROW row_pointer[1];
-			row_pointer[0] = psrc;
-
-			while (cinfo.output_scanline < cinfo.output_height)
-			{
-				jpeg_read_scanlines(&cinfo, row_pointer, 1);
-
-				byte* pdst = pData + (cinfo.output_scanline - 1)*row_stride;
-				for (unsigned int i = 0; i < cinfo.output_width; i++)
-				{
-					pdst[4 * i + 0] = psrc[3 * i + 0];
-					pdst[4 * i + 1] = psrc[3 * i + 1];
-					pdst[4 * i + 2] = psrc[3 * i + 2];
-
-					// apply image processing
-					byte alpha = 255;
-					if (loadFlags != LOAD_IMAGE_NONE)
-					{
-						if (loadFlags & LOAD_IMAGE_ADD_ALPHA)
-							alpha = (pdst[4 * i + 0] + pdst[4 * i + 1] + pdst[4 * i + 2]) / 3;
-						else if (loadFlags & LOAD_IMAGE_CLEAR_ALPHA)
-							alpha = 0;
-						if (loadFlags & LOAD_IMAGE_INVERT_ALPHA)
-							alpha = (255 - alpha);
-					}
-					pdst[4 * i + 3] = alpha;
-				}
-			}
-			delete psrc;
-
-			// drop color components if so flagged
-			if (loadFlags & LOAD_IMAGE_DROP_COLOR)
-			{
-				int numPixels = cinfo.output_width * cinfo.output_height;
-				byte* pNewData = new byte[numPixels];
-				for (int i = 0; i < numPixels; i++)
-				{
-					pNewData[i] = pData[4 * i + 3];
-				}
-
-				delete pData;
-				pData = pNewData;
-			}
-		}
-	}
-	else
-	{
-		LOGWARN("(DxRender::loadJPEGImage) %d color components not supported", cinfo.output_components);
-	}
-
-	// clean up decompression
-	jpeg_finish_decompress(&cinfo);
-	jpeg_destroy_decompress(&cinfo);
-	fclose(pFile);
+	if (data.isCompressed() || data.format != IMG_FORMAT_RGB)
+		return true;
 
-	// load the data into an Image and return
-	DxImage* newImage = nullptr;
-	if (pData != nullptr)
+	int numPixels = MipChain::getChainSize(data) / 3;
+	byte* pData = new byte[4 * numPixels];
+	for (int i = 0; i < numPixels; i++)
 	{
-		// create the image object and load
-		newImage = new DxImage();
-		newImage->loadTexture(loadFlags & LOAD_IMAGE_DROP_COLOR ? IMG_FORMAT_ALPHA : IMG_FORMAT_RGBA, cinfo.output_width, cinfo.output_height, pData);
-		delete pData;
+		pData[4*i + 0] = data.pixels[3*i + 0];
+		pData[4*i + 1] = data.pixels[3*i + 1];
+		pData[4*i + 2] = data.pixels[3*i + 2];
+		pData[4*i + 3] = 255;
 	}
-	return newImage;
+	data.release();
+	data.format = IMG_FORMAT_RGBA;
+	data.pixels = pData;
+	data.dataSize = 4 * numPixels;
+	return true;
 }
 
-static DxImage* loadPNGImage(const std::string& name, unsigned int loadFlags)
+Image* DxRender::loadNewImage(const std::string& name, const std::string& path, unsigned int loadFlags)
 {
-	// compose the complete path to the asset and open it
-	std::string path = plat_getContentDir(0) + name;
-	FILE* pFile = nullptr;
-	if (fopen_s(&pFile, path.c_str(), "rb"))
-	{
-		LOGWARN("(DxRender::loadPNGImage) image '%s' doesn't exist", name.c_str());
-		return nullptr;
-	}
-
-	// check the header to ensure it's a PNG
-	byte header[8];
-	fread(header, 1, sizeof(header), pFile);
-	if (png_sig_cmp(header, 0, sizeof(header)))
-	{
-		LOGWARN("(DxRender::loadPNGImage) image '%s' does not appear to be a PNG", name.c_str());
-		fclose(pFile);
-		return nullptr;
-	}
+	// see if the image already exists
+	Image* pi = findImage(name);
+	if (pi != nullptr)
+		return pi;
 
-	// allocate needed structs
-	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
-	if (!png_ptr)
-	{
-		LOGWARN("(DxRender::loadPNGImage) png_create_read_struct() failed");
-		fclose(pFile);
+	ImageData data;
+	if (!decodeImage(path, loadFlags, getOutputSize(), data))
 		return nullptr;
-	}
-	png_infop info_ptr = png_create_info_struct(png_ptr);
-	if (!info_ptr)
-	{
-		LOGWARN("(DxRender::loadPNGImage) png_create_info_struct() failed");
-		png_destroy_read_struct(&png_ptr, (png_infopp)nullptr, (png_infopp)nullptr);
-		fclose(pFile);
-		return nullptr;
-	}
-
-	// init the PNG file IO
-	png_init_io(png_ptr, pFile);
-	png_set_sig_bytes(png_ptr, sizeof(header));
+	AssetLoader::recordImage(path, loadFlags, data);
 
-	// read the info header
-	png_read_info(png_ptr, info_ptr);
-
-	// transform images to RGBA type (unless greyscale)
-	int colorType = png_get_color_type(png_ptr, info_ptr);
-	if (colorType == PNG_COLOR_TYPE_PALETTE)
-	{
-		png_set_palette_to_rgb(png_ptr);
-		png_set_add_alpha(png_ptr, 0, PNG_FILLER_AFTER);
-	}
-	else if (colorType == PNG_COLOR_TYPE_RGB)
-		png_set_add_alpha(png_ptr, 0, PNG_FILLER_AFTER);
-
-	// add alpha if the transparency is in a tRNS chunk
-	if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
-		png_set_tRNS_to_alpha(png_ptr);
-
-	// expand image data that is less than 8 bits to 8 bits
-	int bitDepth = png_get_bit_depth(png_ptr, info_ptr);
-	if (colorType == PNG_COLOR_TYPE_GRAY && bitDepth < 8)
-		png_set_expand_gray_1_2_4_to_8(png_ptr);
-	else if (bitDepth < 8)
-		png_set_packing(png_ptr);
-
-	// apply the transformations
-	png_read_update_info(png_ptr, info_ptr);
-
-	// re-read header info
-	byte* pData = nullptr;
-	colorType = png_get_color_type(png_ptr, info_ptr);
-	bitDepth = png_get_bit_depth(png_ptr, info_ptr);
-	int channels = png_get_channels(png_ptr, info_ptr);
-	int imageWidth = png_get_image_width(png_ptr, info_ptr);
-	int imageHeight = png_get_image_height(png_ptr, info_ptr);
-	LOGINFO("(DxRender::loadPNGImage) Image=%s, w=%d, h=%d, bits=%d, channels=%d", name.c_str(), imageWidth, imageHeight, bitDepth, channels);
-	if (bitDepth == 8 && channels != 2 && channels != 3)
-	{
-		// allocate image buffer data
-		int row_stride = (channels == 1 ? 1 : 4) * imageWidth;
-		pData = new byte[row_stride*imageHeight];
-		if (pData != nullptr)
-		{
-			// read the PNG
-			png_bytepp row_pointers = new png_bytep[imageHeight];
-			for (int y = 0; y < imageHeight; y++)
-				row_pointers[y] = pData + y*row_stride;
-			png_read_image(png_ptr, row_pointers);
-			delete[] row_pointers;
-
-			// read the end of the PNG (skip the actual data)
-			png_read_end(png_ptr, (png_infop)nullptr);
-
-			// apply image processing
-			if (loadFlags != LOAD_IMAGE_NONE && channels != 1)
-			{
-				int numPixels = imageWidth * imageHeight;
-				for (int i = 0; i < numPixels; i++)
-				{
-					byte alpha;
-					if (loadFlags & LOAD_IMAGE_ADD_ALPHA)
-						alpha = (pData[4 * i + 0] + pData[4 * i + 1] + pData[4 * i + 2]) / 3;
-					else if (loadFlags & LOAD_IMAGE_SET_ALPHA)
-						alpha = 255;
-					else if (loadFlags & LOAD_IMAGE_CLEAR_ALPHA)
-						alpha = 0;
-					else
-						alpha = pData[4 * i + 3];
-					if (loadFlags & LOAD_IMAGE_INVERT_ALPHA)
-						alpha = (255 - alpha);
-					pData[4 * i + 3] = alpha;
-				}
-			}
-		}
+	// create the image object and load
+	DxImage* newImage = new DxImage();
+	uploadImage(newImage, data);
+	data.release();
+	_images[name] = newImage;
 
-		// drop color components if so flagged
-		if (loadFlags & LOAD_IMAGE_DROP_COLOR)
-		{
-			int numPixels = imageWidth * imageHeight;
-			byte* pNewData = new byte[numPixels];
-			for (int i = 0; i < numPixels; i++)
-			{
-				pNewData[i] = pData[4 * i + 3];
-			}
-
-			delete pData;
-			pData = pNewData;
-		}
-	}
-	else
-	{
-		LOGWARN("(DxRender::loadPNGImage) Unsupported bit depth or channels (%d, %d)", bitDepth, channels);
-	}
-	
-	// clean up
-	png_destroy_read_struct(&png_ptr, (png_infopp)&info_ptr, (png_infopp)nullptr);
-	fclose(pFile);
-
-	// load the data into an Image and return
-	DxImage* newImage = nullptr;
-	if (pData != nullptr)
-	{
-		// create the image object and load
-		newImage = new DxImage();
-		newImage->loadTexture(loadFlags & LOAD_IMAGE_DROP_COLOR ? IMG_FORMAT_ALPHA : IMG_FORMAT_RGBA, imageWidth, imageHeight, pData);
-		delete pData;
-	}
 	return newImage;
 }
 
-Image* DxRender::loadImage(const std::string& name, const std::string& path, unsigned int loadFlags)
+// CPU only, this is called from the asset loader threads
+bool DxRender::decodeImage(const std::string& path, unsigned int loadFlags, const Size& fitSize, ImageData& data)
 {
-	// see if the image already exists
-	Image* pi = getImage(name);
-	if (pi != nullptr)
-		return pi;
-
-	DxImage* newImage = nullptr;
+	bool decoded = false;
 	int findDot = path.rfind(".");
 	if (findDot != string::npos)
 	{
@@ -1221,20 +1011,43 @@ Image* DxRender::loadImage(const std::string& name, const std::string& path, uns
 		if (0 == _stricmp(ext.c_str(), "jpg") ||
 			0 == _stricmp(ext.c_str(), "jpeg"))
 		{
-			newImage = loadJPEGImage(path, loadFlags);
+			decoded = ImageDecoder::loadJPEG(path, loadFlags, false, fitSize, data);
 		}
 		else if (0 == _stricmp(ext.c_str(), "png"))
 		{
-			newImage = loadPNGImage(path, loadFlags);
+			decoded = ImageDecoder::loadPNG(path, loadFlags, data);
+		}
+		else if (0 == _stricmp(ext.c_str(), "ktx") ||
+			0 == _stricmp(ext.c_str(), "ktx2"))
+		{
+			decoded = (KtxFile::loadImage(path, loadFlags, _compressionCaps, data) && expandRGBImage(data));
 		}
 	}
-	if (newImage != nullptr)
-		_images[name] = newImage;
 
+	if (decoded && (loadFlags & LOAD_IMAGE_MIPMAPS))
+		MipChain::generate(data);
+	return decoded;
+}
+
+void DxRender::uploadImage(Image* img, const ImageData& data)
+{
+	if (data.isCompressed())
+	{
+		DXGI_FORMAT fmt = (data.compression == TEX_COMPRESSION_BC1 ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC3_UNORM);
+		((DxImage*)img)->loadCompressedTexture(fmt, data, data.mipLevels);
+	}
+	else
+		((DxImage*)img)->loadTexture(data.format, data.width, data.height, data.pixels, data.mipLevels);
+}
+
+Image* DxRender::createPendingImage(const std::string& name)
+{
+	DxImage* newImage = new DxImage();
+	_images[name] = newImage;
 	return newImage;
 }
 
-Image* DxRender::getImage(const std::string& name)
+Image* DxRender::findImage(const std::string& name)
 {
 	std::map<std::string, DxImage*>::const_iterator iter = _images.find(name);
 	if (iter != _images.end() && iter->second != nullptr)
@@ -1242,10 +1055,10 @@ Image* DxRender::getImage(const std::string& name)
 	return nullptr;
 }
 
-Image* DxRender::createRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint)
+Image* DxRender::createNewRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint)
 {
 	// if the render target already exists, that is considered an error
-	if (getImage(name) != nullptr)
+	if (findImage(name) != nullptr)
 		return nullptr;
 
 	DxRenderTarget* newTarget = new DxRenderTarget();
@@ -1259,7 +1072,7 @@ Image* DxRender::createRenderTarget(const std::string& name, IMG_FORMAT fmtHint,
 	return newTarget;
 }
 
-void DxRender::unloadImage(const std::string& name)
+void DxRender::destroyImage(const std::string& name)
 {
 	std::map<std::string, DxImage*>::iterator iter = _images.find(name);
 	if (iter != _images.end() && iter->second != nullptr)
@@ -1287,7 +1100,7 @@ void DxRender::setClearColor(const Color& clearCol)
 	m_clearColor[3] = clearCol.a;
 }
 
-void DxRender::setObjectColor(const Color& objCol)
+void DxRender::applyObjectColor(const Color& objCol)
 {
 	m_cbBasicData.color.x = objCol.r;
 	m_cbBasicData.color.y = objCol.g;
@@ -1324,7 +1137,7 @@ static D3D11_BLEND_DESC createBlendDesc(BLEND_STATE blend)
 	return bd;
 }
 
-void DxRender::setBlending(BLEND_STATE blend)
+void DxRender::applyBlending(BLEND_STATE blend)
 {
 	if (m_d3dBlendStates[blend] == nullptr)
 	{
@@ -1367,7 +1180,7 @@ static D3D11_DEPTH_STENCIL_DESC createDepthStencilDesc(DEPTH_TEST_STATE depth, b
 	return dsd;
 }
 
-void DxRender::setDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite)
+void DxRender::applyDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite)
 {
 	int index = (int)depth + (enableWrite ? 8 : 0);
 	if (m_d3dDepthStencilStates[index] == nullptr)
@@ -1419,7 +1232,7 @@ void DxRender::setFaceCulling(FACE_CULLING cull)
 	}
 }
 
-void DxRender::setMiscValue(int index, float value)
+void DxRender::applyMiscValue(int index, float value)
 {
 	if (index < 0 || index > 3)
 		throw std::out_of_range("(DxRender::createDeviceResources) Misc index out of bounds");
@@ -1434,7 +1247,7 @@ void DxRender::setMiscValue(int index, float value)
 	m_basicChanged = true;
 }
 
-void DxRender::setAmbientColor(const Color& ambientCol)
+void DxRender::applyAmbientColor(const Color& ambientCol)
 {
 	m_cbLightsData.ambientColor.x = ambientCol.r;
 	m_cbLightsData.ambientColor.y = ambientCol.g;
@@ -1443,7 +1256,7 @@ void DxRender::setAmbientColor(const Color& ambientCol)
 	m_lightsChanged = true;
 }
 
-void DxRender::setLightColor(int index, const Color& litCol)
+void DxRender::applyLightColor(int index, const Color& litCol)
 {
 	if (index < 0 || index > 3)
 		throw std::out_of_range("(DxRender::createDeviceResources) Light index out of bounds");
@@ -1454,7 +1267,7 @@ void DxRender::setLightColor(int index, const Color& litCol)
 	m_lightsChanged = true;
 }
 
-void DxRender::setLightDirPos(int index, const Vector3& litDirPos, bool isDir)
+void DxRender::applyLightDirPos(int index, const Vector3& litDirPos, bool isDir)
 {
 	if (index < 0 || index > 3)
 		throw std::out_of_range("(DxRender::createDeviceResources) Light index out of bounds");
@@ -1708,6 +1521,12 @@ DXGI_MODE_ROTATION DxRender::ComputeDisplayRotation()
 	return rotation;
 }
 
+// Matrix uses the same memory layout as XMFLOAT4X4
+static inline DirectX::XMMATRIX toXMMatrix(const Matrix& mat)
+{
+	return DirectX::XMLoadFloat4x4((const DirectX::XMFLOAT4X4*) mat.getData());
+}
+
 void DxRender::SendConstantBuffersToShaders(unsigned int vertexShaderHints, unsigned int pixelShaderHints)
 {
 	// currently we only support matrices being sent to vertex shaders
@@ -1718,7 +1537,7 @@ void DxRender::SendConstantBuffersToShaders(unsigned int vertexShaderHints, unsi
 		{
 			XMStoreFloat4x4(
 				&m_cbMatrixData.model,
-				DirectX::XMMatrixTranspose(m_pmatModel->getMat())
+				DirectX::XMMatrixTranspose(toXMMatrix(m_matModel))
 				);
 			m_modelChanged = false;
 			needMatrices = true;
@@ -1730,7 +1549,7 @@ void DxRender::SendConstantBuffersToShaders(unsigned int vertexShaderHints, unsi
 		{
 			XMStoreFloat4x4(
 				&m_cbMatrixData.view,
-				DirectX::XMMatrixTranspose(m_pmatView->getMat())
+				DirectX::XMMatrixTranspose(toXMMatrix(m_matView))
 				);
 			m_viewChanged = false;
 			needMatrices = true;
@@ -1742,7 +1561,7 @@ void DxRender::SendConstantBuffersToShaders(unsigned int vertexShaderHints, unsi
 		{
 			XMStoreFloat4x4(
 				&m_cbMatrixData.proj,
-				DirectX::XMMatrixTranspose(m_pmatProj->getMat())
+				DirectX::XMMatrixTranspose(toXMMatrix(m_matProj))
 				);
 			m_projChanged = false;
 			needMatrices = true;
@@ -1752,12 +1571,12 @@ void DxRender::SendConstantBuffersToShaders(unsigned int vertexShaderHints, unsi
 	{
 		if (m_mvpChanged)
 		{
-			DirectX::XMMATRIX mvp = m_pmatModel->getMat();
-			mvp = XMMatrixMultiply(mvp, m_pmatView->getMat());
-			mvp = XMMatrixMultiply(mvp, m_pmatProj->getMat());
+			Matrix mvp;
+			Matrix::multiply(m_matModel, m_matView, mvp);
+			mvp.multiply(m_matProj);
 			XMStoreFloat4x4(
 				&m_cbMatrixData.mvp,
-				DirectX::XMMatrixTranspose(mvp)
+				DirectX::XMMatrixTranspose(toXMMatrix(mvp))
 				);
 			m_mvpChanged = false;
 			needMatrices = true;
@@ -6,7 +6,6 @@
 #include "../core/MigDefines.h"
 #include "../core/RenderBase.h"
 #include "DxShader.h"
-#include "DxMatrix.h"
 #include "DxImage.h"
 
 namespace MigTech
@@ -43,6 +42,25 @@ namespace MigTech
 		virtual void createDeviceIndependentResources();
 		virtual void createDeviceResources();
 		virtual void createWindowSizeDependentResources();
+		virtual Image* loadNewImage(const std::string& name, const std::string& path, unsigned int loadFlags);
+		virtual Image* createNewRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint);
+		virtual void destroyImage(const std::string& name);
+		virtual Image* findImage(const std::string& name);
+		virtual Image* createPendingImage(const std::string& name);
+
+		virtual void applyProjectionMatrix(const Matrix* pmat);
+		virtual void applyProjectionMatrix(float angleY, float aspect, float nearZ, float farZ, bool useOrientation);
+		virtual void applyViewMatrix(const Matrix* pmat);
+		virtual void applyViewMatrix(Vector3 eyePos, Vector3 focusPos, Vector3 upVector);
+		virtual void applyModelMatrix(const Matrix* pmat);
+		virtual void applyViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer);
+		virtual void applyObjectColor(const Color& objCol);
+		virtual void applyBlending(BLEND_STATE blend);
+		virtual void applyDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite);
+		virtual void applyMiscValue(int index, float value);
+		virtual void applyAmbientColor(const Color& ambientCol);
+		virtual void applyLightColor(int index, const Color& litCol);
+		virtual void applyLightDirPos(int index, const Vector3& litDirPos, bool isDir);
 
 	public:
 		DxRender();
@@ -51,41 +69,22 @@ namespace MigTech
 		virtual bool initRenderer();
 		virtual void termRenderer();
 
-		virtual IMatrix* createMatrix();
-		virtual void deleteMatrix(IMatrix* pmat);
-		virtual void setProjectionMatrix(const IMatrix* pmat);
-		virtual void setProjectionMatrix(float angleY, float aspect, float nearZ, float farZ, bool useOrientation);
-		virtual void setViewMatrix(const IMatrix* pmat);
-		virtual void setViewMatrix(Vector3 eyePos, Vector3 focusPos, Vector3 upVector);
-		virtual void setModelMatrix(const IMatrix* pmat);
-
 		virtual Shader* loadVertexShader(const std::string& name, VDTYPE vdType, unsigned int shaderHints);
 		virtual Shader* loadPixelShader(const std::string& name, unsigned int shaderHints);
 		virtual Shader* getShader(const std::string& name);
 
-		virtual Image* loadImage(const std::string& name, const std::string& path, unsigned int loadFlags);
-		virtual Image* getImage(const std::string& name);
-		virtual Image* createRenderTarget(const std::string& name, IMG_FORMAT fmtHint, int width, int height, int depthBitsHint);
-		virtual void unloadImage(const std::string& name);
+		virtual bool decodeImage(const std::string& path, unsigned int loadFlags, const Size& fitSize, ImageData& data);
+		virtual void uploadImage(Image* img, const ImageData& data);
 
 		virtual Object* createObject();
 		virtual void deleteObject(Object* pobj);
 
 		virtual void setOutputSize(Size newSize);
 		virtual Size getOutputSize();
-		virtual void setViewport(const Rect* newPort, bool clearRenderBuffer, bool clearDepthBuffer);
 
 		virtual void setClearColor(const Color& clearCol);
-		virtual void setObjectColor(const Color& objCol);
-		virtual void setBlending(BLEND_STATE blend);
-		virtual void setDepthTesting(DEPTH_TEST_STATE depth, bool enableWrite);
 		virtual void setFaceCulling(FACE_CULLING cull);
 
-		virtual void setMiscValue(int index, float value);
-		virtual void setAmbientColor(const Color& ambientCol);
-		virtual void setLightColor(int index, const Color& litCol);
-		virtual void setLightDirPos(int index, const Vector3& litDirPos, bool isDir);
-
 		virtual void onSuspending();
 		virtual void onResuming();
 
@@ -169,9 +168,9 @@ namespace MigTech
 		std::map<std::string, DxImage*> _images;
 
 		// Matrices
-		DxMatrix* m_pmatProj;
-		DxMatrix* m_pmatView;
-		DxMatrix* m_pmatModel;
+		Matrix m_matProj;
+		Matrix m_matView;
+		Matrix m_matModel;
 
 		bool m_basicChanged;
 		bool m_projChanged;
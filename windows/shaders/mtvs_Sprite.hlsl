@@ -0,0 +1,46 @@
+// A constant buffer that stores the basic column-major matrices for composing geometry.
+cbuffer ShaderConstantBasic : register(b0)
+{
+	float4 color;
+	float4 misc;
+};
+
+// A constant buffer that stores the basic column-major matrices for composing geometry.
+cbuffer ShaderConstantMatrix : register(b1)
+{
+	matrix model;
+	matrix view;
+	matrix proj;
+	matrix mvp;
+};
+
+// Per-vertex data used as input to the vertex shader (see SpriteBatch).
+struct VertexShaderInput
+{
+	float3 pos : POSITION;
+	float4 color : COLOR0;
+	float2 uv : TEXCOORD0;
+};
+
+// Per-pixel color data passed through the pixel shader.
+struct PixelShaderInput
+{
+	float4 pos : SV_POSITION;
+	float2 uv : TEXCOORD0;
+	float4 color : COLOR0;
+};
+
+// Sprites are already in world space, the color and UVs come from the vertex.
+PixelShaderInput main(VertexShaderInput input)
+{
+	PixelShaderInput output;
+
+	// Transform the vertex position into projected space.
+	float4 pos = float4(input.pos, 1.0f);
+	output.pos = mul(pos, mvp);
+
+	output.uv = input.uv;
+	output.color = input.color;
+
+	return output;
+}